@@ -0,0 +1,364 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "color_census.hpp"
+#include "color_config.hpp"
+#include "dc_index.hpp"
+
+/**
+ * The lookup the color hooks did before colors.yaml was compiled into tables: the color is formatted as hex,
+ * every key of the category is upper-cased and compared, the match is parsed back into a COLORREF
+ * @param category_node The shapes or text section of colors.yaml
+ * @param color The original color in COLORREF format
+ * @return The mapped color or std::nullopt if the color stays unchanged
+ */
+static std::optional<uint32_t> find_in_yaml(const YAML::Node& category_node, const uint32_t color)
+{
+    std::stringstream ss;
+    ss << '#' << std::uppercase << std::hex
+        << std::setw(2) << std::setfill('0') << (color & 0xff)
+        << std::setw(2) << std::setfill('0') << (color >> 8 & 0xff)
+        << std::setw(2) << std::setfill('0') << (color >> 16 & 0xff);
+    const auto hex = ss.str();
+
+    for (auto it = category_node.begin(); it != category_node.end(); ++it)
+    {
+        auto current_color = it->first.as<std::string>();
+        std::string current_color_upper(current_color.size(), '\0');
+        std::transform(current_color.begin(), current_color.end(), current_color_upper.begin(), ::toupper);
+
+        if (current_color_upper == hex)
+        {
+            const auto ret = it->second.as<std::string>();
+
+            if (ret.empty())
+                return std::nullopt;
+
+            const auto rgb = static_cast<uint32_t>(std::stoul(ret[0] == '#' ? ret.substr(1) : ret, nullptr, 16));
+            return (rgb & 0xff) << 16 | (rgb & 0xff00) | rgb >> 16;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Writes a colors.yaml with as many shape and text mappings as a complete Potato theme
+ * @param windows Also write compDenoise and wdb sections that remap some of the main window colors
+ * @return The colors.yaml root
+ */
+static YAML::Node synthetic_colors(const bool windows = false)
+{
+    uint32_t seed = 7;
+
+    const auto random = [&seed]
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+
+    std::string yaml;
+    char line[64];
+
+    const auto write_section = [&](const std::string& indent, const char* section, const uint32_t count)
+    {
+        yaml += indent + section + ":\n";
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            std::snprintf(line, sizeof(line), "  \"#%06X\": \"#%06X\"\n", random() & 0xffffff, random() & 0xffffff);
+            yaml += indent + line;
+        }
+    };
+
+    write_section("", "shapes", 160);
+    write_section("", "text", 48);
+
+    if (windows)
+    {
+        yaml += "windows:\n";
+
+        for (const auto name : {"compDenoise", "wdb"})
+        {
+            yaml += std::string("  ") + name + ":\n";
+            write_section("    ", "shapes", 32);
+            write_section("    ", "text", 8);
+        }
+    }
+
+    return YAML::Load(yaml);
+}
+
+/**
+ * Looks up the colors a repaint sends through the pen, brush and text color hooks, with the old and the new lookup
+ * @param args Optional colors.yaml, a synthetic one otherwise
+ */
+int bench_colors(const std::vector<std::string>& args)
+{
+    YAML::Node root;
+
+    try
+    {
+        root = !args.empty() ? YAML::LoadFile(args[0]) : synthetic_colors();
+    }
+    catch (const YAML::Exception& ex)
+    {
+        SPDLOG_ERROR("can't load {}: {}", args[0], ex.what());
+        return 1;
+    }
+
+    compiled_colors_t colors;
+
+    if (!color_config::compile(root, colors))
+        return 1;
+
+    std::printf("%-8s %8s %10s %10s %9s  same results\n", "section", "mappings", "yaml scan", "table", "speedup");
+
+    for (const auto& [category, name] : {std::pair<color_category, const char*>{CATEGORY_SHAPES, "shapes"}, {CATEGORY_TEXT, "text"}})
+    {
+        const auto category_node = root[name];
+        std::vector<uint32_t> keys;
+
+        for (auto it = category_node.begin(); it != category_node.end(); ++it)
+        {
+            if (const auto key = color_config::parse_hex(it->first.as<std::string>()))
+                keys.push_back(*key);
+        }
+
+        // three of four calls ask for a color the theme maps, like the stock colors of a repaint
+        std::vector<uint32_t> calls(4096);
+        uint32_t seed = 11;
+
+        for (auto& c : calls)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            c = !keys.empty() && (seed >> 30) != 0 ? keys[(seed >> 8) % keys.size()] : seed >> 8 & 0xffffff;
+        }
+
+        const auto& map = colors.maps[WND_TYPE_MAIN][category];
+        bool same = true;
+
+        for (const auto c : calls)
+            same = same && find_in_yaml(category_node, c) == map.find(c);
+
+        // keeps the compiler from dropping the lookups
+        volatile uint32_t sink = 0;
+
+        const double yaml_ms = time_ms([&]
+        {
+            for (const auto c : calls)
+                sink = sink + find_in_yaml(category_node, c).value_or(c);
+        });
+
+        const double table_ms = time_ms([&]
+        {
+            for (const auto c : calls)
+                sink = sink + map.find(c).value_or(c);
+        });
+
+        const double yaml_ns = yaml_ms * 1e6 / calls.size();
+        const double table_ns = table_ms * 1e6 / calls.size();
+
+        std::printf("%-8s %8zu %7.0f ns %7.1f ns %8.0fx  %s\n", name, keys.size(), yaml_ns, table_ns, yaml_ns / table_ns, same ? "yes" : "NO");
+    }
+
+    return 0;
+}
+
+/**
+ * Bakes a typical list of color rules and maps colors through it, with both lookup modes
+ */
+int bench_lut(const std::vector<std::string>&)
+{
+    std::vector<color_rule_t> rules(4);
+    rules[0].type = RULE_HUE_ROTATE;
+    rules[0].amount = 200.0f;
+    rules[1].type = RULE_SATURATION;
+    rules[1].amount = 0.8f;
+    rules[2].type = RULE_LIGHTNESS;
+    rules[2].amount = 1.1f;
+    rules[3].type = RULE_GRAY_RAMP;
+    rules[3].range_min = 16;
+    rules[3].range_max = 96;
+    rules[3].tolerance = 8;
+    rules[3].ramp_from = 0x201810;
+    rules[3].ramp_to = 0x604830;
+
+    std::vector<uint32_t> calls(4096);
+    uint32_t seed = 3;
+
+    for (auto& c : calls)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        c = seed >> 8 & 0xffffff;
+    }
+
+    std::printf("%zu rules, %u^3 nodes\n\n", rules.size(), color_lut::GRID_SIZE);
+    std::printf("%-10s %9s %9s\n", "mode", "bake", "lookup");
+
+    for (const auto& [mode, name] : {std::pair<lut_interpolation, const char*>{LUT_NEAREST, "nearest"}, {LUT_TRILINEAR, "trilinear"}})
+    {
+        color_lut lut;
+        const double bake_ms = time_ms([&] { lut.bake(rules, mode); });
+
+        volatile uint32_t sink = 0;
+
+        const double apply_ms = time_ms([&]
+        {
+            for (const auto c : calls)
+                sink = sink + lut.apply(c);
+        });
+
+        std::printf("%-10s %6.2f ms %6.1f ns\n", name, bake_ms, apply_ms * 1e6 / calls.size());
+    }
+
+    return 0;
+}
+
+/**
+ * Resolves the window of pen, brush and text colors through the memory DC index and looks them up in its map,
+ * against the lookup in the main window map the hooks do when colors.yaml has no window sections
+ */
+int bench_windows(const std::vector<std::string>&)
+{
+    const auto root = synthetic_colors(true);
+    compiled_colors_t colors;
+
+    if (!color_config::compile(root, colors))
+        return 1;
+
+    // the memory DCs of the three windows, fake handles are enough since the index only compares them
+    dc_index dcs;
+    const void* main_dc = reinterpret_cast<const void*>(0x1010);
+    const void* comp_dc = reinterpret_cast<const void*>(0x1020);
+    const void* wdb_dc = reinterpret_cast<const void*>(0x1030);
+    const void* screen_dc = reinterpret_cast<const void*>(0x2000);
+    dcs.replace(nullptr, main_dc, WND_TYPE_MAIN);
+    dcs.replace(nullptr, comp_dc, WND_TYPE_COMP_DENOISE);
+    dcs.replace(nullptr, wdb_dc, WND_TYPE_WDB);
+
+    std::vector<uint32_t> keys[2];
+
+    for (const auto& section : {root, root["windows"]["compDenoise"], root["windows"]["wdb"]})
+    {
+        for (const auto& [category, name] : {std::pair<color_category, const char*>{CATEGORY_SHAPES, "shapes"}, {CATEGORY_TEXT, "text"}})
+        {
+            for (auto it = section[name].begin(); it != section[name].end(); ++it)
+                keys[category].push_back(*color_config::parse_hex(it->first.as<std::string>()));
+        }
+    }
+
+    // half of the calls ask for a color the theme maps, in the main or one of the window sections
+    std::vector<std::pair<uint32_t, color_category>> calls(4096);
+    uint32_t seed = 13;
+
+    for (auto& [color, category] : calls)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        category = seed >> 31 ? CATEGORY_SHAPES : CATEGORY_TEXT;
+        color = seed >> 30 & 1 ? keys[category][(seed >> 8) % keys[category].size()] : seed >> 8 & 0xffffff;
+    }
+
+    std::printf("%-8s %10s %10s\n", "hdc", "lookup", "overhead");
+
+    volatile uint32_t sink = 0;
+
+    const double main_ms = time_ms([&]
+    {
+        for (const auto& [color, category] : calls)
+            sink = sink + colors.find(color, category, WND_TYPE_MAIN).value_or(color);
+    });
+
+    const double main_ns = main_ms * 1e6 / calls.size();
+    std::printf("%-8s %7.1f ns %10s\n", "main", main_ns, "-");
+
+    // a hit is a text color drawn into a window's memory DC, a miss a DC vmchroma doesn't own
+    // and nullptr a pen or brush, both fall back to the window whose wndproc is running
+    for (const auto& [hdc, name] : {std::pair<const void*, const char*>{comp_dc, "hit"}, {screen_dc, "miss"}, {nullptr, "nullptr"}})
+    {
+        const double ms = time_ms([&]
+        {
+            for (const auto& [color, category] : calls)
+                sink = sink + colors.find(color, category, dcs.resolve(hdc, WND_TYPE_WDB)).value_or(color);
+        });
+
+        const double ns = ms * 1e6 / calls.size();
+        std::printf("%-8s %7.1f ns %7.1f ns\n", name, ns, ns - main_ns);
+    }
+
+    return 0;
+}
+
+/**
+ * Records the colors of repaints with the color census from several threads at once, the hooks record every call
+ * while Voicemeeter's threads draw, so the counters of the frequent colors are contended
+ */
+int bench_census(const std::vector<std::string>&)
+{
+    // a repaint draws a couple of hundred colors, a few of them most of the time
+    std::vector<uint32_t> calls(4096);
+    uint32_t seed = 17;
+
+    for (auto& c : calls)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        c = (seed >> 8) % ((seed >> 30) != 0 ? 16 : 240) * 0x010307 & 0xffffff;
+    }
+
+    constexpr uint32_t ROUNDS = 64;
+    std::printf("%-7s %10s %12s\n", "threads", "record", "throughput");
+
+    for (const uint32_t thread_count : {1u, 2u, 4u, 8u})
+    {
+        color_census census({"shapes", "text"});
+
+        const double ms = time_ms([&]
+        {
+            std::vector<std::thread> threads;
+
+            for (uint32_t t = 0; t < thread_count; t++)
+            {
+                threads.emplace_back([&census, &calls, t]
+                {
+                    for (uint32_t r = 0; r < ROUNDS; r++)
+                    {
+                        for (size_t i = 0; i < calls.size(); i++)
+                            census.record(calls[i], (i + t) & 1, calls[i] & 1);
+                    }
+                });
+            }
+
+            for (auto& t : threads)
+                t.join();
+        });
+
+        const double per_thread = static_cast<double>(calls.size()) * ROUNDS;
+        std::printf("%-7u %7.1f ns %7.0f M/s\n", thread_count, ms * 1e6 / per_thread, per_thread * thread_count / ms / 1e3);
+    }
+
+    return 0;
+}
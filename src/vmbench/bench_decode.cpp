@@ -0,0 +1,673 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+#include "lz4.hpp"
+#include "png_decoder.hpp"
+#include "qoi_decoder.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+void put32_be(std::vector<uint8_t>& out, const uint32_t v)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<uint8_t>(v >> shift));
+}
+
+/**
+ * Encodes a frame as a 24 bit QOI file, following the reference encoder
+ * @param f The frame
+ * @return The file bytes
+ */
+std::vector<uint8_t> encode_qoi(const frame_t& f)
+{
+    std::vector<uint8_t> out = {'q', 'o', 'i', 'f'};
+    put32_be(out, f.width);
+    put32_be(out, f.height);
+    out.push_back(3);
+    out.push_back(0);
+
+    std::array<uint32_t, 64> index = {};
+    uint32_t prev = 0xFF000000; // RGBA as 0xAABBGGRR, opaque black
+    uint32_t run = 0;
+    const size_t count = static_cast<size_t>(f.width) * f.height;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* px = f.pixels.data() + i * 4;
+        const uint8_t r = px[2], g = px[1], b = px[0];
+        const uint32_t rgba = 0xFF000000u | b << 16 | g << 8 | r;
+
+        if (rgba == prev)
+        {
+            if (++run == 62 || i + 1 == count)
+            {
+                out.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+                run = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0)
+        {
+            out.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+            run = 0;
+        }
+
+        const uint32_t slot = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+        if (index[slot] == rgba)
+        {
+            out.push_back(static_cast<uint8_t>(slot));
+        }
+        else
+        {
+            index[slot] = rgba;
+
+            const auto dr = static_cast<int8_t>(r - (prev & 0xFF));
+            const auto dg = static_cast<int8_t>(g - (prev >> 8 & 0xFF));
+            const auto db = static_cast<int8_t>(b - (prev >> 16 & 0xFF));
+            const int dr_dg = dr - dg;
+            const int db_dg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                out.push_back(static_cast<uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            }
+            else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+            {
+                out.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+                out.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+            }
+            else
+            {
+                out.insert(out.end(), {0xFE, r, g, b});
+            }
+        }
+
+        prev = rgba;
+    }
+
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+}
+
+/**
+ * LSB-first bit writer of a deflate stream
+ */
+typedef struct bit_writer
+{
+    std::vector<uint8_t>& out;
+    uint64_t bits = 0;
+    uint32_t count = 0;
+
+    void put(const uint32_t value, const uint32_t n)
+    {
+        bits |= static_cast<uint64_t>(value) << count;
+        count += n;
+
+        while (count >= 8)
+        {
+            out.push_back(static_cast<uint8_t>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are defined MSB first
+    void put_code(const uint32_t code, const uint32_t n)
+    {
+        uint32_t reversed = 0;
+
+        for (uint32_t i = 0; i < n; i++)
+            reversed |= (code >> i & 1) << (n - 1 - i);
+
+        put(reversed, n);
+    }
+
+    void flush()
+    {
+        if (count > 0)
+            out.push_back(static_cast<uint8_t>(bits));
+
+        bits = 0;
+        count = 0;
+    }
+} bit_writer_t;
+
+void put_literal(bit_writer_t& w, const uint32_t symbol)
+{
+    if (symbol < 144)
+        w.put_code(0x30 + symbol, 8);
+    else if (symbol < 256)
+        w.put_code(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        w.put_code(symbol - 256, 7);
+    else
+        w.put_code(0xC0 + symbol - 280, 8);
+}
+
+void put_match(bit_writer_t& w, const uint32_t length, const uint32_t distance)
+{
+    static constexpr uint16_t LENGTH_BASE[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr uint8_t LENGTH_EXTRA[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr uint16_t DIST_BASE[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static constexpr uint8_t DIST_EXTRA[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    uint32_t l = 28;
+
+    while (LENGTH_BASE[l] > length)
+        l--;
+
+    put_literal(w, 257 + l);
+    w.put(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+    uint32_t d = 29;
+
+    while (DIST_BASE[d] > distance)
+        d--;
+
+    w.put_code(d, 5);
+    w.put(distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+/**
+ * Compresses into a zlib stream with one fixed Huffman block and greedy hash chain matching
+ * Smaller files than stored blocks and decoded by the same code paths, though not as small as zlib's output
+ */
+std::vector<uint8_t> zlib_compress(const std::vector<uint8_t>& data)
+{
+    constexpr uint32_t WINDOW = 32768;
+    constexpr uint32_t HASH_BITS = 15;
+    constexpr uint32_t MAX_CHAIN = 16;
+    constexpr uint32_t MAX_MATCH = 258;
+
+    std::vector<uint8_t> out = {0x78, 0x01};
+    bit_writer_t w = {out};
+    w.put(1, 1);
+    w.put(1, 2);
+
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> prev(WINDOW, -1);
+    const size_t size = data.size();
+
+    const auto hash = [&data](const size_t i) { return (static_cast<uint32_t>(data[i]) << 16 | data[i + 1] << 8 | data[i + 2]) * 0x9E3779B1u >> (32 - HASH_BITS); };
+
+    const auto insert = [&](const size_t i)
+    {
+        if (i + 3 > size)
+            return;
+
+        const uint32_t h = hash(i);
+        prev[i % WINDOW] = head[h];
+        head[h] = static_cast<int32_t>(i);
+    };
+
+    for (size_t i = 0; i < size;)
+    {
+        uint32_t best_len = 0;
+        uint32_t best_dist = 0;
+
+        if (i + 3 <= size)
+        {
+            int32_t candidate = head[hash(i)];
+
+            for (uint32_t chain = 0; candidate >= 0 && i - candidate <= WINDOW - 1 && chain < MAX_CHAIN; chain++)
+            {
+                const size_t max_len = std::min<size_t>(MAX_MATCH, size - i);
+                uint32_t len = 0;
+
+                while (len < max_len && data[candidate + len] == data[i + len])
+                    len++;
+
+                if (len > best_len)
+                {
+                    best_len = len;
+                    best_dist = static_cast<uint32_t>(i - candidate);
+                }
+
+                candidate = prev[candidate % WINDOW];
+            }
+        }
+
+        if (best_len >= 3)
+        {
+            put_match(w, best_len, best_dist);
+
+            for (uint32_t k = 0; k < best_len; k++)
+                insert(i + k);
+
+            i += best_len;
+        }
+        else
+        {
+            put_literal(w, data[i]);
+            insert(i);
+            i++;
+        }
+    }
+
+    put_literal(w, 256);
+    w.flush();
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+
+    for (const uint8_t c : data)
+    {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    put32_be(out, b << 16 | a);
+    return out;
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload)
+{
+    static const auto crc_table = []
+    {
+        std::array<uint32_t, 256> t = {};
+
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ c >> 1 : c >> 1;
+
+            t[n] = c;
+        }
+
+        return t;
+    }();
+
+    put32_be(out, static_cast<uint32_t>(payload.size()));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = start; i < out.size(); i++)
+        crc = crc_table[(crc ^ out[i]) & 0xFF] ^ crc >> 8;
+
+    put32_be(out, crc ^ 0xFFFFFFFF);
+}
+
+/**
+ * Encodes a frame as an 8 bit RGB PNG, every row with the filter that has the smallest sum of absolute values
+ * @param f The frame
+ * @return The file bytes
+ */
+std::vector<uint8_t> encode_png(const frame_t& f)
+{
+    const size_t row_bytes = static_cast<size_t>(f.width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((row_bytes + 1) * f.height);
+    std::vector<uint8_t> prev(row_bytes, 0);
+    std::vector<uint8_t> row(row_bytes);
+    std::vector<uint8_t> filtered(row_bytes);
+    std::vector<uint8_t> best(row_bytes);
+
+    for (uint32_t y = 0; y < f.height; y++)
+    {
+        for (uint32_t x = 0; x < f.width; x++)
+        {
+            const uint8_t* px = f.pixels.data() + (static_cast<size_t>(y) * f.width + x) * 4;
+            row[x * 3] = px[2];
+            row[x * 3 + 1] = px[1];
+            row[x * 3 + 2] = px[0];
+        }
+
+        uint64_t best_sum = UINT64_MAX;
+        uint8_t best_filter = 0;
+
+        for (uint8_t filter = 0; filter < 5; filter++)
+        {
+            uint64_t sum = 0;
+
+            for (size_t i = 0; i < row_bytes; i++)
+            {
+                const int a = i >= 3 ? row[i - 3] : 0;
+                const int b = prev[i];
+                const int c = i >= 3 ? prev[i - 3] : 0;
+                int predictor = 0;
+
+                if (filter == 1)
+                    predictor = a;
+                else if (filter == 2)
+                    predictor = b;
+                else if (filter == 3)
+                    predictor = (a + b) / 2;
+                else if (filter == 4)
+                {
+                    const int p = a + b - c;
+                    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                    predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                }
+
+                filtered[i] = static_cast<uint8_t>(row[i] - predictor);
+                sum += static_cast<uint64_t>(std::abs(static_cast<int8_t>(filtered[i])));
+            }
+
+            if (sum < best_sum)
+            {
+                best_sum = sum;
+                best_filter = filter;
+                best.swap(filtered);
+            }
+        }
+
+        raw.push_back(best_filter);
+        raw.insert(raw.end(), best.begin(), best.end());
+        prev.swap(row);
+        row.resize(row_bytes);
+    }
+
+    std::vector<uint8_t> ihdr;
+    put32_be(ihdr, f.width);
+    put32_be(ihdr, f.height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});
+
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    put_chunk(out, "IHDR", ihdr);
+    put_chunk(out, "IDAT", zlib_compress(raw));
+    put_chunk(out, "IEND", {});
+
+    return out;
+}
+
+/**
+ * Stores a frame the way theme authors ship bg.bmp, bottom-up 24 bpp
+ */
+std::vector<uint8_t> encode_bmp(const frame_t& f)
+{
+    auto file = bmp_decoder::create_bmp(f.width, f.height, 24);
+    const uint32_t stride = (f.width * 24 + 31) / 32 * 4;
+
+    for (uint32_t y = 0; y < f.height; y++)
+    {
+        for (uint32_t x = 0; x < f.width; x++)
+            memcpy(file.data() + 54 + static_cast<size_t>(f.height - 1 - y) * stride + x * 3, f.pixels.data() + (static_cast<size_t>(y) * f.width + x) * 4, 3);
+    }
+
+    return file;
+}
+
+/**
+ * Decodes a theme file and converts it into the 32 bpp DIB section of its size, like hk_CreateDIBSection does
+ * @param ext ".bmp", ".png" or ".qoi"
+ * @param file The file bytes
+ * @param dib Receives the pixels
+ * @return False if the file can't be decoded
+ */
+bool load_background(const std::string& ext, const std::vector<uint8_t>& file, std::vector<uint8_t>& dib)
+{
+    std::optional<std::vector<uint8_t>> decoded;
+
+    if (ext == ".png")
+        decoded = png_decoder::decode_to_bmp(file.data(), file.size());
+    else if (ext == ".qoi")
+        decoded = qoi_decoder::decode_to_bmp(file.data(), file.size());
+
+    const auto& bmp = decoded ? *decoded : file;
+    const auto info = bmp_decoder::parse(bmp.data(), bmp.size());
+
+    if (!info)
+        return false;
+
+    const dib_layout_t layout = {info->width, info->height, false, 32};
+    dib.resize(bmp_decoder::dib_size(layout));
+
+    return bmp_decoder::convert(bmp.data(), bmp.size(), *info, dib.data(), layout);
+}
+}
+
+/**
+ * Converts stored bitmaps of the main window's size into DIB sections, every source format into both targets
+ * Voicemeeter's DIBs are bottom-up like the stored files, top-down targets add the row flip
+ */
+int bench_bmp(const std::vector<std::string>&)
+{
+    const auto frame = synthetic_frame();
+
+    typedef struct source
+    {
+        const char* name;
+        uint32_t bpp;
+    } source_t;
+
+    std::printf("%ux%u bitmap\n\n", frame.width, frame.height);
+    std::printf("%-6s %-12s %9s %9s %8s %10s\n", "source", "target", "scalar", "simd", "speedup", "throughput");
+
+    for (const auto& [name, bpp] : {source_t{"rgb555", 16}, {"bgr24", 24}, {"bgrx32", 32}})
+    {
+        auto file = bmp_decoder::create_bmp(frame.width, frame.height, bpp);
+        const auto info = bmp_decoder::parse(file.data(), file.size());
+
+        if (!info)
+            return 1;
+
+        // pixel content doesn't change the cost of the kernels, the frame only keeps the numbers realistic
+        for (uint32_t y = 0; y < frame.height; y++)
+        {
+            uint8_t* row = file.data() + info->pixel_offset + static_cast<size_t>(frame.height - 1 - y) * info->stride;
+
+            for (uint32_t x = 0; x < frame.width; x++)
+            {
+                const uint8_t* px = frame.pixels.data() + (static_cast<size_t>(y) * frame.width + x) * 4;
+
+                if (bpp == 16)
+                {
+                    const auto v = static_cast<uint16_t>((px[2] >> 3) << 10 | (px[1] >> 3) << 5 | px[0] >> 3);
+                    memcpy(row + x * 2, &v, 2);
+                }
+                else
+                {
+                    memcpy(row + x * (bpp / 8), px, bpp / 8);
+                }
+            }
+        }
+
+        for (const uint32_t target_bpp : {24u, 32u})
+        {
+            for (const bool top_down : {false, true})
+            {
+                const dib_layout_t layout = {frame.width, frame.height, top_down, target_bpp};
+                std::vector<uint8_t> dib(bmp_decoder::dib_size(layout));
+
+                const double scalar_ms = time_ms([&] { bmp_decoder::convert_scalar(file.data(), file.size(), *info, dib.data(), layout); });
+                const double simd_ms = time_ms([&] { bmp_decoder::convert(file.data(), file.size(), *info, dib.data(), layout); });
+
+                char target[16];
+                std::snprintf(target, sizeof(target), "%u %s", target_bpp, top_down ? "top-down" : "bottom-up");
+                std::printf("%-6s %-12s %6.2f ms %6.2f ms %7.1fx %6.0f MB/s\n", name, target, scalar_ms, simd_ms, scalar_ms / simd_ms, dib.size() / simd_ms / 1e3);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Compares loading a theme background stored as BMP, PNG and QOI
+ * Without files the synthetic background is encoded in all three formats, files are read into memory first,
+ * the smaller compressed files save disk reads that aren't part of the numbers
+ * @param args Optional bg.bmp, bg.png or bg.qoi files
+ */
+int bench_decode(const std::vector<std::string>& args)
+{
+    typedef struct input
+    {
+        std::string name;
+        std::string ext;
+        std::vector<uint8_t> file;
+    } input_t;
+
+    std::vector<input_t> inputs;
+
+    if (args.empty())
+    {
+        const auto background = synthetic_background();
+        inputs.push_back({"synthetic.bmp", ".bmp", encode_bmp(background)});
+        inputs.push_back({"synthetic.png", ".png", encode_png(background)});
+        inputs.push_back({"synthetic.qoi", ".qoi", encode_qoi(background)});
+    }
+
+    for (const auto& arg : args)
+    {
+        const std::filesystem::path path(arg);
+        std::ifstream in(path, std::ios::binary);
+
+        if (!in.is_open())
+        {
+            SPDLOG_ERROR("can't open {}", arg);
+            return 1;
+        }
+
+        inputs.push_back({path.filename().string(), path.extension().string(), std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>())});
+    }
+
+    std::printf("%-16s %10s %9s %10s  same pixels\n", "file", "size", "load", "throughput");
+    std::vector<uint8_t> first;
+
+    for (const auto& [name, ext, file] : inputs)
+    {
+        std::vector<uint8_t> dib;
+
+        if (!load_background(ext, file, dib))
+        {
+            SPDLOG_ERROR("can't decode {}", name);
+            return 1;
+        }
+
+        if (first.empty())
+            first = dib;
+
+        const double ms = time_ms([&] { load_background(ext, file, dib); });
+        std::printf("%-16s %7.0f KB %6.2f ms %6.0f MP/s  %s\n", name.c_str(), file.size() / 1024.0, ms, dib.size() / 4 / ms / 1e3, dib == first ? "yes" : "NO");
+    }
+
+    return 0;
+}
+
+/**
+ * Compresses the synthetic main window background and decompresses it again, as themeMemory: compress does
+ * with a background once its DIB is filled and again when Voicemeeter creates the DIB another time
+ */
+int bench_lz4(const std::vector<std::string>&)
+{
+    const auto bmp = encode_bmp(synthetic_background());
+    std::vector<uint8_t> packed(lz4::compress_bound(bmp.size()));
+    std::vector<uint8_t> unpacked(bmp.size());
+    size_t packed_size = 0;
+
+    const double compress_ms = time_ms([&] { packed_size = lz4::compress(bmp.data(), bmp.size(), packed.data(), packed.size()); });
+
+    if (packed_size == 0)
+        return 1;
+
+    bool ok = true;
+    const double decompress_ms = time_ms([&] { ok = ok && lz4::decompress(packed.data(), packed_size, unpacked.data(), unpacked.size()); });
+
+    std::printf("%7.0f KB bitmap, %5.0f KB compressed, ratio %.1f:1\n\n", bmp.size() / 1024.0, packed_size / 1024.0, static_cast<double>(bmp.size()) / packed_size);
+    std::printf("%-10s %9s %10s\n", "step", "time", "throughput");
+    std::printf("%-10s %6.2f ms %6.0f MB/s\n", "compress", compress_ms, bmp.size() / compress_ms / 1e3);
+    std::printf("%-10s %6.2f ms %6.0f MB/s  same bytes %s\n", "decompress", decompress_ms, bmp.size() / decompress_ms / 1e3, ok && unpacked == bmp ? "yes" : "NO");
+
+    return 0;
+}
+
+/**
+ * Doubles a frame by repeating every pixel, which is what 2x art of pixel aligned UI looks like at 1x
+ * @param f The frame
+ * @return The frame at twice the size
+ */
+static frame_t double_frame(const frame_t& f)
+{
+    frame_t big;
+    big.width = f.width * 2;
+    big.height = f.height * 2;
+    big.pixels.resize(static_cast<size_t>(big.width) * big.height * 4);
+
+    for (uint32_t y = 0; y < big.height; y++)
+    {
+        for (uint32_t x = 0; x < big.width; x++)
+            memcpy(big.pixels.data() + (static_cast<size_t>(y) * big.width + x) * 4, f.pixels.data() + (static_cast<size_t>(y / 2) * f.width + x / 2) * 4, 4);
+    }
+
+    return big;
+}
+
+/**
+ * Resamples main window art shipped at 2x down to the native size and 1x art up to 2x, like theme_asset does at load time
+ * The error is measured against the frame drawn at the target size
+ */
+int bench_resample(const std::vector<std::string>&)
+{
+    auto frame_1x = synthetic_frame();
+    auto frame_2x = double_frame(frame_1x);
+    thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    typedef struct resample_case
+    {
+        const char* name;
+        frame_t* src;
+        frame_t* expected;
+        resample_filter filter;
+    } resample_case_t;
+
+    const resample_case_t cases[] = {
+        {"2x to 1x lanczos3", &frame_2x, &frame_1x, RESAMPLE_LANCZOS3},
+        {"1x to 2x mitchell", &frame_1x, &frame_2x, RESAMPLE_MITCHELL},
+    };
+
+    std::printf("%ux%u art, %zu threads\n\n", frame_1x.width, frame_1x.height, pool.size());
+    std::printf("%-18s %9s %9s %9s %8s\n", "resample", "scalar", "simd", "threads", "psnr");
+
+    for (const auto& [name, src, expected, filter] : cases)
+    {
+        frame_t dst;
+        dst.width = expected->width;
+        dst.height = expected->height;
+        dst.pixels.resize(expected->pixels.size());
+
+        const double scalar_ms = time_ms([&] { resampler::resize_scalar(src->view(), dst.view(), filter); });
+        const double simd_ms = time_ms([&] { resampler::resize(src->view(), dst.view(), filter); });
+        const double threads_ms = time_ms([&] { resampler::resize(src->view(), dst.view(), filter, &pool); });
+
+        double psnr = 0.0;
+        frame_error(dst, *expected, psnr);
+        std::printf("%-18s %6.1f ms %6.1f ms %6.1f ms %5.1f dB\n", name, scalar_ms, simd_ms, threads_ms, psnr);
+    }
+
+    return 0;
+}
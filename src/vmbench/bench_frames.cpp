@@ -0,0 +1,290 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "damage_tracker.hpp"
+#include "frame_scheduler.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <d3d11.h>
+#endif
+
+namespace
+{
+// the benchmark replays messages on a simulated timeline
+class manual_clock : public frame_clock
+{
+public:
+    uint64_t now = 0;
+
+    uint64_t now_us() override
+    {
+        return now;
+    }
+};
+
+typedef struct message_stream
+{
+    const char* name;
+    uint64_t step_us;
+    frame_reason reason;
+} message_stream_t;
+
+#ifdef _WIN32
+/**
+ * Times what damage tracking adds to a frame on the Direct3D path, GDI doesn't expose the pixels of the texture
+ * Voicemeeter draws into, so get_frame_bits copies them into a DIB section while the texture's DC is out
+ * @param f The frame drawn into the texture
+ * @param with_dc Receives the milliseconds of the GetDC and ReleaseDC pair every frame has
+ * @param with_readback Receives the milliseconds of the pair with the copy in between
+ * @return False if the device or the texture can't be created
+ */
+bool time_readback(const frame_t& f, double& with_dc, double& with_readback)
+{
+    ID3D11Device* device = nullptr;
+    ID3D11DeviceContext* context = nullptr;
+
+    if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, D3D11_SDK_VERSION,
+                                 &device, nullptr, &context)))
+        return false;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = f.width;
+    desc.Height = f.height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_GDI_COMPATIBLE;
+
+    ID3D11Texture2D* texture = nullptr;
+    IDXGISurface1* surface = nullptr;
+
+    if (SUCCEEDED(device->CreateTexture2D(&desc, nullptr, &texture)))
+        texture->QueryInterface(__uuidof(IDXGISurface1), reinterpret_cast<void**>(&surface));
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = static_cast<LONG>(f.width);
+    bmi.bmiHeader.biHeight = -static_cast<LONG>(f.height);
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    const HBITMAP capture = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    const HDC capture_dc = capture ? CreateCompatibleDC(nullptr) : nullptr;
+    HDC dc = nullptr;
+    bool ok = false;
+
+    if (surface && capture_dc && SUCCEEDED(surface->GetDC(FALSE, &dc)))
+    {
+        SelectObject(capture_dc, capture);
+        SetDIBitsToDevice(dc, 0, 0, f.width, f.height, 0, 0, 0, f.height, f.pixels.data(), &bmi, DIB_RGB_COLORS);
+        surface->ReleaseDC(nullptr);
+
+        // the GPU reads the texture between two frames like a present does
+        const auto frame = [&](const bool readback)
+        {
+            context->Flush();
+
+            if (FAILED(surface->GetDC(FALSE, &dc)))
+                return;
+
+            if (readback)
+            {
+                BitBlt(capture_dc, 0, 0, f.width, f.height, dc, 0, 0, SRCCOPY);
+                GdiFlush();
+            }
+
+            surface->ReleaseDC(nullptr);
+        };
+
+        with_dc = time_ms([&] { frame(false); });
+        with_readback = time_ms([&] { frame(true); });
+        ok = true;
+    }
+
+    if (capture_dc)
+        DeleteDC(capture_dc);
+
+    if (capture)
+        DeleteObject(capture);
+
+    if (surface)
+        surface->Release();
+
+    if (texture)
+        texture->Release();
+
+    context->Release();
+    device->Release();
+    return ok;
+}
+#endif
+}
+
+/**
+ * Replays one second of typical message streams through the frame scheduler and counts the presents it leaves,
+ * without it every message presents and waits for vsync
+ * @param args Unused
+ */
+int bench_frames(const std::vector<std::string>&)
+{
+    constexpr uint64_t interval_us = 16000;
+    constexpr uint64_t duration_us = 1000000;
+
+    constexpr message_stream_t streams[] = {
+        {"64 Hz timer", 15625, FRAME_TIMER},
+        {"1 kHz drag", 1000, FRAME_DRAG},
+        {"125 Hz wheel", 8000, FRAME_INPUT},
+        {"1 kHz wheel", 1000, FRAME_INPUT},
+    };
+
+    std::printf("updateIntervalUI 16 ms, one second of messages per stream\n\n");
+    std::printf("stream        requests  presents  input forced  per request\n");
+
+    for (const auto& [name, step_us, reason] : streams)
+    {
+        manual_clock clock;
+        frame_scheduler frames(clock, interval_us);
+        uintptr_t window = 1;
+
+        for (; clock.now < duration_us; clock.now += step_us)
+            frames.request(window, reason);
+
+        const auto stats = frames.get_stats();
+
+        // a fresh window per run keeps the map from growing, the first request always presents
+        const double ns = time_ms([&]
+        {
+            frames.forget(window);
+            window++;
+
+            for (uint32_t i = 0; i < 1000; i++)
+            {
+                clock.now += step_us;
+                frames.request(window, reason);
+            }
+        }) * 1000.0;
+
+        std::printf("%-12s  %8llu  %8llu  %12llu  %8.1f ns\n", name, static_cast<unsigned long long>(stats.requests),
+                    static_cast<unsigned long long>(stats.presented), static_cast<unsigned long long>(stats.input_forced), ns);
+    }
+
+    return 0;
+}
+
+/**
+ * Tracks the damage of animated main window frames at the default window size, the cost damageTracking adds per frame
+ * On Windows the copy of the frame out of the Direct3D texture it needs for that is measured as well
+ * @param args Unused
+ */
+int bench_damage(const std::vector<std::string>&)
+{
+    constexpr uint32_t FRAMES = 60;
+    constexpr size_t MAX_RECTS = 8;
+    constexpr uint32_t TILE = damage_tracker::TILE_SIZE;
+
+    const auto background = synthetic_background();
+    std::vector<frame_t> frames(FRAMES, background);
+
+    for (uint32_t i = 0; i < FRAMES; i++)
+        draw_overlay(frames[i], i);
+
+    const uint32_t width = background.width;
+    const uint32_t height = background.height;
+    const auto stride = static_cast<ptrdiff_t>(width) * 4;
+
+    const auto hash_tiles = [&](const uint8_t* bits, uint32_t (*hash)(const uint8_t*, ptrdiff_t, uint32_t, uint32_t))
+    {
+        uint32_t h = 0;
+
+        for (uint32_t y = 0; y < height; y += TILE)
+        {
+            for (uint32_t x = 0; x < width; x += TILE)
+                h ^= hash(bits + static_cast<ptrdiff_t>(y) * stride + x * 4, stride, std::min(TILE, width - x), std::min(TILE, height - y));
+        }
+
+        return h;
+    };
+
+    volatile uint32_t sink = 0;
+    const double scalar_ms = time_ms([&] { sink = sink + hash_tiles(frames[0].pixels.data(), tile_hash::hash_scalar); });
+    const double simd_ms = time_ms([&] { sink = sink + hash_tiles(frames[0].pixels.data(), tile_hash::hash); });
+
+    damage_tracker tracker;
+    tracker.resize(width, height);
+    tracker.update(frames[0].pixels.data(), stride);
+
+    uint32_t frame = 0;
+    size_t dirty_tiles = 0;
+    uint32_t measured = 0;
+
+    // the frames rotate, so their pixels come from memory like those of a frame GDI drew a while ago
+    const double update_ms = time_ms([&]
+    {
+        frame = (frame + 1) % FRAMES;
+        dirty_tiles += tracker.update(frames[frame].pixels.data(), stride);
+        measured++;
+    });
+
+    // merging is measured on one frame's tiles, the coverage over the whole animation
+    const double rects_ms = time_ms([&] { sink = sink + static_cast<uint32_t>(tracker.rects(MAX_RECTS).size()); });
+    uint64_t rect_area = 0;
+    size_t rect_count = 0;
+
+    for (uint32_t i = 1; i <= FRAMES; i++)
+    {
+        tracker.update(frames[(frame + i) % FRAMES].pixels.data(), stride);
+
+        for (const auto& r : tracker.rects(MAX_RECTS))
+        {
+            rect_area += static_cast<uint64_t>(r.right - r.left) * (r.bottom - r.top);
+            rect_count++;
+        }
+    }
+
+    tracker.update(frames[frame].pixels.data(), stride);
+    const double unchanged_ms = time_ms([&] { tracker.update(frames[frame].pixels.data(), stride); });
+
+    std::printf("%ux%u frame, %zu tiles of %ux%u, %u animated frames\n\n", width, height, tracker.get_tile_count(), TILE, TILE, FRAMES);
+    std::printf("hash all tiles   scalar %.3f ms  SIMD %.3f ms\n", scalar_ms, simd_ms);
+    std::printf("update           %.3f ms per frame, %.1f tiles changed on average\n", update_ms, dirty_tiles / static_cast<double>(measured));
+    std::printf("unchanged frame  %.3f ms\n", unchanged_ms);
+    std::printf("rects            %.3f ms per frame, %.1f rectangles covering %.1f%% of the frame on average\n", rects_ms,
+                rect_count / static_cast<double>(FRAMES), 100.0 * rect_area / FRAMES / (static_cast<double>(width) * height));
+
+#ifdef _WIN32
+    double with_dc = 0.0;
+    double with_readback = 0.0;
+
+    if (time_readback(frames[0], with_dc, with_readback))
+        std::printf("GPU readback     %.3f ms per frame, GetDC and ReleaseDC alone %.3f ms\n", with_readback - with_dc, with_dc);
+    else
+        std::printf("GPU readback     no Direct3D 11 device\n");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "bitmap_recolor.hpp"
+#include "color_grade.hpp"
+#include "pixel_hash.hpp"
+#include "sprite_index.hpp"
+
+/**
+ * Converts a frame to the 24 bpp bottom-up layout Voicemeeter creates most of its bitmaps in
+ * @param f The frame
+ * @return The rows, padded to dib_stride
+ */
+static std::vector<uint8_t> to_dib24(const frame_t& f)
+{
+    const auto stride = bitmap_recolor::dib_stride(f.width, 24);
+    std::vector<uint8_t> dib(static_cast<size_t>(stride) * f.height);
+
+    for (uint32_t y = 0; y < f.height; y++)
+    {
+        for (uint32_t x = 0; x < f.width; x++)
+            memcpy(dib.data() + static_cast<size_t>(f.height - 1 - y) * stride + x * 3, f.pixels.data() + (static_cast<size_t>(y) * f.width + x) * 4, 3);
+    }
+
+    return dib;
+}
+
+/**
+ * Recolors the synthetic main window background the way palette mode does at load time
+ * Every run starts from a fresh copy, the copy is timed separately and subtracted
+ */
+int bench_recolor(const std::vector<std::string>&)
+{
+    const auto frame = synthetic_frame();
+
+    color_map_t map;
+    map.table.insert(0x362E2A, 0x102030);
+    map.table.insert(0x80706A, 0x405060);
+    map.table.insert(0x101010, 0x000000);
+    map.table.insert(0xE8E8E8, 0xF0E0D0);
+
+    color_rule_t rule = {};
+    rule.type = RULE_HUE_ROTATE;
+    rule.amount = 200.0f;
+    color_map_t lut_map = map;
+    lut_map.lut.bake({rule}, LUT_NEAREST);
+
+    std::printf("%ux%u background, copy time subtracted\n\n", frame.width, frame.height);
+    std::printf("%-6s %-6s %9s %9s %8s\n", "format", "map", "scalar", "simd", "speedup");
+
+    for (const uint32_t bpp : {24u, 32u})
+    {
+        const auto source = bpp == 24 ? to_dib24(frame) : frame.pixels;
+        const auto stride = bitmap_recolor::dib_stride(frame.width, bpp);
+        std::vector<uint8_t> bits(source.size());
+
+        const double copy_ms = time_ms([&] { memcpy(bits.data(), source.data(), source.size()); });
+
+        for (const auto& [m, name] : {std::pair<const color_map_t*, const char*>{&map, "table"}, {&lut_map, "rules"}})
+        {
+            const double scalar_ms = time_ms([&]
+            {
+                memcpy(bits.data(), source.data(), source.size());
+                bitmap_recolor::apply_scalar(bits.data(), frame.width, frame.height, stride, bpp, *m);
+            }) - copy_ms;
+
+            const double simd_ms = time_ms([&]
+            {
+                memcpy(bits.data(), source.data(), source.size());
+                bitmap_recolor::apply(bits.data(), frame.width, frame.height, stride, bpp, *m);
+            }) - copy_ms;
+
+            std::printf("%u bpp %-6s %6.2f ms %6.2f ms %7.1fx\n", bpp, name, scalar_ms, simd_ms, scalar_ms / simd_ms);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Grades whole main window frames like the software renderer does before presenting them
+ * Every run starts from a fresh copy, the copy is timed separately and subtracted
+ */
+int bench_grade(const std::vector<std::string>&)
+{
+    const auto frame = synthetic_frame();
+    const double mpix = frame.width * frame.height / 1e6;
+    std::vector<uint8_t> bits(frame.pixels.size());
+
+    grade_settings_t settings;
+    settings.gamma = 1.2f;
+    settings.night_mode = 0.6f;
+    color_grade grade;
+    grade.build(settings);
+
+    const double copy_ms = time_ms([&] { memcpy(bits.data(), frame.pixels.data(), bits.size()); });
+
+    const double scalar_ms = time_ms([&]
+    {
+        memcpy(bits.data(), frame.pixels.data(), bits.size());
+        grade.apply_scalar(bits.data(), frame.width, frame.height, frame.width * 4);
+    }) - copy_ms;
+
+    const double simd_ms = time_ms([&]
+    {
+        memcpy(bits.data(), frame.pixels.data(), bits.size());
+        grade.apply(bits.data(), frame.width, frame.height, frame.width * 4);
+    }) - copy_ms;
+
+    std::printf("%ux%u frame, gamma %.1f, night mode %.1f, copy time subtracted\n\n", frame.width, frame.height, settings.gamma, settings.night_mode);
+    std::printf("%-7s %9s %11s\n", "kernel", "time", "throughput");
+    std::printf("%-7s %6.2f ms %6.0f MP/s\n", "scalar", scalar_ms, mpix / scalar_ms * 1e3);
+    std::printf("%-7s %6.2f ms %6.0f MP/s\n", "simd", simd_ms, mpix / simd_ms * 1e3);
+
+    return 0;
+}
+
+/**
+ * Fingerprints bitmaps the way sprite replacement does when Voicemeeter selects a freshly filled DIB
+ * The size check runs for every DIB Voicemeeter creates, the hash and lookup only for sizes a sprite has
+ */
+int bench_sprites(const std::vector<std::string>&)
+{
+    const auto frame = synthetic_frame();
+    const auto dib24 = to_dib24(frame);
+    const double mb = frame.pixels.size() / 1e6;
+
+    std::printf("%ux%u bitmap\n\n", frame.width, frame.height);
+    std::printf("%-16s %9s %11s\n", "hash", "time", "throughput");
+
+    const double scalar_ms = time_ms([&] { pixel_hash::xxh32_scalar(frame.pixels.data(), frame.pixels.size()); });
+    const double simd_ms = time_ms([&] { pixel_hash::xxh32(frame.pixels.data(), frame.pixels.size()); });
+    const double dib24_ms = time_ms([&] { pixel_hash::dib(dib24.data(), frame.width, frame.height, bitmap_recolor::dib_stride(frame.width, 24), 24); });
+
+    std::printf("%-16s %6.2f ms %6.0f MB/s\n", "32 bpp scalar", scalar_ms, mb / scalar_ms * 1e3);
+    std::printf("%-16s %6.2f ms %6.0f MB/s\n", "32 bpp simd", simd_ms, mb / simd_ms * 1e3);
+    std::printf("%-16s %6.2f ms %6.0f MB/s\n", "24 bpp per row", dib24_ms, dib24.size() / 1e6 / dib24_ms * 1e3);
+
+    // a theme replacing 200 sprites in 20 sizes, probed with the sizes of Voicemeeter's bitmaps, most of which have none
+    sprite_index index;
+
+    for (uint32_t i = 0; i < 200; i++)
+        index.insert({16 + i % 20 * 4, 16 + i % 20 * 2, 32, i * 2654435761u}, i);
+
+    std::vector<sprite_key_t> probes;
+
+    for (uint32_t i = 0; i < 10000; i++)
+        probes.push_back({16 + i % 100 * 4, 16 + i % 100 * 2, i % 3 == 0 ? 24u : 32u, i % 400 * 2654435761u});
+
+    size_t sized = 0, found = 0;
+
+    const double size_ms = time_ms([&]
+    {
+        sized = 0;
+
+        for (const auto& key : probes)
+            sized += index.has_dimensions(key.width, key.height, key.bpp);
+    });
+
+    const double find_ms = time_ms([&]
+    {
+        found = 0;
+
+        for (const auto& key : probes)
+            found += index.find(key).has_value();
+    });
+
+    std::printf("\n%zu sprites, %zu bitmaps, %zu of them with a sprite size, %zu replaced\n", index.size(), probes.size(), sized, found);
+    std::printf("%-16s %6.1f ns per bitmap\n", "size check", size_ms * 1e6 / probes.size());
+    std::printf("%-16s %6.1f ns per bitmap\n", "lookup", find_ms * 1e6 / probes.size());
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "frame_layers.hpp"
+#include "frame_scaler.hpp"
+#include "mip_chain.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Scales a frame to every zoom with every filter, the error is measured against a Lanczos3 resample in float
+ * @param args Optional frame at the default window size, a synthetic one otherwise
+ */
+int bench_scaling(const std::vector<std::string>& args)
+{
+    auto frame = !args.empty() ? load_frame(args[0]) : synthetic_frame();
+
+    if (!frame)
+        return 1;
+
+    auto& src = *frame;
+
+    constexpr std::pair<frame_filter, const char*> filters[] = {
+        {FRAME_FILTER_NEAREST, "nearest"},
+        {FRAME_FILTER_BILINEAR, "bilinear"},
+        {FRAME_FILTER_CUBIC, "cubic"},
+        {FRAME_FILTER_HQ_CUBIC, "hq cubic"},
+        {FRAME_FILTER_AUTO, "auto"},
+    };
+
+    const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_pool pool(threads);
+
+    std::printf("%ux%u frame, error against Lanczos3, %u threads\n\n", src.width, src.height, threads);
+    std::printf("zoom  filter     1 thread  %2u threads  mean error  PSNR\n", threads);
+
+    for (const float zoom : ZOOMS)
+    {
+        frame_t reference;
+        reference.width = std::max(1u, static_cast<uint32_t>(std::lround(src.width * zoom)));
+        reference.height = std::max(1u, static_cast<uint32_t>(std::lround(src.height * zoom)));
+        reference.pixels.resize(static_cast<size_t>(reference.width) * reference.height * 4);
+
+        if (zoom == 1.0f)
+            reference.pixels = src.pixels;
+        else
+            resampler::resize(src.view(), reference.view(), RESAMPLE_LANCZOS3, &pool);
+
+        for (const auto& [filter, name] : filters)
+        {
+            frame_t out = reference;
+            frame_scaler scaler;
+
+            // the first, untimed run builds the tables, like the first frame after a resize
+            const double single = time_ms([&] { scaler.scale(src.view(), out.view(), filter, nullptr); });
+            const double pooled = time_ms([&] { scaler.scale(src.view(), out.view(), filter, &pool); });
+            double psnr = 0.0;
+            const double error = frame_error(out, reference, psnr);
+
+            std::printf("%3.0f%%  %-9s %6.2f ms   %6.2f ms      %6.3f  %5.1f dB\n", zoom * 100, name, single, pooled, error, psnr);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Measures the scaling core of the software renderer over the zoom range WM_SIZING allows, with the bilinear
+ * and the high quality cubic kernel, scalar, SIMD on one thread and SIMD with the rows split across pools
+ * @param args Optional frame at the default window size, a synthetic one otherwise
+ */
+int bench_software(const std::vector<std::string>& args)
+{
+    auto frame = !args.empty() ? load_frame(args[0]) : synthetic_frame();
+
+    if (!frame)
+        return 1;
+
+    auto& src = *frame;
+
+    std::vector<uint32_t> thread_counts = {2, 4};
+    const uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    if (hardware > 4)
+        thread_counts.push_back(hardware);
+
+    std::vector<std::unique_ptr<thread_pool>> pools;
+
+    for (const auto count : thread_counts)
+        pools.push_back(std::make_unique<thread_pool>(count));
+
+    std::printf("%ux%u frame, %u hardware threads\n\n", src.width, src.height, hardware);
+    std::printf("zoom  filter      scalar      simd");
+
+    for (const auto count : thread_counts)
+        std::printf("  %2u threads", count);
+
+    std::printf("  same as scalar\n");
+
+    for (const float zoom : ZOOMS)
+    {
+        frame_t out;
+        out.width = std::max(1u, static_cast<uint32_t>(std::lround(src.width * zoom)));
+        out.height = std::max(1u, static_cast<uint32_t>(std::lround(src.height * zoom)));
+        out.pixels.resize(static_cast<size_t>(out.width) * out.height * 4);
+        frame_t reference = out;
+
+        for (const auto& [filter, name] : {std::pair<frame_filter, const char*>{FRAME_FILTER_BILINEAR, "bilinear"}, {FRAME_FILTER_HQ_CUBIC, "hq cubic"}})
+        {
+            frame_scaler scaler;
+
+            // the first, untimed run builds the tables, like the first frame after a resize
+            const double scalar_ms = time_ms([&] { scaler.scale_scalar(src.view(), reference.view(), filter); });
+            const double simd_ms = time_ms([&] { scaler.scale(src.view(), out.view(), filter, nullptr); });
+            bool same = out.pixels == reference.pixels;
+
+            std::printf("%3.0f%%  %-9s %6.2f ms %6.2f ms", zoom * 100, name, scalar_ms, simd_ms);
+
+            for (auto& pool : pools)
+            {
+                std::printf("  %6.2f ms", time_ms([&] { scaler.scale(src.view(), out.view(), filter, pool.get()); }));
+                same = same && out.pixels == reference.pixels;
+            }
+
+            std::printf("  %s\n", same ? "yes" : "NO");
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Scales animated frames whole and from the layers, at every zoom with the auto filter
+ * Every composited frame is checked against the whole scale, scaled is the share of output pixels that had to be scaled
+ */
+int bench_layers(const std::vector<std::string>&)
+{
+    constexpr uint32_t FRAMES = 60;
+
+    const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_pool pool(threads);
+    auto background = synthetic_background();
+    std::vector<frame_t> frames(FRAMES, background);
+
+    for (uint32_t i = 0; i < FRAMES; i++)
+        draw_overlay(frames[i], i);
+
+    frame_layers split_only;
+    split_only.set_background(background.view());
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+
+    for (auto& f : frames)
+        split_only.split(f.view());
+
+    const double split_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / FRAMES;
+
+    std::printf("%ux%u frame, %u animated frames, auto filter, %u threads\n", background.width, background.height, FRAMES, threads);
+    std::printf("split into %zu overlay rectangles in %.2f ms per frame\n\n", split_only.get_overlay_rects().size(), split_ms);
+    std::printf("zoom  whole 1 thread  layers 1 thread  whole %2u threads  layers %2u threads  scaled  identical\n", threads, threads);
+
+    for (const float zoom : ZOOMS)
+    {
+        frame_t whole;
+        whole.width = std::max(1u, static_cast<uint32_t>(std::lround(background.width * zoom)));
+        whole.height = std::max(1u, static_cast<uint32_t>(std::lround(background.height * zoom)));
+        whole.pixels.resize(static_cast<size_t>(whole.width) * whole.height * 4);
+        frame_t layered = whole;
+
+        double ms[4] = {};
+        frame_layers_stats_t stats = {};
+
+        for (uint32_t run = 0; run < 4; run++)
+        {
+            thread_pool* p = run < 2 ? nullptr : &pool;
+            frame_scaler scaler;
+            frame_layers layers;
+            layers.set_background(background.view());
+            std::vector<damage_rect_t> written;
+            bool full = false;
+
+            start = clock::now();
+
+            for (auto& f : frames)
+            {
+                if (run % 2 == 0)
+                    scaler.scale(f.view(), whole.view(), FRAME_FILTER_AUTO, p);
+                else
+                    layers.composite(f.view(), layered.view(), FRAME_FILTER_AUTO, p, written, full);
+            }
+
+            ms[run] = std::chrono::duration<double, std::milli>(clock::now() - start).count() / FRAMES;
+
+            if (run == 1)
+                stats = layers.get_stats();
+        }
+
+        // every composited frame has to match the whole scale, also with the rows split across the pool
+        frame_scaler scaler;
+        frame_layers layers;
+        layers.set_background(background.view());
+        std::vector<damage_rect_t> written;
+        bool full = false;
+
+        bool identical = true;
+
+        for (uint32_t i = 0; i < FRAMES && identical; i++)
+        {
+            scaler.scale(frames[i].view(), whole.view(), FRAME_FILTER_AUTO, &pool);
+            layers.composite(frames[i].view(), layered.view(), FRAME_FILTER_AUTO, &pool, written, full);
+            identical = whole.pixels == layered.pixels;
+        }
+
+        const double scaled = stats.output_pixels ? 100.0 * stats.scaled_pixels / stats.output_pixels : 0.0;
+
+        std::printf("%3.0f%%  %8.2f ms     %8.2f ms      %8.2f ms      %8.2f ms      %5.1f%%  %s\n",
+                    zoom * 100, ms[0], ms[1], ms[2], ms[3], scaled, identical ? "yes" : "NO");
+    }
+
+    return 0;
+}
+
+/**
+ * Compares drawing a shrunk frame with the auto filter with mipScaling, which builds the prefiltered level
+ * and draws it with the bilinear filter, per frame like the software renderer does
+ * The error is measured against a Lanczos3 resample in float, like bench_scaling
+ */
+int bench_mip(const std::vector<std::string>&)
+{
+    auto src = synthetic_frame();
+    const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_pool pool(threads);
+
+    std::printf("%ux%u frame, error against Lanczos3, %u threads\n\n", src.width, src.height, threads);
+    std::printf("zoom  level  auto       mip        mip build  auto PSNR  mip PSNR\n");
+
+    for (const float zoom : ZOOMS)
+    {
+        frame_t reference;
+        reference.width = std::max(1u, static_cast<uint32_t>(std::lround(src.width * zoom)));
+        reference.height = std::max(1u, static_cast<uint32_t>(std::lround(src.height * zoom)));
+        reference.pixels.resize(static_cast<size_t>(reference.width) * reference.height * 4);
+        resampler::resize(src.view(), reference.view(), RESAMPLE_LANCZOS3, &pool);
+
+        const size_t level = mip_chain::pick_level(zoom);
+        frame_t level_frame;
+        level_frame.width = mip_chain::level_extent(src.width, level);
+        level_frame.height = mip_chain::level_extent(src.height, level);
+        level_frame.pixels.resize(static_cast<size_t>(level_frame.width) * level_frame.height * 4);
+
+        frame_t direct = reference;
+        frame_t mip = reference;
+        frame_scaler direct_scaler;
+        frame_scaler mip_scaler;
+
+        const double direct_ms = time_ms([&] { direct_scaler.scale(src.view(), direct.view(), FRAME_FILTER_AUTO, &pool); });
+
+        const double build_ms = level == 0 ? 0.0 : time_ms([&] { mip_chain::build_level(src.view(), level_frame.view(), level, &pool); });
+
+        const double mip_ms = time_ms([&]
+        {
+            if (level != 0)
+                mip_chain::build_level(src.view(), level_frame.view(), level, &pool);
+
+            mip_scaler.scale(level != 0 ? level_frame.view() : src.view(), mip.view(), FRAME_FILTER_BILINEAR, &pool);
+        });
+
+        double direct_psnr = 0.0;
+        double mip_psnr = 0.0;
+        frame_error(direct, reference, direct_psnr);
+        frame_error(mip, reference, mip_psnr);
+
+        std::printf("%3.0f%%  %5.0f%%  %6.2f ms  %6.2f ms  %6.2f ms  %6.1f dB  %5.1f dB\n",
+                    zoom * 100, mip_chain::LEVEL_SCALES[level] * 100, direct_ms, mip_ms, build_ms, direct_psnr, mip_psnr);
+    }
+
+    return 0;
+}
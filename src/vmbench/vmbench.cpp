@@ -0,0 +1,308 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vmbench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+#include "png_decoder.hpp"
+#include "qoi_decoder.hpp"
+
+/**
+ * vmbench measures the CPU reference kernels of the renderer, so defaults can be picked for slow machines
+ * It runs on any OS, the kernels are the same ones the software renderer uses
+ *
+ * usage: vmbench scaling [frame.bmp|.png|.qoi]
+ * Without a frame a synthetic one with panels, gradients, thin lines and small text-like strokes is used,
+ * a screenshot of a themed Voicemeeter window gives the most realistic numbers
+ *
+ * usage: vmbench software [frame.bmp|.png|.qoi]
+ * Measures the bilinear and high quality cubic scaling of the software renderer, scalar, SIMD and split across threads
+ *
+ * usage: vmbench layers
+ * Compares scaling animated synthetic frames whole with compositing them from the cached background
+ *
+ * usage: vmbench mip
+ * Compares shrinking frames with the auto filter with building the mipScaling level and drawing it bilinear
+ *
+ * usage: vmbench frames
+ * Replays timer, drag and wheel message streams through the frame scheduler and counts the presents left
+ *
+ * usage: vmbench damage
+ * Tracks the changed tiles of animated frames, on Windows also the readback of the frame from its Direct3D texture
+ *
+ * usage: vmbench colors [colors.yaml]
+ * Compares the per-call color lookup of the hooks before and after colors.yaml was compiled into tables
+ *
+ * usage: vmbench windows
+ * Resolves the window of each color through the memory DC index and compares the per-window lookup with the main-only one
+ *
+ * usage: vmbench census
+ * Records hook calls in the color census from 1 to 8 threads at once
+ *
+ * usage: vmbench lut
+ * Bakes color rules into the lookup table and maps colors through it
+ *
+ * usage: vmbench recolor
+ * Recolors a main window background in place with the scalar and the SSE2/AVX2 kernel of palette mode
+ *
+ * usage: vmbench grade
+ * Grades main window frames with the byte-wise reference and the AVX2 kernel
+ *
+ * usage: vmbench sprites
+ * Fingerprints bitmaps with the scalar and SSE4.1 XXH32 and looks them up in a theme's sprite index
+ *
+ * usage: vmbench bmp
+ * Converts stored 16, 24 and 32 bpp bitmaps into 24 and 32 bpp DIB sections in either row order
+ *
+ * usage: vmbench decode [bg.bmp|.png|.qoi ...]
+ * Compares loading a background stored as BMP, PNG and QOI into the DIB section Voicemeeter draws from
+ *
+ * usage: vmbench lz4
+ * Compresses a main window background with LZ4 and decompresses it, the round trip of themeMemory: compress
+ *
+ * usage: vmbench resample
+ * Resamples 2x art to the native size and back up with the scalar, SIMD and threaded resampler and prints the error
+ */
+
+/**
+ * Loads a BMP, PNG or QOI file as a top-down 32 bpp frame
+ * @param path The file
+ * @return The frame or std::nullopt if it can't be read or decoded
+ */
+std::optional<frame_t> load_frame(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in.is_open())
+    {
+        SPDLOG_ERROR("can't open {}", path.string());
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const auto ext = path.extension().string();
+
+    if (ext == ".png" || ext == ".qoi")
+    {
+        auto bmp = ext == ".png" ? png_decoder::decode_to_bmp(file.data(), file.size()) : qoi_decoder::decode_to_bmp(file.data(), file.size());
+
+        if (!bmp)
+        {
+            SPDLOG_ERROR("can't decode {}", path.string());
+            return std::nullopt;
+        }
+
+        file = std::move(*bmp);
+    }
+
+    const auto info = bmp_decoder::parse(file.data(), file.size());
+
+    if (!info)
+    {
+        SPDLOG_ERROR("{} is not a valid image", path.string());
+        return std::nullopt;
+    }
+
+    frame_t f;
+    f.width = info->width;
+    f.height = info->height;
+    f.pixels.resize(static_cast<size_t>(f.width) * f.height * 4);
+
+    if (!bmp_decoder::convert(file.data(), file.size(), *info, f.pixels.data(), {f.width, f.height, true, 32}))
+        return std::nullopt;
+
+    return f;
+}
+
+// fills a rectangle, clipped to the frame
+void fill(frame_t& f, const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1, const uint32_t color)
+{
+    for (uint32_t y = y0; y < std::min(y1, f.height); y++)
+    {
+        for (uint32_t x = x0; x < std::min(x1, f.width); x++)
+            memcpy(f.pixels.data() + (static_cast<size_t>(y) * f.width + x) * 4, &color, 4);
+    }
+}
+
+/**
+ * Draws a theme background at the default size of Voicemeeter's main window, a gradient with a panel per strip
+ * @return The background
+ */
+frame_t synthetic_background()
+{
+    frame_t f;
+    f.width = 1645;
+    f.height = 835;
+    f.pixels.resize(static_cast<size_t>(f.width) * f.height * 4);
+
+    for (uint32_t y = 0; y < f.height; y++)
+    {
+        const auto v = static_cast<uint8_t>(24 + y * 32 / f.height);
+        fill(f, 0, y, f.width, y + 1, 0xff000000u | v << 16 | v << 8 | (v + 8));
+    }
+
+    for (uint32_t strip = 0; strip < 12; strip++)
+    {
+        const uint32_t x0 = 8 + strip * 136;
+        fill(f, x0, 8, x0 + 128, 640, 0xff2a2e36u);
+        fill(f, x0, 8, x0 + 128, 9, 0xff6a7080u);
+        fill(f, x0, 639, x0 + 128, 640, 0xff6a7080u);
+        fill(f, x0, 8, x0 + 1, 640, 0xff6a7080u);
+        fill(f, x0 + 127, 8, x0 + 128, 640, 0xff6a7080u);
+        fill(f, x0 + 80, 200, x0 + 83, 600, 0xff101010u);
+    }
+
+    return f;
+}
+
+/**
+ * Draws what Voicemeeter draws over the background: labels, meters and fader knobs
+ * @param f Frame holding the background
+ * @param tick Animation step, moves the meters and some of the knobs
+ */
+void draw_overlay(frame_t& f, const uint32_t tick)
+{
+    uint32_t seed = 1;
+
+    const auto random = [&seed]
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+
+    for (uint32_t strip = 0; strip < 12; strip++)
+    {
+        const uint32_t x0 = 8 + strip * 136;
+
+        // one pixel strokes in glyph sized cells, the labels don't change
+        for (uint32_t line = 0; line < 6; line++)
+        {
+            for (uint32_t c = 0; c < 14; c++)
+            {
+                const uint32_t gx = x0 + 6 + c * 8;
+                const uint32_t gy = 20 + line * 14;
+
+                for (uint32_t s = 0; s < 4; s++)
+                {
+                    if (random() % 2)
+                        fill(f, gx + random() % 5, gy, gx + random() % 5 + 1, gy + 9, 0xffe8e8e8u);
+                    else
+                        fill(f, gx, gy + random() % 9, gx + 6, gy + random() % 9 + 1, 0xffe8e8e8u);
+                }
+            }
+        }
+
+        for (uint32_t m = 0; m < 4; m++)
+        {
+            const uint32_t level = (random() + tick * (37 + strip * 11 + m * 5)) % 400;
+            fill(f, x0 + 10 + m * 6, 600 - level, x0 + 14 + m * 6, 600, m < 2 ? 0xff30d060u : 0xffd0c030u);
+        }
+
+        const uint32_t knob = 380 + (random() + (strip % 3 == 0 ? tick * 3 : 0)) % 150;
+        fill(f, x0 + 70, knob, x0 + 94, knob + 24, 0xffc0c4ccu);
+    }
+}
+
+/**
+ * Draws a frame that resembles Voicemeeter's main window at its default size
+ * @return The frame
+ */
+frame_t synthetic_frame()
+{
+    auto f = synthetic_background();
+    draw_overlay(f, 0);
+    return f;
+}
+
+/**
+ * Compares a frame against the reference
+ * @param psnr Receives the peak signal to noise ratio in dB, 99 for identical frames
+ * @return Mean absolute error per channel
+ */
+double frame_error(const frame_t& a, const frame_t& b, double& psnr)
+{
+    double abs_sum = 0.0;
+    double sq_sum = 0.0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < a.pixels.size(); i += 4)
+    {
+        for (size_t c = 0; c < 3; c++, n++)
+        {
+            const double d = static_cast<double>(a.pixels[i + c]) - b.pixels[i + c];
+            abs_sum += std::abs(d);
+            sq_sum += d * d;
+        }
+    }
+
+    psnr = sq_sum == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / (sq_sum / n));
+    return abs_sum / n;
+}
+
+typedef struct benchmark
+{
+    const char* name;
+    int (*run)(const std::vector<std::string>& args);
+    const char* usage;
+} benchmark_t;
+
+constexpr benchmark_t benchmarks[] = {
+    {"scaling", bench_scaling, "[frame.bmp|.png|.qoi]"},
+    {"software", bench_software, "[frame.bmp|.png|.qoi]"},
+    {"layers", bench_layers, ""},
+    {"mip", bench_mip, ""},
+    {"frames", bench_frames, ""},
+    {"damage", bench_damage, ""},
+    {"colors", bench_colors, "[colors.yaml]"},
+    {"windows", bench_windows, ""},
+    {"census", bench_census, ""},
+    {"lut", bench_lut, ""},
+    {"recolor", bench_recolor, ""},
+    {"grade", bench_grade, ""},
+    {"sprites", bench_sprites, ""},
+    {"bmp", bench_bmp, ""},
+    {"decode", bench_decode, "[bg.bmp|.png|.qoi ...]"},
+    {"lz4", bench_lz4, ""},
+    {"resample", bench_resample, ""},
+};
+
+int main(int argc, char* argv[])
+{
+    spdlog::set_pattern("%l: %v");
+
+    const std::string mode = argc > 1 ? argv[1] : "";
+    const std::vector<std::string> args(argv + std::min(argc, 2), argv + argc);
+
+    for (const auto& [name, run, usage] : benchmarks)
+    {
+        if (mode == name)
+            return run(args);
+    }
+
+    for (const auto& [name, run, usage] : benchmarks)
+        std::fprintf(stderr, "%s vmbench %s%s%s\n", &name == &benchmarks[0].name ? "usage:" : "      ", name, *usage ? " " : "", usage);
+
+    return 1;
+}
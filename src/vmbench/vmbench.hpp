@@ -0,0 +1,91 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "resampler.hpp"
+
+typedef struct frame
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels; // top-down BGRX
+
+    image_view_t view()
+    {
+        return {pixels.data(), width, height, width * 4, 4};
+    }
+} frame_t;
+
+// the zoom range the main window can be resized to
+inline constexpr float ZOOMS[] = {1.0f, 0.95f, 0.9f, 0.8f, 0.75f, 0.66f, 0.5f};
+
+std::optional<frame_t> load_frame(const std::filesystem::path& path);
+void fill(frame_t& f, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t color);
+frame_t synthetic_background();
+void draw_overlay(frame_t& f, uint32_t tick);
+frame_t synthetic_frame();
+double frame_error(const frame_t& a, const frame_t& b, double& psnr);
+
+/**
+ * Runs a function repeatedly, at least 10 times and for at least 300 ms, after one untimed run
+ * @param run The function to measure
+ * @return Milliseconds per run
+ */
+template <typename F>
+double time_ms(F&& run)
+{
+    run();
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    uint32_t runs = 0;
+
+    while (runs < 10 || clock::now() - start < std::chrono::milliseconds(300))
+    {
+        run();
+        runs++;
+    }
+
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count() / runs;
+}
+
+// every benchmark gets the arguments after its name and returns the exit code
+int bench_scaling(const std::vector<std::string>& args);
+int bench_software(const std::vector<std::string>& args);
+int bench_layers(const std::vector<std::string>& args);
+int bench_mip(const std::vector<std::string>& args);
+int bench_frames(const std::vector<std::string>& args);
+int bench_damage(const std::vector<std::string>& args);
+int bench_colors(const std::vector<std::string>& args);
+int bench_windows(const std::vector<std::string>& args);
+int bench_census(const std::vector<std::string>& args);
+int bench_lut(const std::vector<std::string>& args);
+int bench_recolor(const std::vector<std::string>& args);
+int bench_grade(const std::vector<std::string>& args);
+int bench_sprites(const std::vector<std::string>& args);
+int bench_bmp(const std::vector<std::string>& args);
+int bench_decode(const std::vector<std::string>& args);
+int bench_lz4(const std::vector<std::string>& args);
+int bench_resample(const std::vector<std::string>& args);
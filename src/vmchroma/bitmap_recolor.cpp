@@ -0,0 +1,371 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "bitmap_recolor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "simd.hpp"
+
+namespace bitmap_recolor
+{
+namespace
+{
+constexpr uint32_t MEMO_BITS = 8;
+constexpr uint32_t MEMO_EMPTY = 0xFFFFFFFF;
+
+/**
+ * Direct-mapped cache of recently mapped colors, theme bitmaps only use a handful of colors
+ * so almost every pixel that isn't part of a run is answered from here
+ */
+typedef struct memo
+{
+    uint32_t src[1 << MEMO_BITS];
+    uint32_t dst[1 << MEMO_BITS];
+
+    memo()
+    {
+        std::fill(std::begin(src), std::end(src), MEMO_EMPTY);
+        std::fill(std::begin(dst), std::end(dst), 0);
+    }
+} memo_t;
+
+/**
+ * Swaps the R and B bytes, converts between BGR pixel order and COLORREF in both directions
+ */
+inline uint32_t swap_rb(const uint32_t c)
+{
+    return ((c & 0xFF) << 16) | (c & 0xFF00) | ((c >> 16) & 0xFF);
+}
+
+/**
+ * Maps the color of a BGR(X) pixel value and keeps the upper byte
+ * @param px Pixel value as read from memory in little endian
+ * @param m Color memo
+ * @param map Color map
+ * @return The mapped pixel value
+ */
+inline uint32_t map_pixel(const uint32_t px, memo_t& m, const color_map_t& map)
+{
+    const uint32_t bgr = px & 0x00FFFFFF;
+    const uint32_t slot = (bgr * 0x9E3779B1u) >> (32 - MEMO_BITS);
+
+    if (m.src[slot] != bgr)
+    {
+        const auto mapped = map.find(swap_rb(bgr));
+        m.src[slot] = bgr;
+        m.dst[slot] = mapped ? swap_rb(*mapped & 0x00FFFFFF) : bgr;
+    }
+
+    return (px & 0xFF000000) | m.dst[slot];
+}
+
+inline uint32_t load24(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16);
+}
+
+inline void store24(uint8_t* p, const uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+}
+
+/**
+ * Tracks the last mapped color so runs of the same color skip the memo as well
+ */
+typedef struct run
+{
+    uint32_t src;
+    uint32_t dst;
+
+    run(const uint32_t px, memo_t& m, const color_map_t& map) : src(px), dst(map_pixel(px, m, map))
+    {
+    }
+
+    uint32_t map(const uint32_t px, memo_t& m, const color_map_t& map)
+    {
+        if (px != src)
+        {
+            src = px;
+            dst = map_pixel(px, m, map);
+        }
+
+        return dst;
+    }
+} run_t;
+
+void row32_generic(uint8_t* row, const uint32_t begin, const uint32_t end, run_t& r, memo_t& m, const color_map_t& map)
+{
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t px;
+        std::memcpy(&px, row + i * 4, 4);
+        px = r.map(px, m, map);
+        std::memcpy(row + i * 4, &px, 4);
+    }
+}
+
+void row24_generic(uint8_t* row, const uint32_t begin, const uint32_t end, run_t& r, memo_t& m, const color_map_t& map)
+{
+    for (uint32_t i = begin; i < end; i++)
+        store24(row + i * 3, r.map(load24(row + i * 3), m, map));
+}
+
+/**
+ * Fills a buffer with a repeating 3 byte color, used to compare and store whole vectors of 24 bpp pixels
+ */
+void fill_pattern24(uint8_t* pattern, const size_t size, const uint32_t color)
+{
+    for (size_t i = 0; i < size; i += 3)
+        store24(pattern + i, color);
+}
+
+#if defined(VMCHROMA_SSE2)
+void row32_sse2(uint8_t* row, const uint32_t width, run_t& r, memo_t& m, const color_map_t& map)
+{
+    __m128i vsrc = _mm_set1_epi32(static_cast<int>(r.src));
+    __m128i vdst = _mm_set1_epi32(static_cast<int>(r.dst));
+    uint32_t i = 0;
+
+    for (; i + 4 <= width; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i * 4));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, vsrc)) == 0xFFFF)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i * 4), vdst);
+            continue;
+        }
+
+        row32_generic(row, i, i + 4, r, m, map);
+        vsrc = _mm_set1_epi32(static_cast<int>(r.src));
+        vdst = _mm_set1_epi32(static_cast<int>(r.dst));
+    }
+
+    row32_generic(row, i, width, r, m, map);
+}
+
+void row24_sse2(uint8_t* row, const uint32_t width, run_t& r, memo_t& m, const color_map_t& map)
+{
+    // 16 pixels are 48 bytes, which is exactly three vectors and a whole number of pattern periods
+    alignas(16) uint8_t src_pattern[48 + 3];
+    alignas(16) uint8_t dst_pattern[48 + 3];
+    fill_pattern24(src_pattern, 48, r.src);
+    fill_pattern24(dst_pattern, 48, r.dst);
+    uint32_t i = 0;
+
+    for (; i + 16 <= width; i += 16)
+    {
+        auto p = reinterpret_cast<__m128i*>(row + i * 3);
+        const auto s = reinterpret_cast<const __m128i*>(src_pattern);
+
+        const __m128i eq = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(p), _mm_load_si128(s)), _mm_cmpeq_epi8(_mm_loadu_si128(p + 1), _mm_load_si128(s + 1))),
+            _mm_cmpeq_epi8(_mm_loadu_si128(p + 2), _mm_load_si128(s + 2)));
+
+        if (_mm_movemask_epi8(eq) == 0xFFFF)
+        {
+            std::memcpy(p, dst_pattern, 48);
+            continue;
+        }
+
+        const uint32_t last_src = r.src;
+        row24_generic(row, i, i + 16, r, m, map);
+
+        if (r.src != last_src)
+        {
+            fill_pattern24(src_pattern, 48, r.src);
+            fill_pattern24(dst_pattern, 48, r.dst);
+        }
+    }
+
+    row24_generic(row, i, width, r, m, map);
+}
+
+VMCHROMA_TARGET_AVX2
+void row32_avx2(uint8_t* row, const uint32_t width, run_t& r, memo_t& m, const color_map_t& map)
+{
+    __m256i vsrc = _mm256_set1_epi32(static_cast<int>(r.src));
+    __m256i vdst = _mm256_set1_epi32(static_cast<int>(r.dst));
+    uint32_t i = 0;
+
+    for (; i + 8 <= width; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i * 4));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(v, vsrc)) == -1)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i * 4), vdst);
+            continue;
+        }
+
+        row32_generic(row, i, i + 8, r, m, map);
+        vsrc = _mm256_set1_epi32(static_cast<int>(r.src));
+        vdst = _mm256_set1_epi32(static_cast<int>(r.dst));
+    }
+
+    row32_generic(row, i, width, r, m, map);
+}
+
+VMCHROMA_TARGET_AVX2
+void row24_avx2(uint8_t* row, const uint32_t width, run_t& r, memo_t& m, const color_map_t& map)
+{
+    // 32 pixels are 96 bytes, three vectors
+    alignas(32) uint8_t src_pattern[96 + 3];
+    alignas(32) uint8_t dst_pattern[96 + 3];
+    fill_pattern24(src_pattern, 96, r.src);
+    fill_pattern24(dst_pattern, 96, r.dst);
+    uint32_t i = 0;
+
+    for (; i + 32 <= width; i += 32)
+    {
+        auto p = reinterpret_cast<__m256i*>(row + i * 3);
+        const auto s = reinterpret_cast<const __m256i*>(src_pattern);
+
+        const __m256i eq = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(p), _mm256_load_si256(s)), _mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), _mm256_load_si256(s + 1))),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(p + 2), _mm256_load_si256(s + 2)));
+
+        if (_mm256_movemask_epi8(eq) == -1)
+        {
+            std::memcpy(p, dst_pattern, 96);
+            continue;
+        }
+
+        const uint32_t last_src = r.src;
+        row24_generic(row, i, i + 32, r, m, map);
+
+        if (r.src != last_src)
+        {
+            fill_pattern24(src_pattern, 96, r.src);
+            fill_pattern24(dst_pattern, 96, r.dst);
+        }
+    }
+
+    row24_generic(row, i, width, r, m, map);
+}
+#endif
+}
+
+bool is_supported(const uint32_t bpp)
+{
+    return bpp == 24 || bpp == 32;
+}
+
+/**
+ * Gets the number of color table entries of a palette based DIB
+ * @param bpp Bits per pixel
+ * @param clr_used biClrUsed of the header, 0 for the maximum the bit depth allows
+ * @return Entries in the color table, 0 if the bit depth has no palette
+ */
+uint32_t palette_size(const uint32_t bpp, const uint32_t clr_used)
+{
+    if (bpp != 1 && bpp != 4 && bpp != 8)
+        return 0;
+
+    const uint32_t max_colors = 1u << bpp;
+    return clr_used != 0 ? std::min(clr_used, max_colors) : max_colors;
+}
+
+/**
+ * DIB rows are padded to a multiple of 4 bytes
+ * @param width Width in pixels
+ * @param bpp Bits per pixel
+ * @return Row size in bytes
+ */
+uint32_t dib_stride(const uint32_t width, const uint32_t bpp)
+{
+    return (width * bpp + 31) / 32 * 4;
+}
+
+/**
+ * Recolors the pixels, whole vectors that continue a run of the same color are stored without a lookup
+ * @param bits First byte of the first row in memory
+ * @param width Width in pixels
+ * @param height Number of rows
+ * @param stride Row size in bytes
+ * @param bpp 24 or 32
+ * @param map Color map
+ */
+void apply(uint8_t* bits, const uint32_t width, const uint32_t height, const uint32_t stride, const uint32_t bpp, const color_map_t& map)
+{
+    if (!is_supported(bpp))
+        return;
+
+    if (width == 0 || height == 0)
+        return;
+
+    memo_t m;
+
+    // seed the run with the first pixel so the first vector can already take the fast path
+    uint32_t first = load24(bits);
+
+    if (bpp == 32)
+        std::memcpy(&first, bits, 4);
+
+    run_t r(first, m, map);
+
+#if defined(VMCHROMA_SSE2)
+    const bool avx2 = simd::has_avx2();
+#endif
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t* row = bits + static_cast<size_t>(y) * stride;
+
+#if defined(VMCHROMA_SSE2)
+        if (bpp == 32)
+            avx2 ? row32_avx2(row, width, r, m, map) : row32_sse2(row, width, r, m, map);
+        else
+            avx2 ? row24_avx2(row, width, r, m, map) : row24_sse2(row, width, r, m, map);
+#else
+        if (bpp == 32)
+            row32_generic(row, 0, width, r, m, map);
+        else
+            row24_generic(row, 0, width, r, m, map);
+#endif
+    }
+}
+
+/**
+ * Reference implementation that looks up every pixel on its own
+ */
+void apply_scalar(uint8_t* bits, const uint32_t width, const uint32_t height, const uint32_t stride, const uint32_t bpp, const color_map_t& map)
+{
+    if (!is_supported(bpp))
+        return;
+
+    const uint32_t bytes_pp = bpp / 8;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t* row = bits + static_cast<size_t>(y) * stride;
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* p = row + x * bytes_pp;
+            const auto mapped = map.find(swap_rb(load24(p)));
+
+            if (mapped)
+                store24(p, swap_rb(*mapped & 0x00FFFFFF));
+        }
+    }
+}
+}
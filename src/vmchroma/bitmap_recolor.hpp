@@ -0,0 +1,35 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "color_map.hpp"
+
+/**
+ * In-place recoloring of 24 and 32 bpp DIB pixels (BGR / BGRX memory order) through a color map
+ * The unused fourth byte of 32 bpp pixels is preserved
+ */
+namespace bitmap_recolor
+{
+bool is_supported(uint32_t bpp);
+uint32_t palette_size(uint32_t bpp, uint32_t clr_used);
+uint32_t dib_stride(uint32_t width, uint32_t bpp);
+void apply(uint8_t* bits, uint32_t width, uint32_t height, uint32_t stride, uint32_t bpp, const color_map_t& map);
+void apply_scalar(uint8_t* bits, uint32_t width, uint32_t height, uint32_t stride, uint32_t bpp, const color_map_t& map);
+}
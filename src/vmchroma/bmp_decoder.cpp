@@ -0,0 +1,538 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "bmp_decoder.hpp"
+
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#include "simd.hpp"
+
+namespace bmp_decoder
+{
+namespace
+{
+constexpr uint32_t FILE_HEADER_SIZE = 14;
+constexpr uint32_t INFO_HEADER_SIZE = 40;
+
+enum source_format { SRC_BGR24, SRC_BGRX32, SRC_RGB555, SRC_RGB565, SRC_MASKED };
+
+typedef struct channel
+{
+    uint32_t mask;
+    uint32_t shift;
+    uint32_t bits;
+
+    explicit channel(const uint32_t mask) : mask(mask), shift(0), bits(0)
+    {
+        while (shift < 32 && !(mask >> shift & 1))
+            shift++;
+
+        while (shift + bits < 32 && mask >> (shift + bits) & 1)
+            bits++;
+    }
+
+    /**
+     * Scales the channel value of a pixel to 8 bits, narrower channels repeat their bits
+     */
+    uint8_t extract(const uint32_t px) const
+    {
+        const uint32_t v = (px & mask) >> shift;
+
+        if (bits >= 8)
+            return static_cast<uint8_t>(v >> (bits - 8));
+
+        uint32_t out = 0;
+
+        for (int32_t s = 8 - static_cast<int32_t>(bits); s > -static_cast<int32_t>(bits); s -= static_cast<int32_t>(bits))
+            out |= s >= 0 ? v << s : v >> -s;
+
+        return static_cast<uint8_t>(out);
+    }
+} channel_t;
+
+uint16_t read16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+uint32_t read32(const uint8_t* p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+/**
+ * A mask is usable if it's a single run of set bits within the pixel
+ */
+bool is_valid_mask(const uint32_t mask, const uint32_t bpp)
+{
+    if (mask == 0 || (bpp < 32 && mask >> bpp != 0))
+        return false;
+
+    const channel_t c(mask);
+    return c.bits == 32 || mask >> c.shift == (1u << c.bits) - 1;
+}
+
+source_format classify(const bmp_info_t& info)
+{
+    if (info.bpp == 24)
+        return SRC_BGR24;
+
+    if (info.bpp == 32 && info.mask_r == 0xFF0000 && info.mask_g == 0xFF00 && info.mask_b == 0xFF)
+        return SRC_BGRX32;
+
+    if (info.bpp == 16 && info.mask_r == 0x7C00 && info.mask_g == 0x3E0 && info.mask_b == 0x1F)
+        return SRC_RGB555;
+
+    if (info.bpp == 16 && info.mask_r == 0xF800 && info.mask_g == 0x7E0 && info.mask_b == 0x1F)
+        return SRC_RGB565;
+
+    return SRC_MASKED;
+}
+
+uint32_t row_stride(const uint32_t width, const uint32_t bpp)
+{
+    return (width * bpp + 31) / 32 * 4;
+}
+
+bool fits(const uint8_t* data, const size_t size, const bmp_info_t& info)
+{
+    return data != nullptr && static_cast<uint64_t>(info.pixel_offset) + static_cast<uint64_t>(info.stride) * info.height <= size;
+}
+
+bool is_compatible(const bmp_info_t& info, const dib_layout_t& layout)
+{
+    if (layout.bpp != 24 && layout.bpp != 32)
+    {
+        SPDLOG_ERROR("bitmap target has {} bpp, only 24 and 32 bpp are supported", layout.bpp);
+        return false;
+    }
+
+    if (layout.width != info.width || layout.height != info.height)
+    {
+        SPDLOG_ERROR("bitmap is {}x{}, expected {}x{}", info.width, info.height, layout.width, layout.height);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Reference conversion of a single row, handles every supported input through the channel masks
+ */
+void row_generic(const uint8_t* src, uint8_t* dst, const uint32_t width, const bmp_info_t& info, const uint32_t dst_bpp)
+{
+    const channel_t r(info.mask_r);
+    const channel_t g(info.mask_g);
+    const channel_t b(info.mask_b);
+    const uint32_t src_bytes = info.bpp / 8;
+    const uint32_t dst_bytes = dst_bpp / 8;
+    const bool keep_x = info.bpp == 32 && dst_bpp == 32 && classify(info) == SRC_BGRX32;
+
+    for (uint32_t x = 0; x < width; x++)
+    {
+        const uint8_t* s = src + x * src_bytes;
+        uint8_t* d = dst + x * dst_bytes;
+
+        uint32_t px = s[0] | s[1] << 8;
+
+        if (src_bytes >= 3)
+            px |= s[2] << 16;
+
+        if (src_bytes == 4)
+            px |= static_cast<uint32_t>(s[3]) << 24;
+
+        d[0] = b.extract(px);
+        d[1] = g.extract(px);
+        d[2] = r.extract(px);
+
+        if (dst_bytes == 4)
+            d[3] = keep_x ? s[3] : 0;
+    }
+}
+
+#if defined(VMCHROMA_SSE2)
+/**
+ * Expands 8 RGB555 or RGB565 pixels to BGRX
+ */
+template <bool RGB565>
+void row16_to_32_sse2(const uint8_t* src, uint8_t* dst, const uint32_t width)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask_g = _mm_set1_epi16(RGB565 ? 0x3F : 0x1F);
+    uint32_t x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+
+        __m128i b = _mm_and_si128(v, mask5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask_g);
+        __m128i r = _mm_and_si128(_mm_srli_epi16(v, RGB565 ? 11 : 10), mask5);
+
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = RGB565 ? _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4)) : _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+
+        const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_unpacklo_epi16(bg, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 16), _mm_unpackhi_epi16(bg, r));
+    }
+
+    if (x < width)
+    {
+        bmp_info_t tail = {};
+        tail.bpp = 16;
+        tail.mask_r = RGB565 ? 0xF800 : 0x7C00;
+        tail.mask_g = RGB565 ? 0x7E0 : 0x3E0;
+        tail.mask_b = 0x1F;
+        row_generic(src + x * 2, dst + x * 4, width - x, tail, 32);
+    }
+}
+
+/**
+ * Widens BGR to BGRX with a byte shuffle, 4 pixels per vector
+ */
+VMCHROMA_TARGET_SSSE3
+void row24_to_32_ssse3(const uint8_t* src, uint8_t* dst, const uint32_t width)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    uint32_t x = 0;
+
+    // a vector load reads 16 bytes for 12 used ones, stay inside the row
+    for (; x + 6 <= width; x += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_shuffle_epi8(v, shuffle));
+    }
+
+    for (; x < width; x++)
+    {
+        std::memcpy(dst + x * 4, src + x * 3, 3);
+        dst[x * 4 + 3] = 0;
+    }
+}
+
+/**
+ * Narrows BGRX to BGR, 16 pixels are packed into exactly three vectors
+ */
+VMCHROMA_TARGET_SSSE3
+void row32_to_24_ssse3(const uint8_t* src, uint8_t* dst, const uint32_t width)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    uint32_t x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const auto s = reinterpret_cast<const __m128i*>(src + x * 4);
+        const __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(s), shuffle);
+        const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(s + 1), shuffle);
+        const __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(s + 2), shuffle);
+        const __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(s + 3), shuffle);
+
+        const auto out = reinterpret_cast<__m128i*>(dst + x * 3);
+        _mm_storeu_si128(out, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+
+    for (; x < width; x++)
+        std::memcpy(dst + x * 3, src + x * 4, 3);
+}
+#endif
+
+/**
+ * Calls the row function for every target row with the matching source row, then clears the row padding
+ */
+template <typename F>
+void for_each_row(const uint8_t* data, const bmp_info_t& info, uint8_t* dst, const dib_layout_t& layout, F&& row)
+{
+    const uint32_t dst_stride = row_stride(layout.width, layout.bpp);
+    const uint32_t row_bytes = layout.width * (layout.bpp / 8);
+
+    for (uint32_t y = 0; y < layout.height; y++)
+    {
+        // image row counted from the top
+        const uint32_t image_row = layout.top_down ? y : layout.height - 1 - y;
+        const uint32_t src_row = info.top_down ? image_row : info.height - 1 - image_row;
+
+        uint8_t* d = dst + static_cast<size_t>(y) * dst_stride;
+        row(data + info.pixel_offset + static_cast<size_t>(src_row) * info.stride, d);
+        std::memset(d + row_bytes, 0, dst_stride - row_bytes);
+    }
+}
+}
+
+/**
+ * Parses and validates the headers of a BMP file
+ * @param data The whole file
+ * @param size File size in bytes
+ * @return Image info or std::nullopt if the file is invalid or uses an unsupported format
+ */
+std::optional<bmp_info_t> parse(const uint8_t* data, const size_t size)
+{
+    if (data == nullptr || size < FILE_HEADER_SIZE + INFO_HEADER_SIZE || data[0] != 'B' || data[1] != 'M')
+    {
+        SPDLOG_ERROR("not a bitmap file");
+        return std::nullopt;
+    }
+
+    const uint8_t* ih = data + FILE_HEADER_SIZE;
+    const uint32_t header_size = read32(ih);
+
+    if (header_size != 40 && header_size != 52 && header_size != 56 && header_size != 108 && header_size != 124)
+    {
+        SPDLOG_ERROR("unsupported bitmap header size {}", header_size);
+        return std::nullopt;
+    }
+
+    if (size < FILE_HEADER_SIZE + header_size)
+    {
+        SPDLOG_ERROR("bitmap header is truncated");
+        return std::nullopt;
+    }
+
+    const auto width = static_cast<int32_t>(read32(ih + 4));
+    const auto height = static_cast<int32_t>(read32(ih + 8));
+    const uint16_t planes = read16(ih + 12);
+    const uint16_t bpp = read16(ih + 14);
+    const uint32_t compression = read32(ih + 16);
+
+    if (width <= 0 || width > static_cast<int32_t>(MAX_DIMENSION) || height == 0 || height > static_cast<int32_t>(MAX_DIMENSION) || height < -static_cast<int32_t>(MAX_DIMENSION))
+    {
+        SPDLOG_ERROR("invalid bitmap dimensions {}x{}", width, height);
+        return std::nullopt;
+    }
+
+    if (planes != 1 || (bpp != 16 && bpp != 24 && bpp != 32))
+    {
+        SPDLOG_ERROR("unsupported bitmap format: {} planes, {} bpp", planes, bpp);
+        return std::nullopt;
+    }
+
+    bmp_info_t info = {};
+    info.width = static_cast<uint32_t>(width);
+    info.height = static_cast<uint32_t>(height < 0 ? -height : height);
+    info.top_down = height < 0;
+    info.bpp = bpp;
+    info.stride = row_stride(info.width, bpp);
+
+    uint32_t header_end = FILE_HEADER_SIZE + header_size;
+
+    if (compression == BMP_COMPRESSION_RGB)
+    {
+        info.mask_r = bpp == 16 ? 0x7C00 : 0xFF0000;
+        info.mask_g = bpp == 16 ? 0x3E0 : 0xFF00;
+        info.mask_b = bpp == 16 ? 0x1F : 0xFF;
+    }
+    else if (compression == BMP_COMPRESSION_BITFIELDS && bpp != 24)
+    {
+        // the masks follow a plain info header and are part of every newer header
+        const uint8_t* masks = ih + INFO_HEADER_SIZE;
+
+        if (header_size == INFO_HEADER_SIZE)
+            header_end += 12;
+
+        if (size < header_end)
+        {
+            SPDLOG_ERROR("bitmap color masks are truncated");
+            return std::nullopt;
+        }
+
+        info.mask_r = read32(masks);
+        info.mask_g = read32(masks + 4);
+        info.mask_b = read32(masks + 8);
+
+        if (!is_valid_mask(info.mask_r, bpp) || !is_valid_mask(info.mask_g, bpp) || !is_valid_mask(info.mask_b, bpp) ||
+            (info.mask_r & info.mask_g) || (info.mask_r & info.mask_b) || (info.mask_g & info.mask_b))
+        {
+            SPDLOG_ERROR("invalid bitmap color masks");
+            return std::nullopt;
+        }
+    }
+    else
+    {
+        SPDLOG_ERROR("unsupported bitmap compression {}", compression);
+        return std::nullopt;
+    }
+
+    info.pixel_offset = read32(data + 10);
+
+    if (info.pixel_offset < header_end || !fits(data, size, info))
+    {
+        SPDLOG_ERROR("bitmap pixel data is out of bounds");
+        return std::nullopt;
+    }
+
+    return info;
+}
+
+/**
+ * @param layout Target layout
+ * @return Size of the pixel buffer of a DIB section with that layout
+ */
+uint32_t dib_size(const dib_layout_t& layout)
+{
+    return row_stride(layout.width, layout.bpp) * layout.height;
+}
+
+/**
+ * Checks if a DIB section with the layout can use the stored pixels as they are, through a mapping of the file
+ * The pixel format, row order and stride must match and CreateDIBSection needs the offset to be a multiple of a DWORD
+ * @param info Parsed image info
+ * @param size File size in bytes
+ * @param layout Target layout
+ * @param section_offset Where the file starts in the mapped section, non-zero inside a compiled theme
+ * @return True if the section can start at info.pixel_offset of the file
+ */
+bool is_direct_mappable(const bmp_info_t& info, const size_t size, const dib_layout_t& layout, const size_t section_offset)
+{
+    if (layout.width != info.width || layout.height != info.height || layout.bpp != info.bpp || layout.top_down != info.top_down)
+        return false;
+
+    const auto format = classify(info);
+
+    if (format != SRC_BGR24 && format != SRC_BGRX32)
+        return false;
+
+    if ((section_offset + info.pixel_offset) % 4 != 0 || info.stride != row_stride(layout.width, layout.bpp))
+        return false;
+
+    return static_cast<uint64_t>(info.pixel_offset) + dib_size(layout) <= size;
+}
+
+/**
+ * Converts the pixels into the layout of a DIB section
+ * @param data The whole file
+ * @param size File size in bytes
+ * @param info Parsed image info
+ * @param dst Pixel buffer of the DIB section, at least dib_size(layout) bytes
+ * @param layout Target layout, must have the same dimensions as the image
+ * @return True if the conversion was successful
+ */
+bool convert(const uint8_t* data, const size_t size, const bmp_info_t& info, uint8_t* dst, const dib_layout_t& layout)
+{
+    if (!fits(data, size, info) || dst == nullptr || !is_compatible(info, layout))
+        return false;
+
+    const auto format = classify(info);
+    const uint32_t width = layout.width;
+
+    // same pixel format, only row order and stride can differ
+    if ((format == SRC_BGR24 && layout.bpp == 24) || (format == SRC_BGRX32 && layout.bpp == 32))
+    {
+        for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { std::memcpy(d, s, width * (layout.bpp / 8)); });
+        return true;
+    }
+
+#if defined(VMCHROMA_SSE2)
+    const bool ssse3 = simd::has_ssse3();
+
+    if (format == SRC_BGR24 && ssse3)
+    {
+        for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { row24_to_32_ssse3(s, d, width); });
+        return true;
+    }
+
+    if (format == SRC_BGRX32 && ssse3)
+    {
+        for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { row32_to_24_ssse3(s, d, width); });
+        return true;
+    }
+
+    if (format == SRC_RGB555 || format == SRC_RGB565)
+    {
+        const auto expand = format == SRC_RGB565 ? row16_to_32_sse2<true> : row16_to_32_sse2<false>;
+
+        if (layout.bpp == 32)
+        {
+            for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { expand(s, d, width); });
+            return true;
+        }
+
+        if (ssse3)
+        {
+            std::vector<uint8_t> tmp(static_cast<size_t>(width) * 4);
+
+            for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d)
+            {
+                expand(s, tmp.data(), width);
+                row32_to_24_ssse3(tmp.data(), d, width);
+            });
+
+            return true;
+        }
+    }
+#endif
+
+    for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { row_generic(s, d, width, info, layout.bpp); });
+    return true;
+}
+
+/**
+ * Reference implementation that converts every pixel through the channel masks
+ */
+bool convert_scalar(const uint8_t* data, const size_t size, const bmp_info_t& info, uint8_t* dst, const dib_layout_t& layout)
+{
+    if (!fits(data, size, info) || dst == nullptr || !is_compatible(info, layout))
+        return false;
+
+    for_each_row(data, info, dst, layout, [&](const uint8_t* s, uint8_t* d) { row_generic(s, d, layout.width, info, layout.bpp); });
+    return true;
+}
+
+/**
+ * Creates an empty bottom-up BI_RGB bitmap file in memory, used as the target of the PNG and QOI decoders
+ * @param width Width in pixels, at most MAX_DIMENSION
+ * @param height Height in pixels, at most MAX_DIMENSION
+ * @param bpp 24 or 32
+ * @return The file bytes, pixels start right after the 54 byte header
+ */
+std::vector<uint8_t> create_bmp(const uint32_t width, const uint32_t height, const uint32_t bpp)
+{
+    const uint32_t pixel_offset = FILE_HEADER_SIZE + INFO_HEADER_SIZE;
+    const uint32_t image_size = row_stride(width, bpp) * height;
+    std::vector<uint8_t> file(pixel_offset + static_cast<size_t>(image_size));
+
+    const auto write16 = [&file](const size_t pos, const uint32_t v)
+    {
+        file[pos] = static_cast<uint8_t>(v);
+        file[pos + 1] = static_cast<uint8_t>(v >> 8);
+    };
+
+    const auto write32 = [&write16](const size_t pos, const uint32_t v)
+    {
+        write16(pos, v & 0xFFFF);
+        write16(pos + 2, v >> 16);
+    };
+
+    file[0] = 'B';
+    file[1] = 'M';
+    write32(2, static_cast<uint32_t>(file.size()));
+    write32(10, pixel_offset);
+    write32(14, INFO_HEADER_SIZE);
+    write32(18, width);
+    write32(22, height);
+    write16(26, 1);
+    write16(28, bpp);
+    write32(30, BMP_COMPRESSION_RGB);
+    write32(34, image_size);
+
+    return file;
+}
+}
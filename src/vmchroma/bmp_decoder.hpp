@@ -0,0 +1,67 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// same values as the BI_* constants of wingdi.h
+constexpr uint32_t BMP_COMPRESSION_RGB = 0;
+constexpr uint32_t BMP_COMPRESSION_BITFIELDS = 3;
+
+typedef struct bmp_info
+{
+    uint32_t width;
+    uint32_t height;
+    bool top_down;
+    uint32_t bpp; // 16, 24 or 32
+    uint32_t pixel_offset; // offset of the first stored row from the start of the file
+    uint32_t stride; // stored row size in bytes
+    uint32_t mask_r;
+    uint32_t mask_g;
+    uint32_t mask_b;
+} bmp_info_t;
+
+/**
+ * Layout of the DIB section a bitmap is decoded into, as requested through its BITMAPINFOHEADER
+ */
+typedef struct dib_layout
+{
+    uint32_t width;
+    uint32_t height;
+    bool top_down;
+    uint32_t bpp; // 24 or 32
+} dib_layout_t;
+
+/**
+ * Decoder for uncompressed BMP files, everything is validated against the file size before any pixel is read
+ * Converts 16, 24 and 32 bpp input in either row order into the exact layout of a 24 or 32 bpp DIB section
+ */
+namespace bmp_decoder
+{
+constexpr uint32_t MAX_DIMENSION = 16384;
+
+std::optional<bmp_info_t> parse(const uint8_t* data, size_t size);
+uint32_t dib_size(const dib_layout_t& layout);
+bool is_direct_mappable(const bmp_info_t& info, size_t size, const dib_layout_t& layout, size_t section_offset = 0);
+bool convert(const uint8_t* data, size_t size, const bmp_info_t& info, uint8_t* dst, const dib_layout_t& layout);
+bool convert_scalar(const uint8_t* data, size_t size, const bmp_info_t& info, uint8_t* dst, const dib_layout_t& layout);
+std::vector<uint8_t> create_bmp(uint32_t width, uint32_t height, uint32_t bpp);
+}
@@ -0,0 +1,236 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "color_census.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+#include "yaml-cpp/yaml.h"
+
+/**
+ * @param category_names Names of the categories as written to the stats file
+ */
+color_census::color_census(const std::vector<std::string>& category_names) : categories(category_names.size())
+{
+    for (size_t i = 0; i < category_names.size(); i++)
+    {
+        categories[i].name = category_names[i];
+        categories[i].slots = std::make_unique<slot_t[]>(SLOT_COUNT);
+    }
+
+    start_time = std::chrono::steady_clock::now();
+    last_write_time = start_time;
+}
+
+color_census::~color_census()
+{
+    stop_writer();
+}
+
+/**
+ * Finds the slot of a color, claims an empty slot if the color wasn't seen before
+ * @param cat The category
+ * @param color The color without the upper byte
+ * @return The slot or nullptr if the table has no room left around the color
+ */
+color_census::slot_t* color_census::find_slot(category_t& cat, const uint32_t color)
+{
+    uint32_t idx = (color * 0x9E3779B1u) >> (32 - SLOT_BITS);
+
+    for (uint32_t i = 0; i < MAX_PROBES; i++, idx = (idx + 1) & (SLOT_COUNT - 1))
+    {
+        slot_t& s = cat.slots[idx];
+        uint32_t key = s.key.load(std::memory_order_relaxed);
+
+        if (key == color)
+            return &s;
+
+        if (key == EMPTY_KEY)
+        {
+            // another thread may claim the slot first, then key holds its color
+            if (s.key.compare_exchange_strong(key, color, std::memory_order_relaxed) || key == color)
+                return &s;
+        }
+    }
+
+    cat.dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+/**
+ * Copies the counters of a category
+ * @param category Index of the category
+ * @return All recorded colors, most frequent first
+ */
+std::vector<color_census_entry_t> color_census::snapshot(const size_t category) const
+{
+    std::vector<color_census_entry_t> entries;
+    const auto& cat = categories[category];
+
+    for (uint32_t i = 0; i < SLOT_COUNT; i++)
+    {
+        const auto& s = cat.slots[i];
+        const uint32_t key = s.key.load(std::memory_order_relaxed);
+
+        if (key == EMPTY_KEY)
+            continue;
+
+        entries.push_back({key, s.hits.load(std::memory_order_relaxed), s.misses.load(std::memory_order_relaxed)});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const color_census_entry_t& a, const color_census_entry_t& b)
+    {
+        if (a.hits + a.misses != b.hits + b.misses)
+            return a.hits + a.misses > b.hits + b.misses;
+
+        return a.color < b.color;
+    });
+
+    return entries;
+}
+
+/**
+ * Writes the counters of all categories as yaml, through a temporary file so readers never see a partial file
+ * @param path Path of the stats file
+ * @return True if writing was successful
+ */
+bool color_census::write(const std::filesystem::path& path)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - start_time).count();
+    const double since_last_write = std::chrono::duration<double>(now - last_write_time).count();
+    last_write_time = now;
+
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    out << YAML::Key << "elapsedSeconds" << YAML::Value << static_cast<uint64_t>(elapsed);
+
+    for (size_t c = 0; c < categories.size(); c++)
+    {
+        auto& cat = categories[c];
+        const auto entries = snapshot(c);
+
+        uint64_t calls = 0;
+        uint64_t hits = 0;
+
+        for (const auto& e : entries)
+        {
+            calls += e.hits + e.misses;
+            hits += e.hits;
+        }
+
+        const uint64_t recent_calls = calls - cat.last_calls;
+        cat.last_calls = calls;
+
+        out << YAML::Key << cat.name << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "calls" << YAML::Value << calls;
+        out << YAML::Key << "hits" << YAML::Value << hits;
+        out << YAML::Key << "misses" << YAML::Value << calls - hits;
+        out << YAML::Key << "callsPerSecond" << YAML::Value << static_cast<uint64_t>(elapsed > 0 ? calls / elapsed : 0);
+        out << YAML::Key << "recentCallsPerSecond" << YAML::Value << static_cast<uint64_t>(since_last_write > 0 ? recent_calls / since_last_write : 0);
+        out << YAML::Key << "distinctColors" << YAML::Value << entries.size();
+        out << YAML::Key << "dropped" << YAML::Value << cat.dropped.load(std::memory_order_relaxed);
+        out << YAML::Key << "colors" << YAML::Value << YAML::BeginSeq;
+
+        for (const auto& e : entries)
+        {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "#%02X%02X%02X", e.color & 0xFF, (e.color >> 8) & 0xFF, (e.color >> 16) & 0xFF);
+
+            out << YAML::Flow << YAML::BeginMap;
+            out << YAML::Key << "color" << YAML::Value << YAML::DoubleQuoted << hex;
+            out << YAML::Key << "hits" << YAML::Value << e.hits;
+            out << YAML::Key << "misses" << YAML::Value << e.misses;
+            out << YAML::EndMap;
+        }
+
+        out << YAML::EndSeq;
+        out << YAML::EndMap;
+    }
+
+    out << YAML::EndMap;
+
+    auto tmp_path = path;
+    tmp_path += L".tmp";
+
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+
+        if (!file)
+        {
+            SPDLOG_ERROR("can't open {} for writing", tmp_path.string());
+            return false;
+        }
+
+        file << out.c_str() << '\n';
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+
+    if (ec)
+    {
+        SPDLOG_ERROR("can't write {}: {}", path.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+void color_census::writer_loop(const std::filesystem::path path, const std::chrono::seconds interval)
+{
+    std::unique_lock lock(writer_mtx);
+
+    while (!writer_cv.wait_for(lock, interval, [this] { return writer_stop; }))
+        write(path);
+
+    write(path);
+}
+
+/**
+ * Starts the background thread that writes the stats file
+ * @param path Path of the stats file
+ * @param interval Time between writes, the file is also written once when the writer stops
+ */
+void color_census::start_writer(const std::filesystem::path& path, const std::chrono::seconds interval)
+{
+    if (writer.joinable())
+        return;
+
+    writer_stop = false;
+    writer = std::thread(&color_census::writer_loop, this, path, interval);
+}
+
+/**
+ * Stops the background writer after a final write
+ */
+void color_census::stop_writer()
+{
+    if (!writer.joinable())
+        return;
+
+    {
+        std::lock_guard lock(writer_mtx);
+        writer_stop = true;
+    }
+
+    writer_cv.notify_one();
+    writer.join();
+}
@@ -0,0 +1,106 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct color_census_entry
+{
+    uint32_t color; // COLORREF
+    uint64_t hits; // calls with a mapping in colors.yaml
+    uint64_t misses; // calls that kept the original color
+} color_census_entry_t;
+
+/**
+ * Counts which colors pass through the color hooks and whether colors.yaml maps them
+ * Every category has a fixed size open-addressing table of atomic counters, recording a color
+ * is a hash, a few relaxed loads and one relaxed increment, no locks and no allocations
+ * A background thread periodically writes the counters to a yaml file, most frequent colors first
+ */
+class color_census
+{
+    static constexpr uint32_t SLOT_BITS = 12;
+    static constexpr uint32_t SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr uint32_t MAX_PROBES = 32;
+    static constexpr uint32_t EMPTY_KEY = 0xFFFFFFFF;
+
+    typedef struct slot
+    {
+        std::atomic<uint32_t> key{EMPTY_KEY};
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    } slot_t;
+
+    typedef struct category
+    {
+        std::string name;
+        std::unique_ptr<slot_t[]> slots;
+        // colors that found no free slot within MAX_PROBES
+        std::atomic<uint64_t> dropped{0};
+        // total calls at the previous write, used for the recent call rate
+        uint64_t last_calls = 0;
+    } category_t;
+
+    std::vector<category_t> categories;
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point last_write_time;
+
+    std::thread writer;
+    std::mutex writer_mtx;
+    std::condition_variable writer_cv;
+    bool writer_stop = false;
+
+    slot_t* find_slot(category_t& cat, uint32_t color);
+    void writer_loop(std::filesystem::path path, std::chrono::seconds interval);
+
+public:
+    explicit color_census(const std::vector<std::string>& category_names);
+    ~color_census();
+    color_census(const color_census&) = delete;
+    color_census& operator=(const color_census&) = delete;
+
+    /**
+     * Records one call of a color hook
+     * @param color The original color in COLORREF format, the upper byte is ignored
+     * @param category Index of the category name passed to the constructor
+     * @param hit True if colors.yaml mapped the color
+     */
+    void record(const uint32_t color, const size_t category, const bool hit)
+    {
+        slot_t* s = find_slot(categories[category], color & 0x00FFFFFF);
+
+        if (!s)
+            return;
+
+        (hit ? s->hits : s->misses).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<color_census_entry_t> snapshot(size_t category) const;
+    bool write(const std::filesystem::path& path);
+    void start_writer(const std::filesystem::path& path, std::chrono::seconds interval);
+    void stop_writer();
+};
@@ -0,0 +1,489 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "color_config.hpp"
+
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace color_config
+{
+namespace
+{
+constexpr const char* COLORS_FILE_NAME = "colors.yaml";
+
+const std::pair<color_category, const char*> color_categories[] = {
+    {CATEGORY_TEXT, "text"},
+    {CATEGORY_SHAPES, "shapes"},
+};
+
+const std::pair<WND_TYPE, const char*> window_sections[] = {
+    {WND_TYPE_COMP_DENOISE, "compDenoise"},
+    {WND_TYPE_WDB, "wdb"},
+};
+
+/**
+ * Compiles the color mappings of colors.yaml into one lookup table per color category
+ * Keys are matched case-insensitively, for duplicate keys the first mapping wins
+ * @param root The colors.yaml root or a window section
+ * @param maps The color maps of one window type
+ * @return True if compiling was successful
+ */
+bool compile_colors(YAML::Node root, std::array<color_map_t, 2>& maps)
+{
+    for (const auto& [category, name] : color_categories)
+    {
+        auto& table = maps[category].table;
+        table.clear();
+
+        const auto category_node = root[name];
+
+        if (!category_node.IsDefined() || category_node.IsNull())
+            continue;
+
+        if (!category_node.IsMap())
+        {
+            SPDLOG_ERROR("{} section in {} must be a map", name, COLORS_FILE_NAME);
+            return false;
+        }
+
+        for (auto it = category_node.begin(); it != category_node.end(); ++it)
+        {
+            std::string src_str;
+            std::string dst_str;
+
+            try
+            {
+                src_str = it->first.as<std::string>();
+                dst_str = it->second.IsNull() ? "" : it->second.as<std::string>();
+            }
+            catch (YAML::TypedBadConversion<std::string>&)
+            {
+                SPDLOG_ERROR("error parsing color mapping in {} section", name);
+                continue;
+            }
+
+            // empty value keeps the original color
+            if (dst_str.empty())
+                continue;
+
+            const auto src = parse_hex(src_str);
+            const auto dst = parse_hex(dst_str);
+
+            if (!src || !dst)
+                continue;
+
+            table.insert(*src, *dst);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Parses a single entry of a rules list in colors.yaml
+ * @param node Map with exactly one key naming the rule
+ * @return The parsed rule
+ */
+std::optional<color_rule_t> parse_color_rule(const YAML::Node& node)
+{
+    if (!node.IsMap() || node.size() != 1)
+    {
+        SPDLOG_ERROR("a rule must be a map with a single key");
+        return std::nullopt;
+    }
+
+    const auto name = node.begin()->first.as<std::string>();
+    auto value = node.begin()->second;
+
+    color_rule_t rule = {};
+
+    try
+    {
+        if (name == "hueRotate")
+        {
+            rule.type = RULE_HUE_ROTATE;
+            rule.amount = value.as<float>();
+            return rule;
+        }
+
+        if (name == "saturation")
+        {
+            rule.type = RULE_SATURATION;
+            rule.amount = value.as<float>();
+
+            if (rule.amount < 0.0f)
+            {
+                SPDLOG_ERROR("saturation value must not be negative");
+                return std::nullopt;
+            }
+
+            return rule;
+        }
+
+        if (name == "lightness")
+        {
+            rule.type = RULE_LIGHTNESS;
+            rule.amount = value.as<float>();
+
+            if (rule.amount < 0.0f || rule.amount > 2.0f)
+            {
+                SPDLOG_ERROR("lightness value must be between 0 and 2");
+                return std::nullopt;
+            }
+
+            return rule;
+        }
+
+        if (name == "grayRamp")
+        {
+            rule.type = RULE_GRAY_RAMP;
+
+            const auto range = value["range"];
+
+            if (!range.IsSequence() || range.size() != 2)
+            {
+                SPDLOG_ERROR("grayRamp range must be a list of two gray levels");
+                return std::nullopt;
+            }
+
+            const auto range_min = range[0].as<uint32_t>();
+            const auto range_max = range[1].as<uint32_t>();
+            const auto tolerance = value["tolerance"].IsScalar() ? value["tolerance"].as<uint32_t>() : 8;
+
+            if (range_min > range_max || range_max > 255 || tolerance > 255)
+            {
+                SPDLOG_ERROR("grayRamp range and tolerance must be between 0 and 255");
+                return std::nullopt;
+            }
+
+            const auto from = parse_hex(value["from"].as<std::string>());
+            const auto to = parse_hex(value["to"].as<std::string>());
+
+            if (!from || !to)
+                return std::nullopt;
+
+            rule.range_min = static_cast<uint8_t>(range_min);
+            rule.range_max = static_cast<uint8_t>(range_max);
+            rule.tolerance = static_cast<uint8_t>(tolerance);
+            rule.ramp_from = *from;
+            rule.ramp_to = *to;
+            return rule;
+        }
+    }
+    catch (YAML::Exception&)
+    {
+        SPDLOG_ERROR("error parsing {} rule", name);
+        return std::nullopt;
+    }
+
+    SPDLOG_ERROR("unknown rule: {}", name);
+    return std::nullopt;
+}
+
+/**
+ * Bakes the color rules of colors.yaml into one lookup table per color category
+ * @param root The colors.yaml root or a window section
+ * @param mode Interpolation between the lookup table nodes
+ * @param maps The color maps of one window type
+ * @return True if compiling was successful
+ */
+bool compile_rules(YAML::Node root, const lut_interpolation mode, std::array<color_map_t, 2>& maps)
+{
+    for (const auto& [category, name] : color_categories)
+    {
+        auto& lut = maps[category].lut;
+        lut.clear();
+
+        const auto rules_node = root["rules"][name];
+
+        if (!rules_node.IsDefined() || rules_node.IsNull())
+            continue;
+
+        if (!rules_node.IsSequence())
+        {
+            SPDLOG_ERROR("rules for {} must be a list", name);
+            return false;
+        }
+
+        std::vector<color_rule_t> rules;
+
+        for (const auto& rule_node : rules_node)
+        {
+            const auto rule = parse_color_rule(rule_node);
+
+            if (!rule)
+                return false;
+
+            rules.push_back(*rule);
+        }
+
+        lut.bake(rules, mode);
+    }
+
+    return true;
+}
+
+/**
+ * Compiles the window sections of colors.yaml, windows without a section use the main window mapping
+ * @param root The colors.yaml root
+ * @param mode Interpolation between the lookup table nodes
+ * @param colors The compiled colors
+ * @return True if compiling was successful
+ */
+bool compile_window_colors(YAML::Node root, const lut_interpolation mode, compiled_colors_t& colors)
+{
+    colors.window_maps_enabled.fill(false);
+
+    const auto windows_node = root["windows"];
+
+    if (!windows_node.IsDefined() || windows_node.IsNull())
+        return true;
+
+    if (!windows_node.IsMap())
+    {
+        SPDLOG_ERROR("windows section in {} must be a map", COLORS_FILE_NAME);
+        return false;
+    }
+
+    for (const auto& [wnd_type, name] : window_sections)
+    {
+        const auto section = windows_node[name];
+
+        if (!section.IsDefined() || section.IsNull())
+            continue;
+
+        if (!section.IsMap())
+        {
+            SPDLOG_ERROR("{} window section must be a map", name);
+            return false;
+        }
+
+        if (!compile_colors(section, colors.maps[wnd_type]) || !compile_rules(section, mode, colors.maps[wnd_type]))
+            return false;
+
+        colors.window_maps_enabled[wnd_type] = true;
+    }
+
+    return true;
+}
+}
+
+/**
+ * Convert RGB hex string (#RRGGBB) to COLORREF (BBGGRR)
+ * See https://learn.microsoft.com/en-us/windows/win32/gdi/colorref
+ * @param hex The color as hex string
+ * @return The color in COLORREF format
+ */
+std::optional<uint32_t> parse_hex(const std::string& hex)
+{
+    if (hex.empty())
+    {
+        SPDLOG_ERROR("empty hex value passed");
+        return std::nullopt;
+    }
+
+    std::string clean_hex = (hex[0] == '#') ? hex.substr(1) : hex;
+
+    if (clean_hex.length() != 6)
+    {
+        SPDLOG_ERROR("invalid value passed: {}", hex);
+        return std::nullopt;
+    }
+
+    unsigned long value = 0;
+
+    try
+    {
+        value = std::stoul(clean_hex, nullptr, 16);
+    }
+    catch (...)
+    {
+        SPDLOG_ERROR("invalid hex value passed: {}", clean_hex);
+        return std::nullopt;
+    }
+
+    const uint8_t r = (value >> 16) & 0xFF;
+    const uint8_t g = (value >> 8) & 0xFF;
+    const uint8_t b = value & 0xFF;
+
+    return static_cast<uint32_t>(r) | static_cast<uint32_t>(g) << 8 | static_cast<uint32_t>(b) << 16;
+}
+
+/**
+ * Reads and compiles colors.yaml
+ * @param colors_path Path to colors.yaml
+ * @param colors The compiled colors
+ * @return True if loading was successful
+ */
+bool load_file(const std::filesystem::path& colors_path, compiled_colors_t& colors)
+{
+    if (!std::filesystem::exists(colors_path))
+    {
+        SPDLOG_ERROR("can't find {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    std::ifstream colors_file(colors_path);
+
+    if (!colors_file.is_open())
+    {
+        SPDLOG_ERROR("can't open {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    YAML::Node root;
+
+    try
+    {
+        root = YAML::Load(colors_file);
+    }
+    catch (YAML::ParserException&)
+    {
+        SPDLOG_ERROR("failed to parse {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    return compile(root, colors);
+}
+
+/**
+ * Compiles a parsed colors.yaml
+ * @param root The colors.yaml root
+ * @param colors The compiled colors
+ * @return True if compiling was successful
+ */
+bool compile(YAML::Node root, compiled_colors_t& colors)
+{
+    auto mode = LUT_TRILINEAR;
+
+    if (root["lutInterpolation"].IsScalar())
+    {
+        const auto mode_str = root["lutInterpolation"].as<std::string>();
+
+        if (mode_str == "nearest")
+            mode = LUT_NEAREST;
+        else if (mode_str != "trilinear")
+        {
+            SPDLOG_ERROR("lutInterpolation must be nearest or trilinear");
+            return false;
+        }
+    }
+
+    if (!compile_colors(root, colors.maps[WND_TYPE_MAIN]))
+    {
+        SPDLOG_ERROR("failed to compile {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    if (!compile_rules(root, mode, colors.maps[WND_TYPE_MAIN]))
+    {
+        SPDLOG_ERROR("failed to compile rules in {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    if (!compile_window_colors(root, mode, colors))
+    {
+        SPDLOG_ERROR("failed to compile window sections in {}", COLORS_FILE_NAME);
+        return false;
+    }
+
+    colors.bm_mode = BITMAP_MODE_REPLACE;
+
+    if (root["bitmapMode"].IsScalar())
+    {
+        const auto mode_str = root["bitmapMode"].as<std::string>();
+
+        if (mode_str == "palette")
+            colors.bm_mode = BITMAP_MODE_PALETTE;
+        else if (mode_str != "replace")
+        {
+            SPDLOG_ERROR("bitmapMode must be replace or palette");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Writes compiled colors in the layout of a compiled theme
+ * Layout: bitmap mode, bit mask of the enabled window sections, then table and lookup table of every map
+ * @param colors The compiled colors
+ * @param words Output words
+ */
+void save(const compiled_colors_t& colors, std::vector<uint32_t>& words)
+{
+    uint32_t enabled_mask = 0;
+
+    for (size_t i = 0; i < colors.window_maps_enabled.size(); i++)
+        enabled_mask |= colors.window_maps_enabled[i] ? 1u << i : 0;
+
+    words.push_back(colors.bm_mode);
+    words.push_back(enabled_mask);
+
+    for (const auto& wnd_maps : colors.maps)
+    {
+        for (const auto& map : wnd_maps)
+        {
+            map.table.save(words);
+            map.lut.save(words);
+        }
+    }
+}
+
+/**
+ * Restores colors written by save without parsing colors.yaml
+ * @param words Input words
+ * @param word_count Number of words available
+ * @param colors The compiled colors
+ * @return False if the data is invalid
+ */
+bool load(const uint32_t* words, const size_t word_count, compiled_colors_t& colors)
+{
+    if (word_count < 2 || words[0] > BITMAP_MODE_PALETTE || words[1] >= 1u << colors.window_maps_enabled.size())
+        return false;
+
+    colors.bm_mode = static_cast<bitmap_mode>(words[0]);
+
+    for (size_t i = 0; i < colors.window_maps_enabled.size(); i++)
+        colors.window_maps_enabled[i] = (words[1] >> i & 1) != 0;
+
+    size_t pos = 2;
+
+    for (auto& wnd_maps : colors.maps)
+    {
+        for (auto& map : wnd_maps)
+        {
+            const size_t table_words = map.table.load(words + pos, word_count - pos);
+
+            if (table_words == 0)
+                return false;
+
+            pos += table_words;
+            const size_t lut_words = map.lut.load(words + pos, word_count - pos);
+
+            if (lut_words == 0)
+                return false;
+
+            pos += lut_words;
+        }
+    }
+
+    return pos == word_count;
+}
+}
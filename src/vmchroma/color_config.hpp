@@ -0,0 +1,85 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "color_map.hpp"
+#include "theme_types.hpp"
+#include "yaml-cpp/yaml.h"
+
+/**
+ * Everything colors.yaml compiles to
+ */
+typedef struct compiled_colors
+{
+    // indexed by window type, then by color category
+    std::array<std::array<color_map_t, 2>, 3> maps;
+    std::array<bool, 3> window_maps_enabled = {};
+    bitmap_mode bm_mode = BITMAP_MODE_REPLACE;
+
+    /**
+     * Maps a color drawn in a window, explicit mappings take precedence over rules in every window:
+     * window mappings, main mappings, window rules and finally main rules
+     * @param color The original color in COLORREF format
+     * @param category Text or shapes
+     * @param wnd_type The window the color is drawn in
+     * @return The mapped color or std::nullopt if the color stays unchanged
+     */
+    std::optional<uint32_t> find(const uint32_t color, const color_category category, const WND_TYPE wnd_type) const
+    {
+        const auto& main = maps[WND_TYPE_MAIN][category];
+
+        if (wnd_type == WND_TYPE_MAIN || !window_maps_enabled[wnd_type])
+            return main.find(color);
+
+        const auto& window = maps[wnd_type][category];
+
+        if (const auto mapped = window.table.find(color))
+            return mapped;
+
+        if (const auto mapped = main.table.find(color))
+            return mapped;
+
+        if (!window.lut.empty())
+            return window.lut.apply(color);
+
+        if (!main.lut.empty())
+            return main.lut.apply(color);
+
+        return std::nullopt;
+    }
+} compiled_colors_t;
+
+/**
+ * Compiler for colors.yaml, shared by the DLL and the vmtheme compiler
+ */
+namespace color_config
+{
+std::optional<uint32_t> parse_hex(const std::string& hex);
+bool load_file(const std::filesystem::path& colors_path, compiled_colors_t& colors);
+bool compile(YAML::Node root, compiled_colors_t& colors);
+void save(const compiled_colors_t& colors, std::vector<uint32_t>& words);
+bool load(const uint32_t* words, size_t word_count, compiled_colors_t& colors);
+}
@@ -0,0 +1,219 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "color_grade.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.hpp"
+
+namespace
+{
+// channel multipliers of the warm shift at full strength, roughly a 3400K white point
+constexpr float NIGHT_MODE_G = 0.82f;
+constexpr float NIGHT_MODE_B = 0.58f;
+
+/**
+ * Applies contrast, gamma, tint and warm shift to a single channel value
+ * @param v Channel value between 0 and 1
+ * @param tint Tint channel value between 0 and 1
+ * @param night_mode_factor Channel multiplier of the warm shift at full strength
+ * @param s Grading settings
+ * @return The graded value between 0 and 1
+ */
+float grade_channel(float v, const float tint, const float night_mode_factor, const grade_settings_t& s)
+{
+    v = (v - 0.5f) * s.contrast + 0.5f;
+    v = std::min(1.0f, std::max(0.0f, v));
+    v = std::pow(v, 1.0f / s.gamma);
+    v += (tint - v) * s.tint_strength;
+    v *= 1.0f + (night_mode_factor - 1.0f) * s.night_mode;
+
+    return std::min(1.0f, std::max(0.0f, v));
+}
+
+/**
+ * Grades a BGRX pixel value through the pre-shifted channel tables, the fourth byte is preserved
+ */
+inline uint32_t grade_pixel(const uint32_t v, const uint32_t* r, const uint32_t* g, const uint32_t* b)
+{
+    return (v & 0xFF000000) | r[(v >> 16) & 0xFF] | g[(v >> 8) & 0xFF] | b[v & 0xFF];
+}
+
+#if defined(VMCHROMA_SSE2)
+/**
+ * Looks up 8 BGRX pixels at once with gathers from the pre-shifted channel tables
+ * UI frames are mostly flat areas, vectors that repeat the previous pixel skip the gathers
+ */
+VMCHROMA_TARGET_AVX2
+void apply_row_avx2(uint32_t* px, const uint32_t width, const uint32_t* r, const uint32_t* g, const uint32_t* b)
+{
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    const __m256i last_lane = _mm256_set1_epi32(7);
+
+    if (width == 0)
+        return;
+
+    // seed the run with the first pixel and its real mapping, every value is a valid pixel so there is no "empty" marker
+    __m256i run_src = _mm256_set1_epi32(static_cast<int>(px[0]));
+    __m256i run_dst = _mm256_set1_epi32(static_cast<int>(grade_pixel(px[0], r, g, b)));
+    uint32_t x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + x));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(v, run_src)) == -1)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + x), run_dst);
+            continue;
+        }
+
+        const __m256i ib = _mm256_and_si256(v, byte_mask);
+        const __m256i ig = _mm256_and_si256(_mm256_srli_epi32(v, 8), byte_mask);
+        const __m256i ir = _mm256_and_si256(_mm256_srli_epi32(v, 16), byte_mask);
+
+        const __m256i vb = _mm256_i32gather_epi32(reinterpret_cast<const int*>(b), ib, 4);
+        const __m256i vg = _mm256_i32gather_epi32(reinterpret_cast<const int*>(g), ig, 4);
+        const __m256i vr = _mm256_i32gather_epi32(reinterpret_cast<const int*>(r), ir, 4);
+
+        const __m256i res = _mm256_or_si256(_mm256_or_si256(vb, vg), _mm256_or_si256(vr, _mm256_and_si256(v, alpha_mask)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + x), res);
+
+        run_src = _mm256_permutevar8x32_epi32(v, last_lane);
+        run_dst = _mm256_permutevar8x32_epi32(res, last_lane);
+    }
+
+    for (; x < width; x++)
+        px[x] = grade_pixel(px[x], r, g, b);
+}
+#endif
+}
+
+color_grade::color_grade()
+{
+    build({});
+}
+
+/**
+ * Bakes the grading settings into the channel tables
+ * @param settings Grading settings
+ */
+void color_grade::build(const grade_settings_t& settings)
+{
+    auto s = settings;
+    s.gamma = std::max(0.01f, s.gamma);
+    s.contrast = std::max(0.0f, s.contrast);
+    s.tint_strength = std::min(1.0f, std::max(0.0f, s.tint_strength));
+    s.night_mode = std::min(1.0f, std::max(0.0f, s.night_mode));
+
+    const float tint_r = (s.tint & 0xFF) / 255.0f;
+    const float tint_g = ((s.tint >> 8) & 0xFF) / 255.0f;
+    const float tint_b = ((s.tint >> 16) & 0xFF) / 255.0f;
+
+    identity = true;
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        const float v = i / 255.0f;
+
+        table_r[i] = static_cast<uint8_t>(grade_channel(v, tint_r, 1.0f, s) * 255.0f + 0.5f);
+        table_g[i] = static_cast<uint8_t>(grade_channel(v, tint_g, NIGHT_MODE_G, s) * 255.0f + 0.5f);
+        table_b[i] = static_cast<uint8_t>(grade_channel(v, tint_b, NIGHT_MODE_B, s) * 255.0f + 0.5f);
+
+        shifted_r[i] = static_cast<uint32_t>(table_r[i]) << 16;
+        shifted_g[i] = static_cast<uint32_t>(table_g[i]) << 8;
+        shifted_b[i] = table_b[i];
+
+        if (table_r[i] != i || table_g[i] != i || table_b[i] != i)
+            identity = false;
+    }
+}
+
+/**
+ * @return True if grading doesn't change any color and can be skipped
+ */
+bool color_grade::is_identity() const
+{
+    return identity;
+}
+
+const std::array<uint8_t, 256>& color_grade::get_table_r() const
+{
+    return table_r;
+}
+
+const std::array<uint8_t, 256>& color_grade::get_table_g() const
+{
+    return table_g;
+}
+
+const std::array<uint8_t, 256>& color_grade::get_table_b() const
+{
+    return table_b;
+}
+
+/**
+ * Grades a 32 bpp BGRX surface in place, the fourth byte is preserved
+ * @param bits First byte of the first row in memory
+ * @param width Width in pixels
+ * @param height Number of rows
+ * @param stride Row size in bytes
+ */
+void color_grade::apply(uint8_t* bits, const uint32_t width, const uint32_t height, const uint32_t stride) const
+{
+    if (identity)
+        return;
+
+#if defined(VMCHROMA_SSE2)
+    if (simd::has_avx2())
+    {
+        for (uint32_t y = 0; y < height; y++)
+            apply_row_avx2(reinterpret_cast<uint32_t*>(bits + static_cast<size_t>(y) * stride), width, shifted_r.data(), shifted_g.data(), shifted_b.data());
+
+        return;
+    }
+#endif
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        auto px = reinterpret_cast<uint32_t*>(bits + static_cast<size_t>(y) * stride);
+
+        for (uint32_t x = 0; x < width; x++)
+            px[x] = grade_pixel(px[x], shifted_r.data(), shifted_g.data(), shifted_b.data());
+    }
+}
+
+/**
+ * Reference implementation working on single bytes
+ */
+void color_grade::apply_scalar(uint8_t* bits, const uint32_t width, const uint32_t height, const uint32_t stride) const
+{
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t* row = bits + static_cast<size_t>(y) * stride;
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            row[x * 4 + 0] = table_b[row[x * 4 + 0]];
+            row[x * 4 + 1] = table_g[row[x * 4 + 1]];
+            row[x * 4 + 2] = table_r[row[x * 4 + 2]];
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+typedef struct grade_settings
+{
+    float gamma = 1.0f; // 1 = unchanged, > 1 brightens the mid tones
+    float contrast = 1.0f; // 1 = unchanged, scales the distance to mid gray
+    uint32_t tint = 0; // COLORREF everything is blended towards
+    float tint_strength = 0.0f; // 0 = no tint, 1 = fully tinted
+    float night_mode = 0.0f; // 0 = off, 1 = strongest warm shift
+} grade_settings_t;
+
+/**
+ * Frame-level color grading expressed as one 256 entry lookup table per channel
+ * The same tables drive the Direct2D table transfer effect and the CPU kernels
+ */
+class color_grade
+{
+    std::array<uint8_t, 256> table_r = {};
+    std::array<uint8_t, 256> table_g = {};
+    std::array<uint8_t, 256> table_b = {};
+    // tables with the value already shifted into its BGRA byte position, used by the kernels
+    std::array<uint32_t, 256> shifted_r = {};
+    std::array<uint32_t, 256> shifted_g = {};
+    std::array<uint32_t, 256> shifted_b = {};
+    bool identity = true;
+
+public:
+    color_grade();
+    void build(const grade_settings_t& settings);
+    bool is_identity() const;
+    const std::array<uint8_t, 256>& get_table_r() const;
+    const std::array<uint8_t, 256>& get_table_g() const;
+    const std::array<uint8_t, 256>& get_table_b() const;
+    void apply(uint8_t* bits, uint32_t width, uint32_t height, uint32_t stride) const;
+    void apply_scalar(uint8_t* bits, uint32_t width, uint32_t height, uint32_t stride) const;
+};
@@ -0,0 +1,379 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "color_lut.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.hpp"
+
+namespace
+{
+// Rec. 709 luma weights, same as the SVG / CSS color matrix filters
+constexpr float LUMA_R = 0.213f;
+constexpr float LUMA_G = 0.715f;
+constexpr float LUMA_B = 0.072f;
+
+typedef struct planes
+{
+    std::vector<float> r;
+    std::vector<float> g;
+    std::vector<float> b;
+} planes_t;
+
+typedef struct matrix3
+{
+    float m[9];
+} matrix3_t;
+
+/**
+ * Rotates the hue around the gray axis, see the hueRotate filter of the SVG spec
+ * @param degrees Rotation angle
+ * @return The color matrix
+ */
+matrix3_t hue_rotate_matrix(const float degrees)
+{
+    const float rad = degrees * 3.14159265f / 180.0f;
+    const float c = std::cos(rad);
+    const float s = std::sin(rad);
+
+    return {{
+        LUMA_R + c * (1 - LUMA_R) - s * LUMA_R, LUMA_G - c * LUMA_G - s * LUMA_G, LUMA_B - c * LUMA_B + s * (1 - LUMA_B),
+        LUMA_R - c * LUMA_R + s * 0.143f, LUMA_G + c * (1 - LUMA_G) + s * 0.140f, LUMA_B - c * LUMA_B - s * 0.283f,
+        LUMA_R - c * LUMA_R - s * (1 - LUMA_R), LUMA_G - c * LUMA_G + s * LUMA_G, LUMA_B + c * (1 - LUMA_B) + s * LUMA_B,
+    }};
+}
+
+/**
+ * Scales the saturation while keeping the luma, see the saturate filter of the SVG spec
+ * @param factor 0 = grayscale, 1 = unchanged
+ * @return The color matrix
+ */
+matrix3_t saturation_matrix(const float factor)
+{
+    return {{
+        LUMA_R + (1 - LUMA_R) * factor, LUMA_G - LUMA_G * factor, LUMA_B - LUMA_B * factor,
+        LUMA_R - LUMA_R * factor, LUMA_G + (1 - LUMA_G) * factor, LUMA_B - LUMA_B * factor,
+        LUMA_R - LUMA_R * factor, LUMA_G - LUMA_G * factor, LUMA_B + (1 - LUMA_B) * factor,
+    }};
+}
+
+float clamp01(const float v)
+{
+    return std::min(1.0f, std::max(0.0f, v));
+}
+
+void apply_matrix(planes_t& p, const matrix3_t& mat)
+{
+    const auto& m = mat.m;
+    const size_t n = p.r.size();
+    size_t i = 0;
+
+#if defined(VMCHROMA_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 r = _mm_loadu_ps(&p.r[i]);
+        const __m128 g = _mm_loadu_ps(&p.g[i]);
+        const __m128 b = _mm_loadu_ps(&p.b[i]);
+
+        __m128 nr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(m[0])), _mm_mul_ps(g, _mm_set1_ps(m[1]))), _mm_mul_ps(b, _mm_set1_ps(m[2])));
+        __m128 ng = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(m[3])), _mm_mul_ps(g, _mm_set1_ps(m[4]))), _mm_mul_ps(b, _mm_set1_ps(m[5])));
+        __m128 nb = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(m[6])), _mm_mul_ps(g, _mm_set1_ps(m[7]))), _mm_mul_ps(b, _mm_set1_ps(m[8])));
+
+        _mm_storeu_ps(&p.r[i], _mm_min_ps(one, _mm_max_ps(zero, nr)));
+        _mm_storeu_ps(&p.g[i], _mm_min_ps(one, _mm_max_ps(zero, ng)));
+        _mm_storeu_ps(&p.b[i], _mm_min_ps(one, _mm_max_ps(zero, nb)));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        const float r = p.r[i];
+        const float g = p.g[i];
+        const float b = p.b[i];
+
+        p.r[i] = clamp01(r * m[0] + g * m[1] + b * m[2]);
+        p.g[i] = clamp01(r * m[3] + g * m[4] + b * m[5]);
+        p.b[i] = clamp01(r * m[6] + g * m[7] + b * m[8]);
+    }
+}
+
+/**
+ * Factors below 1 blend towards black, factors above 1 blend towards white
+ * @param p Color planes
+ * @param factor Lightness factor between 0 and 2
+ */
+void apply_lightness(planes_t& p, const float factor)
+{
+    // c * scale + bias covers both directions
+    const float scale = factor <= 1.0f ? factor : 2.0f - factor;
+    const float bias = factor <= 1.0f ? 0.0f : factor - 1.0f;
+    const size_t n = p.r.size();
+    size_t i = 0;
+
+#if defined(VMCHROMA_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vbias = _mm_set1_ps(bias);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(&p.r[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p.r[i]), vscale), vbias));
+        _mm_storeu_ps(&p.g[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p.g[i]), vscale), vbias));
+        _mm_storeu_ps(&p.b[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p.b[i]), vscale), vbias));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        p.r[i] = p.r[i] * scale + bias;
+        p.g[i] = p.g[i] * scale + bias;
+        p.b[i] = p.b[i] * scale + bias;
+    }
+}
+
+/**
+ * Maps all near-gray colors within a luma range onto a gradient between two colors
+ * @param p Color planes
+ * @param rule The gray ramp rule
+ */
+void apply_gray_ramp(planes_t& p, const color_rule_t& rule)
+{
+    const float lo = rule.range_min / 255.0f;
+    const float hi = rule.range_max / 255.0f;
+    const float inv_range = hi > lo ? 1.0f / (hi - lo) : 0.0f;
+    const float tol = rule.tolerance / 255.0f;
+
+    const float from_r = (rule.ramp_from & 0xFF) / 255.0f;
+    const float from_g = ((rule.ramp_from >> 8) & 0xFF) / 255.0f;
+    const float from_b = ((rule.ramp_from >> 16) & 0xFF) / 255.0f;
+    const float delta_r = (rule.ramp_to & 0xFF) / 255.0f - from_r;
+    const float delta_g = ((rule.ramp_to >> 8) & 0xFF) / 255.0f - from_g;
+    const float delta_b = ((rule.ramp_to >> 16) & 0xFF) / 255.0f - from_b;
+
+    const size_t n = p.r.size();
+    size_t i = 0;
+
+#if defined(VMCHROMA_SSE2)
+    const __m128 vlo = _mm_set1_ps(lo);
+    const __m128 vhi = _mm_set1_ps(hi);
+    const __m128 vtol = _mm_set1_ps(tol);
+    const __m128 vinv = _mm_set1_ps(inv_range);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 r = _mm_loadu_ps(&p.r[i]);
+        const __m128 g = _mm_loadu_ps(&p.g[i]);
+        const __m128 b = _mm_loadu_ps(&p.b[i]);
+
+        const __m128 luma = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(LUMA_R)), _mm_mul_ps(g, _mm_set1_ps(LUMA_G))), _mm_mul_ps(b, _mm_set1_ps(LUMA_B)));
+        const __m128 chroma = _mm_sub_ps(_mm_max_ps(r, _mm_max_ps(g, b)), _mm_min_ps(r, _mm_min_ps(g, b)));
+
+        const __m128 mask = _mm_and_ps(_mm_cmple_ps(chroma, vtol), _mm_and_ps(_mm_cmpge_ps(luma, vlo), _mm_cmple_ps(luma, vhi)));
+        const __m128 t = _mm_mul_ps(_mm_sub_ps(luma, vlo), vinv);
+
+        const __m128 nr = _mm_add_ps(_mm_set1_ps(from_r), _mm_mul_ps(_mm_set1_ps(delta_r), t));
+        const __m128 ng = _mm_add_ps(_mm_set1_ps(from_g), _mm_mul_ps(_mm_set1_ps(delta_g), t));
+        const __m128 nb = _mm_add_ps(_mm_set1_ps(from_b), _mm_mul_ps(_mm_set1_ps(delta_b), t));
+
+        _mm_storeu_ps(&p.r[i], _mm_or_ps(_mm_and_ps(mask, nr), _mm_andnot_ps(mask, r)));
+        _mm_storeu_ps(&p.g[i], _mm_or_ps(_mm_and_ps(mask, ng), _mm_andnot_ps(mask, g)));
+        _mm_storeu_ps(&p.b[i], _mm_or_ps(_mm_and_ps(mask, nb), _mm_andnot_ps(mask, b)));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        const float r = p.r[i];
+        const float g = p.g[i];
+        const float b = p.b[i];
+
+        const float luma = r * LUMA_R + g * LUMA_G + b * LUMA_B;
+        const float chroma = std::max(r, std::max(g, b)) - std::min(r, std::min(g, b));
+
+        if (chroma > tol || luma < lo || luma > hi)
+            continue;
+
+        const float t = (luma - lo) * inv_range;
+        p.r[i] = from_r + delta_r * t;
+        p.g[i] = from_g + delta_g * t;
+        p.b[i] = from_b + delta_b * t;
+    }
+}
+
+/**
+ * Linear interpolation of each channel of two packed colors
+ * @param a First color
+ * @param b Second color
+ * @param f Weight of the second color in 1/256 steps, 0 to 256
+ * @return The interpolated color
+ */
+uint32_t lerp_rgb(const uint32_t a, const uint32_t b, const int32_t f)
+{
+    uint32_t res = 0;
+
+    for (int shift = 0; shift <= 16; shift += 8)
+    {
+        const int32_t ca = (a >> shift) & 0xFF;
+        const int32_t cb = (b >> shift) & 0xFF;
+        res |= static_cast<uint32_t>(ca + (((cb - ca) * f + 128) >> 8)) << shift;
+    }
+
+    return res;
+}
+}
+
+/**
+ * Evaluates the rules in order for every node of the table
+ * @param rules The color rules, applied one after another
+ * @param mode Lookup mode used by apply()
+ */
+void color_lut::bake(const std::vector<color_rule_t>& rules, const lut_interpolation mode)
+{
+    interpolation = mode;
+
+    if (rules.empty())
+    {
+        nodes.clear();
+        return;
+    }
+
+    constexpr size_t node_count = GRID_SIZE * GRID_SIZE * GRID_SIZE;
+
+    planes_t p;
+    p.r.resize(node_count);
+    p.g.resize(node_count);
+    p.b.resize(node_count);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        p.r[i] = static_cast<float>(i % GRID_SIZE) / (GRID_SIZE - 1);
+        p.g[i] = static_cast<float>(i / GRID_SIZE % GRID_SIZE) / (GRID_SIZE - 1);
+        p.b[i] = static_cast<float>(i / (GRID_SIZE * GRID_SIZE)) / (GRID_SIZE - 1);
+    }
+
+    for (const auto& rule : rules)
+    {
+        switch (rule.type)
+        {
+        case RULE_HUE_ROTATE:
+            apply_matrix(p, hue_rotate_matrix(rule.amount));
+            break;
+        case RULE_SATURATION:
+            apply_matrix(p, saturation_matrix(rule.amount));
+            break;
+        case RULE_LIGHTNESS:
+            apply_lightness(p, rule.amount);
+            break;
+        case RULE_GRAY_RAMP:
+            apply_gray_ramp(p, rule);
+            break;
+        }
+    }
+
+    nodes.resize(node_count);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        const auto r = static_cast<uint32_t>(clamp01(p.r[i]) * 255.0f + 0.5f);
+        const auto g = static_cast<uint32_t>(clamp01(p.g[i]) * 255.0f + 0.5f);
+        const auto b = static_cast<uint32_t>(clamp01(p.b[i]) * 255.0f + 0.5f);
+        nodes[i] = r | (g << 8) | (b << 16);
+    }
+}
+
+/**
+ * Appends the baked nodes to a compiled theme
+ * Layout: interpolation mode, node count (0 or GRID_SIZE^3), then the nodes
+ * @param words Output words
+ */
+void color_lut::save(std::vector<uint32_t>& words) const
+{
+    words.push_back(interpolation);
+    words.push_back(static_cast<uint32_t>(nodes.size()));
+    words.insert(words.end(), nodes.begin(), nodes.end());
+}
+
+/**
+ * Restores nodes written by save
+ * @param words Input words
+ * @param word_count Number of words available
+ * @return Number of words consumed, 0 if the data is invalid
+ */
+size_t color_lut::load(const uint32_t* words, const size_t word_count)
+{
+    constexpr size_t node_count = GRID_SIZE * GRID_SIZE * GRID_SIZE;
+
+    nodes.clear();
+
+    if (word_count < 2 || words[0] > LUT_TRILINEAR || (words[1] != 0 && words[1] != node_count) || word_count - 2 < words[1])
+        return 0;
+
+    interpolation = static_cast<lut_interpolation>(words[0]);
+    nodes.assign(words + 2, words + 2 + words[1]);
+    return 2 + words[1];
+}
+
+void color_lut::clear()
+{
+    nodes.clear();
+}
+
+bool color_lut::empty() const
+{
+    return nodes.empty();
+}
+
+/**
+ * Interpolates between the 8 surrounding nodes of a color
+ * @param color The original color in COLORREF format
+ * @return The transformed color in COLORREF format
+ */
+uint32_t color_lut::apply_trilinear(const uint32_t color) const
+{
+    uint32_t idx[3];
+    int32_t frac[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        // grid position in 1/256 steps
+        const uint32_t pos = (((color >> (c * 8)) & 0xFF) * (GRID_SIZE - 1) * 256 + 127) / 255;
+        idx[c] = pos >> 8;
+        frac[c] = pos & 0xFF;
+
+        // the last node has no upper neighbour, interpolate fully towards it from below
+        if (idx[c] == GRID_SIZE - 1)
+        {
+            idx[c] = GRID_SIZE - 2;
+            frac[c] = 256;
+        }
+    }
+
+    constexpr uint32_t stride_g = GRID_SIZE;
+    constexpr uint32_t stride_b = GRID_SIZE * GRID_SIZE;
+    const uint32_t* n = &nodes[idx[2] * stride_b + idx[1] * stride_g + idx[0]];
+
+    const uint32_t c00 = lerp_rgb(n[0], n[1], frac[0]);
+    const uint32_t c01 = lerp_rgb(n[stride_g], n[stride_g + 1], frac[0]);
+    const uint32_t c10 = lerp_rgb(n[stride_b], n[stride_b + 1], frac[0]);
+    const uint32_t c11 = lerp_rgb(n[stride_b + stride_g], n[stride_b + stride_g + 1], frac[0]);
+
+    return lerp_rgb(lerp_rgb(c00, c01, frac[1]), lerp_rgb(c10, c11, frac[1]), frac[2]);
+}
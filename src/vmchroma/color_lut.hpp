@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum color_rule_type { RULE_HUE_ROTATE, RULE_SATURATION, RULE_LIGHTNESS, RULE_GRAY_RAMP };
+
+enum lut_interpolation { LUT_NEAREST, LUT_TRILINEAR };
+
+typedef struct color_rule
+{
+    color_rule_type type;
+    float amount; // degrees for hue rotation, factor for saturation and lightness
+    uint8_t range_min; // gray ramp: darkest gray level that is remapped
+    uint8_t range_max; // gray ramp: brightest gray level that is remapped
+    uint8_t tolerance; // gray ramp: max difference between channels to still count as gray
+    uint32_t ramp_from; // gray ramp: COLORREF that range_min is mapped to
+    uint32_t ramp_to; // gray ramp: COLORREF that range_max is mapped to
+} color_rule_t;
+
+/**
+ * RGB lookup table with 32 nodes per axis that holds the result of a list of color rules
+ * The rules are baked once when the theme is loaded, so applying them costs the same no matter how many rules there are
+ */
+class color_lut
+{
+public:
+    static constexpr uint32_t GRID_SIZE = 32;
+
+private:
+    // COLORREF per node, indexed by (b * GRID_SIZE + g) * GRID_SIZE + r
+    std::vector<uint32_t> nodes;
+    lut_interpolation interpolation = LUT_TRILINEAR;
+
+    uint32_t apply_trilinear(uint32_t color) const;
+
+public:
+    void bake(const std::vector<color_rule_t>& rules, lut_interpolation mode);
+    void save(std::vector<uint32_t>& words) const;
+    size_t load(const uint32_t* words, size_t word_count);
+    void clear();
+    bool empty() const;
+
+    /**
+     * Maps a color through the baked rules, the upper byte of the COLORREF is ignored
+     * @param color The original color in COLORREF format
+     * @return The transformed color in COLORREF format
+     */
+    uint32_t apply(uint32_t color) const
+    {
+        if (interpolation == LUT_TRILINEAR)
+            return apply_trilinear(color);
+
+        // nearest node, (c * 31 + 127) / 255 rounds to the closest of the 32 grid positions
+        const uint32_t r = ((color & 0xFF) * (GRID_SIZE - 1) + 127) / 255;
+        const uint32_t g = (((color >> 8) & 0xFF) * (GRID_SIZE - 1) + 127) / 255;
+        const uint32_t b = (((color >> 16) & 0xFF) * (GRID_SIZE - 1) + 127) / 255;
+
+        return nodes[(b * GRID_SIZE + g) * GRID_SIZE + r];
+    }
+};
@@ -0,0 +1,56 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "color_lut.hpp"
+#include "color_table.hpp"
+
+/**
+ * Compiled color mapping of one category in colors.yaml
+ * Explicit mappings take precedence, all other colors go through the baked rules if there are any
+ */
+typedef struct color_map
+{
+    color_table table;
+    color_lut lut;
+
+    void clear()
+    {
+        table.clear();
+        lut.clear();
+    }
+
+    /**
+     * Maps a color, the upper byte of the COLORREF is ignored
+     * @param color The original color in COLORREF format
+     * @return The mapped color or std::nullopt if the color stays unchanged
+     */
+    std::optional<uint32_t> find(const uint32_t color) const
+    {
+        if (const auto mapped = table.find(color))
+            return mapped;
+
+        if (!lut.empty())
+            return lut.apply(color);
+
+        return std::nullopt;
+    }
+} color_map_t;
@@ -0,0 +1,158 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "color_table.hpp"
+
+/**
+ * Removes all entries from the table
+ */
+void color_table::clear()
+{
+    entries.clear();
+    shift = 32;
+    count = 0;
+}
+
+/**
+ * Adds a color mapping to the table, an existing mapping for the same color is kept
+ * @param key The original color in COLORREF format
+ * @param value The replacement color in COLORREF format
+ * @return True if the mapping was added, false if the color was already mapped
+ */
+bool color_table::insert(uint32_t key, uint32_t value)
+{
+    key &= COLOR_MASK;
+
+    // keep the load factor at or below 50% so probe sequences stay short
+    if (entries.empty() || (count + 1) * 2 > entries.size())
+        rehash(entries.empty() ? 4 : 32 - shift + 1);
+
+    const uint32_t mask = static_cast<uint32_t>(entries.size()) - 1;
+
+    for (uint32_t i = slot(key);; i = (i + 1) & mask)
+    {
+        auto& e = entries[i];
+
+        if (e.key == key)
+            return false;
+
+        if (e.key == EMPTY_KEY)
+        {
+            e = {key, value};
+            count++;
+            return true;
+        }
+    }
+}
+
+/**
+ * Resizes the table to 2^capacity_bits slots and reinserts all entries
+ * @param capacity_bits Log2 of the new slot count
+ */
+void color_table::rehash(uint32_t capacity_bits)
+{
+    std::vector<entry_t> old_entries(1u << capacity_bits, {EMPTY_KEY, 0});
+    old_entries.swap(entries);
+    shift = 32 - capacity_bits;
+
+    const uint32_t mask = static_cast<uint32_t>(entries.size()) - 1;
+
+    for (const auto& e : old_entries)
+    {
+        if (e.key == EMPTY_KEY)
+            continue;
+
+        uint32_t i = slot(e.key);
+
+        while (entries[i].key != EMPTY_KEY)
+            i = (i + 1) & mask;
+
+        entries[i] = e;
+    }
+}
+
+/**
+ * Appends the slots as they are to a compiled theme, so loading doesn't insert anything again
+ * Layout: capacity bits, entry count, then key and value of every slot
+ * @param words Output words
+ */
+void color_table::save(std::vector<uint32_t>& words) const
+{
+    words.push_back(entries.empty() ? 0 : 32 - shift);
+    words.push_back(count);
+
+    for (const auto& e : entries)
+    {
+        words.push_back(e.key);
+        words.push_back(e.value);
+    }
+}
+
+/**
+ * Restores slots written by save, the probe sequences are checked to end so a corrupt table can't hang find
+ * @param words Input words
+ * @param word_count Number of words available
+ * @return Number of words consumed, 0 if the data is invalid
+ */
+size_t color_table::load(const uint32_t* words, const size_t word_count)
+{
+    clear();
+
+    if (word_count < 2 || words[0] > 24)
+        return 0;
+
+    const uint32_t capacity_bits = words[0];
+    const size_t slots = capacity_bits == 0 ? 0 : size_t{1} << capacity_bits;
+    const size_t used = 2 + slots * 2;
+
+    if (word_count < used || (slots == 0 && words[1] != 0) || (slots != 0 && words[1] >= slots))
+        return 0;
+
+    std::vector<entry_t> loaded(slots);
+    uint32_t filled = 0;
+
+    for (size_t i = 0; i < slots; i++)
+    {
+        loaded[i] = {words[2 + i * 2], words[3 + i * 2]};
+
+        if (loaded[i].key != EMPTY_KEY)
+        {
+            if ((loaded[i].key & ~COLOR_MASK) != 0)
+                return 0;
+
+            filled++;
+        }
+    }
+
+    if (filled != words[1])
+        return 0;
+
+    entries = std::move(loaded);
+    shift = slots == 0 ? 32 : 32 - capacity_bits;
+    count = filled;
+    return used;
+}
+
+size_t color_table::size() const
+{
+    return count;
+}
+
+bool color_table::empty() const
+{
+    return count == 0;
+}
@@ -0,0 +1,85 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * Flat open-addressing hash table that maps 24-bit COLORREF values (0x00BBGGRR) to their replacement
+ * The table is filled once when the theme is loaded, lookups are a single integer probe sequence
+ * without strings or allocations, so it can be used from the GDI hooks directly
+ */
+class color_table
+{
+    static constexpr uint32_t EMPTY_KEY = 0xFFFFFFFF;
+    static constexpr uint32_t COLOR_MASK = 0x00FFFFFF;
+
+    typedef struct entry
+    {
+        uint32_t key;
+        uint32_t value;
+    } entry_t;
+
+    std::vector<entry_t> entries;
+    uint32_t shift = 32;
+    uint32_t count = 0;
+
+    uint32_t slot(uint32_t key) const
+    {
+        // fibonacci hashing, the upper bits are well distributed even for similar colors
+        return (key * 0x9E3779B1u) >> shift;
+    }
+
+    void rehash(uint32_t capacity_bits);
+
+public:
+    void clear();
+    bool insert(uint32_t key, uint32_t value);
+    void save(std::vector<uint32_t>& words) const;
+    size_t load(const uint32_t* words, size_t word_count);
+    size_t size() const;
+    bool empty() const;
+
+    /**
+     * Looks up the replacement for a color, the upper byte of the COLORREF is ignored
+     * @param key The original color in COLORREF format
+     * @return The mapped color or std::nullopt if the color is not part of the table
+     */
+    std::optional<uint32_t> find(uint32_t key) const
+    {
+        if (count == 0)
+            return std::nullopt;
+
+        key &= COLOR_MASK;
+        const uint32_t mask = static_cast<uint32_t>(entries.size()) - 1;
+
+        for (uint32_t i = slot(key);; i = (i + 1) & mask)
+        {
+            const auto& e = entries[i];
+
+            if (e.key == key)
+                return e.value;
+
+            if (e.key == EMPTY_KEY)
+                return std::nullopt;
+        }
+    }
+};
@@ -17,11 +17,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "config_manager.hpp"
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
+#include "bmp_decoder.hpp"
+#include "theme_cache.hpp"
+#include "theme_compiler.hpp"
+#include "theme_loader.hpp"
+#include "theme_share.hpp"
+#include "thread_pool.hpp"
 #include "window_manager.hpp"
 #include "yaml-cpp/yaml.h"
 
@@ -211,8 +218,10 @@ std::optional<flavor_id> config_manager::get_current_flavor_id()
 }
 
 /**
- * Loads the theme bitmap data from the theme directory
- * @return True if loading was successful
+ * Resolves the active theme and starts loading colors.yaml and the backgrounds on worker threads
+ * A theme compiled with vmtheme is mapped right here instead, see load_pack
+ * See wait_theme for the point where the loader is joined
+ * @return True if the theme could be resolved
  */
 bool config_manager::init_theme()
 {
@@ -224,7 +233,15 @@ bool config_manager::init_theme()
         return false;
     }
 
-    active_flavor = flavor_map[*flavor_id];
+    const auto* flavor = flavors::find(*flavor_id);
+
+    if (!flavor)
+    {
+        SPDLOG_ERROR("unknown Voicemeeter flavor");
+        return false;
+    }
+
+    active_flavor = *flavor;
 
     // no theme specified
     if (!yaml_config["theme"][active_flavor.name].IsScalar())
@@ -262,71 +279,367 @@ bool config_manager::init_theme()
 
     auto userprofile_path = utils::get_userprofile_path();
 
-    std::wstring theme_path = (std::filesystem::path(*userprofile_path) / L"themes" / *active_theme_name_wstr / *active_flavor_name);
+    const auto theme_root = std::filesystem::path(*userprofile_path) / L"themes" / *active_theme_name_wstr;
+    const auto pack_path = theme_root / (*active_flavor_name + THEME_PACK_EXTENSION);
+    sprite_dir = theme_root / SPRITE_DIR;
+    theme_dir = theme_root / *active_flavor_name;
+
+    // a theme compiled with vmtheme is mapped and ready, there is nothing to load in the background
+    if (std::filesystem::exists(pack_path))
+        return timed_phase("pack", [&] { return load_pack(pack_path); });
+
+    if (cfg_get_theme_cache().value_or(false) && timed_phase("cache", [&] { return load_cached(theme_root); }))
+        return true;
+
+    // the settings and cassette backgrounds are only loaded once Voicemeeter asks for them, see load_lazy
+    loader = std::make_unique<theme_loader>();
+    loader->start(theme_root, active_flavor);
+
+    return true;
+}
 
-    if (!std::filesystem::exists(std::filesystem::path(theme_path) / BM_FILE_BG))
+/**
+ * Registers the sprites listed in sprites.yaml, the sprite files themselves are loaded on first use
+ * @param entries Entries of sprites.yaml
+ * @return True if all file names could be converted
+ */
+bool config_manager::add_sprites(const std::vector<sprite_entry_t>& entries)
+{
+    for (const auto& entry : entries)
     {
-        SPDLOG_ERROR("can't find {} in themes folder", *utils::wstr_to_str(BM_FILE_BG));
-        return false;
+        const auto stem = utils::str_to_wstr(entry.file);
+
+        if (!stem)
+        {
+            SPDLOG_ERROR("sprite file name conversion error");
+            return false;
+        }
+
+        sprites.insert(entry.key, static_cast<uint32_t>(sprite_assets.size()));
+        sprite_assets.emplace_back().stem = *stem;
     }
 
-    if (!utils::load_bitmap(std::filesystem::path(theme_path) / BM_FILE_BG, bg_main_bitmap_data))
+    return true;
+}
+
+/**
+ * Maps a theme compiled by vmtheme, the colors are restored as compiled and the bitmaps point into the mapping
+ * @param pack_path Path to <flavor>.vmtheme
+ * @return True if the pack belongs to the running flavor and is complete
+ */
+bool config_manager::load_pack(const std::filesystem::path& pack_path)
+{
+    const auto pack_name = utils::wstr_to_str(pack_path.filename().wstring()).value_or("theme pack");
+    auto file = std::make_shared<mapped_file>();
+
+    if (!file->open(pack_path))
     {
-        SPDLOG_ERROR("error loading {}", *utils::wstr_to_str(BM_FILE_BG));
+        SPDLOG_ERROR("can't open {}", pack_name);
         return false;
     }
 
-    if (!std::filesystem::exists(std::filesystem::path(theme_path) / BM_FILE_BG_SETTINGS))
+    return load_pack(std::move(file), pack_name);
+}
+
+/**
+ * Uses a compiled theme, the colors are restored as compiled and the bitmaps point into the pack
+ * @param view The pack, mapped from a file or shared by another instance
+ * @param pack_name Name of the pack for the log
+ * @return True if the pack belongs to the running flavor and is complete
+ */
+bool config_manager::load_pack(std::shared_ptr<const mapped_view> view, const std::string& pack_name)
+{
+    if (!pack_reader.open(view->data(), view->size()))
     {
-        SPDLOG_ERROR("can't find {} in themes folder", *utils::wstr_to_str(BM_FILE_BG_SETTINGS));
+        SPDLOG_ERROR("{} is corrupt or was compiled by another version of vmtheme", pack_name);
         return false;
     }
 
-    if (!utils::load_bitmap(std::filesystem::path(theme_path) / BM_FILE_BG_SETTINGS, bg_settings_bitmap_data))
+    if (pack_reader.get_flavor() != active_flavor.id)
     {
-        SPDLOG_ERROR("error loading {}", *utils::wstr_to_str(BM_FILE_BG_SETTINGS));
+        SPDLOG_ERROR("{} was compiled for another Voicemeeter flavor", pack_name);
         return false;
     }
 
-    if (!std::filesystem::exists(std::filesystem::path(theme_path) / BM_FILE_BG_CASSETTE))
+    pack = std::move(view);
+
+    const auto colors_section = pack_reader.find(theme_pack::SECTION_COLORS, theme_pack::COLORS_SECTION);
+
+    if (!colors_section || colors_section->offset % sizeof(uint32_t) != 0 || colors_section->size % sizeof(uint32_t) != 0
+        || !color_config::load(reinterpret_cast<const uint32_t*>(colors_section->data), static_cast<size_t>(colors_section->size / sizeof(uint32_t)), colors))
     {
-        SPDLOG_ERROR("can't find {} in themes folder", *utils::wstr_to_str(BM_FILE_BG_CASSETTE));
+        SPDLOG_ERROR("colors in {} are invalid", pack_name);
         return false;
     }
 
-    if (!utils::load_bitmap(std::filesystem::path(theme_path) / BM_FILE_BG_CASSETTE, bg_cassette_bitmap_data))
+    if (const auto sprites_section = pack_reader.find(theme_pack::SECTION_SPRITES, theme_pack::SPRITES_SECTION))
     {
-        SPDLOG_ERROR("error loading {}", *utils::wstr_to_str(BM_FILE_BG_CASSETTE));
-        return false;
+        const size_t record_count = static_cast<size_t>(sprites_section->size / sizeof(theme_pack::sprite_record_t));
+
+        for (size_t i = 0; i < record_count; i++)
+        {
+            theme_pack::sprite_record_t record;
+            std::memcpy(&record, sprites_section->data + i * sizeof(record), sizeof(record));
+
+            const auto bitmap = pack_reader.get(record.bitmap);
+            auto& sprite = sprite_assets.emplace_back();
+
+            // packed sprites are views into the pack, there's nothing left to load on first use
+            std::call_once(sprite.loaded, [&] { sprite.ok = bitmap && sprite.asset.load_packed(pack, *bitmap); });
+
+            if (!sprite.ok)
+            {
+                SPDLOG_ERROR("sprite {} in {} is invalid", i, pack_name);
+                return false;
+            }
+
+            sprites.insert({record.width, record.height, record.bpp, record.hash}, static_cast<uint32_t>(sprite_assets.size() - 1));
+        }
     }
 
-    if (!std::filesystem::exists(std::filesystem::path(*userprofile_path) / L"themes" / *active_theme_name_wstr / CONFIG_FILE_COLORS))
+    // palette mode recolors the original bitmaps, the theme doesn't ship any
+    if (colors.bm_mode == BITMAP_MODE_PALETTE)
+        return true;
+
+    if (!load_packed_bitmap(bg_main_bitmap_data, *utils::wstr_to_str(BM_FILE_BG)))
     {
-        SPDLOG_ERROR("can't find {}", *utils::wstr_to_str(CONFIG_FILE_COLORS));
+        SPDLOG_ERROR("{} has no valid {} bitmap", pack_name, *utils::wstr_to_str(BM_FILE_BG));
         return false;
     }
 
-    std::ifstream colors_file(std::filesystem::path(*userprofile_path) / L"themes" / *active_theme_name_wstr / CONFIG_FILE_COLORS);
+    SPDLOG_INFO("theme loaded from {}", pack_name);
+    return true;
+}
 
-    if (!colors_file.is_open())
+/**
+ * Uses the theme from themes/.cache if none of its files changed since it was cached, or the copy another
+ * running instance published while it wasn't cached yet
+ * Otherwise the theme is compiled on a background thread, published for other instances and cached,
+ * while it loads from its folder as usual
+ * @param theme_root The theme folder
+ * @return True if the theme was loaded from the cache or another instance
+ */
+bool config_manager::load_cached(const std::filesystem::path& theme_root)
+{
+    // reading the theme folder fails the same way below and is reported there
+    const auto key = theme_cache::key(theme_root, active_flavor);
+
+    if (!key)
+        return false;
+
+    const auto entry = theme_cache::entry_path(theme_root.parent_path() / theme_cache::DIR_NAME, theme_root, active_flavor, *key);
+    const auto region_name = theme_share::region_name(active_flavor, *key);
+    std::error_code ec;
+
+    // preferred over the shared copy, bitmaps can be backed by the file mapping instead of being copied
+    if (std::filesystem::exists(entry, ec))
+    {
+        if (load_pack(entry))
+            return true;
+
+        SPDLOG_ERROR("theme cache entry is invalid, loading the theme folder instead");
+        reset_pack();
+        std::filesystem::remove(entry, ec);
+    }
+
+    if (auto shared = theme_share::attach(make_shared_region(), region_name))
+    {
+        if (load_pack(std::move(shared), "shared theme"))
+            return true;
+
+        reset_pack();
+    }
+
+    // compiled once the theme loader joined, from what it already read, see write_cache
+    cache_theme_root = theme_root;
+    cache_entry = entry;
+    cache_region_name = region_name;
+    return false;
+}
+
+/**
+ * Compiles the theme on a background thread, publishes it for other instances and stores it in themes/.cache
+ * colors.yaml, sprites.yaml and the main background are taken from the theme loader instead of being read again
+ * @param sprite_entries Entries of sprites.yaml
+ * @param bg_main Main background as BMP file bytes, empty in palette mode
+ * @return The published theme, empty if it couldn't be compiled or published
+ */
+std::future<std::shared_ptr<const mapped_view>> config_manager::write_cache(std::vector<sprite_entry_t> sprite_entries, std::vector<uint8_t> bg_main)
+{
+    cache_writer = std::make_unique<thread_pool>(1);
+    return cache_writer->submit([this, flavor = active_flavor, sprite_entries = std::move(sprite_entries), bg_main = std::move(bg_main)]
     {
-        SPDLOG_ERROR("can't open {}", *utils::wstr_to_str(CONFIG_FILE_COLORS));
+        // colors isn't modified once the theme is joined, it is only read here
+        const auto compiled = theme_compiler::compile(cache_theme_root, flavor, colors, sprite_entries, bg_main);
+
+        if (!compiled)
+            return std::shared_ptr<const mapped_view>();
+
+        // stays published until this instance exits, see shared_theme
+        auto published = theme_share::publish(make_shared_region(), cache_region_name, *compiled);
+
+        if (!theme_cache::store(cache_entry, *compiled))
+            return published;
+
+        theme_cache::prune(cache_entry);
+        SPDLOG_INFO("theme cached, {} KB", compiled->size() / 1024);
+        return published;
+    });
+}
+
+/**
+ * Drops everything load_pack filled in, so the theme can still be loaded from its folder
+ */
+void config_manager::reset_pack()
+{
+    colors = {};
+    sprites = {};
+    sprite_assets.clear();
+    bg_main_bitmap_data = {};
+    pack_reader = {};
+    pack.reset();
+}
+
+/**
+ * Points an asset at a bitmap section of the compiled theme
+ * @param asset The asset
+ * @param name Section name, the file name of the bitmap without extension
+ * @return False if the pack doesn't have a valid bitmap of that name
+ */
+bool config_manager::load_packed_bitmap(theme_asset& asset, const std::string& name) const
+{
+    const auto section = pack_reader.find(theme_pack::SECTION_BITMAP, name);
+    return section && asset.load_packed(pack, *section);
+}
+
+/**
+ * Waits for the theme loader started by init_theme, only the first call blocks
+ * Nothing compiled from colors.yaml and no background may be read before this returned true
+ * @return True if the theme was loaded successfully
+ */
+bool config_manager::wait_theme()
+{
+    std::call_once(theme_joined, [this] { theme_ok = join_theme(); });
+    return theme_ok;
+}
+
+/**
+ * Collects the results of the theme loader tasks and stops its threads
+ * @return True if colors.yaml and, in replace mode, the main background were loaded
+ */
+bool config_manager::join_theme()
+{
+    // theme disabled or compiled, nothing was started
+    if (!loader)
+        return true;
+
+    auto& loaded = loader->join();
+    const bool loaded_ok = loaded.colors_ok && loaded.sprites_ok && add_sprites(loaded.sprite_entries);
+    const bool bg_main_ok = loaded.bg_main_ok;
+    auto sprite_entries = std::move(loaded.sprite_entries);
+
+    colors = std::move(loaded.colors);
+    bg_main_bitmap_data = std::move(loaded.bg_main);
+    loader.reset();
+
+    if (!loaded_ok)
         return false;
+
+    // the cache misses this theme, the writer compiles it from what was just loaded
+    if (!cache_entry.empty() && (colors.bm_mode == BITMAP_MODE_PALETTE || bg_main_ok))
+    {
+        std::vector<uint8_t> bg_main;
+
+        // copied, the asset may be trimmed while the writer still compiles
+        if (colors.bm_mode == BITMAP_MODE_REPLACE)
+            bg_main.assign(bg_main_bitmap_data.data(), bg_main_bitmap_data.data() + bg_main_bitmap_data.size());
+
+        shared_theme = write_cache(std::move(sprite_entries), std::move(bg_main));
     }
 
-    try
+    if (!sprites.empty())
+        SPDLOG_INFO("theme replaces {} sprites", sprites.size());
+
+    // palette mode recolors the original bitmaps, the theme doesn't ship any
+    if (colors.bm_mode == BITMAP_MODE_PALETTE)
     {
-        yaml_colors = YAML::Load(colors_file);
+        bg_main_bitmap_data = {};
+        return true;
     }
-    catch (YAML::ParserException&)
+
+    if (!bg_main_ok)
     {
-        SPDLOG_ERROR("failed to parse {}", *utils::wstr_to_str(CONFIG_FILE_COLORS));
+        SPDLOG_ERROR("can't load {}.bmp, .png or .qoi from themes folder", *utils::wstr_to_str(BM_FILE_BG));
         return false;
     }
 
     return true;
 }
 
+/**
+ * Loads a background on first use, concurrent callers wait for the one doing the loading
+ * @param lazy The background
+ * @param stem File name without extension
+ * @param width Width of Voicemeeter's bitmap, other sizes are resampled
+ * @return The background or nullptr if it can't be loaded
+ */
+theme_asset* config_manager::load_lazy(lazy_asset_t& lazy, const std::wstring& stem, const uint32_t width)
+{
+    std::call_once(lazy.loaded, [&]
+    {
+        const auto name = utils::wstr_to_str(stem).value_or("background");
+        lazy.ok = pack ? load_packed_bitmap(lazy.asset, name) : timed_phase(name.c_str(), [&] { return lazy.asset.load(theme_dir, stem, width); });
+
+        if (!lazy.ok && pack)
+            SPDLOG_ERROR("compiled theme has no valid {} bitmap", name);
+        else if (!lazy.ok)
+            SPDLOG_ERROR("can't load {}.bmp, .png or .qoi from themes folder", name);
+    });
+
+    return lazy.ok ? &lazy.asset : nullptr;
+}
+
+/**
+ * Logs the memory held by the theme backgrounds, heap buffers and mapped files separately
+ */
+void config_manager::log_theme_memory() const
+{
+    size_t private_bytes = bg_main_bitmap_data.private_bytes();
+    size_t mapped_bytes = bg_main_bitmap_data.mapped_bytes();
+
+    for (const auto* lazy : {&bg_settings_bitmap_data, &bg_cassette_bitmap_data})
+    {
+        if (lazy->ok)
+        {
+            private_bytes += lazy->asset.private_bytes();
+            mapped_bytes += lazy->asset.mapped_bytes();
+        }
+    }
+
+    for (auto& sprite : sprite_assets)
+    {
+        std::lock_guard lock(sprite.mtx);
+        private_bytes += sprite.asset.private_bytes();
+        mapped_bytes += sprite.asset.mapped_bytes();
+    }
+
+    SPDLOG_INFO("theme bitmaps hold {} KB private memory, {} KB mapped", private_bytes / 1024, mapped_bytes / 1024);
+}
+
+/**
+ * Starts loading the settings and cassette backgrounds on a worker thread
+ * Called once the main window is up, so opening the settings dialog doesn't wait for the decode
+ */
+void config_manager::prefetch_backgrounds()
+{
+    if (prefetcher || !wait_theme() || colors.bm_mode == BITMAP_MODE_PALETTE)
+        return;
+
+    prefetcher = std::make_unique<thread_pool>(1);
+    prefetcher->submit([this] { load_lazy(bg_settings_bitmap_data, BM_FILE_BG_SETTINGS, active_flavor.bitmap_width_settings); });
+    prefetcher->submit([this] { load_lazy(bg_cassette_bitmap_data, BM_FILE_BG_CASSETTE, active_flavor.bitmap_width_cassette); });
+}
+
 /**
  * Loads the config file vmchroma.yaml
  * @return True if loading was successful
@@ -493,54 +806,458 @@ std::optional<bool> config_manager::cfg_get_restore_size()
 }
 
 /**
- * Gets a color value from the yaml file in a case-insensitive way
- * @param arg_col The color value in upper case
- * @param category Can either be "shapes" or "text"
- * @return The mapped color value for the current theme
+ * Gets the "gdi object cache" value from the config
+ * @return "gdi object cache" value
  */
-std::optional<std::string> config_manager::cfg_get_color(const std::string& arg_col, const color_category& category)
+std::optional<bool> config_manager::cfg_get_gdi_object_cache()
 {
-    YAML::Node category_node;
+    if (!yaml_config["misc"]["gdiObjectCache"].IsScalar())
+        return false;
 
-    if (category == CATEGORY_SHAPES)
-        category_node = yaml_colors["shapes"];
+    try
+    {
+        return yaml_config["misc"]["gdiObjectCache"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error gdiObjectCache value");
+        return std::nullopt;
+    }
+}
 
-    if (category == CATEGORY_TEXT)
-        category_node = yaml_colors["text"];
+/**
+ * Gets the color stats value from the config
+ * @return Color stats value, false if the key is missing
+ */
+std::optional<bool> config_manager::cfg_get_color_stats()
+{
+    if (!yaml_config["misc"]["colorStats"].IsScalar())
+        return false;
 
-    for (auto it = category_node.begin(); it != category_node.end(); ++it)
+    try
     {
-        auto current_color = it->first.as<std::string>();
-        std::string current_color_upper(current_color.size(), '\0');
-        std::transform(current_color.begin(), current_color.end(), current_color_upper.begin(), ::toupper);
+        return yaml_config["misc"]["colorStats"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error colorStats value");
+        return std::nullopt;
+    }
+}
 
-        if (current_color_upper == arg_col)
+/**
+ * Gets the "prefetch backgrounds" value from the config
+ * @return "prefetch backgrounds" value
+ */
+std::optional<bool> config_manager::cfg_get_prefetch_backgrounds()
+{
+    if (!yaml_config["misc"]["prefetchBackgrounds"].IsScalar())
+        return false;
+
+    try
+    {
+        return yaml_config["misc"]["prefetchBackgrounds"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error prefetchBackgrounds value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the "mip scaling" value from the config
+ * @return "mip scaling" value
+ */
+std::optional<bool> config_manager::cfg_get_mip_scaling()
+{
+    if (!yaml_config["misc"]["mipScaling"].IsScalar())
+        return false;
+
+    try
+    {
+        return yaml_config["misc"]["mipScaling"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error mipScaling value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the "theme cache" value from the config
+ * @return "theme cache" value, false if not set
+ */
+std::optional<bool> config_manager::cfg_get_theme_cache()
+{
+    if (!yaml_config["misc"]["themeCache"].IsScalar())
+        return false;
+
+    try
+    {
+        return yaml_config["misc"]["themeCache"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error themeCache value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the "frame scheduling" value from the config
+ * @return "frame scheduling" value, false if not set
+ */
+std::optional<bool> config_manager::cfg_get_frame_scheduling()
+{
+    if (!yaml_config["misc"]["frameScheduling"].IsScalar())
+        return false;
+
+    try
+    {
+        return yaml_config["misc"]["frameScheduling"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error frameScheduling value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the number of GDI textures each window rotates through from the config
+ * @return Texture ring size, 1 if not set
+ */
+std::optional<uint32_t> config_manager::cfg_get_texture_ring()
+{
+    if (!yaml_config["misc"]["textureRing"].IsScalar())
+        return 1;
+
+    try
+    {
+        const auto size = yaml_config["misc"]["textureRing"].as<uint32_t>();
+
+        if (size < 1 || size > 3)
         {
-            auto ret = it->second.as<std::string>();
+            SPDLOG_ERROR("textureRing value out of range");
+            return std::nullopt;
+        }
+
+        return size;
+    }
+    catch (YAML::TypedBadConversion<uint32_t>&)
+    {
+        SPDLOG_ERROR("error textureRing value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the "damage tracking" value from the config
+ * @return "damage tracking" value, false if not set
+ */
+std::optional<bool> config_manager::cfg_get_damage_tracking()
+{
+    if (!yaml_config["misc"]["damageTracking"].IsScalar())
+        return false;
 
-            if (ret.empty())
+    try
+    {
+        return yaml_config["misc"]["damageTracking"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error damageTracking value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the "software rendering" value from the config
+ * @return "software rendering" value, false if not set
+ */
+std::optional<bool> config_manager::cfg_get_software_rendering()
+{
+    if (!yaml_config["misc"]["softwareRendering"].IsScalar())
+        return false;
+
+    try
+    {
+        return yaml_config["misc"]["softwareRendering"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error softwareRendering value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets the filter windows are scaled with from the config
+ * @return Scaling filter, hqCubic if not set
+ */
+std::optional<frame_filter> config_manager::cfg_get_scaling_filter()
+{
+    if (!yaml_config["misc"]["scalingFilter"].IsScalar())
+        return FRAME_FILTER_HQ_CUBIC;
+
+    const auto filter_str = yaml_config["misc"]["scalingFilter"].as<std::string>();
+
+    if (filter_str == "nearest")
+        return FRAME_FILTER_NEAREST;
+
+    if (filter_str == "bilinear")
+        return FRAME_FILTER_BILINEAR;
+
+    if (filter_str == "cubic")
+        return FRAME_FILTER_CUBIC;
+
+    if (filter_str == "hqCubic")
+        return FRAME_FILTER_HQ_CUBIC;
+
+    if (filter_str == "auto")
+        return FRAME_FILTER_AUTO;
+
+    SPDLOG_ERROR("scalingFilter must be nearest, bilinear, cubic, hqCubic or auto");
+    return std::nullopt;
+}
+
+/**
+ * Gets the "layered compositing" value from the config
+ * @return "layered compositing" value, true if not set
+ */
+std::optional<bool> config_manager::cfg_get_layered_compositing()
+{
+    if (!yaml_config["misc"]["layeredCompositing"].IsScalar())
+        return true;
+
+    try
+    {
+        return yaml_config["misc"]["layeredCompositing"].as<bool>();
+    }
+    catch (YAML::TypedBadConversion<bool>&)
+    {
+        SPDLOG_ERROR("error layeredCompositing value");
+        return std::nullopt;
+    }
+}
+
+/**
+ * Gets what happens to the theme bitmaps once Voicemeeter's bitmaps are filled
+ * @return Memory policy, keep if not set
+ */
+std::optional<theme_memory> config_manager::cfg_get_theme_memory()
+{
+    if (!yaml_config["misc"]["themeMemory"].IsScalar())
+        return THEME_MEMORY_KEEP;
+
+    const auto policy_str = yaml_config["misc"]["themeMemory"].as<std::string>();
+
+    if (policy_str == "keep")
+        return THEME_MEMORY_KEEP;
+
+    if (policy_str == "release")
+        return THEME_MEMORY_RELEASE;
+
+    if (policy_str == "compress")
+        return THEME_MEMORY_COMPRESS;
+
+    SPDLOG_ERROR("themeMemory must be keep, release or compress");
+    return std::nullopt;
+}
+
+/**
+ * Gets the log level from the config
+ * @return Log level value
+ */
+std::optional<spdlog::level::level_enum> config_manager::cfg_get_log_level()
+{
+    if (!yaml_config["misc"]["logLevel"].IsScalar())
+        return spdlog::level::err;
+
+    const auto level_str = yaml_config["misc"]["logLevel"].as<std::string>();
+
+    if (level_str == "error")
+        return spdlog::level::err;
+
+    if (level_str == "warn")
+        return spdlog::level::warn;
+
+    if (level_str == "info")
+        return spdlog::level::info;
+
+    if (level_str == "debug")
+        return spdlog::level::debug;
+
+    SPDLOG_ERROR("logLevel must be error, warn, info or debug");
+    return std::nullopt;
+}
+
+/**
+ * Gets the frame color grading settings from the config, missing values keep their neutral defaults
+ * @return Grading settings
+ */
+std::optional<grade_settings_t> config_manager::cfg_get_grade_settings()
+{
+    grade_settings_t settings = {};
+    const auto grading = yaml_config["grading"];
+
+    if (!grading.IsMap())
+        return settings;
+
+    try
+    {
+        if (grading["gamma"].IsScalar())
+            settings.gamma = grading["gamma"].as<float>();
+
+        if (grading["contrast"].IsScalar())
+            settings.contrast = grading["contrast"].as<float>();
+
+        if (grading["tintStrength"].IsScalar())
+            settings.tint_strength = grading["tintStrength"].as<float>();
+
+        if (grading["nightMode"].IsScalar())
+            settings.night_mode = grading["nightMode"].as<float>();
+
+        if (grading["tint"].IsScalar())
+        {
+            const auto tint = color_config::parse_hex(grading["tint"].as<std::string>());
+
+            if (!tint)
                 return std::nullopt;
 
-            return ret;
+            settings.tint = *tint;
         }
     }
+    catch (YAML::Exception&)
+    {
+        SPDLOG_ERROR("error grading value");
+        return std::nullopt;
+    }
 
-    return std::nullopt;
+    if (settings.gamma < 0.1f || settings.gamma > 10.0f)
+    {
+        SPDLOG_ERROR("grading gamma value must be between 0.1 and 10");
+        return std::nullopt;
+    }
+
+    if (settings.contrast < 0.0f || settings.contrast > 4.0f)
+    {
+        SPDLOG_ERROR("grading contrast value must be between 0 and 4");
+        return std::nullopt;
+    }
+
+    if (settings.tint_strength < 0.0f || settings.tint_strength > 1.0f || settings.night_mode < 0.0f || settings.night_mode > 1.0f)
+    {
+        SPDLOG_ERROR("grading tintStrength and nightMode values must be between 0 and 1");
+        return std::nullopt;
+    }
+
+    return settings;
+}
+
+/**
+ * Gets the mapped color for the current theme
+ * Colors the window section doesn't map fall back to the main window mapping, see compiled_colors::find
+ * @param color The original color
+ * @param category Can either be "shapes" or "text"
+ * @param wnd_type The window the color is drawn in
+ * @return The mapped color value for the current theme
+ */
+std::optional<COLORREF> config_manager::cfg_get_color(COLORREF color, const color_category& category, const WND_TYPE wnd_type) const
+{
+    return colors.find(color, category, wnd_type);
+}
+
+/**
+ * @return True if colors.yaml has at least one window section, only then the hooks need to resolve the window
+ */
+bool config_manager::has_window_colors() const
+{
+    for (const auto enabled : colors.window_maps_enabled)
+    {
+        if (enabled)
+            return true;
+    }
+
+    return false;
+}
+
+theme_asset* config_manager::get_bm_data_main()
+{
+    return &bg_main_bitmap_data;
+}
+
+theme_asset* config_manager::get_bm_data_settings()
+{
+    return load_lazy(bg_settings_bitmap_data, BM_FILE_BG_SETTINGS, active_flavor.bitmap_width_settings);
 }
 
-const std::vector<uint8_t>& config_manager::get_bm_data_main()
+theme_asset* config_manager::get_bm_data_cassette()
 {
-    return bg_main_bitmap_data;
+    return load_lazy(bg_cassette_bitmap_data, BM_FILE_BG_CASSETTE, active_flavor.bitmap_width_cassette);
 }
 
-const std::vector<uint8_t>& config_manager::get_bm_data_settings()
+const color_map_t& config_manager::get_color_map(const color_category& category) const
 {
-    return bg_settings_bitmap_data;
+    return colors.maps[WND_TYPE_MAIN][category];
+}
+
+/**
+ * Checks whether a bitmap has the size of any sprite the theme replaces
+ * @return True if the bitmap needs to be fingerprinted
+ */
+bool config_manager::is_sprite_size(const uint32_t width, const uint32_t height, const uint32_t bpp) const
+{
+    return !sprites.empty() && sprites.has_dimensions(width, height, bpp);
+}
+
+/**
+ * Copies the replacement for a bitmap into its DIB, the sprite file is loaded on the first call
+ * @param key Fingerprint of the bitmap Voicemeeter drew, also the layout of the DIB
+ * @param bits Pixels of the DIB
+ * @param top_down Row order of the DIB
+ * @param policy What happens to the sprite's pixels once they are copied
+ * @return std::nullopt if the theme doesn't replace the bitmap or the file can't be loaded,
+ *         otherwise whether the sprite could be converted to the DIB's layout
+ */
+std::optional<bool> config_manager::fill_sprite(const sprite_key_t& key, uint8_t* bits, const bool top_down, const theme_memory policy)
+{
+    const auto sprite_id = sprites.find(key);
+
+    if (!sprite_id)
+        return std::nullopt;
+
+    auto& sprite = sprite_assets[*sprite_id];
+
+    std::call_once(sprite.loaded, [&]
+    {
+        sprite.ok = sprite.asset.load(sprite_dir, sprite.stem, key.width, key.height);
+
+        if (!sprite.ok)
+            SPDLOG_ERROR("can't load sprite {} from the sprites folder", *utils::wstr_to_str(sprite.stem));
+    });
+
+    if (!sprite.ok)
+        return std::nullopt;
+
+    std::lock_guard lock(sprite.mtx);
+
+    if (!sprite.asset.acquire())
+        return std::nullopt;
+
+    const auto info = bmp_decoder::parse(sprite.asset.data(), sprite.asset.size());
+    const bool filled = info && bmp_decoder::convert(sprite.asset.data(), sprite.asset.size(), *info, bits, {key.width, key.height, top_down, key.bpp});
+
+    sprite.asset.trim(policy);
+
+    return filled;
 }
 
-const std::vector<uint8_t>& config_manager::get_bm_data_cassette()
+bitmap_mode config_manager::get_bitmap_mode() const
 {
-    return bg_cassette_bitmap_data;
+    return colors.bm_mode;
 }
 
 const flavor_info_t& config_manager::get_active_flavor()
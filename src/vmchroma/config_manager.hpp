@@ -17,17 +17,56 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include "color_config.hpp"
+#include "color_grade.hpp"
+#include "mapped_view.hpp"
+#include "sprite_index.hpp"
+#include "theme_asset.hpp"
+#include "theme_loader.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
+#include "window_manager.hpp"
 #include "yaml-cpp/yaml.h"
 
+/**
+ * Background that is only loaded when Voicemeeter first creates its bitmap
+ */
+typedef struct lazy_asset
+{
+    theme_asset asset;
+    std::once_flag loaded;
+    std::atomic<bool> ok = false;
+} lazy_asset_t;
+
+/**
+ * Replacement for a bitmap listed in sprites.yaml, loaded the first time the bitmap is seen
+ * The hooks copy sprites from any thread, the mutex keeps a trim from freeing the pixels during a copy
+ */
+typedef struct sprite_asset
+{
+    std::wstring stem;
+    theme_asset asset;
+    std::once_flag loaded;
+    std::atomic<bool> ok = false;
+    std::mutex mtx;
+} sprite_asset_t;
+
 class config_manager
 {
-    std::wstring BM_FILE_BG = L"bg.bmp";
-    std::wstring BM_FILE_BG_SETTINGS = L"bg_settings.bmp";
-    std::wstring BM_FILE_BG_CASSETTE = L"bg_cassette.bmp";
+    std::wstring BM_FILE_BG = L"bg";
+    std::wstring BM_FILE_BG_SETTINGS = L"bg_settings";
+    std::wstring BM_FILE_BG_CASSETTE = L"bg_cassette";
     std::wstring CONFIG_FILE_THEME = L"vmchroma.yaml";
-    std::wstring CONFIG_FILE_COLORS = L"colors.yaml";
+    std::wstring SPRITE_DIR = L"sprites";
+    std::wstring THEME_PACK_EXTENSION = L".vmtheme";
     std::wstring reg_sub_key_vmchroma = L"VB-Audio\\VMChroma";
     std::wstring reg_sub_key_default = L"VB-Audio\\VMChroma\\Default";
     std::wstring reg_sub_key_banana = L"VB-Audio\\VMChroma\\Banana";
@@ -36,18 +75,43 @@ class config_manager
     std::wstring reg_val_wnd_size_height = L"window_size_height";
     flavor_id current_flavor_id = FLAVOR_NONE;
     flavor_info_t active_flavor = {};
-    std::unordered_map<flavor_id, flavor_info_t> flavor_map =
-    {
-        {FLAVOR_DEFAULT, {"default", FLAVOR_DEFAULT, 1024, 552, 0, 235, 750}},
-        {FLAVOR_BANANA, {"banana", FLAVOR_BANANA, 1024, 550, 800, 305, 744}},
-        {FLAVOR_POTATO, {"potato", FLAVOR_POTATO, 1645, 835, 1050, 340, 1045}},
-    };
-    YAML::Node yaml_colors;
+    compiled_colors_t colors;
     YAML::Node yaml_config;
-    std::vector<uint8_t> bg_main_bitmap_data;
-    std::vector<uint8_t> bg_settings_bitmap_data;
-    std::vector<uint8_t> bg_cassette_bitmap_data;
+    theme_asset bg_main_bitmap_data;
+    lazy_asset_t bg_settings_bitmap_data;
+    lazy_asset_t bg_cassette_bitmap_data;
+    std::filesystem::path theme_dir;
+    sprite_index sprites;
+    // a deque since the entries can't be moved
+    std::deque<sprite_asset_t> sprite_assets;
+    std::filesystem::path sprite_dir;
+    // compiled theme, replaces everything above that is read from the theme folder
+    std::shared_ptr<const mapped_view> pack;
+    theme_pack::reader pack_reader;
     bool theme_enabled = true;
+    // background loading of colors.yaml and the backgrounds, see init_theme and wait_theme
+    std::unique_ptr<theme_loader> loader;
+    std::once_flag theme_joined;
+    bool theme_ok = false;
+    std::unique_ptr<thread_pool> prefetcher;
+    // compiled theme this instance published for other instances, handed over by the cache writer through the future
+    // and held in its shared state until this instance exits
+    std::future<std::shared_ptr<const mapped_view>> shared_theme;
+    // compiles the theme into themes/.cache on the first start after it changed, see load_cached and write_cache
+    std::filesystem::path cache_theme_root;
+    std::filesystem::path cache_entry;
+    std::string cache_region_name;
+    std::unique_ptr<thread_pool> cache_writer;
+
+    bool add_sprites(const std::vector<sprite_entry_t>& entries);
+    bool load_pack(const std::filesystem::path& pack_path);
+    bool load_pack(std::shared_ptr<const mapped_view> view, const std::string& pack_name);
+    bool load_cached(const std::filesystem::path& theme_root);
+    std::future<std::shared_ptr<const mapped_view>> write_cache(std::vector<sprite_entry_t> sprite_entries, std::vector<uint8_t> bg_main);
+    void reset_pack();
+    bool load_packed_bitmap(theme_asset& asset, const std::string& name) const;
+    bool join_theme();
+    theme_asset* load_lazy(lazy_asset_t& lazy, const std::wstring& stem, uint32_t width);
 
 public:
     bool get_theme_enabled();
@@ -55,15 +119,37 @@ public:
     bool reg_get_wnd_size(uint32_t& width, uint32_t& height);
     std::optional<flavor_id> get_current_flavor_id();
     bool init_theme();
+    bool wait_theme();
+    void prefetch_backgrounds();
+    void log_theme_memory() const;
     bool load_config();
     std::optional<uint32_t> cfg_get_font_quality();
     std::optional<uint32_t> cfg_get_fader_shift_scroll_step();
     std::optional<uint32_t> cfg_get_fader_scroll_step();
     std::optional<uint32_t> cfg_get_ui_update_interval();
     std::optional<bool> cfg_get_restore_size();
-    std::optional<std::string> cfg_get_color(const std::string& arg_col, const color_category& category);
-    const std::vector<uint8_t>& get_bm_data_main();
-    const std::vector<uint8_t>& get_bm_data_settings();
-    const std::vector<uint8_t>& get_bm_data_cassette();
+    std::optional<bool> cfg_get_gdi_object_cache();
+    std::optional<bool> cfg_get_color_stats();
+    std::optional<bool> cfg_get_prefetch_backgrounds();
+    std::optional<bool> cfg_get_mip_scaling();
+    std::optional<bool> cfg_get_theme_cache();
+    std::optional<bool> cfg_get_frame_scheduling();
+    std::optional<uint32_t> cfg_get_texture_ring();
+    std::optional<bool> cfg_get_damage_tracking();
+    std::optional<bool> cfg_get_software_rendering();
+    std::optional<frame_filter> cfg_get_scaling_filter();
+    std::optional<bool> cfg_get_layered_compositing();
+    std::optional<theme_memory> cfg_get_theme_memory();
+    std::optional<spdlog::level::level_enum> cfg_get_log_level();
+    std::optional<grade_settings_t> cfg_get_grade_settings();
+    std::optional<COLORREF> cfg_get_color(COLORREF color, const color_category& category, WND_TYPE wnd_type = WND_TYPE_MAIN) const;
+    bool has_window_colors() const;
+    theme_asset* get_bm_data_main();
+    theme_asset* get_bm_data_settings();
+    theme_asset* get_bm_data_cassette();
+    const color_map_t& get_color_map(const color_category& category) const;
+    bool is_sprite_size(uint32_t width, uint32_t height, uint32_t bpp) const;
+    std::optional<bool> fill_sprite(const sprite_key_t& key, uint8_t* bits, bool top_down, theme_memory policy);
+    bitmap_mode get_bitmap_mode() const;
     const flavor_info_t& get_active_flavor();
 };
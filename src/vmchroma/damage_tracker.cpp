@@ -0,0 +1,371 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "damage_tracker.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "simd.hpp"
+
+namespace tile_hash
+{
+namespace
+{
+constexpr uint32_t PRIME1 = 2654435761u;
+constexpr uint32_t PRIME2 = 2246822519u;
+constexpr uint32_t PRIME3 = 3266489917u;
+constexpr uint32_t LANES = 8;
+// independent accumulator sets take turns on the steps of a row, so the multiplies of consecutive steps overlap
+constexpr uint32_t SETS = 4;
+constexpr size_t STEP = LANES * sizeof(uint32_t);
+
+uint32_t rotl(const uint32_t v, const int r)
+{
+    return v << r | v >> (32 - r);
+}
+
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t lane_round(uint32_t acc, const uint32_t input)
+{
+    acc += input * PRIME2;
+    return rotl(acc, 13) * PRIME1;
+}
+
+// acc holds SETS * LANES values, step i of every row goes to set i % SETS
+typedef void (*steps_fn)(uint32_t* acc, const uint8_t* p, ptrdiff_t stride, uint32_t rows, size_t steps);
+
+void steps_scalar(uint32_t* acc, const uint8_t* row, const ptrdiff_t stride, const uint32_t rows, const size_t steps)
+{
+    for (uint32_t y = 0; y < rows; y++, row += stride)
+    {
+        const uint8_t* p = row;
+
+        for (size_t i = 0; i < steps; i++, p += STEP)
+        {
+            uint32_t* set = acc + i % SETS * LANES;
+
+            for (uint32_t lane = 0; lane < LANES; lane++)
+                set[lane] = lane_round(set[lane], read32(p + lane * 4));
+        }
+    }
+}
+
+#if defined(VMCHROMA_SSE2)
+VMCHROMA_TARGET_SSE41 __m128i round_sse41(const __m128i acc, const uint8_t* p, const __m128i prime1, const __m128i prime2)
+{
+    const __m128i v = _mm_add_epi32(acc, _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), prime2));
+    return _mm_mullo_epi32(_mm_or_si128(_mm_slli_epi32(v, 13), _mm_srli_epi32(v, 19)), prime1);
+}
+
+VMCHROMA_TARGET_SSE41 void steps_sse41(uint32_t* acc, const uint8_t* row, const ptrdiff_t stride, const uint32_t rows, const size_t steps)
+{
+    const __m128i prime1 = _mm_set1_epi32(static_cast<int>(PRIME1));
+    const __m128i prime2 = _mm_set1_epi32(static_cast<int>(PRIME2));
+    __m128i v[SETS * 2];
+
+    for (uint32_t i = 0; i < SETS * 2; i++)
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i * 4));
+
+    for (uint32_t y = 0; y < rows; y++, row += stride)
+    {
+        const uint8_t* p = row;
+        size_t i = 0;
+
+        for (; i + SETS <= steps; i += SETS, p += STEP * SETS)
+        {
+            for (uint32_t k = 0; k < SETS * 2; k++)
+                v[k] = round_sse41(v[k], p + k * 16, prime1, prime2);
+        }
+
+        for (uint32_t set = 0; i < steps; i++, set++, p += STEP)
+        {
+            v[set * 2] = round_sse41(v[set * 2], p, prime1, prime2);
+            v[set * 2 + 1] = round_sse41(v[set * 2 + 1], p + 16, prime1, prime2);
+        }
+    }
+
+    for (uint32_t k = 0; k < SETS * 2; k++)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + k * 4), v[k]);
+}
+
+VMCHROMA_TARGET_AVX2 __m256i round_avx2(const __m256i acc, const uint8_t* p, const __m256i prime1, const __m256i prime2)
+{
+    const __m256i v = _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), prime2));
+    return _mm256_mullo_epi32(_mm256_or_si256(_mm256_slli_epi32(v, 13), _mm256_srli_epi32(v, 19)), prime1);
+}
+
+VMCHROMA_TARGET_AVX2 void steps_avx2(uint32_t* acc, const uint8_t* row, const ptrdiff_t stride, const uint32_t rows, const size_t steps)
+{
+    const __m256i prime1 = _mm256_set1_epi32(static_cast<int>(PRIME1));
+    const __m256i prime2 = _mm256_set1_epi32(static_cast<int>(PRIME2));
+    __m256i v[SETS];
+
+    for (uint32_t k = 0; k < SETS; k++)
+        v[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + k * LANES));
+
+    for (uint32_t y = 0; y < rows; y++, row += stride)
+    {
+        const uint8_t* p = row;
+        size_t i = 0;
+
+        for (; i + SETS <= steps; i += SETS, p += STEP * SETS)
+        {
+            for (uint32_t k = 0; k < SETS; k++)
+                v[k] = round_avx2(v[k], p + k * STEP, prime1, prime2);
+        }
+
+        for (uint32_t set = 0; i < steps; i++, set++, p += STEP)
+            v[set] = round_avx2(v[set], p, prime1, prime2);
+    }
+
+    for (uint32_t k = 0; k < SETS; k++)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + k * LANES), v[k]);
+}
+#endif
+
+steps_fn select_steps()
+{
+#if defined(VMCHROMA_SSE2)
+    if (simd::has_avx2())
+        return steps_avx2;
+
+    if (simd::has_sse41())
+        return steps_sse41;
+#endif
+    return steps_scalar;
+}
+
+uint32_t hash_with(const steps_fn steps, const uint8_t* bits, const ptrdiff_t stride, const uint32_t width, const uint32_t height)
+{
+    uint32_t acc[SETS * LANES];
+
+    for (uint32_t i = 0; i < SETS * LANES; i++)
+        acc[i] = PRIME1 + i * PRIME3;
+
+    const size_t row_bytes = static_cast<size_t>(width) * 4;
+    const size_t full_steps = row_bytes / STEP;
+
+    if (full_steps > 0)
+        steps(acc, bits, stride, height, full_steps);
+
+    // pixels of a narrow edge tile that don't fill a step, after all full steps
+    for (uint32_t y = 0; y < height && full_steps * STEP < row_bytes; y++)
+    {
+        const uint8_t* row = bits + static_cast<ptrdiff_t>(y) * stride;
+
+        for (size_t x = full_steps * STEP, lane = 0; x < row_bytes; x += 4, lane++)
+            acc[lane] = lane_round(acc[lane], read32(row + x));
+    }
+
+    uint32_t h = width * PRIME3 + height;
+
+    for (uint32_t i = 0; i < SETS * LANES; i++)
+        h = rotl(h + acc[i], static_cast<int>(i % 31 + 1)) * PRIME1;
+
+    h ^= h >> 15;
+    h *= PRIME2;
+    h ^= h >> 13;
+    h *= PRIME3;
+    h ^= h >> 16;
+    return h;
+}
+}
+
+/**
+ * Hashes a block of 32 bpp pixels, using AVX2 or SSE4.1 for the lanes if available
+ * @param bits First pixel of the block
+ * @param stride Bytes from one row to the next, negative for bottom-up bitmaps
+ * @param width Width in pixels
+ * @param height Height in rows
+ * @return Hash of the block
+ */
+uint32_t hash(const uint8_t* bits, const ptrdiff_t stride, const uint32_t width, const uint32_t height)
+{
+    static const steps_fn steps = select_steps();
+    return hash_with(steps, bits, stride, width, height);
+}
+
+uint32_t hash_scalar(const uint8_t* bits, const ptrdiff_t stride, const uint32_t width, const uint32_t height)
+{
+    return hash_with(steps_scalar, bits, stride, width, height);
+}
+}
+
+/**
+ * Sets the frame size, the next update reports the whole frame as changed
+ * @param frame_width Width in pixels
+ * @param frame_height Height in pixels
+ */
+void damage_tracker::resize(const uint32_t frame_width, const uint32_t frame_height)
+{
+    width = frame_width;
+    height = frame_height;
+    tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    hashes.assign(static_cast<size_t>(tiles_x) * tiles_y, 0);
+    dirty.assign(hashes.size(), 1);
+    dirty_count = hashes.size();
+    valid = false;
+}
+
+/**
+ * Makes the next update report the whole frame, e.g. after the window was resized or the grading changed
+ */
+void damage_tracker::invalidate()
+{
+    valid = false;
+}
+
+/**
+ * Hashes the frame and compares every tile with the last update
+ * @param bits First row of the frame, 32 bpp
+ * @param stride Bytes from one row to the next, negative for bottom-up bitmaps
+ * @return Number of changed tiles, all of them after resize or invalidate
+ */
+size_t damage_tracker::update(const uint8_t* bits, const ptrdiff_t stride)
+{
+    dirty_count = 0;
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+    {
+        const uint32_t y = ty * TILE_SIZE;
+        const uint32_t h = std::min(TILE_SIZE, height - y);
+
+        for (uint32_t tx = 0; tx < tiles_x; tx++)
+        {
+            const uint32_t x = tx * TILE_SIZE;
+            const uint32_t w = std::min(TILE_SIZE, width - x);
+            const size_t i = static_cast<size_t>(ty) * tiles_x + tx;
+            const uint32_t tile = tile_hash::hash(bits + static_cast<ptrdiff_t>(y) * stride + x * 4, stride, w, h);
+
+            dirty[i] = !valid || tile != hashes[i];
+            dirty_count += dirty[i];
+            hashes[i] = tile;
+        }
+    }
+
+    valid = true;
+    return dirty_count;
+}
+
+/**
+ * Merges the changed tiles of the last update into rectangles in pixels, clipped to the frame
+ * Runs of tiles in a row are joined first, then runs spanning the same columns in consecutive rows,
+ * and while there are too many rectangles the two whose bounding box adds the least area are joined
+ * @param max_rects Maximum number of rectangles, at least 1
+ * @return The rectangles, empty if nothing changed
+ */
+std::vector<damage_rect_t> damage_tracker::rects(const size_t max_rects) const
+{
+    std::vector<damage_rect_t> out;
+    // rectangles that still end at the previous tile row and can grow downwards
+    std::vector<size_t> open;
+    std::vector<size_t> next_open;
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+    {
+        next_open.clear();
+
+        for (uint32_t tx = 0; tx < tiles_x;)
+        {
+            if (!dirty[static_cast<size_t>(ty) * tiles_x + tx])
+            {
+                tx++;
+                continue;
+            }
+
+            const uint32_t run_start = tx;
+
+            while (tx < tiles_x && dirty[static_cast<size_t>(ty) * tiles_x + tx])
+                tx++;
+
+            const damage_rect_t run = {run_start * TILE_SIZE, ty * TILE_SIZE, std::min(tx * TILE_SIZE, width), std::min((ty + 1) * TILE_SIZE, height)};
+            const auto grow = std::find_if(open.begin(), open.end(), [&](const size_t r)
+            {
+                return out[r].left == run.left && out[r].right == run.right;
+            });
+
+            if (grow != open.end())
+            {
+                out[*grow].bottom = run.bottom;
+                next_open.push_back(*grow);
+            }
+            else
+            {
+                next_open.push_back(out.size());
+                out.push_back(run);
+            }
+        }
+
+        open.swap(next_open);
+    }
+
+    const auto area = [](const damage_rect_t& r)
+    {
+        return static_cast<int64_t>(r.right - r.left) * (r.bottom - r.top);
+    };
+
+    const auto join = [](const damage_rect_t& a, const damage_rect_t& b)
+    {
+        return damage_rect_t{std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom)};
+    };
+
+    while (out.size() > std::max<size_t>(1, max_rects))
+    {
+        size_t best_a = 0;
+        size_t best_b = 1;
+        int64_t best_cost = INT64_MAX;
+
+        for (size_t a = 0; a < out.size(); a++)
+        {
+            for (size_t b = a + 1; b < out.size(); b++)
+            {
+                // negative for rectangles that overlap
+                const int64_t cost = area(join(out[a], out[b])) - area(out[a]) - area(out[b]);
+
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        out[best_a] = join(out[best_a], out[best_b]);
+        out.erase(out.begin() + static_cast<ptrdiff_t>(best_b));
+    }
+
+    return out;
+}
+
+size_t damage_tracker::get_dirty_tiles() const
+{
+    return dirty_count;
+}
+
+size_t damage_tracker::get_tile_count() const
+{
+    return hashes.size();
+}
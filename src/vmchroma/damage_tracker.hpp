@@ -0,0 +1,66 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct damage_rect
+{
+    uint32_t left;
+    uint32_t top;
+    uint32_t right;
+    uint32_t bottom;
+} damage_rect_t;
+
+/**
+ * Hashing of 32 bpp tiles, eight XXH32-style lanes over 32 byte steps of every row, four sets of lanes take turns
+ * A set of lanes maps onto one AVX2 or two SSE4.1 registers, the result is identical to the scalar version
+ */
+namespace tile_hash
+{
+uint32_t hash(const uint8_t* bits, ptrdiff_t stride, uint32_t width, uint32_t height);
+uint32_t hash_scalar(const uint8_t* bits, ptrdiff_t stride, uint32_t width, uint32_t height);
+}
+
+/**
+ * Finds the parts of a frame that changed since the last one by hashing it in TILE_SIZE x TILE_SIZE tiles
+ * Changed tiles are merged into at most a given number of rectangles, close to the changed area
+ */
+class damage_tracker
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tiles_x = 0;
+    uint32_t tiles_y = 0;
+    std::vector<uint32_t> hashes;
+    std::vector<uint8_t> dirty;
+    size_t dirty_count = 0;
+    bool valid = false;
+
+public:
+    static constexpr uint32_t TILE_SIZE = 64;
+
+    void resize(uint32_t frame_width, uint32_t frame_height);
+    void invalidate();
+    size_t update(const uint8_t* bits, ptrdiff_t stride);
+    std::vector<damage_rect_t> rects(size_t max_rects) const;
+    size_t get_dirty_tiles() const;
+    size_t get_tile_count() const;
+};
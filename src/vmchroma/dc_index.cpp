@@ -0,0 +1,39 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "dc_index.hpp"
+
+/**
+ * Replaces a memory DC in the index, the surface hands out a new DC after every render
+ * @param old_dc The previous DC or nullptr to add a new entry
+ * @param new_dc The new DC or nullptr to remove the entry
+ * @param type The window type
+ * @return False if a new entry didn't fit into the index
+ */
+bool dc_index::replace(const void* old_dc, const void* new_dc, const WND_TYPE type)
+{
+    for (auto& e : entries)
+    {
+        if (e.hdc == old_dc)
+        {
+            e = {new_dc, type};
+            return true;
+        }
+    }
+
+    return new_dc == nullptr;
+}
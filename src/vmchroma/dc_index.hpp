@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include "theme_types.hpp"
+
+typedef struct dc_index_entry
+{
+    const void* hdc;
+    WND_TYPE type;
+} dc_index_entry_t;
+
+/**
+ * Memory DC of every window, so hooks that get a DC know the window it draws in without asking the system
+ * Scanned linearly since there are only a handful of windows
+ */
+class dc_index
+{
+public:
+    static constexpr size_t SIZE = 8;
+
+private:
+    std::array<dc_index_entry_t, SIZE> entries = {};
+
+public:
+    bool replace(const void* old_dc, const void* new_dc, WND_TYPE type);
+
+    /**
+     * Gets the window a memory DC belongs to
+     * @param hdc The device context
+     * @return The window type or std::nullopt if it isn't the memory DC of a window
+     */
+    std::optional<WND_TYPE> find(const void* hdc) const
+    {
+        if (hdc == nullptr)
+            return std::nullopt;
+
+        for (const auto& e : entries)
+        {
+            if (e.hdc == hdc)
+                return e.type;
+        }
+
+        return std::nullopt;
+    }
+
+    /**
+     * Finds the window a color is drawn in, by memory DC if there is one, otherwise by the running wndproc
+     * @param hdc The device context or nullptr for pens and brushes
+     * @param active The window whose wndproc is running
+     * @return The window type
+     */
+    WND_TYPE resolve(const void* hdc, const WND_TYPE active) const
+    {
+        if (const auto type = find(hdc))
+            return *type;
+
+        return active;
+    }
+};
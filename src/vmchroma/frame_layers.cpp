@@ -0,0 +1,391 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "frame_layers.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "simd.hpp"
+
+namespace
+{
+// the fourth byte of a 32 bpp DIB is undefined for GDI, only the color is compared
+constexpr uint32_t COLOR_MASK = 0x00ffffffu;
+
+/**
+ * Compares a tile of the frame with the background, stops at the first differing row
+ * @return True if any pixel differs
+ */
+bool tile_differs(const uint8_t* frame, const size_t frame_stride, const uint8_t* background, const size_t background_stride,
+                  const uint32_t width, const uint32_t height)
+{
+    for (uint32_t y = 0; y < height; y++, frame += frame_stride, background += background_stride)
+    {
+        uint32_t x = 0;
+
+#if defined(VMCHROMA_SSE2)
+        const __m128i mask = _mm_set1_epi32(static_cast<int>(COLOR_MASK));
+        __m128i diff = _mm_setzero_si128();
+
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + x * 4));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + x * 4));
+            diff = _mm_or_si128(diff, _mm_xor_si128(a, b));
+        }
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(diff, mask), _mm_setzero_si128())) != 0xffff)
+            return true;
+#endif
+
+        for (; x < width; x++)
+        {
+            uint32_t a, b;
+            memcpy(&a, frame + x * 4, 4);
+            memcpy(&b, background + x * 4, 4);
+
+            if ((a ^ b) & COLOR_MASK)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
+/**
+ * Keeps a copy of the background the frames are compared with, e.g. the theme bitmap Voicemeeter draws the window from
+ * @param image The background at the default size of the window, 3 or 4 channels
+ * @return False if the image is invalid
+ */
+bool frame_layers::set_background(const image_view_t& image)
+{
+    if (image.pixels == nullptr || image.width == 0 || image.height == 0 || (image.channels != 3 && image.channels != 4) ||
+        image.stride < image.width * image.channels)
+        return false;
+
+    width = image.width;
+    height = image.height;
+    background.resize(static_cast<size_t>(width) * height * 4);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* s = image.pixels + static_cast<size_t>(y) * image.stride;
+        uint8_t* d = background.data() + static_cast<size_t>(y) * width * 4;
+
+        for (uint32_t x = 0; x < width; x++, s += image.channels, d += 4)
+        {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = image.channels == 4 ? s[3] : 0;
+        }
+    }
+
+    tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    overlay_tiles.assign(static_cast<size_t>(tiles_x) * tiles_y, 0);
+    overlay_hashes.assign(overlay_tiles.size(), 0);
+    scaled_valid = false;
+    output_valid = false;
+    return true;
+}
+
+/**
+ * Drops the background, composite fails until another one is set
+ */
+void frame_layers::clear_background()
+{
+    width = 0;
+    height = 0;
+    tiles_x = 0;
+    tiles_y = 0;
+    background = {};
+    scaled_background = {};
+    overlay_tiles = {};
+    overlay_hashes = {};
+    last_overlay_tiles = {};
+    last_overlay_hashes = {};
+    dirty_tiles = {};
+    overlay_rects = {};
+    scaled_valid = false;
+    output_valid = false;
+}
+
+bool frame_layers::has_background() const
+{
+    return !background.empty();
+}
+
+/**
+ * Makes the next composite write the whole destination, e.g. after something else drew into it
+ */
+void frame_layers::invalidate()
+{
+    output_valid = false;
+}
+
+/**
+ * Finds the tiles of the frame that differ from the background, hashes them and merges them into rectangles
+ * The tiles of the previous split are kept for composite
+ * @param frame The frame at the size of the background, 4 channels
+ * @return Number of differing tiles, every tile if the frame doesn't have the size of the background
+ */
+size_t frame_layers::split(const image_view_t& frame)
+{
+    std::swap(overlay_tiles, last_overlay_tiles);
+    std::swap(overlay_hashes, last_overlay_hashes);
+    overlay_tiles.resize(static_cast<size_t>(tiles_x) * tiles_y);
+    overlay_hashes.resize(overlay_tiles.size());
+
+    if (frame.width != width || frame.height != height || frame.channels != 4)
+    {
+        std::fill(overlay_tiles.begin(), overlay_tiles.end(), 1);
+        std::fill(overlay_hashes.begin(), overlay_hashes.end(), 0);
+        find_rects(overlay_tiles, overlay_rects);
+        output_valid = false;
+        return overlay_tiles.size();
+    }
+
+    size_t count = 0;
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+    {
+        const uint32_t y0 = ty * TILE_SIZE;
+        const uint32_t rows = std::min(TILE_SIZE, height - y0);
+
+        for (uint32_t tx = 0; tx < tiles_x; tx++)
+        {
+            const uint32_t x0 = tx * TILE_SIZE;
+            const uint32_t columns = std::min(TILE_SIZE, width - x0);
+            const uint8_t* bits = frame.pixels + static_cast<size_t>(y0) * frame.stride + static_cast<size_t>(x0) * 4;
+            const bool differs = tile_differs(bits, frame.stride, background.data() + (static_cast<size_t>(y0) * width + x0) * 4,
+                                              static_cast<size_t>(width) * 4, columns, rows);
+            const size_t i = static_cast<size_t>(ty) * tiles_x + tx;
+
+            overlay_tiles[i] = differs;
+            overlay_hashes[i] = differs ? tile_hash::hash(bits, static_cast<ptrdiff_t>(frame.stride), columns, rows) : 0;
+            count += differs;
+        }
+    }
+
+    find_rects(overlay_tiles, overlay_rects);
+    return count;
+}
+
+/**
+ * Merges runs of set tiles in a tile row, then runs with the same columns in consecutive rows
+ * @param tiles One byte per tile, non-zero if set
+ * @param rects Receives the rectangles in frame coordinates
+ */
+void frame_layers::find_rects(const std::vector<uint8_t>& tiles, std::vector<damage_rect_t>& rects) const
+{
+    // rectangles ending at the previous tile row start here, in tile coordinates
+    size_t open_begin = 0;
+
+    rects.clear();
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+    {
+        const size_t open_end = rects.size();
+        const uint8_t* row = tiles.data() + static_cast<size_t>(ty) * tiles_x;
+
+        for (uint32_t tx = 0; tx < tiles_x;)
+        {
+            if (!row[tx])
+            {
+                tx++;
+                continue;
+            }
+
+            const uint32_t run_start = tx;
+
+            while (tx < tiles_x && row[tx])
+                tx++;
+
+            const auto grown = std::find_if(rects.begin() + open_begin, rects.begin() + open_end, [&](const damage_rect_t& r)
+            {
+                return r.left == run_start && r.right == tx && r.bottom == ty;
+            });
+
+            if (grown != rects.begin() + open_end)
+                grown->bottom = ty + 1;
+            else
+                rects.push_back({run_start, ty, tx, ty + 1});
+        }
+
+        // rectangles that weren't continued in this row are done, the others move to the end for the next row
+        std::stable_partition(rects.begin() + open_begin, rects.end(), [ty](const damage_rect_t& r)
+        {
+            return r.bottom != ty + 1;
+        });
+
+        open_begin = std::find_if(rects.begin() + open_begin, rects.end(), [ty](const damage_rect_t& r)
+        {
+            return r.bottom == ty + 1;
+        }) - rects.begin();
+    }
+
+    for (auto& r : rects)
+    {
+        r.left *= TILE_SIZE;
+        r.top *= TILE_SIZE;
+        r.right = std::min(r.right * TILE_SIZE, width);
+        r.bottom = std::min(r.bottom * TILE_SIZE, height);
+    }
+}
+
+/**
+ * Scales the output pixels that read any of the given parts of the frame
+ * @param tile_rects Rectangles in frame coordinates
+ * @param written Receives the rectangles of the destination that were scaled
+ * @return False if scaling failed
+ */
+bool frame_layers::scale_tiles(const image_view_t& frame, const image_view_t& dst, const frame_filter filter, thread_pool* pool,
+                               const std::vector<damage_rect_t>& tile_rects, std::vector<damage_rect_t>& written)
+{
+    const size_t first = written.size();
+
+    for (const auto& r : tile_rects)
+    {
+        damage_rect_t mapped;
+
+        if (scaler.map_rect(frame, dst, filter, r, mapped) && mapped.left < mapped.right && mapped.top < mapped.bottom)
+        {
+            written.push_back(mapped);
+            stats.scaled_pixels += static_cast<uint64_t>(mapped.right - mapped.left) * (mapped.bottom - mapped.top);
+        }
+    }
+
+    return written.size() == first || scaler.scale_rects(frame, dst, written.data() + first, written.size() - first, filter, pool);
+}
+
+/**
+ * Scales a frame into the destination, a new destination starts from the cached scaled background
+ * @param frame The frame at the size of the background, 4 channels
+ * @param dst Destination, kept by the caller between frames
+ * @param filter Scaling filter
+ * @param pool Optional thread pool
+ * @param written Receives the rectangles of the destination that were written, may overlap
+ * @param full Receives true if the whole destination was written
+ * @return False if there is no background of the frame's size or scaling failed, the destination is undefined then
+ */
+bool frame_layers::composite(const image_view_t& frame, const image_view_t& dst, const frame_filter filter, thread_pool* pool,
+                             std::vector<damage_rect_t>& written, bool& full)
+{
+    written.clear();
+    full = true;
+
+    if (!has_background() || frame.width != width || frame.height != height)
+        return false;
+
+    if (!scaled_valid || dst.width != scaled_width || dst.height != scaled_height || filter != scaled_filter)
+    {
+        scaled_background.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+
+        const image_view_t src = {background.data(), width, height, width * 4, 4};
+        const image_view_t scaled = {scaled_background.data(), dst.width, dst.height, dst.width * 4, 4};
+
+        if (!scaler.scale(src, scaled, filter, pool))
+            return false;
+
+        scaled_width = dst.width;
+        scaled_height = dst.height;
+        scaled_filter = filter;
+        scaled_valid = true;
+        output_valid = false;
+        stats.background_scales++;
+    }
+
+    if (dst.pixels != output_pixels)
+        output_valid = false;
+
+    const bool had_output = output_valid;
+    const damage_rect_t all = {0, 0, dst.width, dst.height};
+    const size_t overlay = split(frame);
+
+    stats.frames++;
+    stats.output_pixels += static_cast<uint64_t>(dst.width) * dst.height;
+    output_valid = false;
+
+    // tiles whose pixels may differ from the last frame, background tiles are known to be unchanged
+    size_t dirty = overlay;
+
+    if (had_output)
+    {
+        dirty_tiles.resize(overlay_tiles.size());
+        dirty = 0;
+
+        for (size_t i = 0; i < overlay_tiles.size(); i++)
+        {
+            dirty_tiles[i] = overlay_tiles[i] != last_overlay_tiles[i] || overlay_hashes[i] != last_overlay_hashes[i];
+            dirty += dirty_tiles[i];
+        }
+    }
+
+    // most of the frame has to be scaled anyway, e.g. the background is drawn somewhere else
+    if (dirty * 4 > overlay_tiles.size() * 3)
+    {
+        if (!scaler.scale(frame, dst, filter, pool))
+            return false;
+
+        written.assign(1, all);
+        stats.full_frames++;
+        stats.scaled_pixels += static_cast<uint64_t>(dst.width) * dst.height;
+    }
+    else if (!had_output)
+    {
+        // the background where the frame shows it, the overlay scaled on top
+        for (uint32_t y = 0; y < dst.height; y++)
+            memcpy(dst.pixels + static_cast<size_t>(y) * dst.stride, scaled_background.data() + static_cast<size_t>(y) * dst.width * 4, static_cast<size_t>(dst.width) * 4);
+
+        if (!scale_tiles(frame, dst, filter, pool, overlay_rects, written))
+            return false;
+
+        written.assign(1, all);
+    }
+    else
+    {
+        std::vector<damage_rect_t> dirty_rects;
+        find_rects(dirty_tiles, dirty_rects);
+
+        if (!scale_tiles(frame, dst, filter, pool, dirty_rects, written))
+            return false;
+
+        full = false;
+    }
+
+    output_valid = true;
+    output_pixels = dst.pixels;
+    return true;
+}
+
+/**
+ * Gets the overlay found by the last split
+ * @return Rectangles in frame coordinates
+ */
+const std::vector<damage_rect_t>& frame_layers::get_overlay_rects() const
+{
+    return overlay_rects;
+}
+
+frame_layers_stats_t frame_layers::get_stats() const
+{
+    return stats;
+}
@@ -0,0 +1,85 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "damage_tracker.hpp"
+#include "frame_scaler.hpp"
+
+class thread_pool;
+
+typedef struct frame_layers_stats
+{
+    uint64_t frames; // frames composited from the layers
+    uint64_t full_frames; // frames scaled whole because most of them differed from the background
+    uint64_t background_scales; // times the background was scaled, once per window size and filter
+    uint64_t scaled_pixels; // output pixels scaled from the frame
+    uint64_t output_pixels; // output pixels of all composited frames
+} frame_layers_stats_t;
+
+/**
+ * Splits a frame into the static theme background and the overlay Voicemeeter draws on top of it, e.g. meters,
+ * fader knobs and text, by comparing it with the background in TILE_SIZE x TILE_SIZE tiles
+ * The background is scaled once per window size and filter and kept, a new destination starts as a copy of it with
+ * only the overlay scaled on top; afterwards only tiles that joined or left the overlay or whose overlay changed are
+ * scaled again, widened by the reach of the filter, so the output is always the same as scaling the whole frame
+ * Background tiles are only compared, overlay tiles are hashed too so they can be compared with the last frame
+ */
+class frame_layers
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tiles_x = 0;
+    uint32_t tiles_y = 0;
+    std::vector<uint8_t> background; // BGRX, the fourth byte is ignored when comparing
+    std::vector<uint8_t> scaled_background;
+    uint32_t scaled_width = 0;
+    uint32_t scaled_height = 0;
+    frame_filter scaled_filter = FRAME_FILTER_AUTO;
+    bool scaled_valid = false;
+    bool output_valid = false; // the destination holds the last frame and the tile state below describes it
+    const uint8_t* output_pixels = nullptr;
+    frame_scaler scaler;
+    std::vector<uint8_t> overlay_tiles;
+    std::vector<uint32_t> overlay_hashes;
+    std::vector<uint8_t> last_overlay_tiles;
+    std::vector<uint32_t> last_overlay_hashes;
+    std::vector<uint8_t> dirty_tiles;
+    std::vector<damage_rect_t> overlay_rects; // source coordinates
+    frame_layers_stats_t stats = {};
+
+    void find_rects(const std::vector<uint8_t>& tiles, std::vector<damage_rect_t>& rects) const;
+    bool scale_tiles(const image_view_t& frame, const image_view_t& dst, frame_filter filter, thread_pool* pool,
+                     const std::vector<damage_rect_t>& tile_rects, std::vector<damage_rect_t>& written);
+
+public:
+    static constexpr uint32_t TILE_SIZE = 16;
+
+    bool set_background(const image_view_t& image);
+    void clear_background();
+    bool has_background() const;
+    void invalidate();
+    size_t split(const image_view_t& frame);
+    bool composite(const image_view_t& frame, const image_view_t& dst, frame_filter filter, thread_pool* pool,
+                   std::vector<damage_rect_t>& written, bool& full);
+    const std::vector<damage_rect_t>& get_overlay_rects() const;
+    frame_layers_stats_t get_stats() const;
+};
@@ -0,0 +1,627 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "frame_scaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+// the vertical pass keeps 6 fractional bits in its 16 bit rows, the horizontal pass removes them
+constexpr int ROW_BITS = 6;
+constexpr int V_SHIFT = frame_scaler::WEIGHT_BITS - ROW_BITS;
+constexpr int H_SHIFT = frame_scaler::WEIGHT_BITS + ROW_BITS;
+
+double box(const double x)
+{
+    return std::abs(x) <= 0.5 ? 1.0 : 0.0;
+}
+
+double tent(const double x)
+{
+    return std::max(0.0, 1.0 - std::abs(x));
+}
+
+// the Mitchell-Netravali family of cubics
+double cubic(double x, const double B, const double C)
+{
+    x = std::abs(x);
+
+    if (x < 1.0)
+        return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0;
+
+    if (x < 2.0)
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0;
+
+    return 0.0;
+}
+
+double catmull_rom(const double x)
+{
+    return cubic(x, 0.0, 0.5);
+}
+
+// B = C = 1/3, like the resampler
+double mitchell(const double x)
+{
+    return cubic(x, 1.0 / 3.0, 1.0 / 3.0);
+}
+
+int16_t clamp_i16(const int32_t v)
+{
+    return static_cast<int16_t>(std::clamp(v, -32768, 32767));
+}
+
+typedef struct kernel_weights
+{
+    const int16_t* weights;
+    const int32_t* pairs;
+} kernel_weights_t;
+
+typedef void (*vertical_fn)(const uint8_t* const* rows, const kernel_weights_t& w, uint32_t taps, int16_t* out, size_t n);
+// row holds the source columns from origin on
+typedef void (*horizontal_fn)(const int16_t* row, const uint32_t* first, uint32_t origin, const kernel_weights_t& w, uint32_t taps, uint8_t* out, uint32_t width);
+
+void vertical_scalar(const uint8_t* const* rows, const kernel_weights_t& w, const uint32_t taps, int16_t* out, const size_t n)
+{
+    const int16_t* weights = w.weights;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t acc = 0;
+
+        for (uint32_t k = 0; k < taps; k++)
+            acc += weights[k] * rows[k][i];
+
+        out[i] = clamp_i16((acc + (1 << (V_SHIFT - 1))) >> V_SHIFT);
+    }
+}
+
+void horizontal_scalar(const int16_t* row, const uint32_t* first, const uint32_t origin, const kernel_weights_t& w, const uint32_t taps, uint8_t* out, const uint32_t width)
+{
+    const int16_t* weights = w.weights;
+
+    for (uint32_t x = 0; x < width; x++, weights += taps, out += 4)
+    {
+        const int16_t* p = row + static_cast<size_t>(first[x] - origin) * 4;
+
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            int32_t acc = 0;
+
+            for (uint32_t k = 0; k < taps; k++)
+                acc += weights[k] * p[k * 4 + c];
+
+            out[c] = static_cast<uint8_t>(std::clamp((acc + (1 << (H_SHIFT - 1))) >> H_SHIFT, 0, 255));
+        }
+    }
+}
+
+#if defined(VMCHROMA_SSE2)
+// PAIRS is the number of tap pairs, 0 for any number of taps; the loops over fixed pairs are unrolled
+template <uint32_t PAIRS>
+void vertical_sse2(const uint8_t* const* rows, const kernel_weights_t& weights, const uint32_t taps, int16_t* out, const size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (V_SHIFT - 1));
+    const uint32_t pairs = PAIRS > 0 ? PAIRS : (taps + 1) / 2;
+    __m128i w[32];
+    const uint8_t* r[64];
+
+    for (uint32_t j = 0; j < pairs; j++)
+    {
+        w[j] = _mm_set1_epi32(weights.pairs[j]);
+        r[j * 2] = rows[j * 2];
+        // a missing second tap reads the first row again with weight 0
+        r[j * 2 + 1] = j * 2 + 1 < taps ? rows[j * 2 + 1] : rows[j * 2];
+    }
+
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+
+        for (uint32_t j = 0; j < (PAIRS > 0 ? PAIRS : pairs); j++)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r[j * 2] + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r[j * 2 + 1] + i));
+            const __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+            const __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+            const __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+            const __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), w[j]));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), w[j]));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), w[j]));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), w[j]));
+        }
+
+        acc0 = _mm_srai_epi32(_mm_add_epi32(acc0, round), V_SHIFT);
+        acc1 = _mm_srai_epi32(_mm_add_epi32(acc1, round), V_SHIFT);
+        acc2 = _mm_srai_epi32(_mm_add_epi32(acc2, round), V_SHIFT);
+        acc3 = _mm_srai_epi32(_mm_add_epi32(acc3, round), V_SHIFT);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(acc0, acc1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_packs_epi32(acc2, acc3));
+    }
+
+    if (i < n)
+    {
+        const uint8_t* tail[64];
+
+        for (uint32_t k = 0; k < taps; k++)
+            tail[k] = rows[k] + i;
+
+        vertical_scalar(tail, weights, taps, out + i, n - i);
+    }
+}
+
+// one output pixel, two neighboring source pixels per multiply-add, interleaved channel by channel
+template <uint32_t PAIRS>
+__m128i horizontal_pixel(const int16_t* p, const int32_t* pairs, const uint32_t pair_count)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    for (uint32_t j = 0; j < (PAIRS > 0 ? PAIRS : pair_count); j++)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j * 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(v, _mm_srli_si128(v, 8)), _mm_set1_epi32(pairs[j])));
+    }
+
+    return acc;
+}
+
+// the row has one spare pixel, so the second pixel of the last pair can be loaded even if its weight is 0
+template <uint32_t PAIRS>
+void horizontal_sse2(const int16_t* row, const uint32_t* first, const uint32_t origin, const kernel_weights_t& weights, const uint32_t taps, uint8_t* out, const uint32_t width)
+{
+    const __m128i round = _mm_set1_epi32(1 << (H_SHIFT - 1));
+    const uint32_t pair_count = PAIRS > 0 ? PAIRS : (taps + 1) / 2;
+    const int32_t* pairs = weights.pairs;
+    uint32_t x = 0;
+
+    // two output pixels per store
+    for (; x + 2 <= width; x += 2, pairs += pair_count * 2, out += 8)
+    {
+        __m128i a = horizontal_pixel<PAIRS>(row + static_cast<size_t>(first[x] - origin) * 4, pairs, pair_count);
+        __m128i b = horizontal_pixel<PAIRS>(row + static_cast<size_t>(first[x + 1] - origin) * 4, pairs + pair_count, pair_count);
+        a = _mm_srai_epi32(_mm_add_epi32(a, round), H_SHIFT);
+        b = _mm_srai_epi32(_mm_add_epi32(b, round), H_SHIFT);
+        const __m128i px = _mm_packs_epi32(a, b);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(px, px));
+    }
+
+    if (x < width)
+    {
+        __m128i a = horizontal_pixel<PAIRS>(row + static_cast<size_t>(first[x] - origin) * 4, pairs, pair_count);
+        a = _mm_srai_epi32(_mm_add_epi32(a, round), H_SHIFT);
+        const __m128i px = _mm_packs_epi32(a, a);
+        const int v = _mm_cvtsi128_si32(_mm_packus_epi16(px, px));
+        memcpy(out, &v, 4);
+    }
+}
+
+// 16 bytes widened to 16 bit in one step, the lane-wise unpacks and packs cancel out so the order is kept
+template <uint32_t PAIRS>
+VMCHROMA_TARGET_AVX2 void vertical_avx2(const uint8_t* const* rows, const kernel_weights_t& weights, const uint32_t taps, int16_t* out, const size_t n)
+{
+    const __m256i round = _mm256_set1_epi32(1 << (V_SHIFT - 1));
+    const uint32_t pairs = PAIRS > 0 ? PAIRS : (taps + 1) / 2;
+    __m256i w[32];
+    const uint8_t* r[64];
+
+    for (uint32_t j = 0; j < pairs; j++)
+    {
+        w[j] = _mm256_set1_epi32(weights.pairs[j]);
+        r[j * 2] = rows[j * 2];
+        r[j * 2 + 1] = j * 2 + 1 < taps ? rows[j * 2 + 1] : rows[j * 2];
+    }
+
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+
+        for (uint32_t j = 0; j < (PAIRS > 0 ? PAIRS : pairs); j++)
+        {
+            const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r[j * 2] + i)));
+            const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r[j * 2 + 1] + i)));
+
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w[j]));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w[j]));
+        }
+
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), V_SHIFT);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), V_SHIFT);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_packs_epi32(lo, hi));
+    }
+
+    if (i < n)
+    {
+        const uint8_t* tail[64];
+
+        for (uint32_t k = 0; k < taps; k++)
+            tail[k] = rows[k] + i;
+
+        vertical_scalar(tail, weights, taps, out + i, n - i);
+    }
+}
+
+vertical_fn pick_vertical_simd(const uint32_t taps)
+{
+    if (simd::has_avx2())
+    {
+        switch ((taps + 1) / 2)
+        {
+        case 1: return vertical_avx2<1>;
+        case 2: return vertical_avx2<2>;
+        case 3: return vertical_avx2<3>;
+        case 4: return vertical_avx2<4>;
+        default: return vertical_avx2<0>;
+        }
+    }
+
+    switch ((taps + 1) / 2)
+    {
+    case 1: return vertical_sse2<1>;
+    case 2: return vertical_sse2<2>;
+    case 3: return vertical_sse2<3>;
+    case 4: return vertical_sse2<4>;
+    default: return vertical_sse2<0>;
+    }
+}
+
+horizontal_fn pick_horizontal_sse2(const uint32_t taps)
+{
+    switch ((taps + 1) / 2)
+    {
+    case 1: return horizontal_sse2<1>;
+    case 2: return horizontal_sse2<2>;
+    case 3: return horizontal_sse2<3>;
+    case 4: return horizontal_sse2<4>;
+    default: return horizontal_sse2<0>;
+    }
+}
+#endif
+
+// scaling 1:1 with Mitchell would blur, the frame is shown as is instead
+void copy_unscaled(const image_view_t& src, const image_view_t& dst, const damage_rect_t* rects, const size_t rect_count)
+{
+    for (size_t i = 0; i < rect_count; i++)
+    {
+        const auto& r = rects[i];
+
+        for (uint32_t y = r.top; y < r.bottom; y++)
+        {
+            memcpy(dst.pixels + static_cast<size_t>(y) * dst.stride + static_cast<size_t>(r.left) * 4,
+                   src.pixels + static_cast<size_t>(y) * src.stride + static_cast<size_t>(r.left) * 4,
+                   static_cast<size_t>(r.right - r.left) * 4);
+        }
+    }
+}
+
+typedef struct pass
+{
+    uint32_t taps;
+    const uint32_t* first;
+    const int16_t* weights;
+    const int32_t* pairs;
+} pass_t;
+
+/**
+ * Scales the output rectangles, each task handles a few of them with its own row buffer
+ * Rectangles are cut into bands of rows first, so a few chunks per worker keep the threads busy when one is preempted
+ */
+bool run(const image_view_t& src, const image_view_t& dst, const pass_t& v, const pass_t& h, const damage_rect_t* rects, const size_t rect_count,
+         thread_pool* pool, const vertical_fn vertical, const horizontal_fn horizontal)
+{
+    const uint32_t v_pairs = (v.taps + 1) / 2;
+    const uint32_t h_pairs = (h.taps + 1) / 2;
+
+    // only the source columns the rectangle reads are filtered vertically
+    const auto scale_rect = [&](const damage_rect_t& r, std::vector<int16_t>& row)
+    {
+        const uint32_t origin = h.first[r.left];
+        const size_t row_values = static_cast<size_t>(h.first[r.right - 1] + h.taps - origin) * 4;
+        const kernel_weights_t h_weights = {h.weights + static_cast<size_t>(r.left) * h.taps, h.pairs + static_cast<size_t>(r.left) * h_pairs};
+        const uint8_t* taps[64];
+
+        for (uint32_t y = r.top; y < r.bottom; y++)
+        {
+            for (uint32_t k = 0; k < v.taps; k++)
+                taps[k] = src.pixels + static_cast<size_t>(v.first[y] + k) * src.stride + static_cast<size_t>(origin) * 4;
+
+            const kernel_weights_t v_weights = {v.weights + static_cast<size_t>(y) * v.taps, v.pairs + static_cast<size_t>(y) * v_pairs};
+            vertical(taps, v_weights, v.taps, row.data(), row_values);
+            horizontal(row.data(), h.first + r.left, origin, h_weights, h.taps,
+                       dst.pixels + static_cast<size_t>(y) * dst.stride + static_cast<size_t>(r.left) * 4, r.right - r.left);
+        }
+    };
+
+    // the spare pixel after the row is read with weight 0 by the SIMD kernels
+    const size_t row_size = static_cast<size_t>(src.width) * 4 + 4;
+    uint64_t area = 0;
+
+    for (size_t i = 0; i < rect_count; i++)
+        area += static_cast<uint64_t>(rects[i].right - rects[i].left) * (rects[i].bottom - rects[i].top);
+
+    if (pool == nullptr || pool->size() < 2 || area < 64 * static_cast<uint64_t>(dst.width))
+    {
+        std::vector<int16_t> row(row_size, 0);
+
+        for (size_t i = 0; i < rect_count; i++)
+            scale_rect(rects[i], row);
+
+        return true;
+    }
+
+    const uint64_t chunks = pool->size() * 4;
+    const uint64_t chunk_area = (area + chunks - 1) / chunks;
+    std::vector<damage_rect_t> bands;
+
+    for (size_t i = 0; i < rect_count; i++)
+    {
+        const auto& r = rects[i];
+        const uint64_t width = r.right - r.left;
+        const auto rows = static_cast<uint32_t>(std::max<uint64_t>(1, chunk_area / width));
+
+        for (uint32_t y = r.top; y < r.bottom; y += rows)
+            bands.push_back({r.left, y, r.right, std::min(r.bottom, y + rows)});
+    }
+
+    // consecutive bands up to about the same area make one task
+    std::vector<std::future<void>> done;
+    size_t first = 0;
+    uint64_t task_area = 0;
+
+    for (size_t i = 0; i < bands.size(); i++)
+    {
+        task_area += static_cast<uint64_t>(bands[i].right - bands[i].left) * (bands[i].bottom - bands[i].top);
+
+        if (task_area < chunk_area && i + 1 < bands.size())
+            continue;
+
+        done.push_back(pool->submit([&scale_rect, &bands, row_size, first, last = i + 1]
+        {
+            std::vector<int16_t> row(row_size, 0);
+
+            for (size_t k = first; k < last; k++)
+                scale_rect(bands[k], row);
+        }));
+
+        first = i + 1;
+        task_area = 0;
+    }
+
+    for (auto& f : done)
+        f.get();
+
+    return true;
+}
+}
+
+/**
+ * Resolves the auto filter from the scale the frame is drawn at
+ * @param scale Window size relative to the default size, the larger of both axes
+ * @return Nearest when unscaled, cubic down to 85% where it has the lowest error at about half the cost of
+ *         high quality cubic, high quality cubic below where the fixed size kernels alias (see vmbench scaling)
+ */
+frame_filter frame_scaler::pick_filter(const float scale)
+{
+    if (scale >= 0.999f && scale <= 1.001f)
+        return FRAME_FILTER_NEAREST;
+
+    return scale >= 0.85f ? FRAME_FILTER_CUBIC : FRAME_FILTER_HQ_CUBIC;
+}
+
+/**
+ * Computes a fixed number of taps for every output coordinate, windows at the edges are moved inside the source
+ * and the taps falling outside the kernel get weight 0, so edges don't darken
+ */
+void frame_scaler::build_axis(axis_t& axis, const uint32_t src_size, const uint32_t dst_size, const frame_filter filter)
+{
+    const double support = filter == FRAME_FILTER_NEAREST ? 0.5 : filter == FRAME_FILTER_BILINEAR ? 1.0 : 2.0;
+    const auto kernel = filter == FRAME_FILTER_NEAREST ? box : filter == FRAME_FILTER_BILINEAR ? tent : filter == FRAME_FILTER_CUBIC ? catmull_rom : mitchell;
+    const double scale = static_cast<double>(src_size) / dst_size;
+    // only high quality cubic widens its kernel when shrinking, the others sample a fixed neighborhood like Direct2D
+    const double filter_scale = filter == FRAME_FILTER_HQ_CUBIC ? std::max(scale, 1.0) : 1.0;
+    const double radius = support * filter_scale;
+
+    axis.src_size = src_size;
+    axis.dst_size = dst_size;
+    axis.taps = std::min(src_size, std::max(1u, static_cast<uint32_t>(std::ceil(2 * radius))));
+    axis.first.resize(dst_size);
+    axis.weights.assign(static_cast<size_t>(dst_size) * axis.taps, 0);
+    axis.pairs.clear();
+    axis.pairs.reserve(static_cast<size_t>(dst_size) * ((axis.taps + 1) / 2));
+
+    std::vector<double> w(axis.taps);
+
+    for (uint32_t i = 0; i < dst_size; i++)
+    {
+        const double center = (i + 0.5) * scale;
+        const auto lowest = static_cast<int64_t>(std::floor(center - radius - 0.5)) + 1;
+        const auto first = static_cast<uint32_t>(std::clamp<int64_t>(lowest, 0, src_size - axis.taps));
+        double sum = 0.0;
+
+        for (uint32_t k = 0; k < axis.taps; k++)
+        {
+            w[k] = kernel((first + k + 0.5 - center) / filter_scale);
+            sum += w[k];
+        }
+
+        int16_t* q = axis.weights.data() + static_cast<size_t>(i) * axis.taps;
+        int32_t q_sum = 0;
+        uint32_t largest = 0;
+
+        for (uint32_t k = 0; k < axis.taps; k++)
+        {
+            q[k] = static_cast<int16_t>(std::lround(w[k] / sum * (1 << WEIGHT_BITS)));
+            q_sum += q[k];
+
+            if (std::abs(w[k]) > std::abs(w[largest]))
+                largest = k;
+        }
+
+        // rounding leftovers go to the center tap so flat areas stay exact
+        q[largest] = static_cast<int16_t>(q[largest] + (1 << WEIGHT_BITS) - q_sum);
+        axis.first[i] = first;
+
+        for (uint32_t k = 0; k < axis.taps; k += 2)
+        {
+            const auto lo = static_cast<uint16_t>(q[k]);
+            const auto hi = static_cast<uint16_t>(k + 1 < axis.taps ? q[k + 1] : 0);
+            axis.pairs.push_back(static_cast<int32_t>(static_cast<uint32_t>(hi) << 16 | lo));
+        }
+    }
+}
+
+bool frame_scaler::prepare(const image_view_t& src, const image_view_t& dst, const frame_filter frame_filter)
+{
+    const auto valid = [](const image_view_t& img)
+    {
+        return img.pixels != nullptr && img.width > 0 && img.height > 0 && img.channels == 4 && img.stride >= img.width * 4;
+    };
+
+    if (!valid(src) || !valid(dst))
+        return false;
+
+    const auto resolved = frame_filter != FRAME_FILTER_AUTO
+                              ? frame_filter
+                              : pick_filter(std::max(static_cast<float>(dst.width) / src.width, static_cast<float>(dst.height) / src.height));
+
+    if (filter != resolved || h_axis.src_size != src.width || h_axis.dst_size != dst.width)
+        build_axis(h_axis, src.width, dst.width, resolved);
+
+    if (filter != resolved || v_axis.src_size != src.height || v_axis.dst_size != dst.height)
+        build_axis(v_axis, src.height, dst.height, resolved);
+
+    filter = resolved;
+
+    // 64 taps cover shrinking to less than a tenth, far below the half size a window can be shrunk to
+    return h_axis.taps <= 64 && v_axis.taps <= 64;
+}
+
+/**
+ * Scales a BGRX frame to the size of the destination, an unscaled frame is copied
+ * @param src Source frame, 4 channels
+ * @param dst Destination frame, 4 channels
+ * @param frame_filter Filter, auto picks one by the scale
+ * @param pool Optional thread pool the rows are split across
+ * @return False if the frames are invalid
+ */
+bool frame_scaler::scale(const image_view_t& src, const image_view_t& dst, const frame_filter frame_filter, thread_pool* pool)
+{
+    const damage_rect_t all = {0, 0, dst.width, dst.height};
+    return scale_rects(src, dst, &all, 1, frame_filter, pool);
+}
+
+/**
+ * Scales only parts of the frame, the rest of the destination is left as is
+ * Every output pixel is the same as if the whole frame was scaled
+ * @param src Source frame, 4 channels
+ * @param dst Destination frame, 4 channels
+ * @param rects Non-empty rectangles in destination coordinates, see map_rect
+ * @param rect_count Number of rectangles
+ * @param frame_filter Filter, auto picks one by the scale
+ * @param pool Optional thread pool the rectangles are split across
+ * @return False if the frames are invalid or a rectangle is outside the destination
+ */
+bool frame_scaler::scale_rects(const image_view_t& src, const image_view_t& dst, const damage_rect_t* rects, const size_t rect_count,
+                               const frame_filter frame_filter, thread_pool* pool)
+{
+    if (!prepare(src, dst, frame_filter))
+        return false;
+
+    for (size_t i = 0; i < rect_count; i++)
+    {
+        const auto& r = rects[i];
+
+        if (r.left >= r.right || r.top >= r.bottom || r.right > dst.width || r.bottom > dst.height)
+            return false;
+    }
+
+    if (src.width == dst.width && src.height == dst.height)
+    {
+        copy_unscaled(src, dst, rects, rect_count);
+        return true;
+    }
+
+    const pass_t v = {v_axis.taps, v_axis.first.data(), v_axis.weights.data(), v_axis.pairs.data()};
+    const pass_t h = {h_axis.taps, h_axis.first.data(), h_axis.weights.data(), h_axis.pairs.data()};
+
+#if defined(VMCHROMA_SSE2)
+    return run(src, dst, v, h, rects, rect_count, pool, pick_vertical_simd(v_axis.taps), pick_horizontal_sse2(h_axis.taps));
+#else
+    return run(src, dst, v, h, rects, rect_count, pool, vertical_scalar, horizontal_scalar);
+#endif
+}
+
+bool frame_scaler::scale_scalar(const image_view_t& src, const image_view_t& dst, const frame_filter frame_filter)
+{
+    if (!prepare(src, dst, frame_filter))
+        return false;
+
+    const damage_rect_t all = {0, 0, dst.width, dst.height};
+
+    if (src.width == dst.width && src.height == dst.height)
+    {
+        copy_unscaled(src, dst, &all, 1);
+        return true;
+    }
+
+    const pass_t v = {v_axis.taps, v_axis.first.data(), v_axis.weights.data(), v_axis.pairs.data()};
+    const pass_t h = {h_axis.taps, h_axis.first.data(), h_axis.weights.data(), h_axis.pairs.data()};
+
+    return run(src, dst, v, h, &all, 1, nullptr, vertical_scalar, horizontal_scalar);
+}
+
+/**
+ * Gets the output pixels whose filter taps read a part of the source, so a change there only has to be scaled again inside them
+ * @param src Source frame, 4 channels
+ * @param dst Destination frame, 4 channels
+ * @param frame_filter Filter, auto picks one by the scale
+ * @param src_rect Rectangle in source coordinates
+ * @param dst_rect Receives the rectangle in destination coordinates, empty if no output pixel reads the source rectangle
+ * @return False if the frames are invalid
+ */
+bool frame_scaler::map_rect(const image_view_t& src, const image_view_t& dst, const frame_filter frame_filter, const damage_rect_t& src_rect, damage_rect_t& dst_rect)
+{
+    if (!prepare(src, dst, frame_filter))
+        return false;
+
+    // an output coordinate is reached if its taps overlap [lo, hi), the first taps never decrease along an axis
+    const auto reach = [](const axis_t& axis, const uint32_t lo, const uint32_t hi, uint32_t& out_lo, uint32_t& out_hi)
+    {
+        const uint32_t from = lo + 1 >= axis.taps ? lo + 1 - axis.taps : 0;
+        out_lo = static_cast<uint32_t>(std::lower_bound(axis.first.begin(), axis.first.end(), from) - axis.first.begin());
+        out_hi = static_cast<uint32_t>(std::lower_bound(axis.first.begin(), axis.first.end(), hi) - axis.first.begin());
+        out_hi = std::max(out_lo, out_hi);
+    };
+
+    reach(h_axis, src_rect.left, src_rect.right, dst_rect.left, dst_rect.right);
+    reach(v_axis, src_rect.top, src_rect.bottom, dst_rect.top, dst_rect.bottom);
+    return true;
+}
@@ -0,0 +1,69 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "damage_tracker.hpp"
+#include "resampler.hpp"
+
+class thread_pool;
+
+// the scalingFilter modes, auto is resolved per frame by pick_filter
+enum frame_filter { FRAME_FILTER_NEAREST, FRAME_FILTER_BILINEAR, FRAME_FILTER_CUBIC, FRAME_FILTER_HQ_CUBIC, FRAME_FILTER_AUTO };
+
+/**
+ * Scales 32 bpp frames for the software renderer, every frame to the same size until the window is resized
+ * The filter tables are built once per size pair with 14 bit integer weights, a fixed number of taps per axis
+ * The vertical pass writes 16 bit rows (AVX2 or SSE2), the horizontal pass reads two taps per multiply-add (SSE2),
+ * integer math keeps the SIMD result identical to the scalar one; rows are split across a thread pool if one is given
+ * The filters are CPU references of the Direct2D interpolation modes: nearest, a 2x2 tent, a 4x4 Catmull-Rom cubic,
+ * and for high quality cubic Mitchell-Netravali widened by the scale when shrinking
+ */
+class frame_scaler
+{
+    typedef struct axis
+    {
+        uint32_t src_size = 0;
+        uint32_t dst_size = 0;
+        uint32_t taps = 0;
+        std::vector<uint32_t> first; // first source coordinate of each output coordinate
+        std::vector<int16_t> weights; // taps per output coordinate, sum 1 << WEIGHT_BITS
+        std::vector<int32_t> pairs; // the weights of two taps packed for a multiply-add, a last odd tap is paired with 0
+    } axis_t;
+
+    axis_t h_axis;
+    axis_t v_axis;
+    frame_filter filter = FRAME_FILTER_BILINEAR;
+
+    static void build_axis(axis_t& axis, uint32_t src_size, uint32_t dst_size, frame_filter filter);
+    bool prepare(const image_view_t& src, const image_view_t& dst, frame_filter frame_filter);
+
+public:
+    static constexpr int WEIGHT_BITS = 14;
+
+    static frame_filter pick_filter(float scale);
+
+    bool scale(const image_view_t& src, const image_view_t& dst, frame_filter frame_filter, thread_pool* pool = nullptr);
+    bool scale_rects(const image_view_t& src, const image_view_t& dst, const damage_rect_t* rects, size_t rect_count,
+                     frame_filter frame_filter, thread_pool* pool = nullptr);
+    bool scale_scalar(const image_view_t& src, const image_view_t& dst, frame_filter frame_filter);
+    bool map_rect(const image_view_t& src, const image_view_t& dst, frame_filter frame_filter, const damage_rect_t& src_rect, damage_rect_t& dst_rect);
+};
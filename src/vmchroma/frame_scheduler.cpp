@@ -0,0 +1,141 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "frame_scheduler.hpp"
+
+#include <chrono>
+
+uint64_t steady_frame_clock::now_us()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @param clock Time source
+ * @param frame_interval_us Minimum time between two presents of a window that aren't forced by input
+ */
+frame_scheduler::frame_scheduler(frame_clock& clock, const uint64_t frame_interval_us) : clock(clock), frame_interval_us(frame_interval_us)
+{
+}
+
+// a window is due this long after its last present, the slack absorbs timer jitter
+uint64_t frame_scheduler::due_after_us() const
+{
+    return frame_interval_us - frame_interval_us / 4;
+}
+
+/**
+ * Asks to present a window, the caller renders if this returns true
+ * @param window Window handle
+ * @param reason What changed the window
+ * @return True if the window should present now, otherwise it stays dirty until a later request
+ */
+bool frame_scheduler::request(const uintptr_t window, const frame_reason reason)
+{
+    auto& state = windows[window];
+    const auto now = clock.now_us();
+    const auto elapsed = now - state.last_present_us;
+    const bool frame_due = !state.presented || elapsed >= due_after_us();
+
+    stats.requests++;
+    state.dirty = true;
+
+    if (!frame_due && !(reason == FRAME_INPUT && elapsed >= frame_interval_us / 4))
+    {
+        stats.coalesced++;
+        return false;
+    }
+
+    if (!frame_due)
+        stats.input_forced++;
+
+    stats.presented++;
+    state.last_present_us = now;
+    state.presented = true;
+    state.dirty = false;
+    state.flush_armed = false;
+    return true;
+}
+
+/**
+ * Checks whether a frame request for a window would present, without making one
+ * Used to skip work that only feeds a frame, like Voicemeeter's timer handler
+ * @param window Window handle
+ * @return True if a timer or paint request would present now
+ */
+bool frame_scheduler::is_due(const uintptr_t window)
+{
+    const auto it = windows.find(window);
+
+    if (it == windows.end() || !it->second.presented)
+        return true;
+
+    return clock.now_us() - it->second.last_present_us >= due_after_us();
+}
+
+/**
+ * @param window Window handle
+ * @return True if the window has changes no present has shown yet
+ */
+bool frame_scheduler::is_dirty(const uintptr_t window) const
+{
+    const auto it = windows.find(window);
+    return it != windows.end() && it->second.dirty;
+}
+
+/**
+ * Gets when a deferred window has to present at the latest, once per deferral so the flush timer isn't pushed back
+ * by every message of a burst
+ * @param window Window handle
+ * @return Microseconds until the window is due or std::nullopt if it isn't dirty or the flush is already armed
+ */
+std::optional<uint64_t> frame_scheduler::arm_flush(const uintptr_t window)
+{
+    const auto it = windows.find(window);
+
+    if (it == windows.end() || !it->second.dirty || it->second.flush_armed)
+        return std::nullopt;
+
+    it->second.flush_armed = true;
+
+    const auto elapsed = clock.now_us() - it->second.last_present_us;
+    return elapsed < due_after_us() ? due_after_us() - elapsed : 0;
+}
+
+/**
+ * Lets arm_flush arm again once the flush timer fired, in case the window still isn't due then
+ * @param window Window handle
+ */
+void frame_scheduler::disarm_flush(const uintptr_t window)
+{
+    if (const auto it = windows.find(window); it != windows.end())
+        it->second.flush_armed = false;
+}
+
+/**
+ * Drops the state of a destroyed window
+ * @param window Window handle
+ */
+void frame_scheduler::forget(const uintptr_t window)
+{
+    windows.erase(window);
+}
+
+frame_scheduler_stats_t frame_scheduler::get_stats() const
+{
+    return stats;
+}
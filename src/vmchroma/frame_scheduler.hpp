@@ -0,0 +1,87 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+// clicks and wheel turns are input, moving the mouse with a button held is paced like timer ticks
+enum frame_reason { FRAME_TIMER, FRAME_PAINT, FRAME_DRAG, FRAME_INPUT };
+
+typedef struct frame_scheduler_stats
+{
+    uint64_t requests;
+    uint64_t presented;
+    uint64_t coalesced;
+    uint64_t input_forced; // presented for input sooner than the frame interval allows
+} frame_scheduler_stats_t;
+
+/**
+ * Time source of the frame scheduler
+ * A steady clock in the DLL, can be replaced by a manual clock for testing
+ */
+class frame_clock
+{
+public:
+    virtual ~frame_clock() = default;
+    virtual uint64_t now_us() = 0;
+};
+
+class steady_frame_clock : public frame_clock
+{
+public:
+    uint64_t now_us() override;
+};
+
+/**
+ * Decides when a window presents, so a burst of messages costs one vsync-waiting Present instead of one each
+ * A request that comes too early leaves the window dirty until a later request or the flush timer armed through arm_flush
+ * Timer ticks, paints and drags present at most once per frame interval, with a quarter interval of slack because
+ * Windows timers tick on a 15.6 ms grid
+ * Clicks and wheel turns present right away unless the window presented less than a quarter interval ago,
+ * so the first input of a burst is never delayed while the messages that follow it within the same frame are coalesced
+ */
+class frame_scheduler
+{
+    typedef struct window_state
+    {
+        uint64_t last_present_us;
+        bool presented;
+        bool dirty;
+        bool flush_armed;
+    } window_state_t;
+
+    frame_clock& clock;
+    uint64_t frame_interval_us;
+    std::unordered_map<uintptr_t, window_state_t> windows;
+    frame_scheduler_stats_t stats = {};
+
+    uint64_t due_after_us() const;
+
+public:
+    frame_scheduler(frame_clock& clock, uint64_t frame_interval_us);
+
+    bool request(uintptr_t window, frame_reason reason);
+    bool is_due(uintptr_t window);
+    bool is_dirty(uintptr_t window) const;
+    std::optional<uint64_t> arm_flush(uintptr_t window);
+    void disarm_flush(uintptr_t window);
+    void forget(uintptr_t window);
+    frame_scheduler_stats_t get_stats() const;
+};
@@ -0,0 +1,157 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "gdi_cache.hpp"
+
+/**
+ * @param backend Creates and destroys the actual objects
+ * @param capacity Number of objects after which unreferenced objects get destroyed
+ */
+gdi_cache::gdi_cache(gdi_backend& backend, const size_t capacity) : backend(backend), capacity(capacity)
+{
+}
+
+/**
+ * Destroys all cached objects, referenced or not
+ */
+gdi_cache::~gdi_cache()
+{
+    for (const auto& [key, e] : entries)
+        backend.destroy(e.handle);
+}
+
+/**
+ * Gets a shared object for the key and takes a reference on it
+ * @param key Kind, style, width and color of the object
+ * @return The object handle, nullptr if the backend failed to create it
+ */
+void* gdi_cache::acquire(const gdi_object_key_t& key)
+{
+    std::lock_guard lock(mtx);
+
+    if (const auto it = entries.find(key); it != entries.end())
+    {
+        add_ref(it->second);
+        stats.hits++;
+        return it->second.handle;
+    }
+
+    stats.misses++;
+
+    void* handle = backend.create(key);
+
+    if (handle == nullptr)
+        return nullptr;
+
+    // the backend handed out a handle we already own, e.g. the stock object for a null pen
+    // it stays tracked under the key it was created for, the caller shares that entry's references
+    if (const auto owner = handles.find(handle); owner != handles.end())
+    {
+        add_ref(entries[owner->second]);
+        return handle;
+    }
+
+    entries[key] = {handle, 1, idle.end()};
+    handles[handle] = key;
+    stats.live_handles++;
+    stats.referenced_handles++;
+
+    evict_idle();
+
+    return handle;
+}
+
+/**
+ * Drops a reference on a cached object, the object itself stays alive
+ * @param handle The object handle
+ * @return True if the handle belongs to the cache, false if the caller has to delete it
+ */
+bool gdi_cache::release(void* handle)
+{
+    std::lock_guard lock(mtx);
+
+    const auto it = handles.find(handle);
+
+    if (it == handles.end())
+        return false;
+
+    auto& e = entries[it->second];
+
+    // more deletes than creates, keep the object in the cache anyway
+    if (e.refs == 0)
+        return true;
+
+    if (--e.refs == 0)
+    {
+        e.idle_it = idle.insert(idle.end(), it->second);
+        stats.referenced_handles--;
+        evict_idle();
+    }
+
+    return true;
+}
+
+/**
+ * Checks if the handle is owned by the cache
+ * @param handle The object handle
+ * @return True if the handle belongs to the cache
+ */
+bool gdi_cache::contains(void* handle)
+{
+    std::lock_guard lock(mtx);
+    return handles.find(handle) != handles.end();
+}
+
+/**
+ * Takes a reference on an object, unreferenced objects stop being candidates for eviction
+ * @param e The cache entry
+ */
+void gdi_cache::add_ref(entry_t& e)
+{
+    if (e.refs++ == 0)
+    {
+        idle.erase(e.idle_it);
+        stats.referenced_handles++;
+    }
+}
+
+/**
+ * Destroys unreferenced objects until the cache is within capacity again
+ * Referenced objects may still be selected into a DC and are never destroyed
+ */
+void gdi_cache::evict_idle()
+{
+    while (entries.size() > capacity && !idle.empty())
+    {
+        const auto key = idle.front();
+        idle.pop_front();
+
+        const auto it = entries.find(key);
+        backend.destroy(it->second.handle);
+        handles.erase(it->second.handle);
+        entries.erase(it);
+
+        stats.live_handles--;
+        stats.evictions++;
+    }
+}
+
+gdi_cache_stats_t gdi_cache::get_stats()
+{
+    std::lock_guard lock(mtx);
+    return stats;
+}
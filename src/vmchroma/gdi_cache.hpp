@@ -0,0 +1,108 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+enum gdi_object_kind { GDI_OBJECT_PEN, GDI_OBJECT_BRUSH };
+
+typedef struct gdi_object_key
+{
+    gdi_object_kind kind;
+    uint32_t style; // pen style or brush style
+    uintptr_t param; // pen width or brush hatch
+    uint32_t color;
+
+    bool operator==(const gdi_object_key& other) const
+    {
+        return kind == other.kind && style == other.style && param == other.param && color == other.color;
+    }
+} gdi_object_key_t;
+
+typedef struct gdi_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint32_t live_handles;
+    uint32_t referenced_handles;
+} gdi_cache_stats_t;
+
+/**
+ * Creates and destroys the actual GDI objects for the cache
+ * Implemented with the original GDI functions in the DLL, can be replaced by a mock for testing
+ */
+class gdi_backend
+{
+public:
+    virtual ~gdi_backend() = default;
+    virtual void* create(const gdi_object_key_t& key) = 0;
+    virtual bool destroy(void* handle) = 0;
+};
+
+/**
+ * Hands out shared pens and brushes for identical (kind, style, width, color) requests
+ * Every acquire takes a reference and every release drops one, objects are only destroyed
+ * when the cache runs over capacity and the least recently released object has no references left
+ */
+class gdi_cache
+{
+    typedef struct key_hash
+    {
+        size_t operator()(const gdi_object_key_t& key) const
+        {
+            uint64_t h = (static_cast<uint64_t>(key.kind) << 32 | key.style) * 0x9E3779B97F4A7C15ull;
+            h ^= (static_cast<uint64_t>(key.param) + 0x632BE59BD9B4E019ull) * 0xBF58476D1CE4E5B9ull;
+            h ^= (static_cast<uint64_t>(key.color) + 0x94D049BB133111EBull) * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(h ^ (h >> 31));
+        }
+    } key_hash_t;
+
+    typedef struct entry
+    {
+        void* handle;
+        uint32_t refs;
+        std::list<gdi_object_key_t>::iterator idle_it;
+    } entry_t;
+
+    gdi_backend& backend;
+    size_t capacity;
+    std::mutex mtx;
+    std::unordered_map<gdi_object_key_t, entry_t, key_hash_t> entries;
+    std::unordered_map<void*, gdi_object_key_t> handles;
+    // unreferenced objects, least recently released first
+    std::list<gdi_object_key_t> idle;
+    gdi_cache_stats_t stats = {};
+
+    void add_ref(entry_t& e);
+    void evict_idle();
+
+public:
+    gdi_cache(gdi_backend& backend, size_t capacity);
+    ~gdi_cache();
+    gdi_cache(const gdi_cache&) = delete;
+    gdi_cache& operator=(const gdi_cache&) = delete;
+
+    void* acquire(const gdi_object_key_t& key);
+    bool release(void* handle);
+    bool contains(void* handle);
+    gdi_cache_stats_t get_stats();
+};
@@ -0,0 +1,455 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "inflate.hpp"
+
+#include <cstring>
+
+namespace inflate
+{
+namespace
+{
+constexpr uint32_t FAST_BITS = 10;
+constexpr uint32_t MAX_CODE_BITS = 15;
+
+const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/**
+ * LSB-first bit reader with a 64 bit buffer, reading past the end yields zero bits and sets overrun
+ */
+typedef struct bit_reader
+{
+    const uint8_t* src;
+    const uint8_t* end;
+    uint64_t buf = 0;
+    uint32_t count = 0;
+    bool overrun = false;
+
+    bit_reader(const uint8_t* src, const size_t size) : src(src), end(src + size)
+    {
+    }
+
+    void refill()
+    {
+        while (count <= 56)
+        {
+            if (src < end)
+                buf |= static_cast<uint64_t>(*src++) << count;
+            else if (count == 0)
+            {
+                overrun = true;
+                return;
+            }
+            else
+                return;
+
+            count += 8;
+        }
+    }
+
+    uint32_t peek(const uint32_t n)
+    {
+        if (count < n)
+            refill();
+
+        // missing bits read as zero, the caller notices through overrun
+        if (count < n)
+            overrun = true;
+
+        return static_cast<uint32_t>(buf & ((1ull << n) - 1));
+    }
+
+    void consume(const uint32_t n)
+    {
+        buf >>= n;
+        count = count >= n ? count - n : 0;
+    }
+
+    uint32_t bits(const uint32_t n)
+    {
+        if (n == 0)
+            return 0;
+
+        const uint32_t v = peek(n);
+        consume(n);
+        return v;
+    }
+
+    /**
+     * Drops the bits up to the next byte boundary and returns the read position in bytes
+     */
+    const uint8_t* align()
+    {
+        consume(count & 7);
+        // the whole bytes still in the buffer haven't been consumed yet
+        const uint8_t* p = src - count / 8;
+        buf = 0;
+        count = 0;
+        return p;
+    }
+} bit_reader_t;
+
+/**
+ * Canonical Huffman decoding table, short codes are resolved with one lookup,
+ * longer codes by walking the code ranges of each length
+ */
+typedef struct huffman
+{
+    // symbol << 4 | code length, 0 if the code is longer than FAST_BITS
+    uint16_t fast[1 << FAST_BITS];
+    uint16_t first_code[MAX_CODE_BITS + 2];
+    uint16_t first_symbol[MAX_CODE_BITS + 2];
+    uint32_t max_code[MAX_CODE_BITS + 2];
+    uint16_t symbols[288];
+
+    bool build(const uint8_t* lengths, const uint32_t n)
+    {
+        uint32_t counts[MAX_CODE_BITS + 1] = {};
+
+        for (uint32_t i = 0; i < n; i++)
+            counts[lengths[i]]++;
+
+        counts[0] = 0;
+        std::memset(fast, 0, sizeof(fast));
+
+        uint32_t code = 0;
+        uint32_t symbol_index = 0;
+        uint32_t next_code[MAX_CODE_BITS + 1] = {};
+
+        for (uint32_t len = 1; len <= MAX_CODE_BITS; len++)
+        {
+            next_code[len] = code;
+            first_code[len] = static_cast<uint16_t>(code);
+            first_symbol[len] = static_cast<uint16_t>(symbol_index);
+            code += counts[len];
+
+            // over-subscribed code
+            if (counts[len] && code - 1 >= (1u << len))
+                return false;
+
+            // exclusive end of the codes of this length, aligned to 16 bits for comparing
+            max_code[len] = code << (16 - len);
+            code <<= 1;
+            symbol_index += counts[len];
+        }
+
+        max_code[MAX_CODE_BITS + 1] = 0x10000;
+
+        for (uint32_t len = 1, idx = 0; len <= MAX_CODE_BITS; len++)
+        {
+            for (uint32_t i = 0; i < n; i++)
+            {
+                if (lengths[i] == len)
+                    symbols[idx++] = static_cast<uint16_t>(i);
+            }
+        }
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const uint32_t len = lengths[i];
+
+            if (len == 0 || len > FAST_BITS)
+                continue;
+
+            const uint32_t c = next_code[len]++;
+            const uint32_t rev = reverse(c, len);
+
+            for (uint32_t j = rev; j < (1u << FAST_BITS); j += 1u << len)
+                fast[j] = static_cast<uint16_t>(i << 4 | len);
+        }
+
+        return true;
+    }
+
+    static uint32_t reverse(uint32_t v, const uint32_t len)
+    {
+        uint32_t r = 0;
+
+        for (uint32_t i = 0; i < len; i++, v >>= 1)
+            r = r << 1 | (v & 1);
+
+        return r;
+    }
+
+    /**
+     * @return The decoded symbol or -1 for an invalid code
+     */
+    int32_t decode(bit_reader_t& br) const
+    {
+        const uint32_t peeked = br.peek(MAX_CODE_BITS);
+        const uint16_t entry = fast[peeked & ((1 << FAST_BITS) - 1)];
+
+        if (entry != 0)
+        {
+            br.consume(entry & 0xF);
+            return entry >> 4;
+        }
+
+        const uint32_t code16 = reverse(peeked, 16);
+
+        for (uint32_t len = FAST_BITS + 1; len <= MAX_CODE_BITS; len++)
+        {
+            if (code16 < max_code[len])
+            {
+                const uint32_t idx = first_symbol[len] + (code16 >> (16 - len)) - first_code[len];
+
+                if (idx >= 288)
+                    return -1;
+
+                br.consume(len);
+                return symbols[idx];
+            }
+        }
+
+        return -1;
+    }
+} huffman_t;
+
+bool build_fixed(huffman_t& litlen, huffman_t& dist)
+{
+    uint8_t lengths[288];
+
+    for (uint32_t i = 0; i < 288; i++)
+        lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+
+    uint8_t dist_lengths[30];
+    std::memset(dist_lengths, 5, sizeof(dist_lengths));
+
+    return litlen.build(lengths, 288) && dist.build(dist_lengths, 30);
+}
+
+bool build_dynamic(bit_reader_t& br, huffman_t& litlen, huffman_t& dist)
+{
+    const uint32_t hlit = br.bits(5) + 257;
+    const uint32_t hdist = br.bits(5) + 1;
+    const uint32_t hclen = br.bits(4) + 4;
+
+    if (hlit > 286 || hdist > 30)
+        return false;
+
+    uint8_t code_lengths[19] = {};
+
+    for (uint32_t i = 0; i < hclen; i++)
+        code_lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(br.bits(3));
+
+    huffman_t cl;
+
+    if (!cl.build(code_lengths, 19))
+        return false;
+
+    uint8_t lengths[286 + 30] = {};
+    uint32_t n = 0;
+
+    while (n < hlit + hdist)
+    {
+        const int32_t sym = cl.decode(br);
+
+        if (sym < 0 || br.overrun)
+            return false;
+
+        if (sym < 16)
+        {
+            lengths[n++] = static_cast<uint8_t>(sym);
+            continue;
+        }
+
+        uint32_t repeat;
+        uint8_t value = 0;
+
+        if (sym == 16)
+        {
+            if (n == 0)
+                return false;
+
+            value = lengths[n - 1];
+            repeat = 3 + br.bits(2);
+        }
+        else if (sym == 17)
+            repeat = 3 + br.bits(3);
+        else
+            repeat = 11 + br.bits(7);
+
+        if (n + repeat > hlit + hdist)
+            return false;
+
+        std::memset(lengths + n, value, repeat);
+        n += repeat;
+    }
+
+    // the end of block code must exist
+    if (lengths[256] == 0)
+        return false;
+
+    return litlen.build(lengths, hlit) && dist.build(lengths + hlit, hdist);
+}
+
+uint32_t adler32(const uint8_t* data, size_t size)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+
+    while (size > 0)
+    {
+        // largest block before b can overflow
+        const size_t block = size < 5552 ? size : 5552;
+
+        for (size_t i = 0; i < block; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+
+        a %= 65521;
+        b %= 65521;
+        data += block;
+        size -= block;
+    }
+
+    return b << 16 | a;
+}
+}
+
+/**
+ * Decompresses a zlib stream whose decompressed size is known in advance
+ * @param src The zlib stream
+ * @param src_size Size of the stream in bytes
+ * @param dst Output buffer
+ * @param dst_size Exact decompressed size, anything else is treated as an error
+ * @return True if the stream was valid and produced exactly dst_size bytes
+ */
+bool zlib_decompress(const uint8_t* src, const size_t src_size, uint8_t* dst, const size_t dst_size)
+{
+    if (src_size < 6)
+        return false;
+
+    const uint32_t cmf = src[0];
+    const uint32_t flg = src[1];
+
+    // deflate with a window of at most 32K, no preset dictionary
+    if ((cmf & 0xF) != 8 || (cmf >> 4) > 7 || (cmf << 8 | flg) % 31 != 0 || (flg & 0x20))
+        return false;
+
+    bit_reader_t br(src + 2, src_size - 2);
+    size_t out = 0;
+    bool last = false;
+    huffman_t litlen;
+    huffman_t dist;
+
+    while (!last)
+    {
+        last = br.bits(1) != 0;
+        const uint32_t type = br.bits(2);
+
+        if (type == 0)
+        {
+            const uint8_t* p = br.align();
+
+            if (br.end - p < 4)
+                return false;
+
+            const uint32_t len = p[0] | p[1] << 8;
+            const uint32_t nlen = p[2] | p[3] << 8;
+            p += 4;
+
+            if ((len ^ 0xFFFF) != nlen || static_cast<size_t>(br.end - p) < len || dst_size - out < len)
+                return false;
+
+            std::memcpy(dst + out, p, len);
+            out += len;
+            br.src = p + len;
+            continue;
+        }
+
+        if (type == 1)
+        {
+            if (!build_fixed(litlen, dist))
+                return false;
+        }
+        else if (type == 2)
+        {
+            if (!build_dynamic(br, litlen, dist))
+                return false;
+        }
+        else
+            return false;
+
+        for (;;)
+        {
+            const int32_t sym = litlen.decode(br);
+
+            if (sym < 0 || br.overrun)
+                return false;
+
+            if (sym < 256)
+            {
+                if (out == dst_size)
+                    return false;
+
+                dst[out++] = static_cast<uint8_t>(sym);
+                continue;
+            }
+
+            if (sym == 256)
+                break;
+
+            if (sym > 285)
+                return false;
+
+            const uint32_t len = LENGTH_BASE[sym - 257] + br.bits(LENGTH_EXTRA[sym - 257]);
+            const int32_t dsym = dist.decode(br);
+
+            if (dsym < 0 || dsym > 29)
+                return false;
+
+            const uint32_t distance = DIST_BASE[dsym] + br.bits(DIST_EXTRA[dsym]);
+
+            if (distance > out || dst_size - out < len || br.overrun)
+                return false;
+
+            uint8_t* d = dst + out;
+            const uint8_t* s = d - distance;
+
+            // overlapping copies repeat the last bytes, they need to go byte by byte
+            if (distance >= len)
+                std::memcpy(d, s, len);
+            else
+            {
+                for (uint32_t i = 0; i < len; i++)
+                    d[i] = s[i];
+            }
+
+            out += len;
+        }
+    }
+
+    if (out != dst_size)
+        return false;
+
+    const uint8_t* p = br.align();
+
+    if (br.end - p < 4)
+        return false;
+
+    const uint32_t expected = static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+
+    return adler32(dst, dst_size) == expected;
+}
+}
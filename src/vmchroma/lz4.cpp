@@ -0,0 +1,280 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lz4.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace lz4
+{
+namespace
+{
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+// the format requires the last 5 bytes to be literals and no match to start in the last 12 bytes
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MF_LIMIT = 12;
+constexpr uint32_t HASH_BITS = 14;
+
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash4(const uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * Writes the 255-byte continuation of a literal or match length
+ */
+uint8_t* write_length(uint8_t* op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+/**
+ * Reads the 255-byte continuation of a literal or match length
+ * @return False if the input ends inside the length
+ */
+bool read_length(const uint8_t*& ip, const uint8_t* end, size_t& len)
+{
+    uint8_t b;
+
+    do
+    {
+        if (ip >= end)
+            return false;
+
+        b = *ip++;
+        len += b;
+    }
+    while (b == 255);
+
+    return true;
+}
+
+uint8_t* write_sequence(uint8_t* op, const uint8_t* literals, const size_t literal_len, const size_t offset, const size_t match_len)
+{
+    uint8_t* token = op++;
+    const size_t ml = match_len - MIN_MATCH;
+
+    *token = static_cast<uint8_t>((literal_len >= 15 ? 15 : literal_len) << 4 | (ml >= 15 ? 15 : ml));
+
+    if (literal_len >= 15)
+        op = write_length(op, literal_len - 15);
+
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+
+    if (ml >= 15)
+        op = write_length(op, ml - 15);
+
+    return op;
+}
+}
+
+/**
+ * Gets the worst case compressed size
+ * @param src_size Uncompressed size
+ * @return Size the destination buffer of compress needs
+ */
+size_t compress_bound(const size_t src_size)
+{
+    return src_size + src_size / 255 + 16;
+}
+
+/**
+ * Compresses a buffer with a single-probe hash table, greedy matching
+ * @param src Uncompressed data
+ * @param src_size Uncompressed size
+ * @param dst Destination buffer
+ * @param dst_capacity Size of dst, at least compress_bound(src_size)
+ * @return Compressed size, 0 if dst is too small
+ */
+size_t compress(const uint8_t* src, const size_t src_size, uint8_t* dst, const size_t dst_capacity)
+{
+    if (dst_capacity < compress_bound(src_size))
+        return 0;
+
+    uint8_t* op = dst;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + src_size;
+
+    if (src_size > MF_LIMIT)
+    {
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        const uint8_t* const match_limit = end - LAST_LITERALS;
+        const uint8_t* const search_end = end - MF_LIMIT;
+        const uint8_t* ip = src + 1;
+
+        table[hash4(read32(src))] = 0;
+
+        while (ip < search_end)
+        {
+            const uint32_t h = hash4(read32(ip));
+            const uint8_t* ref = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+
+            if (ip - ref > static_cast<ptrdiff_t>(MAX_OFFSET) || ref >= ip || read32(ref) != read32(ip))
+            {
+                ip++;
+                continue;
+            }
+
+            // extend backwards over literals that also match
+            while (ip > anchor && ref > src && ip[-1] == ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+
+            const uint8_t* mp = ip + MIN_MATCH;
+            const uint8_t* mr = ref + MIN_MATCH;
+
+            while (mp < match_limit && *mp == *mr)
+            {
+                mp++;
+                mr++;
+            }
+
+            op = write_sequence(op, anchor, ip - anchor, ip - ref, mp - ip);
+
+            // index one position inside the match so long runs keep finding their period
+            if (mp - 2 > ip)
+                table[hash4(read32(mp - 2))] = static_cast<uint32_t>(mp - 2 - src);
+
+            ip = anchor = mp;
+        }
+    }
+
+    const size_t literal_len = end - anchor;
+
+    *op++ = static_cast<uint8_t>((literal_len >= 15 ? 15 : literal_len) << 4);
+
+    if (literal_len >= 15)
+        op = write_length(op, literal_len - 15);
+
+    if (literal_len > 0)
+        memcpy(op, anchor, literal_len);
+
+    op += literal_len;
+
+    return op - dst;
+}
+
+/**
+ * Decompresses a block, every read and write is bounds checked
+ * @param src Compressed data
+ * @param src_size Compressed size
+ * @param dst Destination buffer
+ * @param dst_size Exact uncompressed size
+ * @return False if the block is malformed or doesn't decompress to exactly dst_size bytes
+ */
+bool decompress(const uint8_t* src, const size_t src_size, uint8_t* dst, const size_t dst_size)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const ip_end = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* const op_end = dst + dst_size;
+
+    while (ip < ip_end)
+    {
+        const uint8_t token = *ip++;
+        size_t literal_len = token >> 4;
+
+        if (literal_len == 15 && !read_length(ip, ip_end, literal_len))
+            return false;
+
+        if (literal_len > static_cast<size_t>(ip_end - ip) || literal_len > static_cast<size_t>(op_end - op))
+            return false;
+
+        if (literal_len > 0)
+            memcpy(op, ip, literal_len);
+
+        ip += literal_len;
+        op += literal_len;
+
+        // the last sequence has no match
+        if (ip == ip_end)
+            break;
+
+        if (ip_end - ip < 2)
+            return false;
+
+        const size_t offset = ip[0] | ip[1] << 8;
+        ip += 2;
+
+        if (offset == 0 || offset > static_cast<size_t>(op - dst))
+            return false;
+
+        size_t match_len = token & 15;
+
+        if (match_len == 15 && !read_length(ip, ip_end, match_len))
+            return false;
+
+        match_len += MIN_MATCH;
+
+        if (match_len > static_cast<size_t>(op_end - op))
+            return false;
+
+        const uint8_t* ref = op - offset;
+        uint8_t* const match_end = op + match_len;
+
+        // short offsets repeat a pattern, copying from a multiple of the period keeps 8 byte copies valid
+        size_t step = offset;
+
+        if (step < 8)
+        {
+            const size_t head = match_len < 8 ? match_len : 8;
+
+            for (size_t i = 0; i < head; i++)
+                op[i] = ref[i];
+
+            op += head;
+            step = offset * ((8 + offset - 1) / offset);
+            ref = op - step;
+        }
+
+        while (match_end - op >= 8)
+        {
+            memcpy(op, ref, 8);
+            op += 8;
+            ref += 8;
+        }
+
+        while (op < match_end)
+            *op++ = *ref++;
+    }
+
+    return op == op_end;
+}
+}
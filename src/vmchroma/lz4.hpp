@@ -0,0 +1,32 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compressor and decompressor for the LZ4 block format
+ * Used to keep theme bitmaps compressed in memory, flat UI colors compress to a few percent of the raw size
+ */
+namespace lz4
+{
+size_t compress_bound(size_t src_size);
+size_t compress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_capacity);
+bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+}
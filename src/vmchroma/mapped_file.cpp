@@ -0,0 +1,195 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mapped_file.hpp"
+
+#include <utility>
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#include "utils.hpp"
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(section, other.section);
+#else
+        std::swap(fd, other.fd);
+#endif
+        std::swap(view, other.view);
+        std::swap(view_size, other.view_size);
+    }
+
+    return *this;
+}
+
+/**
+ * Maps the whole file, a previously mapped file is closed first
+ * @param path Path to the file
+ * @return True on success
+ */
+bool mapped_file::open(const std::filesystem::path& path)
+{
+    close();
+
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SPDLOG_ERROR("failed to open file {}: {}", *utils::wstr_to_str(path), GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER file_size = {};
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || static_cast<uint64_t>(file_size.QuadPart) > SIZE_MAX)
+    {
+        SPDLOG_ERROR("invalid file size of {}", *utils::wstr_to_str(path));
+        close();
+        return false;
+    }
+
+    // copy-on-write, pixels written through a DIB section never reach the file
+    section = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+
+    if (section == nullptr)
+    {
+        SPDLOG_ERROR("failed to map file {}: {}", *utils::wstr_to_str(path), GetLastError());
+        close();
+        return false;
+    }
+
+    view = static_cast<const uint8_t*>(MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0));
+
+    if (view == nullptr)
+    {
+        SPDLOG_ERROR("failed to map view of file {}: {}", *utils::wstr_to_str(path), GetLastError());
+        close();
+        return false;
+    }
+
+    view_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        SPDLOG_ERROR("failed to open file {}: {}", path.string(), errno);
+        return false;
+    }
+
+    struct stat st = {};
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || static_cast<uint64_t>(st.st_size) > SIZE_MAX)
+    {
+        SPDLOG_ERROR("invalid file size of {}", path.string());
+        close();
+        return false;
+    }
+
+    // private like the copy-on-write section on Windows
+    const auto map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+    {
+        SPDLOG_ERROR("failed to map file {}: {}", path.string(), errno);
+        close();
+        return false;
+    }
+
+    view = static_cast<const uint8_t*>(map);
+    view_size = static_cast<size_t>(st.st_size);
+#endif
+
+    return true;
+}
+
+void mapped_file::close()
+{
+#ifdef _WIN32
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+
+    if (section != nullptr)
+        CloseHandle(section);
+
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    file = INVALID_HANDLE_VALUE;
+    section = nullptr;
+#else
+    if (view != nullptr)
+        munmap(const_cast<uint8_t*>(view), view_size);
+
+    if (fd != -1)
+        ::close(fd);
+
+    fd = -1;
+#endif
+    view = nullptr;
+    view_size = 0;
+}
+
+bool mapped_file::is_open() const
+{
+    return view != nullptr;
+}
+
+const uint8_t* mapped_file::data() const
+{
+    return view;
+}
+
+size_t mapped_file::size() const
+{
+    return view_size;
+}
+
+/**
+ * @return The file-mapping section or nullptr where GDI can't use one
+ */
+void* mapped_file::get_section() const
+{
+#ifdef _WIN32
+    return section;
+#else
+    return nullptr;
+#endif
+}
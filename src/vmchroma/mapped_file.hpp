@@ -0,0 +1,61 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "mapped_view.hpp"
+
+/**
+ * Read-only view of a whole file through a copy-on-write file-mapping section
+ * The pages are shared with the file cache and only loaded when touched, the section handle
+ * can be passed to CreateDIBSection so a bitmap is backed by the file instead of a copy
+ * Elsewhere the file is mmap'ed privately and there is no section, so the tools and tests see the same bytes
+ */
+class mapped_file : public mapped_view
+{
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE section = nullptr;
+#else
+    int fd = -1;
+#endif
+    const uint8_t* view = nullptr;
+    size_t view_size = 0;
+
+public:
+    mapped_file() = default;
+    ~mapped_file() override;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool is_open() const;
+    const uint8_t* data() const override;
+    size_t size() const override;
+    void* get_section() const override;
+};
@@ -0,0 +1,34 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Read-only memory a compiled theme is used from, a mapped file or a region shared with other instances
+ */
+class mapped_view
+{
+public:
+    virtual ~mapped_view() = default;
+    virtual const uint8_t* data() const = 0;
+    virtual size_t size() const = 0;
+    // file-mapping section CreateDIBSection can map bitmaps from, nullptr if they have to be copied
+    virtual void* get_section() const = 0;
+};
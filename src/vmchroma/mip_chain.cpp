@@ -0,0 +1,300 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mip_chain.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace mip_chain
+{
+namespace
+{
+// window sizes are whole pixels, 822 / 1645 still counts as the 50% level
+constexpr float LEVEL_TOLERANCE = 0.01f;
+
+/**
+ * Two source taps of one output coordinate, weights are quarters and sum to 4
+ * 50%: every output pixel averages two source pixels
+ * 75%: every 4 source pixels become 3, weighted 3:1, 2:2 and 1:3 by how much of them the output pixel covers
+ */
+typedef struct tap_pair
+{
+    uint32_t first;
+    uint32_t second;
+    uint16_t first_weight;
+    uint16_t second_weight;
+} tap_pair_t;
+
+tap_pair_t get_taps(const uint32_t out, const uint32_t src_extent, const size_t level)
+{
+    tap_pair_t t = {};
+
+    if (level == 2)
+        t = {out * 2, out * 2 + 1, 2, 2};
+    else
+    {
+        const uint32_t base = out / 3 * 4;
+
+        switch (out % 3)
+        {
+        case 0: t = {base, base + 1, 3, 1}; break;
+        case 1: t = {base + 1, base + 2, 2, 2}; break;
+        default: t = {base + 2, base + 3, 1, 3}; break;
+        }
+    }
+
+    // the last output pixel of an odd sized source only has one real tap
+    t.first = std::min(t.first, src_extent - 1);
+    t.second = std::min(t.second, src_extent - 1);
+    return t;
+}
+
+bool is_valid(const image_view_t& img)
+{
+    return img.pixels != nullptr && img.width > 0 && img.height > 0 && (img.channels == 3 || img.channels == 4)
+        && img.stride >= static_cast<size_t>(img.width) * img.channels;
+}
+
+/**
+ * Weighted sum of the two source rows of an output row, 16 bit per channel
+ */
+void vertical_scalar(const uint8_t* r0, const uint8_t* r1, const tap_pair_t& t, uint16_t* row, const size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        row[i] = static_cast<uint16_t>(r0[i] * t.first_weight + r1[i] * t.second_weight);
+}
+
+void horizontal_scalar(const uint16_t* row, const image_view_t& src, const size_t level, uint8_t* dst, const uint32_t x0, const uint32_t x1, const uint32_t channels)
+{
+    for (uint32_t x = x0; x < x1; x++)
+    {
+        const auto t = get_taps(x, src.width, level);
+        const uint16_t* p0 = row + static_cast<size_t>(t.first) * channels;
+        const uint16_t* p1 = row + static_cast<size_t>(t.second) * channels;
+
+        for (uint32_t c = 0; c < channels; c++)
+            dst[static_cast<size_t>(x) * channels + c] = static_cast<uint8_t>((p0[c] * t.first_weight + p1[c] * t.second_weight + 8) >> 4);
+    }
+}
+
+/**
+ * Number of output pixels the SIMD paths handle, all of them have two taps inside the source
+ */
+uint32_t simd_width(const image_view_t& src, const size_t level)
+{
+    if (src.channels != 4)
+        return 0;
+
+    return level == 2 ? src.width / 2 : src.width / 4 * 3;
+}
+
+#if defined(VMCHROMA_SSE2)
+void vertical_sse2(const uint8_t* r0, const uint8_t* r1, const tap_pair_t& t, uint16_t* row, const size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16(static_cast<short>(t.first_weight));
+    const __m128i w1 = _mm_set1_epi16(static_cast<short>(t.second_weight));
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i));
+
+        const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+        const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i + 8), hi);
+    }
+
+    vertical_scalar(r0 + i, r1 + i, t, row + i, n - i);
+}
+
+/**
+ * BGRX only, one register holds two pixels of the vertical sums
+ */
+void horizontal_sse2(const uint16_t* row, const image_view_t& src, const size_t level, uint8_t* dst, const uint32_t x0, const uint32_t x1, const uint32_t channels)
+{
+    const __m128i round = _mm_set1_epi16(8);
+    const uint32_t end = std::min(x1, simd_width(src, level));
+    uint32_t x = x0;
+
+    if (level == 2)
+    {
+        // 2 output pixels from 4 source pixels
+        for (; x + 2 <= end; x += 2)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + static_cast<size_t>(x) * 8));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + static_cast<size_t>(x) * 8 + 8));
+            const __m128i sa = _mm_add_epi16(a, _mm_srli_si128(a, 8));
+            const __m128i sb = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+            __m128i sum = _mm_slli_epi16(_mm_unpacklo_epi64(sa, sb), 1);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 4);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + static_cast<size_t>(x) * 4), _mm_packus_epi16(sum, sum));
+        }
+    }
+    else
+    {
+        // 3 output pixels from 4 source pixels, groups start at multiples of 3
+        for (; x % 3 != 0 && x < end; x++)
+            horizontal_scalar(row, src, level, dst, x, x + 1, channels);
+
+        for (; x + 3 <= end; x += 3)
+        {
+            const size_t s = static_cast<size_t>(x) / 3 * 16;
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + s));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + s + 8));
+            const __m128i a_hi = _mm_srli_si128(a, 8);
+            const __m128i b_hi = _mm_srli_si128(b, 8);
+
+            const __m128i o0 = _mm_add_epi16(_mm_add_epi16(a, _mm_slli_epi16(a, 1)), a_hi);
+            const __m128i o1 = _mm_slli_epi16(_mm_add_epi16(a_hi, b), 1);
+            const __m128i o2 = _mm_add_epi16(_mm_add_epi16(b_hi, _mm_slli_epi16(b_hi, 1)), b);
+
+            const __m128i o01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(o0, o1), round), 4);
+            const __m128i o22 = _mm_srli_epi16(_mm_add_epi16(o2, round), 4);
+            const __m128i packed = _mm_packus_epi16(o01, o22);
+
+            uint8_t* out = dst + static_cast<size_t>(x) * 4;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+            const int32_t last = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+            std::memcpy(out + 8, &last, sizeof(last));
+        }
+    }
+
+    horizontal_scalar(row, src, level, dst, x, x1, channels);
+}
+#endif
+
+typedef void (*vertical_fn)(const uint8_t*, const uint8_t*, const tap_pair_t&, uint16_t*, size_t);
+typedef void (*horizontal_fn)(const uint16_t*, const image_view_t&, size_t, uint8_t*, uint32_t, uint32_t, uint32_t);
+
+bool run(const image_view_t& src, const image_view_t& dst, const size_t level, thread_pool* pool, const vertical_fn vertical, const horizontal_fn horizontal)
+{
+    if (level >= LEVEL_SCALES.size() || !is_valid(src) || !is_valid(dst) || src.channels != dst.channels)
+        return false;
+
+    if (dst.width != level_extent(src.width, level) || dst.height != level_extent(src.height, level))
+        return false;
+
+    const size_t row_bytes = static_cast<size_t>(src.width) * src.channels;
+
+    if (level == 0)
+    {
+        for (uint32_t y = 0; y < src.height; y++)
+            std::memcpy(dst.pixels + static_cast<size_t>(y) * dst.stride, src.pixels + static_cast<size_t>(y) * src.stride, row_bytes);
+
+        return true;
+    }
+
+    const auto rows = [&](const uint32_t y0, const uint32_t y1)
+    {
+        std::vector<uint16_t> row(row_bytes);
+
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            const auto t = get_taps(y, src.height, level);
+            vertical(src.pixels + static_cast<size_t>(t.first) * src.stride, src.pixels + static_cast<size_t>(t.second) * src.stride, t, row.data(), row_bytes);
+            horizontal(row.data(), src, level, dst.pixels + static_cast<size_t>(y) * dst.stride, 0, dst.width, src.channels);
+        }
+    };
+
+    if (pool == nullptr || pool->size() < 2 || dst.height < 64)
+    {
+        rows(0, dst.height);
+        return true;
+    }
+
+    const uint32_t chunks = static_cast<uint32_t>(std::min<size_t>(pool->size() * 4, dst.height));
+    std::vector<std::future<void>> done;
+
+    for (uint32_t i = 0; i < chunks; i++)
+    {
+        const uint32_t y0 = static_cast<uint32_t>(static_cast<uint64_t>(dst.height) * i / chunks);
+        const uint32_t y1 = static_cast<uint32_t>(static_cast<uint64_t>(dst.height) * (i + 1) / chunks);
+        done.push_back(pool->submit([&rows, y0, y1] { rows(y0, y1); }));
+    }
+
+    for (auto& f : done)
+        f.get();
+
+    return true;
+}
+}
+
+/**
+ * Picks the smallest level that is still at least as large as the window, so it is only ever
+ * shrunk by less than one level step or enlarged a little, both of which bilinear filtering handles
+ * @param scale Window size relative to the default size
+ * @return Index into LEVEL_SCALES
+ */
+size_t pick_level(const float scale)
+{
+    for (size_t i = LEVEL_SCALES.size(); i-- > 0;)
+    {
+        if (LEVEL_SCALES[i] >= scale - LEVEL_TOLERANCE)
+            return i;
+    }
+
+    return 0;
+}
+
+/**
+ * Gets the width or height of a level, rounded up so the last source pixels aren't dropped
+ * @param extent Width or height of the full size frame
+ * @param level Index into LEVEL_SCALES
+ * @return Width or height of the level
+ */
+uint32_t level_extent(const uint32_t extent, const size_t level)
+{
+    switch (level)
+    {
+    case 1: return static_cast<uint32_t>((static_cast<uint64_t>(extent) * 3 + 3) / 4);
+    case 2: return (extent + 1) / 2;
+    default: return extent;
+    }
+}
+
+/**
+ * Builds one level from the full size frame
+ * @param src Full size frame
+ * @param dst Level image, level_extent of the source in both dimensions and the same channel count
+ * @param level Index into LEVEL_SCALES
+ * @param pool Optional thread pool the rows are split across
+ * @return False if the images or the level are invalid
+ */
+bool build_level(const image_view_t& src, const image_view_t& dst, const size_t level, thread_pool* pool)
+{
+#if defined(VMCHROMA_SSE2)
+    return run(src, dst, level, pool, vertical_sse2, horizontal_sse2);
+#else
+    return run(src, dst, level, pool, vertical_scalar, horizontal_scalar);
+#endif
+}
+
+bool build_level_scalar(const image_view_t& src, const image_view_t& dst, const size_t level)
+{
+    return run(src, dst, level, nullptr, vertical_scalar, horizontal_scalar);
+}
+}
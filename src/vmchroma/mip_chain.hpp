@@ -0,0 +1,42 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "resampler.hpp"
+
+class thread_pool;
+
+/**
+ * Prefiltered levels for the range the main window can be shrunk to (50% to 100% of the default size)
+ * Each level is made from the full size frame by a fixed ratio area kernel, the window is then drawn
+ * from the nearest level at or above its scale with a cheap bilinear filter instead of a wide cubic one
+ */
+namespace mip_chain
+{
+// level 0 is the unscaled frame, the others are built with the kernels below
+constexpr std::array<float, 3> LEVEL_SCALES = {1.0f, 0.75f, 0.5f};
+
+size_t pick_level(float scale);
+uint32_t level_extent(uint32_t extent, size_t level);
+bool build_level(const image_view_t& src, const image_view_t& dst, size_t level, thread_pool* pool = nullptr);
+bool build_level_scalar(const image_view_t& src, const image_view_t& dst, size_t level);
+}
@@ -0,0 +1,229 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pixel_hash.hpp"
+
+#include <cstring>
+
+#include "simd.hpp"
+
+namespace pixel_hash
+{
+namespace
+{
+constexpr uint32_t PRIME1 = 2654435761u;
+constexpr uint32_t PRIME2 = 2246822519u;
+constexpr uint32_t PRIME3 = 3266489917u;
+constexpr uint32_t PRIME4 = 668265263u;
+constexpr uint32_t PRIME5 = 374761393u;
+constexpr size_t STRIPE = 16;
+
+uint32_t rotl(const uint32_t v, const int r)
+{
+    return v << r | v >> (32 - r);
+}
+
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t xxh_round(uint32_t acc, const uint32_t input)
+{
+    acc += input * PRIME2;
+    return rotl(acc, 13) * PRIME1;
+}
+
+typedef void (*stripes_fn)(uint32_t* acc, const uint8_t* p, size_t stripes);
+
+void stripes_scalar(uint32_t* acc, const uint8_t* p, const size_t stripes)
+{
+    uint32_t v1 = acc[0], v2 = acc[1], v3 = acc[2], v4 = acc[3];
+
+    for (size_t i = 0; i < stripes; i++, p += STRIPE)
+    {
+        v1 = xxh_round(v1, read32(p));
+        v2 = xxh_round(v2, read32(p + 4));
+        v3 = xxh_round(v3, read32(p + 8));
+        v4 = xxh_round(v4, read32(p + 12));
+    }
+
+    acc[0] = v1;
+    acc[1] = v2;
+    acc[2] = v3;
+    acc[3] = v4;
+}
+
+#if defined(VMCHROMA_SSE2)
+VMCHROMA_TARGET_SSE41 void stripes_sse41(uint32_t* acc, const uint8_t* p, const size_t stripes)
+{
+    const __m128i prime1 = _mm_set1_epi32(static_cast<int>(PRIME1));
+    const __m128i prime2 = _mm_set1_epi32(static_cast<int>(PRIME2));
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc));
+
+    for (size_t i = 0; i < stripes; i++, p += STRIPE)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        v = _mm_add_epi32(v, _mm_mullo_epi32(in, prime2));
+        v = _mm_or_si128(_mm_slli_epi32(v, 13), _mm_srli_epi32(v, 19));
+        v = _mm_mullo_epi32(v, prime1);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc), v);
+}
+#endif
+
+stripes_fn select_stripes()
+{
+#if defined(VMCHROMA_SSE2)
+    if (simd::has_sse41())
+        return stripes_sse41;
+#endif
+    return stripes_scalar;
+}
+
+/**
+ * Incremental XXH32, lets a bitmap be hashed row by row without its stride padding
+ */
+typedef struct xxh32_state
+{
+    stripes_fn stripes;
+    uint32_t acc[4];
+    uint8_t buf[STRIPE];
+    size_t buffered = 0;
+    uint64_t total = 0;
+    uint32_t seed;
+
+    xxh32_state(const uint32_t seed, const stripes_fn stripes) : stripes(stripes), seed(seed)
+    {
+        acc[0] = seed + PRIME1 + PRIME2;
+        acc[1] = seed + PRIME2;
+        acc[2] = seed;
+        acc[3] = seed - PRIME1;
+    }
+
+    void update(const uint8_t* p, size_t len)
+    {
+        total += len;
+
+        if (buffered > 0)
+        {
+            const size_t take = len < STRIPE - buffered ? len : STRIPE - buffered;
+            memcpy(buf + buffered, p, take);
+            buffered += take;
+            p += take;
+            len -= take;
+
+            if (buffered < STRIPE)
+                return;
+
+            stripes(acc, buf, 1);
+            buffered = 0;
+        }
+
+        const size_t count = len / STRIPE;
+
+        if (count > 0)
+            stripes(acc, p, count);
+
+        p += count * STRIPE;
+        len -= count * STRIPE;
+
+        if (len > 0)
+            memcpy(buf, p, len);
+
+        buffered = len;
+    }
+
+    uint32_t digest() const
+    {
+        uint32_t h = total >= STRIPE
+                         ? rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18)
+                         : seed + PRIME5;
+
+        h += static_cast<uint32_t>(total);
+
+        const uint8_t* p = buf;
+        const uint8_t* const end = buf + buffered;
+
+        for (; p + 4 <= end; p += 4)
+            h = rotl(h + read32(p) * PRIME3, 17) * PRIME4;
+
+        for (; p < end; p++)
+            h = rotl(h + *p * PRIME5, 11) * PRIME1;
+
+        h ^= h >> 15;
+        h *= PRIME2;
+        h ^= h >> 13;
+        h *= PRIME3;
+        h ^= h >> 16;
+        return h;
+    }
+} xxh32_state_t;
+}
+
+/**
+ * Hashes a buffer with XXH32, using SSE4.1 for the accumulators if available
+ * @param data Data to hash
+ * @param len Length in bytes
+ * @param seed Hash seed
+ * @return XXH32 hash
+ */
+uint32_t xxh32(const uint8_t* data, const size_t len, const uint32_t seed)
+{
+    static const stripes_fn stripes = select_stripes();
+
+    xxh32_state_t state(seed, stripes);
+    state.update(data, len);
+    return state.digest();
+}
+
+uint32_t xxh32_scalar(const uint8_t* data, const size_t len, const uint32_t seed)
+{
+    xxh32_state_t state(seed, stripes_scalar);
+    state.update(data, len);
+    return state.digest();
+}
+
+/**
+ * Hashes the pixel bytes of a DIB, the row padding is not part of the hash
+ * @param bits First row in memory
+ * @param width Width in pixels
+ * @param height Number of rows
+ * @param stride Distance between rows in bytes
+ * @param bpp Bits per pixel
+ * @return XXH32 hash of the concatenated rows
+ */
+uint32_t dib(const uint8_t* bits, const uint32_t width, const uint32_t height, const uint32_t stride, const uint32_t bpp)
+{
+    const size_t row_bytes = (static_cast<size_t>(width) * bpp + 7) / 8;
+
+    if (row_bytes == stride)
+        return xxh32(bits, row_bytes * height);
+
+    static const stripes_fn stripes = select_stripes();
+
+    xxh32_state_t state(0, stripes);
+
+    for (uint32_t y = 0; y < height; y++)
+        state.update(bits + static_cast<size_t>(y) * stride, row_bytes);
+
+    return state.digest();
+}
+}
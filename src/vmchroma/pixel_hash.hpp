@@ -0,0 +1,32 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * XXH32 hashing of bitmap pixels, used to fingerprint the bitmaps Voicemeeter draws
+ * The four XXH32 accumulators map onto one SSE4.1 register, the result is identical to the scalar version
+ */
+namespace pixel_hash
+{
+uint32_t xxh32(const uint8_t* data, size_t len, uint32_t seed = 0);
+uint32_t xxh32_scalar(const uint8_t* data, size_t len, uint32_t seed = 0);
+uint32_t dib(const uint8_t* bits, uint32_t width, uint32_t height, uint32_t stride, uint32_t bpp);
+}
@@ -0,0 +1,339 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "png_decoder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+#include "inflate.hpp"
+
+namespace png_decoder
+{
+namespace
+{
+constexpr uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+enum color_type { COLOR_GRAY = 0, COLOR_RGB = 2, COLOR_PALETTE = 3, COLOR_GRAY_ALPHA = 4, COLOR_RGBA = 6 };
+
+uint32_t read_be32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+uint32_t channels_of(const uint8_t type)
+{
+    switch (type)
+    {
+    case COLOR_GRAY:
+    case COLOR_PALETTE:
+        return 1;
+    case COLOR_GRAY_ALPHA:
+        return 2;
+    case COLOR_RGB:
+        return 3;
+    case COLOR_RGBA:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool is_valid_depth(const uint8_t type, const uint8_t depth)
+{
+    switch (type)
+    {
+    case COLOR_GRAY:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+    case COLOR_PALETTE:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case COLOR_RGB:
+    case COLOR_GRAY_ALPHA:
+    case COLOR_RGBA:
+        return depth == 8 || depth == 16;
+    default:
+        return false;
+    }
+}
+
+uint8_t paeth(const uint8_t a, const uint8_t b, const uint8_t c)
+{
+    const int32_t p = a + b - c;
+    const int32_t pa = std::abs(p - a);
+    const int32_t pb = std::abs(p - b);
+    const int32_t pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc)
+        return a;
+
+    return pb <= pc ? b : c;
+}
+
+/**
+ * Reverses the filter of one scanline in place
+ * @param row The filtered row without the filter type byte
+ * @param prev The previous unfiltered row, all zero for the first row
+ * @param len Row size in bytes
+ * @param bpp Bytes per complete pixel, at least 1
+ * @return False for an unknown filter type
+ */
+bool unfilter(const uint8_t filter, uint8_t* row, const uint8_t* prev, const size_t len, const uint32_t bpp)
+{
+    switch (filter)
+    {
+    case 0:
+        return true;
+    case 1:
+        for (size_t i = bpp; i < len; i++)
+            row[i] = static_cast<uint8_t>(row[i] + row[i - bpp]);
+        return true;
+    case 2:
+        for (size_t i = 0; i < len; i++)
+            row[i] = static_cast<uint8_t>(row[i] + prev[i]);
+        return true;
+    case 3:
+        for (size_t i = 0; i < len; i++)
+            row[i] = static_cast<uint8_t>(row[i] + ((i >= bpp ? row[i - bpp] : 0) + prev[i]) / 2);
+        return true;
+    case 4:
+        for (size_t i = 0; i < len; i++)
+            row[i] = static_cast<uint8_t>(row[i] + paeth(i >= bpp ? row[i - bpp] : 0, prev[i], i >= bpp ? prev[i - bpp] : 0));
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Writes one unfiltered scanline as BGR pixels
+ */
+void write_row(const uint8_t* src, uint8_t* dst, const uint32_t width, const uint8_t type, const uint8_t depth, const uint8_t (*palette)[3])
+{
+    if (depth < 8)
+    {
+        const uint32_t per_byte = 8 / depth;
+        const uint32_t mask = (1u << depth) - 1;
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint32_t shift = 8 - depth * (x % per_byte + 1);
+            const uint32_t v = src[x / per_byte] >> shift & mask;
+
+            if (type == COLOR_PALETTE)
+            {
+                dst[x * 3 + 0] = palette[v][2];
+                dst[x * 3 + 1] = palette[v][1];
+                dst[x * 3 + 2] = palette[v][0];
+            }
+            else
+            {
+                const auto gray = static_cast<uint8_t>(v * 255 / mask);
+                dst[x * 3 + 0] = dst[x * 3 + 1] = dst[x * 3 + 2] = gray;
+            }
+        }
+
+        return;
+    }
+
+    // 16 bit samples are big endian, the high byte comes first
+    const uint32_t sample = depth / 8;
+    const uint32_t stride = channels_of(type) * sample;
+
+    switch (type)
+    {
+    case COLOR_PALETTE:
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint8_t* c = palette[src[x]];
+            dst[x * 3 + 0] = c[2];
+            dst[x * 3 + 1] = c[1];
+            dst[x * 3 + 2] = c[0];
+        }
+        break;
+    case COLOR_GRAY:
+    case COLOR_GRAY_ALPHA:
+        for (uint32_t x = 0; x < width; x++)
+            dst[x * 3 + 0] = dst[x * 3 + 1] = dst[x * 3 + 2] = src[x * stride];
+        break;
+    default:
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint8_t* p = src + x * stride;
+            dst[x * 3 + 0] = p[2 * sample];
+            dst[x * 3 + 1] = p[sample];
+            dst[x * 3 + 2] = p[0];
+        }
+        break;
+    }
+}
+}
+
+/**
+ * Decodes a PNG file
+ * @param data The whole file
+ * @param size File size in bytes
+ * @return A 24 bpp bitmap file or std::nullopt if the file is invalid or unsupported
+ */
+std::optional<std::vector<uint8_t>> decode_to_bmp(const uint8_t* data, const size_t size)
+{
+    if (data == nullptr || size < sizeof(SIGNATURE) || std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) != 0)
+    {
+        SPDLOG_ERROR("not a png file");
+        return std::nullopt;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t depth = 0;
+    uint8_t type = 0;
+    uint8_t palette[256][3] = {};
+    uint32_t palette_size = 0;
+    std::vector<uint8_t> idat;
+    bool has_header = false;
+    bool has_end = false;
+    size_t pos = sizeof(SIGNATURE);
+
+    while (!has_end)
+    {
+        if (size - pos < 12)
+        {
+            SPDLOG_ERROR("png file is truncated");
+            return std::nullopt;
+        }
+
+        const uint32_t len = read_be32(data + pos);
+        const uint8_t* chunk_type = data + pos + 4;
+        const uint8_t* chunk = data + pos + 8;
+
+        if (len > size - pos - 12)
+        {
+            SPDLOG_ERROR("png chunk is out of bounds");
+            return std::nullopt;
+        }
+
+        if (std::memcmp(chunk_type, "IHDR", 4) == 0)
+        {
+            if (len != 13 || has_header)
+            {
+                SPDLOG_ERROR("invalid png header");
+                return std::nullopt;
+            }
+
+            width = read_be32(chunk);
+            height = read_be32(chunk + 4);
+            depth = chunk[8];
+            type = chunk[9];
+            has_header = true;
+
+            if (width == 0 || height == 0 || width > bmp_decoder::MAX_DIMENSION || height > bmp_decoder::MAX_DIMENSION)
+            {
+                SPDLOG_ERROR("invalid png dimensions {}x{}", width, height);
+                return std::nullopt;
+            }
+
+            if (!is_valid_depth(type, depth) || chunk[10] != 0 || chunk[11] != 0)
+            {
+                SPDLOG_ERROR("unsupported png format: color type {}, bit depth {}", type, depth);
+                return std::nullopt;
+            }
+
+            if (chunk[12] != 0)
+            {
+                SPDLOG_ERROR("interlaced png files are not supported");
+                return std::nullopt;
+            }
+        }
+        else if (!has_header)
+        {
+            SPDLOG_ERROR("png file doesn't start with a header");
+            return std::nullopt;
+        }
+        else if (std::memcmp(chunk_type, "PLTE", 4) == 0)
+        {
+            if (len % 3 != 0 || len / 3 > 256 || len == 0)
+            {
+                SPDLOG_ERROR("invalid png palette");
+                return std::nullopt;
+            }
+
+            palette_size = len / 3;
+            std::memcpy(palette, chunk, len);
+        }
+        else if (std::memcmp(chunk_type, "IDAT", 4) == 0)
+            idat.insert(idat.end(), chunk, chunk + len);
+        else if (std::memcmp(chunk_type, "IEND", 4) == 0)
+            has_end = true;
+        else if (!(chunk_type[0] & 0x20))
+        {
+            // unknown chunks are only allowed to be skipped if they're marked as ancillary
+            SPDLOG_ERROR("unsupported critical png chunk {}", std::string(reinterpret_cast<const char*>(chunk_type), 4));
+            return std::nullopt;
+        }
+
+        pos += 12 + static_cast<size_t>(len);
+    }
+
+    if (type == COLOR_PALETTE && palette_size == 0)
+    {
+        SPDLOG_ERROR("png file is missing its palette");
+        return std::nullopt;
+    }
+
+    const uint32_t bits_pp = channels_of(type) * depth;
+    const size_t row_bytes = (static_cast<size_t>(width) * bits_pp + 7) / 8;
+    const uint32_t filter_bpp = bits_pp >= 8 ? bits_pp / 8 : 1;
+    std::vector<uint8_t> raw((row_bytes + 1) * height);
+
+    if (!inflate::zlib_decompress(idat.data(), idat.size(), raw.data(), raw.size()))
+    {
+        SPDLOG_ERROR("corrupt png image data");
+        return std::nullopt;
+    }
+
+    // palette indices beyond the palette are invalid, the spec leaves them undefined
+    if (type == COLOR_PALETTE)
+    {
+        for (uint32_t i = palette_size; i < 256; i++)
+            palette[i][0] = palette[i][1] = palette[i][2] = 0;
+    }
+
+    auto bmp = bmp_decoder::create_bmp(width, height, 24);
+    const auto info = bmp_decoder::parse(bmp.data(), bmp.size());
+    const std::vector<uint8_t> zero_row(row_bytes);
+    const uint8_t* prev = zero_row.data();
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t* line = raw.data() + y * (row_bytes + 1);
+
+        if (!unfilter(line[0], line + 1, prev, row_bytes, filter_bpp))
+        {
+            SPDLOG_ERROR("invalid png filter type {}", line[0]);
+            return std::nullopt;
+        }
+
+        // bitmap rows are stored bottom-up
+        uint8_t* dst = bmp.data() + info->pixel_offset + static_cast<size_t>(height - 1 - y) * info->stride;
+        write_row(line + 1, dst, width, type, depth, palette);
+        prev = line + 1;
+    }
+
+    return bmp;
+}
+}
@@ -0,0 +1,33 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * Decoder for non-interlaced PNG files with 1 to 16 bit gray, RGB, palette and alpha formats
+ * Rows are written straight into a bottom-up 24 bpp BMP in memory, the layout of the shipped theme bitmaps,
+ * alpha is dropped since the backgrounds are opaque
+ */
+namespace png_decoder
+{
+std::optional<std::vector<uint8_t>> decode_to_bmp(const uint8_t* data, size_t size);
+}
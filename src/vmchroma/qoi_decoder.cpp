@@ -0,0 +1,164 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "qoi_decoder.hpp"
+
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+
+namespace qoi_decoder
+{
+namespace
+{
+constexpr size_t HEADER_SIZE = 14;
+constexpr size_t END_MARKER_SIZE = 8;
+
+constexpr uint8_t OP_INDEX = 0x00;
+constexpr uint8_t OP_DIFF = 0x40;
+constexpr uint8_t OP_LUMA = 0x80;
+constexpr uint8_t OP_RUN = 0xC0;
+constexpr uint8_t OP_RGB = 0xFE;
+constexpr uint8_t OP_RGBA = 0xFF;
+constexpr uint8_t OP_MASK = 0xC0;
+
+uint32_t read_be32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+typedef struct rgba
+{
+    uint8_t r, g, b, a;
+} rgba_t;
+
+uint32_t hash(const rgba_t& c)
+{
+    return (c.r * 3 + c.g * 5 + c.b * 7 + c.a * 11) % 64;
+}
+}
+
+/**
+ * Decodes a QOI file
+ * @param data The whole file
+ * @param size File size in bytes
+ * @return A 24 bpp bitmap file or std::nullopt if the file is invalid
+ */
+std::optional<std::vector<uint8_t>> decode_to_bmp(const uint8_t* data, const size_t size)
+{
+    if (data == nullptr || size < HEADER_SIZE + END_MARKER_SIZE || std::memcmp(data, "qoif", 4) != 0)
+    {
+        SPDLOG_ERROR("not a qoi file");
+        return std::nullopt;
+    }
+
+    const uint32_t width = read_be32(data + 4);
+    const uint32_t height = read_be32(data + 8);
+    const uint8_t channels = data[12];
+
+    if (width == 0 || height == 0 || width > bmp_decoder::MAX_DIMENSION || height > bmp_decoder::MAX_DIMENSION || (channels != 3 && channels != 4))
+    {
+        SPDLOG_ERROR("invalid qoi header: {}x{}, {} channels", width, height, channels);
+        return std::nullopt;
+    }
+
+    auto bmp = bmp_decoder::create_bmp(width, height, 24);
+    const auto info = bmp_decoder::parse(bmp.data(), bmp.size());
+
+    rgba_t index[64] = {};
+    rgba_t px = {0, 0, 0, 255};
+    uint32_t run = 0;
+    const uint8_t* p = data + HEADER_SIZE;
+    // ops never read into the end marker
+    const uint8_t* end = data + size - END_MARKER_SIZE;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        // bitmap rows are stored bottom-up
+        uint8_t* dst = bmp.data() + info->pixel_offset + static_cast<size_t>(height - 1 - y) * info->stride;
+
+        for (uint32_t x = 0; x < width; x++, dst += 3)
+        {
+            if (run > 0)
+                run--;
+            else
+            {
+                if (p >= end)
+                {
+                    SPDLOG_ERROR("qoi file is truncated");
+                    return std::nullopt;
+                }
+
+                const uint8_t op = *p++;
+
+                if (op == OP_RGB || op == OP_RGBA)
+                {
+                    const size_t n = op == OP_RGB ? 3 : 4;
+
+                    if (static_cast<size_t>(end - p) < n)
+                    {
+                        SPDLOG_ERROR("qoi file is truncated");
+                        return std::nullopt;
+                    }
+
+                    px.r = p[0];
+                    px.g = p[1];
+                    px.b = p[2];
+
+                    if (op == OP_RGBA)
+                        px.a = p[3];
+
+                    p += n;
+                }
+                else if ((op & OP_MASK) == OP_INDEX)
+                    px = index[op];
+                else if ((op & OP_MASK) == OP_DIFF)
+                {
+                    px.r = static_cast<uint8_t>(px.r + ((op >> 4 & 3) - 2));
+                    px.g = static_cast<uint8_t>(px.g + ((op >> 2 & 3) - 2));
+                    px.b = static_cast<uint8_t>(px.b + ((op & 3) - 2));
+                }
+                else if ((op & OP_MASK) == OP_LUMA)
+                {
+                    if (p >= end)
+                    {
+                        SPDLOG_ERROR("qoi file is truncated");
+                        return std::nullopt;
+                    }
+
+                    const uint8_t b2 = *p++;
+                    const int32_t dg = (op & 0x3F) - 32;
+                    px.r = static_cast<uint8_t>(px.r + dg - 8 + (b2 >> 4 & 0xF));
+                    px.g = static_cast<uint8_t>(px.g + dg);
+                    px.b = static_cast<uint8_t>(px.b + dg - 8 + (b2 & 0xF));
+                }
+                else
+                    run = op & 0x3F;
+
+                index[hash(px)] = px;
+            }
+
+            dst[0] = px.b;
+            dst[1] = px.g;
+            dst[2] = px.r;
+        }
+    }
+
+    return bmp;
+}
+}
@@ -0,0 +1,403 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace resampler
+{
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+
+/**
+ * Filter taps of one output coordinate, weights sum to 1
+ */
+typedef struct contributions
+{
+    uint32_t first;
+    uint32_t count;
+    uint32_t weight_offset;
+} contributions_t;
+
+typedef struct filter_bank
+{
+    std::vector<contributions_t> taps;
+    std::vector<float> weights;
+} filter_bank_t;
+
+double sinc(const double x)
+{
+    if (x == 0.0)
+        return 1.0;
+
+    return std::sin(PI * x) / (PI * x);
+}
+
+double lanczos3(const double x)
+{
+    return std::abs(x) < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+// Mitchell-Netravali with B = C = 1/3
+double mitchell(double x)
+{
+    constexpr double B = 1.0 / 3.0;
+    constexpr double C = 1.0 / 3.0;
+    x = std::abs(x);
+
+    if (x < 1.0)
+        return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0;
+
+    if (x < 2.0)
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0;
+
+    return 0.0;
+}
+
+/**
+ * Computes the taps of every output coordinate, the filter is widened by the scale when shrinking
+ * Taps outside the source are dropped and the rest renormalized, which keeps edges from darkening
+ */
+filter_bank_t build_filter(const uint32_t src_size, const uint32_t dst_size, const resample_filter filter)
+{
+    const double support = filter == RESAMPLE_LANCZOS3 ? 3.0 : 2.0;
+    const auto kernel = filter == RESAMPLE_LANCZOS3 ? lanczos3 : mitchell;
+    const double scale = static_cast<double>(src_size) / dst_size;
+    const double filter_scale = std::max(scale, 1.0);
+    const double radius = support * filter_scale;
+
+    filter_bank_t bank;
+    bank.taps.resize(dst_size);
+
+    for (uint32_t i = 0; i < dst_size; i++)
+    {
+        const double center = (i + 0.5) * scale;
+        const auto first = static_cast<int64_t>(std::max(0.0, std::floor(center - radius)));
+        const auto last = static_cast<int64_t>(std::min(static_cast<double>(src_size), std::ceil(center + radius)));
+        const size_t offset = bank.weights.size();
+        double sum = 0.0;
+
+        for (int64_t j = first; j < last; j++)
+        {
+            const double w = kernel((j + 0.5 - center) / filter_scale);
+            bank.weights.push_back(static_cast<float>(w));
+            sum += w;
+        }
+
+        // trim zero taps at both ends so the inner loops don't run over them
+        size_t begin = offset;
+        size_t end = bank.weights.size();
+
+        while (end > begin + 1 && bank.weights[end - 1] == 0.0f)
+            end--;
+
+        while (begin + 1 < end && bank.weights[begin] == 0.0f)
+            begin++;
+
+        for (size_t k = begin; k < end; k++)
+            bank.weights[offset + k - begin] = static_cast<float>(bank.weights[k] / sum);
+
+        bank.weights.resize(offset + end - begin);
+        bank.taps[i] = {static_cast<uint32_t>(first + (begin - offset)), static_cast<uint32_t>(end - begin), static_cast<uint32_t>(offset)};
+    }
+
+    return bank;
+}
+
+uint8_t to_u8(const float v)
+{
+    const float r = std::nearbyint(v);
+    return static_cast<uint8_t>(r < 0.0f ? 0.0f : r > 255.0f ? 255.0f : r);
+}
+
+void vertical_scalar(const image_view_t& src, const contributions_t& c, const float* w, float* row, const size_t n)
+{
+    std::fill(row, row + n, 0.0f);
+
+    for (uint32_t k = 0; k < c.count; k++)
+    {
+        const uint8_t* s = src.pixels + static_cast<size_t>(c.first + k) * src.stride;
+
+        for (size_t x = 0; x < n; x++)
+            row[x] += w[k] * s[x];
+    }
+}
+
+void horizontal_scalar(const float* row, const filter_bank_t& bank, const uint32_t channels, uint8_t* dst, const uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++)
+    {
+        const auto& c = bank.taps[x];
+        const float* w = bank.weights.data() + c.weight_offset;
+
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            float acc = 0.0f;
+
+            for (uint32_t k = 0; k < c.count; k++)
+                acc += w[k] * row[(c.first + k) * channels + ch];
+
+            dst[x * channels + ch] = to_u8(acc);
+        }
+    }
+}
+
+#if defined(VMCHROMA_SSE2)
+void vertical_sse2(const image_view_t& src, const contributions_t& c, const float* w, float* row, const size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t x = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+
+        for (uint32_t k = 0; k < c.count; k++)
+        {
+            const __m128 wk = _mm_set1_ps(w[k]);
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.pixels + static_cast<size_t>(c.first + k) * src.stride + x));
+            const __m128i lo = _mm_unpacklo_epi8(b, zero);
+            const __m128i hi = _mm_unpackhi_epi8(b, zero);
+
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(wk, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero))));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(wk, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero))));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(wk, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero))));
+            acc3 = _mm_add_ps(acc3, _mm_mul_ps(wk, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))));
+        }
+
+        _mm_storeu_ps(row + x, acc0);
+        _mm_storeu_ps(row + x + 4, acc1);
+        _mm_storeu_ps(row + x + 8, acc2);
+        _mm_storeu_ps(row + x + 12, acc3);
+    }
+
+    for (; x < n; x++)
+    {
+        float acc = 0.0f;
+
+        for (uint32_t k = 0; k < c.count; k++)
+            acc += w[k] * src.pixels[static_cast<size_t>(c.first + k) * src.stride + x];
+
+        row[x] = acc;
+    }
+}
+
+VMCHROMA_TARGET_AVX2 void vertical_avx2(const image_view_t& src, const contributions_t& c, const float* w, float* row, const size_t n)
+{
+    size_t x = 0;
+
+    for (; x + 32 <= n; x += 32)
+    {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+        for (uint32_t k = 0; k < c.count; k++)
+        {
+            const __m256 wk = _mm256_set1_ps(w[k]);
+            const uint8_t* s = src.pixels + static_cast<size_t>(c.first + k) * src.stride + x;
+
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(wk, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s))))));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(wk, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 8))))));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(wk, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 16))))));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(wk, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 24))))));
+        }
+
+        _mm256_storeu_ps(row + x, acc0);
+        _mm256_storeu_ps(row + x + 8, acc1);
+        _mm256_storeu_ps(row + x + 16, acc2);
+        _mm256_storeu_ps(row + x + 24, acc3);
+    }
+
+    for (; x < n; x++)
+    {
+        float acc = 0.0f;
+
+        for (uint32_t k = 0; k < c.count; k++)
+            acc += w[k] * src.pixels[static_cast<size_t>(c.first + k) * src.stride + x];
+
+        row[x] = acc;
+    }
+}
+
+/**
+ * One pixel per SSE register, the fourth lane of a 3 channel pixel reads the next pixel and is ignored,
+ * the float row has one pixel of padding for the last read
+ */
+void horizontal_sse2(const float* row, const filter_bank_t& bank, const uint32_t channels, uint8_t* dst, const uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++)
+    {
+        const auto& c = bank.taps[x];
+        const float* w = bank.weights.data() + c.weight_offset;
+        const float* p = row + static_cast<size_t>(c.first) * channels;
+        __m128 acc = _mm_setzero_ps();
+
+        for (uint32_t k = 0; k < c.count; k++, p += channels)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p)));
+
+        __m128i v = _mm_cvtps_epi32(acc);
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+
+        const uint32_t px = static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+        uint8_t* d = dst + static_cast<size_t>(x) * channels;
+
+        d[0] = static_cast<uint8_t>(px);
+        d[1] = static_cast<uint8_t>(px >> 8);
+        d[2] = static_cast<uint8_t>(px >> 16);
+
+        if (channels == 4)
+            d[3] = static_cast<uint8_t>(px >> 24);
+    }
+}
+#endif
+
+typedef void (*vertical_fn)(const image_view_t&, const contributions_t&, const float*, float*, size_t);
+typedef void (*horizontal_fn)(const float*, const filter_bank_t&, uint32_t, uint8_t*, uint32_t);
+
+bool is_valid(const image_view_t& img)
+{
+    return img.pixels != nullptr && img.width > 0 && img.height > 0 && (img.channels == 3 || img.channels == 4)
+        && img.stride >= static_cast<size_t>(img.width) * img.channels;
+}
+
+bool run(const image_view_t& src, const image_view_t& dst, const resample_filter filter, thread_pool* pool, const vertical_fn vertical, const horizontal_fn horizontal)
+{
+    if (!is_valid(src) || !is_valid(dst) || src.channels != dst.channels)
+        return false;
+
+    const auto h_bank = build_filter(src.width, dst.width, filter);
+    const auto v_bank = build_filter(src.height, dst.height, filter);
+    const size_t row_floats = static_cast<size_t>(src.width) * src.channels;
+
+    const auto rows = [&](const uint32_t y0, const uint32_t y1)
+    {
+        // one spare pixel for the 4 float loads of the horizontal pass
+        std::vector<float> row(row_floats + 4, 0.0f);
+
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            const auto& c = v_bank.taps[y];
+            vertical(src, c, v_bank.weights.data() + c.weight_offset, row.data(), row_floats);
+            horizontal(row.data(), h_bank, src.channels, dst.pixels + static_cast<size_t>(y) * dst.stride, dst.width);
+        }
+    };
+
+    if (pool == nullptr || pool->size() < 2 || dst.height < 64)
+    {
+        rows(0, dst.height);
+        return true;
+    }
+
+    // a few chunks per worker keep the threads busy when rows differ in cost
+    const uint32_t chunks = static_cast<uint32_t>(std::min<size_t>(pool->size() * 4, dst.height));
+    std::vector<std::future<void>> done;
+
+    for (uint32_t i = 0; i < chunks; i++)
+    {
+        const uint32_t y0 = static_cast<uint32_t>(static_cast<uint64_t>(dst.height) * i / chunks);
+        const uint32_t y1 = static_cast<uint32_t>(static_cast<uint64_t>(dst.height) * (i + 1) / chunks);
+        done.push_back(pool->submit([&rows, y0, y1] { rows(y0, y1); }));
+    }
+
+    for (auto& f : done)
+        f.get();
+
+    return true;
+}
+}
+
+/**
+ * Resamples an image to the size of the destination
+ * @param src Source image
+ * @param dst Destination image, same channel count as the source
+ * @param filter Lanczos3 for sharp downscaling, Mitchell for upscaling without ringing
+ * @param pool Optional thread pool the rows are split across
+ * @return False if the images are invalid
+ */
+bool resize(const image_view_t& src, const image_view_t& dst, const resample_filter filter, thread_pool* pool)
+{
+#if defined(VMCHROMA_SSE2)
+    const vertical_fn vertical = simd::has_avx2() ? vertical_avx2 : vertical_sse2;
+    return run(src, dst, filter, pool, vertical, horizontal_sse2);
+#else
+    return run(src, dst, filter, pool, vertical_scalar, horizontal_scalar);
+#endif
+}
+
+bool resize_scalar(const image_view_t& src, const image_view_t& dst, const resample_filter filter)
+{
+    return run(src, dst, filter, nullptr, vertical_scalar, horizontal_scalar);
+}
+
+/**
+ * Brings a BMP file into the plain bottom-up 24 bpp layout of Voicemeeter's bitmaps, resampled to their size if it differs
+ * Lanczos3 when shrinking, Mitchell when enlarging
+ * @param data BMP file bytes
+ * @param size Size of the file
+ * @param width Target width, 0 to keep the width of the image
+ * @param height Target height, 0 to keep the aspect ratio of the image
+ * @param pool Optional thread pool the rows are split across
+ * @return The converted BMP file or std::nullopt if the input is invalid
+ */
+std::optional<std::vector<uint8_t>> fit_bmp(const uint8_t* data, const size_t size, const uint32_t width, const uint32_t height, thread_pool* pool)
+{
+    const auto info = bmp_decoder::parse(data, size);
+
+    if (!info)
+        return std::nullopt;
+
+    const uint32_t dst_width = width != 0 ? width : info->width;
+    const uint32_t dst_height = height != 0
+                                    ? height
+                                    : std::max(1u, static_cast<uint32_t>(std::lround(static_cast<double>(info->height) * dst_width / info->width)));
+
+    if (dst_width > bmp_decoder::MAX_DIMENSION || dst_height > bmp_decoder::MAX_DIMENSION)
+        return std::nullopt;
+
+    auto src_bmp = bmp_decoder::create_bmp(info->width, info->height, 24);
+    const auto src_info = bmp_decoder::parse(src_bmp.data(), src_bmp.size());
+
+    if (!src_info || !bmp_decoder::convert(data, size, *info, src_bmp.data() + src_info->pixel_offset, {info->width, info->height, false, 24}))
+        return std::nullopt;
+
+    if (dst_width == info->width && dst_height == info->height)
+        return src_bmp;
+
+    auto dst_bmp = bmp_decoder::create_bmp(dst_width, dst_height, 24);
+    const auto dst_info = bmp_decoder::parse(dst_bmp.data(), dst_bmp.size());
+
+    if (!dst_info)
+        return std::nullopt;
+
+    const image_view_t src = {src_bmp.data() + src_info->pixel_offset, info->width, info->height, src_info->stride, 3};
+    const image_view_t dst = {dst_bmp.data() + dst_info->pixel_offset, dst_width, dst_height, dst_info->stride, 3};
+
+    if (!resize(src, dst, dst_width < info->width ? RESAMPLE_LANCZOS3 : RESAMPLE_MITCHELL, pool))
+        return std::nullopt;
+
+    return dst_bmp;
+}
+}
@@ -0,0 +1,51 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class thread_pool;
+
+enum resample_filter { RESAMPLE_LANCZOS3, RESAMPLE_MITCHELL };
+
+/**
+ * Image of 8 bit channels, 3 (BGR) or 4 (BGRX) per pixel
+ */
+typedef struct image_view
+{
+    uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // bytes between rows
+    uint32_t channels;
+} image_view_t;
+
+/**
+ * Separable resampler for theme art shipped at a different resolution than Voicemeeter's bitmaps
+ * Each output row is filtered vertically into a float row (AVX2 / SSE2) and then horizontally (SSE2),
+ * rows are independent and are split across a thread pool if one is given
+ */
+namespace resampler
+{
+bool resize(const image_view_t& src, const image_view_t& dst, resample_filter filter, thread_pool* pool = nullptr);
+bool resize_scalar(const image_view_t& src, const image_view_t& dst, resample_filter filter);
+std::optional<std::vector<uint8_t>> fit_bmp(const uint8_t* data, size_t size, uint32_t width, uint32_t height, thread_pool* pool = nullptr);
+}
@@ -0,0 +1,288 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "shared_region.hpp"
+
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include "utils.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+class shared_region_win32 final : public shared_region
+{
+    HANDLE mapping = nullptr;
+    uint8_t* header_view = nullptr;
+    uint8_t* payload_view = nullptr;
+    size_t header_size = 0;
+    size_t payload_size = 0;
+    bool writable = false;
+
+    static uint8_t* map(HANDLE mapping, DWORD access, uint64_t offset, size_t size)
+    {
+        return static_cast<uint8_t*>(MapViewOfFile(mapping, access, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), size));
+    }
+
+public:
+    ~shared_region_win32() override
+    {
+        if (payload_view != nullptr)
+            UnmapViewOfFile(payload_view);
+
+        if (header_view != nullptr)
+            UnmapViewOfFile(header_view);
+
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+    }
+
+    bool create(const std::string& name, const size_t header_bytes, const size_t payload_bytes) override
+    {
+        const auto wname = utils::str_to_wstr("Local\\" + name);
+
+        if (!wname)
+            return false;
+
+        const uint64_t total = static_cast<uint64_t>(header_bytes) + payload_bytes;
+        mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(total >> 32), static_cast<DWORD>(total), wname->c_str());
+
+        if (mapping == nullptr || GetLastError() == ERROR_ALREADY_EXISTS)
+            return false;
+
+        header_view = map(mapping, FILE_MAP_WRITE, 0, header_bytes);
+        payload_view = map(mapping, FILE_MAP_WRITE, header_bytes, payload_bytes);
+
+        if (header_view == nullptr || payload_view == nullptr)
+        {
+            SPDLOG_ERROR("failed to map shared region {}: {}", name, GetLastError());
+            return false;
+        }
+
+        header_size = header_bytes;
+        payload_size = payload_bytes;
+        writable = true;
+        return true;
+    }
+
+    bool open(const std::string& name, const size_t header_bytes) override
+    {
+        const auto wname = utils::str_to_wstr("Local\\" + name);
+
+        if (!wname)
+            return false;
+
+        mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, wname->c_str());
+
+        if (mapping == nullptr)
+            return false;
+
+        header_view = map(mapping, FILE_MAP_WRITE, 0, header_bytes);
+        header_size = header_bytes;
+        return header_view != nullptr;
+    }
+
+    bool map_payload(const size_t payload_bytes) override
+    {
+        // fails if the view would reach past the end of the mapping
+        payload_view = map(mapping, FILE_MAP_READ, header_size, payload_bytes);
+        payload_size = payload_view != nullptr ? payload_bytes : 0;
+        return payload_view != nullptr;
+    }
+
+    bool seal() override
+    {
+        DWORD old_protect = 0;
+        writable = false;
+        return VirtualProtect(payload_view, payload_size, PAGE_READONLY, &old_protect) != FALSE;
+    }
+
+    void unlink() override
+    {
+        // the mapping is gone with its last handle
+    }
+
+    uint8_t* header() const override
+    {
+        return header_view;
+    }
+
+    uint8_t* writable_payload() const override
+    {
+        return writable ? payload_view : nullptr;
+    }
+
+    const uint8_t* data() const override
+    {
+        return payload_view;
+    }
+
+    size_t size() const override
+    {
+        return payload_size;
+    }
+};
+#else
+class shared_region_posix final : public shared_region
+{
+    std::string shm_name;
+    uint8_t* header_view = nullptr;
+    uint8_t* payload_view = nullptr;
+    size_t header_size = 0;
+    size_t payload_size = 0;
+    size_t region_size = 0;
+    int fd = -1;
+    bool writable = false;
+
+public:
+    ~shared_region_posix() override
+    {
+        if (payload_view != nullptr)
+            munmap(payload_view, payload_size);
+
+        if (header_view != nullptr)
+            munmap(header_view, header_size);
+
+        if (fd != -1)
+            close(fd);
+    }
+
+    bool create(const std::string& name, const size_t header_bytes, const size_t payload_bytes) override
+    {
+        shm_name = "/" + name;
+        fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (fd == -1)
+            return false;
+
+        region_size = header_bytes + payload_bytes;
+
+        if (ftruncate(fd, static_cast<off_t>(region_size)) != 0)
+        {
+            shm_unlink(shm_name.c_str());
+            return false;
+        }
+
+        auto* header_map = mmap(nullptr, header_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto* payload_map = mmap(nullptr, payload_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(header_bytes));
+
+        header_view = header_map != MAP_FAILED ? static_cast<uint8_t*>(header_map) : nullptr;
+        payload_view = payload_map != MAP_FAILED ? static_cast<uint8_t*>(payload_map) : nullptr;
+        header_size = header_bytes;
+        payload_size = payload_bytes;
+
+        if (header_view == nullptr || payload_view == nullptr)
+        {
+            SPDLOG_ERROR("failed to map shared region {}", name);
+            shm_unlink(shm_name.c_str());
+            return false;
+        }
+
+        writable = true;
+        return true;
+    }
+
+    bool open(const std::string& name, const size_t header_bytes) override
+    {
+        shm_name = "/" + name;
+        fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+        struct stat st = {};
+
+        if (fd == -1 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_bytes)
+            return false;
+
+        region_size = static_cast<size_t>(st.st_size);
+        auto* header_map = mmap(nullptr, header_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (header_map == MAP_FAILED)
+            return false;
+
+        header_view = static_cast<uint8_t*>(header_map);
+        header_size = header_bytes;
+        return true;
+    }
+
+    bool map_payload(const size_t payload_bytes) override
+    {
+        if (payload_bytes == 0 || payload_bytes > region_size - header_size)
+            return false;
+
+        auto* payload_map = mmap(nullptr, payload_bytes, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(header_size));
+
+        if (payload_map == MAP_FAILED)
+            return false;
+
+        payload_view = static_cast<uint8_t*>(payload_map);
+        payload_size = payload_bytes;
+        return true;
+    }
+
+    bool seal() override
+    {
+        writable = false;
+        return mprotect(payload_view, payload_size, PROT_READ) == 0;
+    }
+
+    void unlink() override
+    {
+        shm_unlink(shm_name.c_str());
+    }
+
+    uint8_t* header() const override
+    {
+        return header_view;
+    }
+
+    uint8_t* writable_payload() const override
+    {
+        return writable ? payload_view : nullptr;
+    }
+
+    const uint8_t* data() const override
+    {
+        return payload_view;
+    }
+
+    size_t size() const override
+    {
+        return payload_size;
+    }
+};
+#endif
+}
+
+/**
+ * Creates an unopened shared region of the platform
+ * @return The region
+ */
+std::unique_ptr<shared_region> make_shared_region()
+{
+#ifdef _WIN32
+    return std::make_unique<shared_region_win32>();
+#else
+    return std::make_unique<shared_region_posix>();
+#endif
+}
@@ -0,0 +1,56 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mapped_view.hpp"
+
+/**
+ * Named shared memory made of a small writable header and a payload that is read-only once published
+ * A file mapping in the Local\ namespace on Windows, so the 32 and 64 bit Voicemeeter of a session see the same region,
+ * a POSIX shm object everywhere else
+ * Views of the payload start at header_size, which must be a multiple of 64 KB, the allocation granularity of Windows
+ */
+class shared_region : public mapped_view
+{
+public:
+    // creates a new region with both parts writable, fails if the name is taken
+    virtual bool create(const std::string& name, size_t header_size, size_t payload_size) = 0;
+    // opens an existing region, only its header is mapped until map_payload
+    virtual bool open(const std::string& name, size_t header_size) = 0;
+    // maps the payload of an opened region read-only, fails if the region is smaller
+    virtual bool map_payload(size_t payload_size) = 0;
+    // makes the payload of a created region read-only
+    virtual bool seal() = 0;
+    // removes the name once the last user is gone, a no-op where the system does that by itself
+    virtual void unlink() = 0;
+    virtual uint8_t* header() const = 0;
+    virtual uint8_t* writable_payload() const = 0;
+
+    // GDI would write into the shared pages through a DIB section, so bitmaps are copied
+    void* get_section() const override
+    {
+        return nullptr;
+    }
+};
+
+std::unique_ptr<shared_region> make_shared_region();
@@ -0,0 +1,91 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "simd.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace simd
+{
+namespace
+{
+typedef struct cpu_features
+{
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false;
+} cpu_features_t;
+
+/**
+ * Queries the instruction set extensions supported by the CPU and the OS
+ * @return The supported extensions
+ */
+cpu_features_t detect()
+{
+    cpu_features_t f;
+
+#if defined(_MSC_VER) && defined(VMCHROMA_SSE2)
+    int regs[4] = {};
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    f.ssse3 = (regs[2] & (1 << 9)) != 0;
+    f.sse41 = (regs[2] & (1 << 19)) != 0;
+
+    // AVX2 also requires the OS to save the YMM registers
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+    if (max_leaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+    {
+        __cpuidex(regs, 7, 0);
+        f.avx2 = (regs[1] & (1 << 5)) != 0;
+    }
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(VMCHROMA_SSE2)
+    __builtin_cpu_init();
+    f.ssse3 = __builtin_cpu_supports("ssse3");
+    f.sse41 = __builtin_cpu_supports("sse4.1");
+    f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    return f;
+}
+
+const cpu_features_t& features()
+{
+    static const cpu_features_t f = detect();
+    return f;
+}
+}
+
+bool has_ssse3()
+{
+    return features().ssse3;
+}
+
+bool has_sse41()
+{
+    return features().sse41;
+}
+
+bool has_avx2()
+{
+    return features().avx2;
+}
+}
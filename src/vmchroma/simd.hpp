@@ -0,0 +1,45 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// SSE2 is the baseline on x64 and the MSVC default for x86 since VS2012
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define VMCHROMA_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// everything above SSE2 is compiled per function and selected at runtime
+#if defined(VMCHROMA_SSE2)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define VMCHROMA_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define VMCHROMA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define VMCHROMA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VMCHROMA_TARGET_SSSE3
+#define VMCHROMA_TARGET_SSE41
+#define VMCHROMA_TARGET_AVX2
+#endif
+#endif
+
+namespace simd
+{
+bool has_ssse3();
+bool has_sse41();
+bool has_avx2();
+}
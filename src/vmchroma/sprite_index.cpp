@@ -0,0 +1,68 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sprite_index.hpp"
+
+uint64_t sprite_index::pack_dimensions(const uint32_t width, const uint32_t height, const uint32_t bpp)
+{
+    return static_cast<uint64_t>(width) << 32 | static_cast<uint64_t>(height) << 8 | (bpp & 0xFF);
+}
+
+/**
+ * Adds a sprite, a later sprite with the same fingerprint replaces the earlier one
+ * @param key Fingerprint of the original bitmap
+ * @param sprite_id Id of the replacement
+ */
+void sprite_index::insert(const sprite_key_t& key, const uint32_t sprite_id)
+{
+    entries[key] = sprite_id;
+    dimensions.insert(pack_dimensions(key.width, key.height, key.bpp));
+}
+
+/**
+ * Looks up the replacement for a bitmap
+ * @param key Fingerprint of the bitmap
+ * @return Sprite id, or nullopt if the theme doesn't replace the bitmap
+ */
+std::optional<uint32_t> sprite_index::find(const sprite_key_t& key) const
+{
+    const auto it = entries.find(key);
+
+    if (it == entries.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+/**
+ * Checks whether any sprite has the given dimensions
+ * @return True if a bitmap of this size can have a replacement
+ */
+bool sprite_index::has_dimensions(const uint32_t width, const uint32_t height, const uint32_t bpp) const
+{
+    return dimensions.count(pack_dimensions(width, height, bpp)) != 0;
+}
+
+size_t sprite_index::size() const
+{
+    return entries.size();
+}
+
+bool sprite_index::empty() const
+{
+    return entries.empty();
+}
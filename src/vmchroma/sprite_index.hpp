@@ -0,0 +1,66 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+typedef struct sprite_key
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    uint32_t hash; // pixel_hash::dib of the pixels Voicemeeter drew
+
+    bool operator==(const sprite_key& other) const
+    {
+        return width == other.width && height == other.height && bpp == other.bpp && hash == other.hash;
+    }
+} sprite_key_t;
+
+/**
+ * Maps bitmap fingerprints to the replacement sprites of a theme
+ * The dimensions are indexed separately, so bitmaps no sprite could match are skipped without hashing their pixels
+ */
+class sprite_index
+{
+    typedef struct key_hash
+    {
+        size_t operator()(const sprite_key_t& key) const
+        {
+            uint64_t h = (static_cast<uint64_t>(key.width) << 32 | key.height) * 0x9E3779B97F4A7C15ull;
+            h ^= (static_cast<uint64_t>(key.bpp) << 32 | key.hash) * 0xBF58476D1CE4E5B9ull;
+            return static_cast<size_t>(h ^ (h >> 31));
+        }
+    } key_hash_t;
+
+    std::unordered_map<sprite_key_t, uint32_t, key_hash_t> entries;
+    std::unordered_set<uint64_t> dimensions;
+
+    static uint64_t pack_dimensions(uint32_t width, uint32_t height, uint32_t bpp);
+
+public:
+    void insert(const sprite_key_t& key, uint32_t sprite_id);
+    std::optional<uint32_t> find(const sprite_key_t& key) const;
+    bool has_dimensions(uint32_t width, uint32_t height, uint32_t bpp) const;
+    size_t size() const;
+    bool empty() const;
+};
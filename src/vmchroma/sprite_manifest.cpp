@@ -0,0 +1,86 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sprite_manifest.hpp"
+
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+#include "yaml-cpp/yaml.h"
+
+namespace sprite_manifest
+{
+/**
+ * Reads the optional sprites.yaml, which maps fingerprints of Voicemeeter's bitmaps to files in the sprites folder
+ * @param sprites_path Path to sprites.yaml
+ * @param entries The listed sprites
+ * @return True if there is no manifest or it was loaded successfully
+ */
+bool load_file(const std::filesystem::path& sprites_path, std::vector<sprite_entry_t>& entries)
+{
+    entries.clear();
+
+    if (!std::filesystem::exists(sprites_path))
+        return true;
+
+    std::ifstream sprites_file(sprites_path);
+
+    if (!sprites_file.is_open())
+    {
+        SPDLOG_ERROR("can't open sprites.yaml");
+        return false;
+    }
+
+    YAML::Node yaml_sprites;
+
+    try
+    {
+        yaml_sprites = YAML::Load(sprites_file);
+    }
+    catch (YAML::ParserException&)
+    {
+        SPDLOG_ERROR("failed to parse sprites.yaml");
+        return false;
+    }
+
+    if (!yaml_sprites["sprites"].IsSequence())
+        return true;
+
+    for (const auto& node : yaml_sprites["sprites"])
+    {
+        sprite_entry_t entry = {};
+
+        try
+        {
+            entry.key.width = node["width"].as<uint32_t>();
+            entry.key.height = node["height"].as<uint32_t>();
+            entry.key.bpp = node["bpp"].as<uint32_t>();
+            entry.key.hash = static_cast<uint32_t>(std::stoul(node["hash"].as<std::string>(), nullptr, 16));
+            entry.file = node["file"].as<std::string>();
+        }
+        catch (std::exception&)
+        {
+            SPDLOG_ERROR("sprite entries need width, height, bpp, hash and file");
+            return false;
+        }
+
+        entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
+}
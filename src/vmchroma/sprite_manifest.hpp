@@ -0,0 +1,41 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "sprite_index.hpp"
+
+/**
+ * Entry of sprites.yaml, the sprite replacing the bitmap with the given fingerprint
+ */
+typedef struct sprite_entry
+{
+    sprite_key_t key;
+    std::string file; // name in the sprites folder without extension
+} sprite_entry_t;
+
+/**
+ * Reader for sprites.yaml, shared by the DLL and the vmtheme compiler
+ */
+namespace sprite_manifest
+{
+bool load_file(const std::filesystem::path& sprites_path, std::vector<sprite_entry_t>& entries);
+}
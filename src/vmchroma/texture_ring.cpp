@@ -0,0 +1,165 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "texture_ring.hpp"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+/**
+ * @param device Creates the textures and submits the copies
+ * @param slot_count Number of textures, 1 keeps a single texture without copies
+ */
+texture_ring::texture_ring(texture_device& device, const size_t slot_count) : device(device), slot_count(std::max<size_t>(1, slot_count)), fences(this->slot_count, 0)
+{
+}
+
+texture_ring::~texture_ring()
+{
+    destroy();
+}
+
+/**
+ * Creates all textures and hands the first one to GDI
+ * @param width Width of the window's bitmap
+ * @param height Height of the window's bitmap
+ * @return True if the DC returned by get_dc can be drawn into
+ */
+bool texture_ring::create(const uint32_t width, const uint32_t height)
+{
+    destroy();
+
+    for (size_t slot = 0; slot < slot_count; slot++)
+    {
+        created = true;
+
+        if (!device.create_slot(slot, width, height))
+        {
+            SPDLOG_ERROR("failed to create {}x{} texture {} of {}", width, height, slot + 1, slot_count);
+            destroy();
+            return false;
+        }
+
+        stats.textures_created++;
+
+        if (stats.frames > 0)
+            stats.frame_creations++;
+    }
+
+    current = 0;
+    std::fill(fences.begin(), fences.end(), 0);
+    dc = device.acquire_dc(current);
+    stats.dc_acquires++;
+
+    return dc != nullptr;
+}
+
+/**
+ * Takes the DC back from GDI and releases all textures
+ */
+void texture_ring::destroy()
+{
+    if (!created)
+        return;
+
+    if (dc)
+        device.release_dc(current);
+
+    // the GPU may still read a texture for the last present
+    for (const auto fence : fences)
+    {
+        if (fence != 0)
+            device.wait(fence);
+    }
+
+    for (size_t slot = 0; slot < slot_count; slot++)
+        device.destroy_slot(slot);
+
+    dc = nullptr;
+    created = false;
+}
+
+/**
+ * Takes the current texture back from GDI so the GPU can read it, the caller draws get_slot afterwards
+ * @return False if the DC couldn't be released, the frame must be skipped then
+ */
+bool texture_ring::begin_frame()
+{
+    if (!dc)
+        return false;
+
+    if (!device.release_dc(current))
+        return false;
+
+    dc = nullptr;
+    return true;
+}
+
+/**
+ * Called once the frame drawn from the current texture is submitted, hands the next texture to GDI
+ * @return True if the DC returned by get_dc can be drawn into
+ */
+bool texture_ring::end_frame()
+{
+    stats.frames++;
+    fences[current] = device.signal();
+
+    const size_t next = (current + 1) % slot_count;
+
+    if (next != current)
+    {
+        if (fences[next] != 0 && !device.is_complete(fences[next]))
+        {
+            stats.fence_waits++;
+            device.wait(fences[next]);
+        }
+
+        fences[next] = 0;
+        device.copy(next, current);
+        stats.copies++;
+        current = next;
+    }
+
+    dc = device.acquire_dc(current);
+    stats.dc_acquires++;
+
+    return dc != nullptr;
+}
+
+/**
+ * Gets the DC GDI currently draws into, changes after every end_frame if the ring has more than one texture
+ * @return The DC or nullptr between begin_frame and end_frame
+ */
+void* texture_ring::get_dc() const
+{
+    return dc;
+}
+
+size_t texture_ring::get_slot() const
+{
+    return current;
+}
+
+size_t texture_ring::get_slot_count() const
+{
+    return slot_count;
+}
+
+texture_ring_stats_t texture_ring::get_stats() const
+{
+    return stats;
+}
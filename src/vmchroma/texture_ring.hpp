@@ -0,0 +1,83 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct texture_ring_stats
+{
+    uint64_t frames;
+    uint64_t textures_created; // GDI-compatible textures, each with the bitmap Direct2D reads it through
+    uint64_t frame_creations; // textures created after the first frame, the per-frame cost this ring removes
+    uint64_t dc_acquires;
+    uint64_t copies;
+    uint64_t fence_waits; // frames that had to wait for the GPU before GDI could draw into the next texture
+} texture_ring_stats_t;
+
+/**
+ * GPU side of the texture ring
+ * Implemented with Direct3D 11 and Direct2D in the DLL, can be replaced by a fake device for testing
+ * Slots are numbered 0 to slot count - 1, fences are increasing values of work submitted to the GPU
+ */
+class texture_device
+{
+public:
+    virtual ~texture_device() = default;
+    virtual bool create_slot(size_t slot, uint32_t width, uint32_t height) = 0;
+    virtual void destroy_slot(size_t slot) = 0;
+    virtual void* acquire_dc(size_t slot) = 0;
+    virtual bool release_dc(size_t slot) = 0;
+    virtual void copy(size_t dst_slot, size_t src_slot) = 0;
+    virtual uint64_t signal() = 0;
+    virtual bool is_complete(uint64_t fence) = 0;
+    virtual void wait(uint64_t fence) = 0;
+};
+
+/**
+ * A few GDI-compatible textures a window's memory DC rotates through, created once instead of every frame
+ * GDI draws into the current texture while the GPU may still read the previous ones for earlier presents
+ * Voicemeeter only redraws what changed, so the next texture gets a GPU copy of the current one before GDI draws into it
+ * A texture is only handed to GDI again once the fence of the frame that read it has completed
+ */
+class texture_ring
+{
+    texture_device& device;
+    size_t slot_count;
+    std::vector<uint64_t> fences; // per slot, 0 while no frame read it
+    size_t current = 0;
+    void* dc = nullptr;
+    bool created = false;
+    texture_ring_stats_t stats = {};
+
+public:
+    texture_ring(texture_device& device, size_t slot_count);
+    ~texture_ring();
+    texture_ring(const texture_ring&) = delete;
+    texture_ring& operator=(const texture_ring&) = delete;
+
+    bool create(uint32_t width, uint32_t height);
+    void destroy();
+    bool begin_frame();
+    bool end_frame();
+    void* get_dc() const;
+    size_t get_slot() const;
+    size_t get_slot_count() const;
+    texture_ring_stats_t get_stats() const;
+};
@@ -0,0 +1,263 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_asset.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+#include "lz4.hpp"
+#include "png_decoder.hpp"
+#include "qoi_decoder.hpp"
+#include "resampler.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Loads a background from the first of <stem>.bmp, <stem>.png and <stem>.qoi that exists
+ * Safe to call from a worker thread, the asset isn't shared until load returns
+ * @param dir Theme directory
+ * @param stem File name without extension
+ * @param width Width of the bitmap the asset replaces, 0 to use the asset as is
+ * @param height Height of the bitmap the asset replaces, 0 to keep the aspect ratio of the art
+ * @return True if loading was successful, false without logging if none of the files exist
+ */
+bool theme_asset::load(const std::filesystem::path& dir, const std::wstring& stem, const uint32_t width, const uint32_t height)
+{
+    source_dir = dir;
+    source_stem = stem;
+    target_width = width;
+    target_height = height;
+
+    return load_files() && fit_to_target();
+}
+
+/**
+ * Uses a bitmap section of a compiled theme, the vmtheme compiler already fitted it to Voicemeeter's bitmap
+ * @param pack_view The pack, shared by all assets of the theme
+ * @param section The bitmap section
+ * @return False if the section isn't a valid BMP file
+ */
+bool theme_asset::load_packed(const std::shared_ptr<const mapped_view>& pack_view, const theme_pack::section_t& section)
+{
+    if (!bmp_decoder::parse(section.data, static_cast<size_t>(section.size)))
+        return false;
+
+    pack = pack_view;
+    pack_offset = static_cast<size_t>(section.offset);
+    pack_size = static_cast<size_t>(section.size);
+    return true;
+}
+
+bool theme_asset::load_files()
+{
+    const auto bmp_path = source_dir / (source_stem + L".bmp");
+
+    if (std::filesystem::exists(bmp_path))
+    {
+        if (!file.open(bmp_path))
+            return false;
+
+        if (!bmp_decoder::parse(file.data(), file.size()))
+        {
+            SPDLOG_ERROR("invalid bitmap file {}", bmp_path.u8string());
+            file.close();
+            return false;
+        }
+
+        return true;
+    }
+
+    for (const auto* ext : {L".png", L".qoi"})
+    {
+        const auto path = source_dir / (source_stem + ext);
+
+        if (!std::filesystem::exists(path))
+            continue;
+
+        mapped_file encoded;
+
+        if (!encoded.open(path))
+            return false;
+
+        auto bmp = ext == std::wstring(L".png")
+                       ? png_decoder::decode_to_bmp(encoded.data(), encoded.size())
+                       : qoi_decoder::decode_to_bmp(encoded.data(), encoded.size());
+
+        if (!bmp || !bmp_decoder::parse(bmp->data(), bmp->size()))
+        {
+            SPDLOG_ERROR("can't decode {}", path.u8string());
+            return false;
+        }
+
+        decoded = std::move(*bmp);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Resamples art shipped at another resolution, e.g. 2x, to the size of Voicemeeter's bitmap
+ * Lanczos3 when shrinking, Mitchell when enlarging, the rows are split across all cores
+ * @return True if the asset has the target size afterwards
+ */
+bool theme_asset::fit_to_target()
+{
+    const auto info = bmp_decoder::parse(data(), size());
+
+    if (!info)
+        return false;
+
+    if (target_width == 0 || (info->width == target_width && (target_height == 0 || info->height == target_height)))
+        return true;
+
+    thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+    auto fitted = resampler::fit_bmp(data(), size(), target_width, target_height, &pool);
+
+    if (!fitted)
+        return false;
+
+    const auto fitted_info = bmp_decoder::parse(fitted->data(), fitted->size());
+
+    if (!fitted_info)
+        return false;
+
+    SPDLOG_INFO("resampled {} from {}x{} to {}x{}", std::filesystem::path(source_stem).u8string(), info->width, info->height, fitted_info->width, fitted_info->height);
+
+    file.close();
+    decoded = std::move(*fitted);
+    return true;
+}
+
+/**
+ * Makes the BMP bytes available again after trim, by decompressing or reloading them from the theme folder
+ * @return True if data and size can be used
+ */
+bool theme_asset::acquire()
+{
+    if (pack || file.is_open() || !decoded.empty())
+        return true;
+
+    if (!compressed.empty())
+    {
+        decoded.resize(compressed_from);
+
+        if (lz4::decompress(compressed.data(), compressed.size(), decoded.data(), decoded.size()))
+            return true;
+
+        SPDLOG_ERROR("compressed theme bitmap {} is corrupt, reloading it", std::filesystem::path(source_stem).u8string());
+        decoded = {};
+        compressed = {};
+    }
+
+    return load_files() && fit_to_target();
+}
+
+/**
+ * Drops the BMP bytes after the DIB has been filled, must not be called while a DIB uses the file section
+ * Mapped .bmp files are clean file cache pages, only release unmaps them
+ * @param policy Keep the bytes, release them, or keep decoded bitmaps LZ4 compressed
+ */
+void theme_asset::trim(const theme_memory policy)
+{
+    // the pack stays mapped for the other assets anyway
+    if (policy == THEME_MEMORY_KEEP || pack)
+        return;
+
+    if (policy == THEME_MEMORY_RELEASE)
+    {
+        file.close();
+        decoded = {};
+        compressed = {};
+        return;
+    }
+
+    if (decoded.empty())
+        return;
+
+    // compressed once, later trims only drop the decompressed copy again
+    if (compressed.empty())
+    {
+        compressed.resize(lz4::compress_bound(decoded.size()));
+        compressed.resize(lz4::compress(decoded.data(), decoded.size(), compressed.data(), compressed.size()));
+        compressed.shrink_to_fit();
+        compressed_from = decoded.size();
+    }
+
+    decoded = {};
+}
+
+const uint8_t* theme_asset::data() const
+{
+    if (pack)
+        return pack->data() + pack_offset;
+
+    return file.is_open() ? file.data() : decoded.data();
+}
+
+size_t theme_asset::size() const
+{
+    if (pack)
+        return pack_size;
+
+    return file.is_open() ? file.size() : decoded.size();
+}
+
+/**
+ * Gets the file-mapping section backing the asset
+ * @return Section handle, nullptr for decoded assets which only live in process memory and for shared themes
+ */
+void* theme_asset::get_section() const
+{
+    if (pack)
+        return pack->get_section();
+
+    return file.is_open() ? file.get_section() : nullptr;
+}
+
+/**
+ * Gets where the BMP file starts in the section returned by get_section
+ * @return Byte offset, 0 unless the asset is part of a compiled theme
+ */
+size_t theme_asset::get_section_offset() const
+{
+    return pack ? pack_offset : 0;
+}
+
+/**
+ * Gets the heap memory held by the asset
+ * @return Bytes of decoded and compressed buffers
+ */
+size_t theme_asset::private_bytes() const
+{
+    return decoded.capacity() + compressed.capacity();
+}
+
+/**
+ * Gets the size of the mapped file view, shared with the file cache
+ * @return Bytes mapped
+ */
+size_t theme_asset::mapped_bytes() const
+{
+    if (pack)
+        return pack_size;
+
+    return file.is_open() ? file.size() : 0;
+}
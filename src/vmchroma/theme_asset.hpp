@@ -0,0 +1,68 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "mapped_view.hpp"
+#include "theme_pack.hpp"
+#include "theme_types.hpp"
+
+/**
+ * Background bitmap of a theme
+ * A .bmp file is mapped as is, a .png or .qoi file is decoded into an in-memory BMP with the same layout,
+ * so callers only ever see BMP file bytes
+ * Art at another resolution than Voicemeeter's bitmap is resampled to it once when it is loaded
+ * Once its DIB is filled the asset can be trimmed, acquire brings the bytes back if the DIB is created again
+ * An asset from a compiled theme is a view into the pack, mapped from a file or shared by another instance, and is never trimmed
+ */
+class theme_asset
+{
+    mapped_file file;
+    std::shared_ptr<const mapped_view> pack;
+    size_t pack_offset = 0;
+    size_t pack_size = 0;
+    std::vector<uint8_t> decoded;
+    std::vector<uint8_t> compressed;
+    size_t compressed_from = 0;
+    std::filesystem::path source_dir;
+    std::wstring source_stem;
+    uint32_t target_width = 0;
+    uint32_t target_height = 0;
+
+    bool load_files();
+    bool fit_to_target();
+
+public:
+    bool load(const std::filesystem::path& dir, const std::wstring& stem, uint32_t width = 0, uint32_t height = 0);
+    bool load_packed(const std::shared_ptr<const mapped_view>& pack_view, const theme_pack::section_t& section);
+    bool acquire();
+    void trim(theme_memory policy);
+    const uint8_t* data() const;
+    size_t size() const;
+    void* get_section() const;
+    size_t get_section_offset() const;
+    size_t private_bytes() const;
+    size_t mapped_bytes() const;
+};
@@ -0,0 +1,250 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "pixel_hash.hpp"
+#include "theme_pack.hpp"
+
+namespace theme_cache
+{
+namespace
+{
+constexpr char TEMP_EXTENSION[] = ".tmp";
+
+// a write that was interrupted, e.g. because Voicemeeter exited, leaves its temporary file behind
+constexpr auto TEMP_MAX_AGE = std::chrono::hours(1);
+
+/**
+ * Hashes the name, size and last write time of a file into the key, the content isn't read
+ * @param hash Running hash
+ * @param path The file
+ * @param name Name of the file relative to the theme folder
+ * @return False if the file doesn't exist
+ */
+bool hash_file(uint32_t& hash, const std::filesystem::path& path, const std::string& name)
+{
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(path, ec);
+
+    if (ec)
+        return false;
+
+    const auto write_time = std::filesystem::last_write_time(path, ec);
+
+    if (ec)
+        return false;
+
+    const uint64_t stamp[] = {size, static_cast<uint64_t>(write_time.time_since_epoch().count())};
+
+    hash = pixel_hash::xxh32(reinterpret_cast<const uint8_t*>(name.data()), name.size(), hash);
+    hash = pixel_hash::xxh32(reinterpret_cast<const uint8_t*>(stamp), sizeof(stamp), hash);
+    return true;
+}
+
+/**
+ * Hashes every file of a theme subfolder, in name order so the key doesn't depend on the directory listing
+ * @param hash Running hash
+ * @param theme_root The theme folder
+ * @param dir_name The subfolder
+ * @return False if a file vanished while listing the folder
+ */
+bool hash_dir(uint32_t& hash, const std::filesystem::path& theme_root, const std::string& dir_name)
+{
+    std::error_code ec;
+    std::vector<std::filesystem::path> files;
+
+    for (const auto& entry : std::filesystem::directory_iterator(theme_root / dir_name, ec))
+    {
+        if (entry.is_regular_file(ec))
+            files.push_back(entry.path());
+    }
+
+    std::sort(files.begin(), files.end());
+
+    for (const auto& path : files)
+    {
+        if (!hash_file(hash, path, dir_name + "/" + path.filename().generic_u8string()))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Checks whether a file in the cache folder belongs to the same theme and flavor as an entry
+ * @param name File name
+ * @param prefix <theme>.<flavor>. of the entry
+ * @return True if the name is the prefix followed by a key, the name of an entry or of its temporary file
+ */
+bool has_entry_prefix(const std::filesystem::path::string_type& name, const std::filesystem::path::string_type& prefix)
+{
+    // a theme whose name starts with <theme>.<flavor>. is told apart by the 8 hex digits of the key
+    if (name.size() <= prefix.size() + 8 || name.compare(0, prefix.size(), prefix) != 0 || name[prefix.size() + 8] != '.')
+        return false;
+
+    for (size_t i = prefix.size(); i < prefix.size() + 8; i++)
+    {
+        const auto c = name[i];
+
+        if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F')))
+            return false;
+    }
+
+    return true;
+}
+}
+
+/**
+ * Computes the cache key of one flavor of a theme from everything that goes into compiling it
+ * Only the size and write time of colors.yaml, sprites.yaml and the files in the sprites and flavor folders are read,
+ * so checking the cache at startup costs a few file system lookups instead of reading the whole theme
+ * @param theme_root The theme folder
+ * @param flavor The flavor
+ * @return The key or std::nullopt if colors.yaml doesn't exist
+ */
+std::optional<uint32_t> key(const std::filesystem::path& theme_root, const flavor_info_t& flavor)
+{
+    const uint32_t header[] = {VERSION, theme_pack::VERSION, static_cast<uint32_t>(flavor.id),
+                               flavor.bitmap_width_main, flavor.bitmap_width_settings, flavor.bitmap_width_cassette};
+    uint32_t hash = pixel_hash::xxh32(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+
+    if (!hash_file(hash, theme_root / "colors.yaml", "colors.yaml"))
+        return std::nullopt;
+
+    std::error_code ec;
+
+    if (std::filesystem::exists(theme_root / "sprites.yaml", ec) && !hash_file(hash, theme_root / "sprites.yaml", "sprites.yaml"))
+        return std::nullopt;
+
+    if (!hash_dir(hash, theme_root, "sprites") || !hash_dir(hash, theme_root, flavor.name))
+        return std::nullopt;
+
+    return hash;
+}
+
+/**
+ * Gets the file of a cache entry
+ * @param cache_dir The cache folder
+ * @param theme_root The theme folder, its name is part of the entry's name
+ * @param flavor The flavor
+ * @param key Key of the theme's current files
+ * @return <cache_dir>/<theme>.<flavor>.<key>.vmtheme
+ */
+std::filesystem::path entry_path(const std::filesystem::path& cache_dir, const std::filesystem::path& theme_root, const flavor_info_t& flavor,
+                                 const uint32_t key)
+{
+    char key_hex[9];
+    std::snprintf(key_hex, sizeof(key_hex), "%08X", key);
+
+    auto name = theme_root.filename();
+    name += "." + flavor.name + "." + key_hex + theme_pack::FILE_EXTENSION;
+    return cache_dir / name;
+}
+
+/**
+ * Writes a cache entry to a temporary file first and renames it into place, so a reader never sees a partial entry
+ * Several Voicemeeter instances may store the same entry at once, they write identical files
+ * @param entry The entry
+ * @param data Pack file bytes
+ * @return True if the entry was stored
+ */
+bool store(const std::filesystem::path& entry, const std::vector<uint8_t>& data)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(entry.parent_path(), ec);
+
+    if (ec)
+    {
+        SPDLOG_ERROR("can't create theme cache folder: {}", ec.message());
+        return false;
+    }
+
+    // unique per writer, so instances storing the same entry don't write into each other's file
+    const auto writer_id = std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    auto temp = entry;
+    temp += "." + std::to_string(writer_id) + TEMP_EXTENSION;
+
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+
+        if (!out.is_open() || !out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())) || !out.flush())
+        {
+            SPDLOG_ERROR("can't write theme cache entry");
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, entry, ec);
+
+    if (ec)
+    {
+        // another instance got there first and has the entry mapped
+        std::filesystem::remove(temp, ec);
+        return std::filesystem::exists(entry, ec);
+    }
+
+    return true;
+}
+
+/**
+ * Removes the other entries of the same theme and flavor, which were compiled from older versions of its files
+ * Entries still mapped by a running instance can't be removed yet, they are retried on the next store
+ * @param entry The current entry
+ */
+void prune(const std::filesystem::path& entry)
+{
+    // <theme>.<flavor>.<key>.vmtheme, the theme name may contain dots itself
+    const auto stem = entry.stem().native();
+    const auto prefix = stem.substr(0, stem.size() - 8);
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::error_code ec;
+
+    for (const auto& file : std::filesystem::directory_iterator(entry.parent_path(), ec))
+    {
+        const auto& path = file.path();
+
+        if (path == entry || !has_entry_prefix(path.filename().native(), prefix))
+            continue;
+
+        if (path.extension() == TEMP_EXTENSION)
+        {
+            const auto write_time = file.last_write_time(ec);
+
+            // possibly still being written by another instance
+            if (ec || now - write_time < TEMP_MAX_AGE)
+                continue;
+        }
+        else if (path.extension() != theme_pack::FILE_EXTENSION)
+            continue;
+
+        std::filesystem::remove(path, ec);
+    }
+}
+}
@@ -0,0 +1,42 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "theme_types.hpp"
+
+/**
+ * Cache of compiled themes in themes/.cache, so only the first start after a theme changed decodes it
+ * Entries are theme packs named <theme>.<flavor>.<key>.vmtheme, the key hashes the name, size and write time of every
+ * file the compiler reads, so editing a theme or updating vmchroma leads to a new entry and the old one is pruned once it is replaced
+ */
+namespace theme_cache
+{
+// part of the key, increment when the compiler produces different output from the same files
+constexpr uint32_t VERSION = 1;
+constexpr char DIR_NAME[] = ".cache";
+
+std::optional<uint32_t> key(const std::filesystem::path& theme_root, const flavor_info_t& flavor);
+std::filesystem::path entry_path(const std::filesystem::path& cache_dir, const std::filesystem::path& theme_root, const flavor_info_t& flavor, uint32_t key);
+bool store(const std::filesystem::path& entry, const std::vector<uint8_t>& data);
+void prune(const std::filesystem::path& entry);
+}
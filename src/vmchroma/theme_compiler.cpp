@@ -0,0 +1,236 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_compiler.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+#include "bmp_decoder.hpp"
+#include "color_config.hpp"
+#include "png_decoder.hpp"
+#include "qoi_decoder.hpp"
+#include "resampler.hpp"
+#include "sprite_manifest.hpp"
+#include "theme_pack.hpp"
+
+namespace theme_compiler
+{
+namespace
+{
+std::optional<std::vector<uint8_t>> read_file(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+        return std::nullopt;
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/**
+ * Loads the first of <stem>.bmp, <stem>.png and <stem>.qoi that exists, in the same order as theme_asset
+ * @param dir Folder of the image
+ * @param stem File name without extension
+ * @return BMP file bytes or std::nullopt if no file exists or it can't be decoded
+ */
+std::optional<std::vector<uint8_t>> load_image(const std::filesystem::path& dir, const std::string& stem)
+{
+    for (const auto* ext : {".bmp", ".png", ".qoi"})
+    {
+        const auto path = dir / (stem + ext);
+
+        if (!std::filesystem::exists(path))
+            continue;
+
+        const auto bytes = read_file(path);
+
+        if (!bytes)
+        {
+            SPDLOG_ERROR("can't read {}", path.string());
+            return std::nullopt;
+        }
+
+        std::optional<std::vector<uint8_t>> bmp;
+
+        if (ext == std::string(".bmp"))
+            bmp = bytes;
+        else if (ext == std::string(".png"))
+            bmp = png_decoder::decode_to_bmp(bytes->data(), bytes->size());
+        else
+            bmp = qoi_decoder::decode_to_bmp(bytes->data(), bytes->size());
+
+        if (!bmp || !bmp_decoder::parse(bmp->data(), bmp->size()))
+        {
+            SPDLOG_ERROR("can't decode {}", path.string());
+            return std::nullopt;
+        }
+
+        return bmp;
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Adds an image as a bottom-up 24 bpp BMP of the given size, the layout of Voicemeeter's bitmaps
+ * @param writer The pack
+ * @param name Section name
+ * @param bmp The image
+ * @param width Target width
+ * @param height Target height, 0 to keep the aspect ratio
+ * @param pool Worker threads for resampling, may be nullptr
+ * @return TOC index of the section
+ */
+std::optional<uint32_t> add_bitmap(theme_pack::writer& writer, const std::string& name, const std::vector<uint8_t>& bmp,
+                                   const uint32_t width, const uint32_t height, thread_pool* pool)
+{
+    const auto src_info = bmp_decoder::parse(bmp.data(), bmp.size());
+    const auto fitted = resampler::fit_bmp(bmp.data(), bmp.size(), width, height, pool);
+
+    if (!src_info || !fitted)
+    {
+        SPDLOG_ERROR("can't convert {}", name);
+        return std::nullopt;
+    }
+
+    const auto info = bmp_decoder::parse(fitted->data(), fitted->size());
+
+    if (src_info->width != info->width || src_info->height != info->height)
+        SPDLOG_INFO("{}: resampled from {}x{} to {}x{}", name, src_info->width, src_info->height, info->width, info->height);
+
+    const auto index = writer.add(theme_pack::SECTION_BITMAP, name, fitted->data(), fitted->size(), info->pixel_offset);
+
+    if (!index)
+        SPDLOG_ERROR("{} is too long for a section name", name);
+
+    return index;
+}
+}
+
+/**
+ * Validates one flavor of a theme and compiles it into a theme pack
+ * @param theme_root The theme folder
+ * @param flavor The flavor to compile
+ * @param pool Worker threads for resampling, may be nullptr
+ * @return The pack file or std::nullopt if the theme is invalid
+ */
+std::optional<std::vector<uint8_t>> compile(const std::filesystem::path& theme_root, const flavor_info_t& flavor, thread_pool* pool)
+{
+    compiled_colors_t colors;
+
+    if (!color_config::load_file(theme_root / "colors.yaml", colors))
+        return std::nullopt;
+
+    std::vector<sprite_entry_t> sprite_entries;
+
+    if (!sprite_manifest::load_file(theme_root / "sprites.yaml", sprite_entries))
+        return std::nullopt;
+
+    return compile(theme_root, flavor, colors, sprite_entries, {}, pool);
+}
+
+/**
+ * Compiles one flavor of a theme whose colors.yaml, sprites.yaml and main background were already loaded,
+ * the DLL's theme cache passes what its theme loader read so only the rest comes from the theme folder
+ * @param theme_root The theme folder
+ * @param flavor The flavor to compile
+ * @param colors Compiled colors.yaml
+ * @param sprite_entries Entries of sprites.yaml
+ * @param bg_main Main background as BMP file bytes, empty to load it from the flavor folder
+ * @param pool Worker threads for resampling, may be nullptr
+ * @return The pack file or std::nullopt if the theme is invalid
+ */
+std::optional<std::vector<uint8_t>> compile(const std::filesystem::path& theme_root, const flavor_info_t& flavor, const compiled_colors_t& colors,
+                                            const std::vector<sprite_entry_t>& sprite_entries, const std::vector<uint8_t>& bg_main, thread_pool* pool)
+{
+    theme_pack::writer writer(flavor.id);
+
+    std::vector<uint32_t> color_words;
+    color_config::save(colors, color_words);
+    writer.add(theme_pack::SECTION_COLORS, theme_pack::COLORS_SECTION, reinterpret_cast<const uint8_t*>(color_words.data()), color_words.size() * sizeof(uint32_t));
+
+    std::vector<theme_pack::sprite_record_t> sprite_records;
+    std::map<std::string, uint32_t> sprite_bitmaps;
+
+    for (const auto& entry : sprite_entries)
+    {
+        // the same file can replace several bitmaps, but only if they have the same size
+        const auto name = theme_pack::SPRITE_PREFIX + entry.file + "@" + std::to_string(entry.key.width) + "x" + std::to_string(entry.key.height);
+        auto it = sprite_bitmaps.find(name);
+
+        if (it == sprite_bitmaps.end())
+        {
+            const auto bmp = load_image(theme_root / "sprites", entry.file);
+
+            if (!bmp)
+            {
+                SPDLOG_ERROR("can't load sprite {}.bmp, .png or .qoi from the sprites folder", entry.file);
+                return std::nullopt;
+            }
+
+            const auto index = add_bitmap(writer, name, *bmp, entry.key.width, entry.key.height, pool);
+
+            if (!index)
+                return std::nullopt;
+
+            it = sprite_bitmaps.emplace(name, *index).first;
+        }
+
+        sprite_records.push_back({entry.key.width, entry.key.height, entry.key.bpp, entry.key.hash, it->second});
+    }
+
+    if (!sprite_records.empty())
+        writer.add(theme_pack::SECTION_SPRITES, theme_pack::SPRITES_SECTION, reinterpret_cast<const uint8_t*>(sprite_records.data()), sprite_records.size() * sizeof(theme_pack::sprite_record_t));
+
+    // palette mode recolors Voicemeeter's own bitmaps
+    if (colors.bm_mode == BITMAP_MODE_REPLACE)
+    {
+        const auto flavor_dir = theme_root / flavor.name;
+        const std::pair<const char*, uint32_t> backgrounds[] = {
+            {"bg", flavor.bitmap_width_main},
+            {"bg_settings", flavor.bitmap_width_settings},
+            {"bg_cassette", flavor.bitmap_width_cassette},
+        };
+
+        for (const auto& [stem, width] : backgrounds)
+        {
+            // flavors without that window
+            if (width == 0)
+                continue;
+
+            const bool preloaded = stem == std::string("bg") && !bg_main.empty();
+            const auto loaded = preloaded ? std::nullopt : load_image(flavor_dir, stem);
+
+            if (!preloaded && !loaded)
+            {
+                SPDLOG_ERROR("can't load {}/{}.bmp, .png or .qoi", flavor.name, stem);
+                return std::nullopt;
+            }
+
+            if (!add_bitmap(writer, stem, preloaded ? bg_main : *loaded, width, 0, pool))
+                return std::nullopt;
+        }
+    }
+
+    return writer.finish();
+}
+}
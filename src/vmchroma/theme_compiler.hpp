@@ -0,0 +1,39 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "color_config.hpp"
+#include "sprite_manifest.hpp"
+#include "theme_types.hpp"
+
+class thread_pool;
+
+/**
+ * Builds a theme pack from a theme folder, used by the vmtheme compiler and for the DLL's theme cache
+ */
+namespace theme_compiler
+{
+std::optional<std::vector<uint8_t>> compile(const std::filesystem::path& theme_root, const flavor_info_t& flavor, thread_pool* pool = nullptr);
+std::optional<std::vector<uint8_t>> compile(const std::filesystem::path& theme_root, const flavor_info_t& flavor, const compiled_colors_t& colors,
+                                            const std::vector<sprite_entry_t>& sprite_entries, const std::vector<uint8_t>& bg_main, thread_pool* pool = nullptr);
+}
@@ -0,0 +1,61 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_loader.hpp"
+
+/**
+ * Starts loading a theme folder, the tasks run until join collects them
+ * The main background is loaded before colors.yaml tells whether the theme is in palette mode, the caller drops it then
+ * @param theme_root Theme folder containing colors.yaml, the optional sprites.yaml and a folder per flavor
+ * @param flavor Flavor whose background is loaded and fitted to its bitmap width
+ */
+void theme_loader::start(const std::filesystem::path& theme_root, const flavor_info_t& flavor)
+{
+    const auto colors_path = theme_root / "colors.yaml";
+    const auto sprites_path = theme_root / "sprites.yaml";
+    const auto flavor_dir = theme_root / flavor.name;
+    const auto bg_width = flavor.bitmap_width_main;
+
+    load_start = std::chrono::steady_clock::now();
+    pool = std::make_unique<thread_pool>(3);
+
+    colors_loaded = pool->submit([this, colors_path] { return timed_phase("colors", [&] { return color_config::load_file(colors_path, result.colors); }); });
+    sprites_loaded = pool->submit([this, sprites_path] { return timed_phase("sprites", [&] { return sprite_manifest::load_file(sprites_path, result.sprite_entries); }); });
+    bg_main_loaded = pool->submit([this, flavor_dir, bg_width] { return timed_phase("bg", [&] { return result.bg_main.load(flavor_dir, L"bg", bg_width); }); });
+}
+
+/**
+ * Waits for the tasks started by start and stops the threads, must be called exactly once after start
+ * @return The loaded theme, owned by the loader
+ */
+theme_load_result_t& theme_loader::join()
+{
+    const auto join_start = std::chrono::steady_clock::now();
+
+    result.colors_ok = colors_loaded.get();
+    result.sprites_ok = sprites_loaded.get();
+    result.bg_main_ok = bg_main_loaded.get();
+
+    pool.reset();
+
+    const auto join_end = std::chrono::steady_clock::now();
+    SPDLOG_INFO("theme loaded after {} ms, blocked {} ms waiting for it",
+                std::chrono::duration<double, std::milli>(join_end - load_start).count(),
+                std::chrono::duration<double, std::milli>(join_end - join_start).count());
+
+    return result;
+}
@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "color_config.hpp"
+#include "sprite_manifest.hpp"
+#include "theme_asset.hpp"
+#include "theme_types.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Runs a theme loading phase and logs how long it took
+ * @param name Phase name for the log
+ * @param phase Callable returning true on success
+ * @return Result of the phase
+ */
+template <typename F>
+bool timed_phase(const char* name, F&& phase)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = phase();
+
+    SPDLOG_INFO("theme phase {} took {} ms", name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return ok;
+}
+
+/**
+ * What the theme loader read from a theme folder, each part is only valid if its flag is set
+ */
+typedef struct theme_load_result
+{
+    compiled_colors_t colors;
+    std::vector<sprite_entry_t> sprite_entries;
+    theme_asset bg_main;
+    bool colors_ok = false;
+    bool sprites_ok = false;
+    bool bg_main_ok = false;
+} theme_load_result_t;
+
+/**
+ * Loads colors.yaml, sprites.yaml and the main background of a theme folder on worker threads
+ * The three don't depend on each other, so they load while Voicemeeter keeps starting up
+ * Nothing of the result may be touched before join returned
+ */
+class theme_loader
+{
+    std::unique_ptr<thread_pool> pool;
+    std::future<bool> colors_loaded;
+    std::future<bool> sprites_loaded;
+    std::future<bool> bg_main_loaded;
+    std::chrono::steady_clock::time_point load_start;
+    theme_load_result_t result;
+
+public:
+    void start(const std::filesystem::path& theme_root, const flavor_info_t& flavor);
+    theme_load_result_t& join();
+};
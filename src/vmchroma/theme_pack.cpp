@@ -0,0 +1,175 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_pack.hpp"
+
+#include <cstring>
+
+namespace theme_pack
+{
+writer::writer(const uint32_t flavor) : flavor(flavor)
+{
+}
+
+/**
+ * Appends a section
+ * @param type Section type
+ * @param name Name the section is looked up by, unique per type
+ * @param data Section bytes
+ * @param size Number of bytes
+ * @param align_offset Offset into the section that has to be aligned, the pixel offset of a BMP file
+ * @return TOC index of the section or std::nullopt if the name is too long or already used
+ */
+std::optional<uint32_t> writer::add(const section_type type, const std::string& name, const uint8_t* data, const size_t size, const size_t align_offset)
+{
+    if (name.empty() || name.size() >= NAME_SIZE)
+        return std::nullopt;
+
+    for (const auto& e : toc)
+    {
+        if (e.type == type && name == e.name)
+            return std::nullopt;
+    }
+
+    const size_t pos = sizeof(header_t) + body.size();
+    const size_t pad = (ALIGNMENT - (pos + align_offset) % ALIGNMENT) % ALIGNMENT;
+
+    toc_entry_t entry = {};
+    std::memcpy(entry.name, name.data(), name.size());
+    entry.type = type;
+    entry.offset = pos + pad;
+    entry.size = size;
+
+    body.resize(body.size() + pad, 0);
+    body.insert(body.end(), data, data + size);
+    toc.push_back(entry);
+
+    return static_cast<uint32_t>(toc.size() - 1);
+}
+
+/**
+ * Lays out header, sections and table of contents
+ * @return The complete pack file
+ */
+std::vector<uint8_t> writer::finish() const
+{
+    const size_t body_end = sizeof(header_t) + body.size();
+    const size_t toc_offset = (body_end + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    const size_t file_size = toc_offset + toc.size() * sizeof(toc_entry_t);
+
+    header_t hdr = {};
+    std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.version = VERSION;
+    hdr.flavor = flavor;
+    hdr.file_size = file_size;
+    hdr.toc_offset = static_cast<uint32_t>(toc_offset);
+    hdr.toc_count = static_cast<uint32_t>(toc.size());
+
+    std::vector<uint8_t> out(file_size, 0);
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+
+    if (!body.empty())
+        std::memcpy(out.data() + sizeof(header_t), body.data(), body.size());
+
+    if (!toc.empty())
+        std::memcpy(out.data() + toc_offset, toc.data(), toc.size() * sizeof(toc_entry_t));
+
+    return out;
+}
+
+/**
+ * Checks the header and that every section lies inside the file, nothing else is parsed
+ * @param data Pack bytes, must stay valid while the reader is used
+ * @param size Size of the pack
+ * @return False if the file isn't a pack of this version or is truncated
+ */
+bool reader::open(const uint8_t* data, const size_t size)
+{
+    base = nullptr;
+    toc = nullptr;
+
+    if (data == nullptr || size < sizeof(header_t))
+        return false;
+
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, MAGIC, sizeof(MAGIC)) != 0 || hdr.version != VERSION || hdr.file_size != size)
+        return false;
+
+    if (hdr.toc_offset < sizeof(header_t) || hdr.toc_offset % alignof(toc_entry_t) != 0 || hdr.toc_offset > size
+        || hdr.toc_count > (size - hdr.toc_offset) / sizeof(toc_entry_t))
+        return false;
+
+    const auto* entries = reinterpret_cast<const toc_entry_t*>(data + hdr.toc_offset);
+
+    for (uint32_t i = 0; i < hdr.toc_count; i++)
+    {
+        const auto& e = entries[i];
+
+        if (e.name[NAME_SIZE - 1] != '\0' || e.type < SECTION_COLORS || e.type > SECTION_SPRITES)
+            return false;
+
+        if (e.offset < sizeof(header_t) || e.offset > hdr.toc_offset || e.size > hdr.toc_offset - e.offset)
+            return false;
+    }
+
+    base = data;
+    toc = entries;
+    return true;
+}
+
+uint32_t reader::get_flavor() const
+{
+    return hdr.flavor;
+}
+
+size_t reader::count() const
+{
+    return toc != nullptr ? hdr.toc_count : 0;
+}
+
+/**
+ * Gets a section by its position in the table of contents
+ * @param index TOC index
+ * @return The section or std::nullopt if the index is out of range
+ */
+std::optional<section_t> reader::get(const uint32_t index) const
+{
+    if (index >= count())
+        return std::nullopt;
+
+    const auto& e = toc[index];
+    return section_t{base + e.offset, e.offset, e.size};
+}
+
+/**
+ * Looks up a section by type and name
+ * @param type Section type
+ * @param name Section name
+ * @return The section or std::nullopt if the pack doesn't have it
+ */
+std::optional<section_t> reader::find(const section_type type, const std::string& name) const
+{
+    for (uint32_t i = 0; i < count(); i++)
+    {
+        if (toc[i].type == type && name == toc[i].name)
+            return get(i);
+    }
+
+    return std::nullopt;
+}
+}
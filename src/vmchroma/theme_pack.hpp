@@ -0,0 +1,110 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Compiled theme in one file, written by the vmtheme compiler and mapped by the DLL as is
+ * Fields are little endian and of fixed size, so the 32 and 64 bit DLL read the same file
+ * Sections start on 16 byte boundaries, bitmaps are placed so their pixel rows do, which lets
+ * CreateDIBSection map them straight from the file section
+ */
+namespace theme_pack
+{
+constexpr char MAGIC[8] = {'V', 'M', 'T', 'H', 'E', 'M', 'E', '\0'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t ALIGNMENT = 16;
+constexpr size_t NAME_SIZE = 48;
+constexpr char FILE_EXTENSION[] = ".vmtheme";
+constexpr char COLORS_SECTION[] = "colors";
+constexpr char SPRITES_SECTION[] = "sprites";
+constexpr char SPRITE_PREFIX[] = "sprites/"; // bitmap sections of sprites are named after their file
+
+enum section_type : uint32_t { SECTION_COLORS = 1, SECTION_BITMAP = 2, SECTION_SPRITES = 3 };
+
+typedef struct header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flavor; // flavor_id the bitmaps were fitted to
+    uint64_t file_size;
+    uint32_t toc_offset;
+    uint32_t toc_count;
+} header_t;
+
+typedef struct toc_entry
+{
+    char name[NAME_SIZE]; // zero terminated
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+} toc_entry_t;
+
+/**
+ * Record of the sprites section, one per sprites.yaml entry
+ */
+typedef struct sprite_record
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    uint32_t hash;
+    uint32_t bitmap; // toc index of the sprite's bitmap section
+} sprite_record_t;
+
+static_assert(sizeof(header_t) == 32 && sizeof(toc_entry_t) == 72 && sizeof(sprite_record_t) == 20, "pack layout must not depend on the target");
+
+typedef struct section
+{
+    const uint8_t* data;
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+} section_t;
+
+class writer
+{
+    uint32_t flavor;
+    std::vector<uint8_t> body;
+    std::vector<toc_entry_t> toc;
+
+public:
+    explicit writer(uint32_t flavor);
+    std::optional<uint32_t> add(section_type type, const std::string& name, const uint8_t* data, size_t size, size_t align_offset = 0);
+    std::vector<uint8_t> finish() const;
+};
+
+class reader
+{
+    const uint8_t* base = nullptr;
+    const toc_entry_t* toc = nullptr;
+    header_t hdr = {};
+
+public:
+    bool open(const uint8_t* data, size_t size);
+    uint32_t get_flavor() const;
+    size_t count() const;
+    std::optional<section_t> get(uint32_t index) const;
+    std::optional<section_t> find(section_type type, const std::string& name) const;
+};
+}
@@ -0,0 +1,121 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_share.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace theme_share
+{
+namespace
+{
+/**
+ * Drops a reference to a region, the last instance to detach removes its name
+ * @param region The region
+ */
+void detach(shared_region* region)
+{
+    auto* hdr = reinterpret_cast<header_t*>(region->header());
+
+    if (hdr->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        region->unlink();
+
+    delete region;
+}
+}
+
+/**
+ * Gets the name of the region of a compiled theme
+ * @param flavor The flavor the theme was compiled for
+ * @param key Cache key of the theme's files, see theme_cache::key
+ * @return Region name, the same in every instance that loads the same files
+ */
+std::string region_name(const flavor_info_t& flavor, const uint32_t key)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "vmchroma.theme.%u.%s.%08X", VERSION, flavor.name.c_str(), key);
+    return name;
+}
+
+/**
+ * Attaches to a theme another instance published
+ * @param region An unopened region
+ * @param name Region name
+ * @return The theme pack or nullptr if no complete theme of that name is published
+ */
+std::shared_ptr<const mapped_view> attach(std::unique_ptr<shared_region> region, const std::string& name)
+{
+    if (!region->open(name, HEADER_SIZE))
+        return nullptr;
+
+    auto* hdr = reinterpret_cast<header_t*>(region->header());
+
+    if (std::memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) != 0 || hdr->version != VERSION || hdr->state.load(std::memory_order_acquire) != STATE_READY)
+        return nullptr;
+
+    if (hdr->payload_size == 0 || hdr->payload_size > SIZE_MAX || !region->map_payload(static_cast<size_t>(hdr->payload_size)))
+        return nullptr;
+
+    // a region whose last instance is detaching is about to be unlinked, it must not be revived
+    auto refs = hdr->refs.load(std::memory_order_relaxed);
+
+    do
+    {
+        if (refs == 0)
+            return nullptr;
+    }
+    while (!hdr->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acq_rel));
+
+    return std::shared_ptr<const mapped_view>(region.release(), [](const mapped_view* view) { detach(static_cast<shared_region*>(const_cast<mapped_view*>(view))); });
+}
+
+/**
+ * Publishes a compiled theme for other instances, the caller holds the first reference
+ * @param region An unopened region
+ * @param name Region name
+ * @param pack The theme pack
+ * @return The published theme or nullptr if the name is taken, e.g. by an instance that published it first
+ */
+std::shared_ptr<const mapped_view> publish(std::unique_ptr<shared_region> region, const std::string& name, const std::vector<uint8_t>& pack)
+{
+    if (pack.empty() || !region->create(name, HEADER_SIZE, pack.size()))
+        return nullptr;
+
+    // instances that open the region before it is ready see STATE_WRITING and don't attach
+    auto* hdr = new (region->header()) header_t;
+    std::memcpy(hdr->magic, MAGIC, sizeof(MAGIC));
+    hdr->version = VERSION;
+    hdr->state.store(STATE_WRITING, std::memory_order_relaxed);
+    hdr->refs.store(1, std::memory_order_relaxed);
+    hdr->reserved = 0;
+    hdr->payload_size = pack.size();
+
+    std::memcpy(region->writable_payload(), pack.data(), pack.size());
+
+    if (!region->seal())
+    {
+        region->unlink();
+        return nullptr;
+    }
+
+    hdr->state.store(STATE_READY, std::memory_order_release);
+
+    return std::shared_ptr<const mapped_view>(region.release(), [](const mapped_view* view) { detach(static_cast<shared_region*>(const_cast<mapped_view*>(view))); });
+}
+}
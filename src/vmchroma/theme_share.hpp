@@ -0,0 +1,60 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_view.hpp"
+#include "shared_region.hpp"
+#include "theme_types.hpp"
+
+/**
+ * Publishes a compiled theme in shared memory, so other Voicemeeter instances attach to it instead of compiling it again
+ * The payload is the theme pack as is, whose layout doesn't depend on the pointer size, so the 32 and 64 bit
+ * instances share one region
+ */
+namespace theme_share
+{
+constexpr char MAGIC[8] = {'V', 'M', 'S', 'H', 'A', 'R', 'E', '\0'};
+constexpr uint32_t VERSION = 1;
+// the payload view has to start on the 64 KB allocation granularity of Windows
+constexpr size_t HEADER_SIZE = 65536;
+
+enum region_state : uint32_t { STATE_WRITING, STATE_READY };
+
+typedef struct header
+{
+    char magic[8];
+    uint32_t version;
+    std::atomic<uint32_t> state; // STATE_READY once the payload is complete
+    std::atomic<uint32_t> refs; // attached instances, the name is unlinked when the last one detaches
+    uint32_t reserved;
+    uint64_t payload_size;
+} header_t;
+
+static_assert(sizeof(header_t) == 32 && std::atomic<uint32_t>::is_always_lock_free, "header layout must not depend on the target");
+
+std::string region_name(const flavor_info_t& flavor, uint32_t key);
+std::shared_ptr<const mapped_view> attach(std::unique_ptr<shared_region> region, const std::string& name);
+std::shared_ptr<const mapped_view> publish(std::unique_ptr<shared_region> region, const std::string& name, const std::vector<uint8_t>& pack);
+}
@@ -0,0 +1,64 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "theme_types.hpp"
+
+#include <array>
+
+namespace flavors
+{
+namespace
+{
+const std::array<flavor_info_t, 3> flavor_list = {{
+    {"default", FLAVOR_DEFAULT, 1024, 552, 0, 235, 750},
+    {"banana", FLAVOR_BANANA, 1024, 550, 800, 305, 744},
+    {"potato", FLAVOR_POTATO, 1645, 835, 1050, 340, 1045},
+}};
+}
+
+/**
+ * Gets the bitmap widths and client area of a Voicemeeter flavor
+ * @param id The flavor
+ * @return Flavor info or nullptr for FLAVOR_NONE
+ */
+const flavor_info_t* find(const flavor_id id)
+{
+    for (const auto& f : flavor_list)
+    {
+        if (f.id == id)
+            return &f;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Gets a flavor by the name used for its folder in a theme
+ * @param name default, banana or potato
+ * @return Flavor info or nullptr if the name is unknown
+ */
+const flavor_info_t* find(const std::string& name)
+{
+    for (const auto& f : flavor_list)
+    {
+        if (f.name == name)
+            return &f;
+    }
+
+    return nullptr;
+}
+}
@@ -0,0 +1,50 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// shared by the DLL and the vmtheme compiler, so nothing in here may depend on windows.h
+
+enum flavor_id { FLAVOR_NONE, FLAVOR_DEFAULT, FLAVOR_BANANA, FLAVOR_POTATO };
+
+enum color_category { CATEGORY_TEXT, CATEGORY_SHAPES };
+
+enum bitmap_mode { BITMAP_MODE_REPLACE, BITMAP_MODE_PALETTE };
+
+enum theme_memory { THEME_MEMORY_KEEP, THEME_MEMORY_RELEASE, THEME_MEMORY_COMPRESS };
+
+enum WND_TYPE { WND_TYPE_MAIN, WND_TYPE_COMP_DENOISE, WND_TYPE_WDB };
+
+typedef struct flavor_info
+{
+    std::string name;
+    flavor_id id;
+    uint32_t bitmap_width_main{};
+    uint32_t bitmap_width_settings{};
+    uint32_t bitmap_width_cassette{};
+    uint32_t htclient_x1{};
+    uint32_t htclient_x2{};
+} flavor_info_t;
+
+namespace flavors
+{
+const flavor_info_t* find(flavor_id id);
+const flavor_info_t* find(const std::string& name);
+}
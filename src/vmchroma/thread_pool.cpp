@@ -0,0 +1,68 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "thread_pool.hpp"
+
+/**
+ * @param threads Number of workers, at least one is started
+ */
+thread_pool::thread_pool(const size_t threads)
+{
+    const size_t n = threads > 0 ? threads : 1;
+
+    for (size_t i = 0; i < n; i++)
+        workers.emplace_back(&thread_pool::worker_loop, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard lock(mtx);
+        stopping = true;
+    }
+
+    cv.notify_all();
+
+    for (auto& w : workers)
+        w.join();
+}
+
+size_t thread_pool::size() const
+{
+    return workers.size();
+}
+
+void thread_pool::worker_loop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            if (tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
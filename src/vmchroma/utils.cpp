@@ -122,47 +122,6 @@ std::string colorref_to_hex(const COLORREF color)
     return ss.str();
 }
 
-/**
- * Convert RGB hex string (#RRGGBB) to COLORREF (BBGGRR)
- * See https://learn.microsoft.com/en-us/windows/win32/gdi/colorref
- * @param hex The color as hex string
- * @return The color in COLORREF format
- */
-std::optional<COLORREF> hex_to_colorref(const std::string& hex)
-{
-    if (hex.empty())
-    {
-        SPDLOG_ERROR("empty hex value passed");
-        return std::nullopt;
-    }
-
-    std::string clean_hex = (hex[0] == '#') ? hex.substr(1) : hex;
-
-    if (clean_hex.length() != 6)
-    {
-        SPDLOG_ERROR("invalid value passed: {}", hex);
-        return std::nullopt;
-    }
-
-    unsigned long value = 0;
-
-    try
-    {
-        value = std::stoul(clean_hex, nullptr, 16);
-    }
-    catch (...)
-    {
-        SPDLOG_ERROR("invalid hex value passed: {}", clean_hex);
-        return std::nullopt;
-    }
-
-    const uint8_t r = (value >> 16) & 0xFF;
-    const uint8_t g = (value >> 8) & 0xFF;
-    const uint8_t b = value & 0xFF;
-
-    return RGB(r, g, b);
-}
-
 /**
  * Find non-exported functions using signature scanning
  * Function signatures should be stable across updates
@@ -214,35 +173,6 @@ std::optional<PVOID> find_function_signature(const signature_t& sig)
     return std::nullopt;
 }
 
-/**
- * Loads the bitmap file from the specified path
- * @param path Path to bitmap
- * @param target Target buffer
- * @return True on success
- */
-bool load_bitmap(const std::wstring& path, std::vector<uint8_t>& target)
-{
-    std::ifstream f(path.c_str(), std::ios::binary | std::ios::ate);
-
-    if (!f.is_open())
-    {
-        SPDLOG_ERROR("failed to open file {}", *wstr_to_str(path));
-        return false;
-    }
-
-    const auto size = f.tellg();
-    f.seekg(0, std::ios::beg);
-    target.assign(size, '\0');
-
-    if (!f.read(reinterpret_cast<char*>(target.data()), size))
-    {
-        SPDLOG_ERROR("failed to read file {}", *wstr_to_str(path));
-        return false;
-    }
-
-    return true;
-}
-
 /**
  * Gets the path to the Voicemeeter user directory
  * @return Path to VM directory
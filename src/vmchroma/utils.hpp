@@ -23,6 +23,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <spdlog/spdlog.h>
 
+#include "theme_types.hpp"
+
 #if defined(_WIN64)
 #define ARCH_CALL __fastcall
 #else
@@ -35,21 +37,6 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define WNDPROC_SUB_CALL __cdecl
 #endif
 
-const enum flavor_id { FLAVOR_NONE, FLAVOR_DEFAULT, FLAVOR_BANANA, FLAVOR_POTATO };
-
-const enum color_category { CATEGORY_TEXT, CATEGORY_SHAPES };
-
-typedef struct flavor_info
-{
-    std::string name;
-    flavor_id id;
-    uint32_t bitmap_width_main{};
-    uint32_t bitmap_width_settings{};
-    uint32_t bitmap_width_cassette{};
-    uint32_t htclient_x1{};
-    uint32_t htclient_x2{};
-} flavor_info_t;
-
 typedef struct createwindowexa_lparam
 {
     HWND hwnd;
@@ -87,9 +74,7 @@ void attach_console_debug();
 std::optional<std::wstring> str_to_wstr(const std::string&);
 std::optional<std::string> wstr_to_str(const std::wstring&);
 std::string colorref_to_hex(COLORREF);
-std::optional<COLORREF> hex_to_colorref(const std::string&);
 std::optional<PVOID> find_function_signature(const signature_t&);
-bool load_bitmap(const std::wstring&, std::vector<uint8_t>&);
 std::optional<std::wstring> get_userprofile_path();
 void setup_logging();
 bool apply_scroll_patch64(o_scroll_handler_t);
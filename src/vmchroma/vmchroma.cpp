@@ -18,6 +18,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <windows.h>
 #include <windowsx.h>
 #include <detours.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <optional>
 #include <vector>
@@ -31,6 +35,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "winapi_hook_defs.hpp"
 #include "window_manager.hpp"
 #include "config_manager.hpp"
+#include "gdi_cache.hpp"
+#include "frame_scheduler.hpp"
+#include "bitmap_recolor.hpp"
+#include "bmp_decoder.hpp"
+#include "color_census.hpp"
+#include "pixel_hash.hpp"
 
 //******************//
 //      WINAPI      //
@@ -41,6 +51,8 @@ HFONT (WINAPI *o_CreateFontIndirectA)(const LOGFONTA* lplf) = CreateFontIndirect
 BOOL (WINAPI *o_AppendMenuA)(HMENU hMenu, UINT uFlags, UINT_PTR uIDNewItem, LPCSTR lpNewItem) = AppendMenuA;
 HPEN (WINAPI *o_CreatePen)(int iStyle, int cWidth, COLORREF color) = CreatePen;
 HBRUSH (WINAPI *o_CreateBrushIndirect)(const LOGBRUSH* plbrush) = CreateBrushIndirect;
+BOOL (WINAPI *o_DeleteObject)(HGDIOBJ ho) = DeleteObject;
+HGDIOBJ (WINAPI *o_SelectObject)(HDC hdc, HGDIOBJ h) = SelectObject;
 COLORREF (WINAPI *o_SetTextColor)(HDC hdc, COLORREF color) = SetTextColor;
 ATOM (WINAPI *o_RegisterClassA)(const WNDCLASSA* lpWndClass) = RegisterClassA;
 BOOL (WINAPI *o_Rectangle)(HDC hdc, int left, int top, int right, int bottom) = Rectangle;
@@ -64,6 +76,38 @@ static signature_t sig_handle_scroll = {{0x48, 0x89, 0x74, 0x24, 0x20, 0x41, 0x5
 std::unique_ptr<window_manager> wm;
 std::unique_ptr<config_manager> cm;
 
+/**
+ * Creates the pens and brushes for the gdi object cache with the original GDI functions
+ */
+class gdi_backend_win final : public gdi_backend
+{
+public:
+    void* create(const gdi_object_key_t& key) override
+    {
+        if (key.kind == GDI_OBJECT_PEN)
+            return o_CreatePen(static_cast<int>(key.style), static_cast<int>(key.param), key.color);
+
+        const LOGBRUSH lb = {key.style, key.color, key.param};
+        return o_CreateBrushIndirect(&lb);
+    }
+
+    bool destroy(void* handle) override
+    {
+        return o_DeleteObject(handle);
+    }
+};
+
+static constexpr size_t GDI_CACHE_CAPACITY = 512;
+static gdi_backend_win gdi_backend_default;
+std::unique_ptr<gdi_cache> gdi_objects;
+static constexpr std::chrono::seconds COLOR_STATS_INTERVAL(10);
+static constexpr std::wstring_view COLOR_STATS_FILE = L"vmchroma_color_stats.yaml";
+std::unique_ptr<color_census> census;
+static constexpr uint32_t FRAME_INTERVAL_MAX_MS = 16;
+static constexpr UINT_PTR FRAME_FLUSH_TIMER_ID = 12347;
+static steady_frame_clock frame_clock_default;
+std::unique_ptr<frame_scheduler> frames;
+
 static std::unordered_map<long, long> font_height_map = {
     {20, 18}, // input custom label
     {16, 15} // master section fader
@@ -77,6 +121,161 @@ static o_WndProc_chldwnd_t o_WndProc_denoiser = nullptr;
 static o_WndProc_chldwnd_t o_WndProc_wdb = nullptr;
 static HMENU tray_menu = nullptr;
 
+typedef struct pending_dib
+{
+    HBITMAP handle;
+    uint8_t* bits;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    bool top_down;
+    bool recolor; // palette mode background, recolored unless a sprite replaces it
+} pending_dib_t;
+
+// DIBs that Voicemeeter still has to fill before they can be recolored or fingerprinted for a sprite
+// GDI objects are created and deleted from any thread, the count lets SelectObject skip the lock
+static std::vector<pending_dib_t> pending_dibs;
+static std::mutex pending_dibs_mtx;
+static std::atomic<size_t> pending_dib_count = 0;
+// set from the hooks, so atomic like the pending DIB count
+// direct_mapping is cleared if GDI refuses a DIB section backed by a theme file, all bitmaps are copied after that
+static std::atomic<bool> direct_mapping = true;
+static std::atomic<bool> theme_error_shown = false;
+static std::atomic<bool> prefetch_requested = false;
+static theme_memory theme_memory_policy = THEME_MEMORY_KEEP;
+
+/**
+ * Marks the window whose wndproc is running for the lifetime of the scope
+ * Child wndprocs can run nested inside the main wndproc, the previous window is restored on exit
+ */
+typedef struct wnd_type_scope
+{
+    WND_TYPE prev;
+
+    explicit wnd_type_scope(const WND_TYPE type) : prev(wm->set_active_wnd_type(type))
+    {
+    }
+
+    ~wnd_type_scope()
+    {
+        wm->set_active_wnd_type(prev);
+    }
+} wnd_type_scope_t;
+
+/**
+ * Renders a window now, or leaves it to the frame scheduler to present it together with the changes that follow
+ * @param hwnd The window
+ * @param reason What changed the window
+ */
+static void request_frame(HWND hwnd, const frame_reason reason)
+{
+    const auto window = reinterpret_cast<uintptr_t>(hwnd);
+
+    if (!frames || frames->request(window, reason))
+    {
+        wm->render(hwnd);
+        return;
+    }
+
+    // Voicemeeter's timer can tick slower than the frame interval, this timer presents the changes at the deadline
+    if (const auto delay_us = frames->arm_flush(window))
+        o_SetTimer(hwnd, FRAME_FLUSH_TIMER_ID, static_cast<UINT>(std::max<uint64_t>(USER_TIMER_MINIMUM, *delay_us / 1000 + 1)), nullptr);
+}
+
+/**
+ * Presents a deferred frame when its flush timer fires
+ * @param hwnd The window
+ */
+static void flush_frame(HWND hwnd)
+{
+    KillTimer(hwnd, FRAME_FLUSH_TIMER_ID);
+
+    if (!frames)
+        return;
+
+    frames->disarm_flush(reinterpret_cast<uintptr_t>(hwnd));
+
+    if (frames->is_dirty(reinterpret_cast<uintptr_t>(hwnd)))
+        request_frame(hwnd, FRAME_TIMER);
+}
+
+/**
+ * Checks whether a frame of the window would be presented now
+ * Synthetic timer messages are only sent then, Voicemeeter redraws the whole window in its timer handler
+ * @param hwnd The window
+ * @return True if the window is due or there is no frame scheduler
+ */
+static bool frame_due(HWND hwnd)
+{
+    return !frames || frames->is_due(reinterpret_cast<uintptr_t>(hwnd));
+}
+
+/**
+ * Joins the theme loader, the first call blocks until colors.yaml and the backgrounds are loaded
+ * A theme that failed to load is reported once and leaves the hooked calls unchanged
+ * @return True if the theme can be used
+ */
+static bool theme_ready()
+{
+    if (cm->wait_theme())
+        return true;
+
+    if (!theme_error_shown.exchange(true))
+    {
+        SPDLOG_ERROR("failed to init theme");
+        utils::mbox_error(L"failed to init theme, check error log for more details");
+    }
+
+    return false;
+}
+
+/**
+ * Queues a DIB to be recolored or fingerprinted once Voicemeeter has filled it
+ * @param dib The DIB
+ */
+static void queue_pending_dib(const pending_dib_t& dib)
+{
+    std::lock_guard lock(pending_dibs_mtx);
+    pending_dibs.push_back(dib);
+    pending_dib_count = pending_dibs.size();
+}
+
+/**
+ * Removes a DIB from the queue
+ * @param handle Any GDI object handle
+ * @return The queued DIB or nullopt if the handle wasn't queued
+ */
+static std::optional<pending_dib_t> take_pending_dib(HGDIOBJ handle)
+{
+    if (pending_dib_count == 0)
+        return std::nullopt;
+
+    std::lock_guard lock(pending_dibs_mtx);
+    const auto it = std::find_if(pending_dibs.begin(), pending_dibs.end(), [handle](const pending_dib_t& dib) { return dib.handle == handle; });
+
+    if (it == pending_dibs.end())
+        return std::nullopt;
+
+    const auto dib = *it;
+    pending_dibs.erase(it);
+    pending_dib_count = pending_dibs.size();
+
+    return dib;
+}
+
+/**
+ * Finds the window a color is drawn in, by memory DC if there is one, otherwise by the running wndproc
+ * @param hdc The device context or nullptr for pens and brushes
+ * @return The window type
+ */
+static WND_TYPE resolve_wnd_type(HDC hdc)
+{
+    if (!cm->has_window_colors())
+        return WND_TYPE_MAIN;
+
+    return wm->resolve_wnd_type(hdc);
+}
+
 bool apply_hooks();
 
 //*****************************//
@@ -106,6 +305,9 @@ HANDLE WINAPI hk_CreateMutexA(LPSECURITY_ATTRIBUTES lpMutexAttributes, BOOL bIni
             return o_CreateMutexA(lpMutexAttributes, bInitialOwner, lpName);
         }
 
+        if (const auto log_level = cm->cfg_get_log_level())
+            spdlog::set_level(*log_level);
+
         if (!cm->init_theme())
         {
             SPDLOG_ERROR("failed to init theme");
@@ -113,6 +315,34 @@ HANDLE WINAPI hk_CreateMutexA(LPSECURITY_ATTRIBUTES lpMutexAttributes, BOOL bIni
             return o_CreateMutexA(lpMutexAttributes, bInitialOwner, lpName);
         }
 
+        // the getters log invalid values, the setting keeps its default then, like restoreSize and the scroll steps
+        wm->set_color_grade(cm->cfg_get_grade_settings().value_or(grade_settings_t{}));
+        wm->set_mip_scaling(cm->cfg_get_mip_scaling().value_or(false));
+        wm->set_texture_ring_size(cm->cfg_get_texture_ring().value_or(1));
+        wm->set_damage_tracking(cm->cfg_get_damage_tracking().value_or(false));
+        wm->set_software_rendering(cm->cfg_get_software_rendering().value_or(false));
+        wm->set_scaling_filter(cm->cfg_get_scaling_filter().value_or(FRAME_FILTER_HQ_CUBIC));
+        wm->set_layered_compositing(cm->cfg_get_layered_compositing().value_or(true));
+        theme_memory_policy = cm->cfg_get_theme_memory().value_or(THEME_MEMORY_KEEP);
+
+        if (cm->cfg_get_frame_scheduling().value_or(false))
+        {
+            const auto interval_ms = std::clamp(cm->cfg_get_ui_update_interval().value_or(FRAME_INTERVAL_MAX_MS), 1u, FRAME_INTERVAL_MAX_MS);
+            frames = std::make_unique<frame_scheduler>(frame_clock_default, interval_ms * 1000);
+        }
+
+        if (cm->get_theme_enabled() && cm->cfg_get_gdi_object_cache().value_or(false))
+            gdi_objects = std::make_unique<gdi_cache>(gdi_backend_default, GDI_CACHE_CAPACITY);
+
+        if (cm->get_theme_enabled() && cm->cfg_get_color_stats().value_or(false))
+        {
+            if (const auto userprofile_path = utils::get_userprofile_path())
+            {
+                census = std::make_unique<color_census>(std::vector<std::string>{"text", "shapes"});
+                census->start_writer(std::filesystem::path(*userprofile_path) / L"themes" / COLOR_STATS_FILE, COLOR_STATS_INTERVAL);
+            }
+        }
+
         if (!apply_hooks())
         {
             SPDLOG_ERROR("hooking failed");
@@ -162,16 +392,21 @@ BOOL WINAPI hk_AppendMenuA(HMENU hMenu, UINT uFlags, UINT_PTR uIDNewItem, LPCSTR
 /**
  * GDI function used to draw lines
  * We hook this function to change the color of UI elements made up of lines
- * Color values are parsed from the colors.yaml
+ * Color values are looked up in the tables compiled from colors.yaml
  * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-createpen
  */
 HPEN WINAPI hk_CreatePen(int iStyle, int cWidth, COLORREF color)
 {
-    if (const auto new_col_opt = cm->cfg_get_color(utils::colorref_to_hex(color), CATEGORY_SHAPES))
-    {
-        if (const auto new_col = utils::hex_to_colorref(*new_col_opt))
-            color = *new_col;
-    }
+    const auto new_col = theme_ready() ? cm->cfg_get_color(color, CATEGORY_SHAPES, resolve_wnd_type(nullptr)) : std::nullopt;
+
+    if (census)
+        census->record(color, CATEGORY_SHAPES, new_col.has_value());
+
+    if (new_col)
+        color = *new_col;
+
+    if (gdi_objects && iStyle != PS_NULL)
+        return static_cast<HPEN>(gdi_objects->acquire({GDI_OBJECT_PEN, static_cast<uint32_t>(iStyle), static_cast<uintptr_t>(cWidth), color}));
 
     return o_CreatePen(iStyle, cWidth, color);
 }
@@ -179,33 +414,61 @@ HPEN WINAPI hk_CreatePen(int iStyle, int cWidth, COLORREF color)
 /**
  * GDI function used to draw forms like filled rectangles
  * We hook this function to change the color of UI elements made up of such forms
- * Color values are parsed from the colors.yaml
+ * Color values are looked up in the tables compiled from colors.yaml
  * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-createbrushindirect
  */
 HBRUSH WINAPI hk_CreateBrushIndirect(LOGBRUSH* plbrush)
 {
-    if (const auto new_col_opt = cm->cfg_get_color(utils::colorref_to_hex(plbrush->lbColor), CATEGORY_SHAPES))
+    const auto new_col = theme_ready() ? cm->cfg_get_color(plbrush->lbColor, CATEGORY_SHAPES, resolve_wnd_type(nullptr)) : std::nullopt;
+
+    if (census)
+        census->record(plbrush->lbColor, CATEGORY_SHAPES, new_col.has_value());
+
+    if (new_col)
+        plbrush->lbColor = *new_col;
+
+    // pattern brushes reference a bitmap owned by the application and are never shared
+    // GDI ignores lbHatch of solid brushes, so whatever is left in it must not split the cache entries
+    if (gdi_objects && (plbrush->lbStyle == BS_SOLID || plbrush->lbStyle == BS_HATCHED))
     {
-        if (const auto new_col = utils::hex_to_colorref(*new_col_opt))
-            plbrush->lbColor = *new_col;
+        const ULONG_PTR hatch = plbrush->lbStyle == BS_SOLID ? 0 : plbrush->lbHatch;
+        return static_cast<HBRUSH>(gdi_objects->acquire({GDI_OBJECT_BRUSH, plbrush->lbStyle, hatch, plbrush->lbColor}));
     }
 
     return o_CreateBrushIndirect(plbrush);
 }
 
+/**
+ * Deletes a GDI object
+ * We hook this function so that pens and brushes handed out by the gdi object cache are never actually freed
+ * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-deleteobject
+ */
+BOOL WINAPI hk_DeleteObject(HGDIOBJ ho)
+{
+    if (gdi_objects && gdi_objects->release(ho))
+        return TRUE;
+
+    // bitmaps deleted before they were ever selected
+    take_pending_dib(ho);
+
+    return o_DeleteObject(ho);
+}
+
 /**
  * GDI function used to set the color of text
  * We hook this function to change text color
- * Color values are parsed from the colors.yaml
+ * Color values are looked up in the tables compiled from colors.yaml
  * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-settextcolor
  */
 COLORREF WINAPI hk_SetTextColor(HDC hdc, COLORREF color)
 {
-    if (const auto new_col_opt = cm->cfg_get_color(utils::colorref_to_hex(color), CATEGORY_TEXT))
-    {
-        if (const auto new_col = utils::hex_to_colorref(*new_col_opt))
-            color = *new_col;
-    }
+    const auto new_col = theme_ready() ? cm->cfg_get_color(color, CATEGORY_TEXT, resolve_wnd_type(hdc)) : std::nullopt;
+
+    if (census)
+        census->record(color, CATEGORY_TEXT, new_col.has_value());
+
+    if (new_col)
+        color = *new_col;
 
     return o_SetTextColor(hdc, color);
 }
@@ -282,31 +545,157 @@ void ARCH_CALL hk_scroll_handler(uint64_t* a1, HWND hwnd, uint32_t x, uint32_t y
 /**
  * Provides a pointer to a buffer for the loaded bitmaps
  * We hook this function in order to write our own background bitmaps to the buffer
+ * In palette mode the original bitmaps are kept and recolored instead, see hk_SelectObject
  * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-createdibsection
  */
 HBITMAP WINAPI hk_CreateDIBSection(HDC hdc, BITMAPINFO* pbmi, UINT usage, void** ppvBits, HANDLE hSection, DWORD offset)
 {
+    const auto& af = cm->get_active_flavor();
+    const auto width = static_cast<uint32_t>(pbmi->bmiHeader.biWidth);
+    const bool is_theme_bitmap = width == af.bitmap_width_main || width == af.bitmap_width_settings || width == af.bitmap_width_cassette;
+
+    if (is_theme_bitmap && !theme_ready())
+        return o_CreateDIBSection(hdc, pbmi, usage, ppvBits, hSection, offset);
+
+    if (is_theme_bitmap && cm->get_bitmap_mode() == BITMAP_MODE_PALETTE)
+    {
+        const auto& header = pbmi->bmiHeader;
+        const auto& map = cm->get_color_map(CATEGORY_SHAPES);
+
+        // palette based bitmaps only need their color table recolored
+        if (const uint32_t colors = bitmap_recolor::palette_size(header.biBitCount, header.biClrUsed); colors != 0 && usage == DIB_RGB_COLORS)
+        {
+            std::vector<uint8_t> bmi(header.biSize + colors * sizeof(RGBQUAD));
+            memcpy(bmi.data(), pbmi, bmi.size());
+
+            bitmap_recolor::apply(bmi.data() + header.biSize, colors, 1, colors * sizeof(RGBQUAD), 32, map);
+
+            return o_CreateDIBSection(hdc, reinterpret_cast<BITMAPINFO*>(bmi.data()), usage, ppvBits, hSection, offset);
+        }
+
+        const auto bm_handle = o_CreateDIBSection(hdc, pbmi, usage, ppvBits, hSection, offset);
+
+        if (bm_handle != nullptr && ppvBits != nullptr && *ppvBits != nullptr && header.biCompression == BI_RGB && bitmap_recolor::is_supported(header.biBitCount))
+            queue_pending_dib({bm_handle, static_cast<uint8_t*>(*ppvBits), width, static_cast<uint32_t>(abs(header.biHeight)), header.biBitCount, header.biHeight < 0, true});
+
+        return bm_handle;
+    }
+
     void* ppvBits_new = nullptr;
-    const uint8_t* bm_data = nullptr;
+    theme_asset* bm_data = nullptr;
+
+    if (width == af.bitmap_width_main)
+        bm_data = cm->get_bm_data_main();
+    else if (width == af.bitmap_width_settings)
+        bm_data = cm->get_bm_data_settings();
+    else if (width == af.bitmap_width_cassette)
+        bm_data = cm->get_bm_data_cassette();
 
-    if (pbmi->bmiHeader.biWidth == cm->get_active_flavor().bitmap_width_main)
-        bm_data = cm->get_bm_data_main().data();
-    else if (pbmi->bmiHeader.biWidth == cm->get_active_flavor().bitmap_width_settings)
-        bm_data = cm->get_bm_data_settings().data();
-    else if (pbmi->bmiHeader.biWidth == cm->get_active_flavor().bitmap_width_cassette)
-        bm_data = cm->get_bm_data_cassette().data();
+    // a trimmed background is decompressed or reloaded here
+    if (bm_data != nullptr && !bm_data->acquire())
+        bm_data = nullptr;
 
-    if (bm_data != nullptr)
+    const auto& header = pbmi->bmiHeader;
+    const auto bm_info = bm_data != nullptr ? bmp_decoder::parse(bm_data->data(), bm_data->size()) : std::nullopt;
+
+    // the theme bitmap is decoded into exactly the layout Voicemeeter asked for, anything else keeps the original bitmap
+    if (bm_info && header.biCompression == BI_RGB && header.biPlanes == 1)
     {
-        const auto bm_offset = reinterpret_cast<const BITMAPFILEHEADER*>(bm_data)->bfOffBits;
+        const dib_layout_t layout = {width, static_cast<uint32_t>(abs(header.biHeight)), header.biHeight < 0, header.biBitCount};
+
+        // software rendering keeps the main background scaled and only scales what Voicemeeter draws over it
+        // the layer is decoded once, Voicemeeter may create the main bitmap again at the same size
+        if (width == af.bitmap_width_main && wm->is_software_rendering() && wm->is_layered_compositing() && !wm->has_background(WND_TYPE_MAIN, layout.width, layout.height))
+        {
+            std::vector<uint8_t> background(static_cast<size_t>(layout.width) * layout.height * 4);
+
+            if (bmp_decoder::convert(bm_data->data(), bm_data->size(), *bm_info, background.data(), {layout.width, layout.height, true, 32}))
+                wm->set_background(WND_TYPE_MAIN, layout.width, layout.height, std::move(background));
+        }
+
+        // stored pixels already in the requested layout, back the bitmap with the file instead of copying it
+        // decoded png and qoi themes have no section and are always copied
+        if (direct_mapping && hSection == nullptr && bm_data->get_section() != nullptr && bmp_decoder::is_direct_mappable(*bm_info, bm_data->size(), layout, bm_data->get_section_offset()))
+        {
+            if (const auto bm_handle = o_CreateDIBSection(hdc, pbmi, usage, &ppvBits_new, bm_data->get_section(), static_cast<DWORD>(bm_data->get_section_offset() + bm_info->pixel_offset)))
+                return bm_handle;
+
+            SPDLOG_WARN("file-backed bitmap rejected: {}, copying theme bitmaps instead", GetLastError());
+            direct_mapping = false;
+        }
+
         const auto bm_handle = o_CreateDIBSection(hdc, pbmi, usage, &ppvBits_new, hSection, offset);
+        const bool filled = bm_handle != nullptr && bmp_decoder::convert(bm_data->data(), bm_data->size(), *bm_info, static_cast<uint8_t*>(ppvBits_new), layout);
 
-        memcpy(ppvBits_new, &bm_data[bm_offset], pbmi->bmiHeader.biSizeImage);
+        // the pixels live in the DIB now, the theme's copy is only needed again if Voicemeeter recreates the bitmap
+        bm_data->trim(theme_memory_policy);
+        cm->log_theme_memory();
 
-        return bm_handle;
+        if (filled)
+            return bm_handle;
+
+        SPDLOG_ERROR("theme bitmap doesn't match the requested {}x{} {} bpp bitmap", layout.width, layout.height, layout.bpp);
+
+        if (bm_handle != nullptr)
+            o_DeleteObject(bm_handle);
     }
 
-    return o_CreateDIBSection(hdc, pbmi, usage, ppvBits, hSection, offset);
+    const auto bm_handle = o_CreateDIBSection(hdc, pbmi, usage, ppvBits, hSection, offset);
+    const auto height = static_cast<uint32_t>(abs(header.biHeight));
+
+    // sprites are recognized by the pixels Voicemeeter draws into the bitmap, see hk_SelectObject
+    // at debug level every bitmap is fingerprinted so theme authors can find the hashes
+    if (bm_handle != nullptr && ppvBits != nullptr && *ppvBits != nullptr && header.biCompression == BI_RGB && bitmap_recolor::is_supported(header.biBitCount)
+        && theme_ready() && (cm->is_sprite_size(width, height, header.biBitCount) || spdlog::should_log(spdlog::level::debug)))
+        queue_pending_dib({bm_handle, static_cast<uint8_t*>(*ppvBits), width, height, header.biBitCount, header.biHeight < 0, false});
+
+    return bm_handle;
+}
+
+/**
+ * Replaces the pixels of a filled DIB if its fingerprint is listed in the theme's sprites.yaml
+ * The fingerprint is logged at debug level, which is how theme authors find the values for the manifest
+ * @param dib The DIB, already filled by Voicemeeter
+ * @return True if the DIB now holds the sprite
+ */
+static bool replace_sprite(const pending_dib_t& dib)
+{
+    const auto stride = bitmap_recolor::dib_stride(dib.width, dib.bpp);
+    const sprite_key_t key = {dib.width, dib.height, dib.bpp, pixel_hash::dib(dib.bits, dib.width, dib.height, stride, dib.bpp)};
+
+    SPDLOG_DEBUG("bitmap {}x{} {} bpp hash {:08X}", key.width, key.height, key.bpp, key.hash);
+
+    const auto replaced = cm->fill_sprite(key, dib.bits, dib.top_down, theme_memory_policy);
+
+    if (!replaced)
+        return false;
+
+    if (!*replaced)
+        SPDLOG_ERROR("sprite for hash {:08X} doesn't match the {}x{} {} bpp bitmap", key.hash, key.width, key.height, key.bpp);
+
+    return *replaced;
+}
+
+/**
+ * Selects an object into a device context
+ * Voicemeeter fills its bitmaps right after creating them and selects them into a DC before the first blit,
+ * so this is where queued bitmaps get replaced by sprites or recolored in palette mode, once per bitmap
+ * See https://learn.microsoft.com/en-us/windows/win32/api/wingdi/nf-wingdi-selectobject
+ */
+HGDIOBJ WINAPI hk_SelectObject(HDC hdc, HGDIOBJ h)
+{
+    if (const auto dib = take_pending_dib(h))
+    {
+        GdiFlush();
+
+        if (!replace_sprite(*dib) && dib->recolor)
+        {
+            const auto stride = bitmap_recolor::dib_stride(dib->width, dib->bpp);
+            bitmap_recolor::apply(dib->bits, dib->width, dib->height, stride, dib->bpp, cm->get_color_map(CATEGORY_SHAPES));
+        }
+    }
+
+    return o_SelectObject(hdc, h);
 }
 
 /**
@@ -431,16 +820,24 @@ BOOL WINAPI hk_TrackPopupMenu(HMENU hMenu, UINT uFlags, int x, int y, int nReser
  */
 LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    const wnd_type_scope_t scope(WND_TYPE_MAIN);
+
     if (msg == WM_COMMAND && LOWORD(wParam) == 0x1337)
         ShellExecuteW(nullptr, L"open", L"https://github.com/emkaix/voicemeeter-chroma", nullptr, nullptr, SW_SHOW);
 
     if (msg == WM_TIMER && wParam == 12346)
     {
         const auto ret = o_WndProc_main(hwnd, msg, wParam, lParam);
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_TIMER);
         return ret;
     }
 
+    if (msg == WM_TIMER && wParam == FRAME_FLUSH_TIMER_ID)
+    {
+        flush_frame(hwnd);
+        return 0;
+    }
+
     if (msg == WM_DISPLAYCHANGE)
     {
         const auto& wctx = wm->get_wctx(hwnd);
@@ -458,7 +855,7 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
         const auto ret = o_WndProc_main(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y));
 
         if (msg == WM_LBUTTONDOWN || msg == WM_LBUTTONDBLCLK || msg == WM_LBUTTONUP)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_INPUT);
 
         return ret;
     }
@@ -475,7 +872,7 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
 
         const auto ret = o_WndProc_main(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y));
 
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_INPUT);
 
         return ret;
     }
@@ -488,9 +885,14 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
 
         const auto ret = o_WndProc_main(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y));
 
-        // keep db meters from being visually stuck
+        // keep db meters from being visually stuck, mouse moves arrive far faster than frames are presented
         if (wParam & MK_LBUTTON)
-            SendMessageA(hwnd, WM_TIMER, 12346, 0);
+        {
+            if (frame_due(hwnd))
+                SendMessageA(hwnd, WM_TIMER, 12346, 0);
+            else
+                request_frame(hwnd, FRAME_DRAG);
+        }
 
         return ret;
     }
@@ -607,10 +1009,10 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
         const auto rect = reinterpret_cast<RECT*>(lParam);
 
         int new_width = rect->right - rect->left;
-        new_width = max(wctx.default_cx / 2, min(wctx.default_cx, new_width));
+        new_width = std::clamp(new_width, wctx.default_cx / 2, wctx.default_cx);
 
         int new_height = MulDiv(new_width, wctx.default_cy, wctx.default_cx);
-        new_height = max(wctx.default_cy / 2, min(wctx.default_cy, new_height));
+        new_height = std::clamp(new_height, wctx.default_cy / 2, wctx.default_cy);
 
         rect->right = rect->left + new_width;
         rect->bottom = rect->top + new_height;
@@ -619,7 +1021,10 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
 
         wm->resize_child_windows();
 
-        SendMessageA(hwnd, WM_TIMER, 12346, 0);
+        if (frame_due(hwnd))
+            SendMessageA(hwnd, WM_TIMER, 12346, 0);
+        else
+            request_frame(hwnd, FRAME_DRAG);
 
         return 1;
     }
@@ -639,9 +1044,18 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
     {
         const auto ret = o_WndProc_main(hwnd, msg, wParam, lParam);
 
-        SendMessageA(hwnd, WM_TIMER, 12346, 0);
+        // the timer handler redraws the meters and presents the frame
+        if (frame_due(hwnd))
+            SendMessageA(hwnd, WM_TIMER, 12346, 0);
+        else
+            request_frame(hwnd, FRAME_PAINT);
 
-        wm->render(hwnd);
+        // the main window is up, the other backgrounds can be decoded without delaying startup
+        if (!prefetch_requested.exchange(true))
+        {
+            if (cm->get_theme_enabled() && cm->cfg_get_prefetch_backgrounds().value_or(false))
+                cm->prefetch_backgrounds();
+        }
 
         return ret;
     }
@@ -665,6 +1079,24 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
         if (rc.right > 0 && rc.right <= wctx.default_cx && rc.bottom > 0 && rc.bottom <= wctx.default_cy)
             cm->reg_save_wnd_size(rc.right, rc.bottom);
 
+        if (census)
+            census->stop_writer();
+
+        if (gdi_objects)
+        {
+            const auto stats = gdi_objects->get_stats();
+            SPDLOG_INFO("gdi object cache: {} hits, {} misses, {} evictions, {} live handles, {} referenced",
+                        stats.hits, stats.misses, stats.evictions, stats.live_handles, stats.referenced_handles);
+        }
+
+        if (frames)
+        {
+            const auto stats = frames->get_stats();
+            SPDLOG_INFO("frame scheduler: {} requests, {} presented, {} coalesced, {} forced by input",
+                        stats.requests, stats.presented, stats.coalesced, stats.input_forced);
+            frames->forget(reinterpret_cast<uintptr_t>(hwnd));
+        }
+
         wm->destroy_window(hwnd);
     }
 
@@ -677,6 +1109,8 @@ LRESULT ARCH_CALL hk_WndProc_main(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
  */
 LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, uint64_t a5)
 {
+    const wnd_type_scope_t scope(WND_TYPE_COMP_DENOISE);
+
     if (msg == WM_CREATE)
     {
         const auto cs = reinterpret_cast<CREATESTRUCTA*>(lParam);
@@ -697,14 +1131,21 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPA
     {
         const auto ret = o_WndProc_comp(hwnd, msg, wParam, lParam, a5);
 
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_PAINT);
 
         return ret;
     }
 
     if (msg == WM_TIMER && wParam == 12346)
     {
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_TIMER);
+
+        return 0;
+    }
+
+    if (msg == WM_TIMER && wParam == FRAME_FLUSH_TIMER_ID)
+    {
+        flush_frame(hwnd);
 
         return 0;
     }
@@ -717,7 +1158,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPA
         const auto ret = o_WndProc_comp(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (msg == WM_LBUTTONDOWN || msg == WM_LBUTTONDBLCLK || msg == WM_LBUTTONUP)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_INPUT);
 
         return ret;
     }
@@ -731,7 +1172,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPA
         const auto ret = o_WndProc_comp(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (wParam & MK_LBUTTON)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_DRAG);
 
         return ret;
     }
@@ -740,6 +1181,9 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPA
     {
         const auto ret = o_WndProc_comp(hwnd, msg, wParam, lParam, a5);
 
+        if (frames)
+            frames->forget(reinterpret_cast<uintptr_t>(hwnd));
+
         wm->destroy_window(hwnd);
 
         return ret;
@@ -761,6 +1205,8 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_comp(HWND hwnd, UINT msg, WPARAM wParam, LPA
  */
 LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, uint64_t a5)
 {
+    const wnd_type_scope_t scope(WND_TYPE_COMP_DENOISE);
+
     if (msg == WM_CREATE)
     {
         const auto cs = reinterpret_cast<CREATESTRUCTA*>(lParam);
@@ -779,7 +1225,14 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
 
     if (msg == WM_TIMER && wParam == 12346)
     {
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_TIMER);
+
+        return 0;
+    }
+
+    if (msg == WM_TIMER && wParam == FRAME_FLUSH_TIMER_ID)
+    {
+        flush_frame(hwnd);
 
         return 0;
     }
@@ -788,7 +1241,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
     {
         const auto ret = o_WndProc_denoiser(hwnd, msg, wParam, lParam, a5);
 
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_PAINT);
 
         return ret;
     }
@@ -801,7 +1254,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
         const auto ret = o_WndProc_denoiser(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (msg == WM_LBUTTONDOWN || msg == WM_LBUTTONDBLCLK || msg == WM_LBUTTONUP)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_INPUT);
 
         return ret;
     }
@@ -815,7 +1268,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
         auto ret = o_WndProc_denoiser(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (wParam & MK_LBUTTON)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_DRAG);
 
         return ret;
     }
@@ -824,6 +1277,9 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
     {
         const auto ret = o_WndProc_denoiser(hwnd, msg, wParam, lParam, a5);
 
+        if (frames)
+            frames->forget(reinterpret_cast<uintptr_t>(hwnd));
+
         wm->destroy_window(hwnd);
 
         return ret;
@@ -845,11 +1301,13 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_denoiser(HWND hwnd, UINT msg, WPARAM wParam,
  */
 LRESULT WNDPROC_SUB_CALL hk_WndProc_wdb(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, uint64_t a5)
 {
+    const wnd_type_scope_t scope(WND_TYPE_WDB);
+
     if (msg == WM_PAINT)
     {
         const auto ret = o_WndProc_wdb(hwnd, msg, wParam, lParam, a5);
 
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_PAINT);
 
         return ret;
     }
@@ -879,7 +1337,14 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_wdb(HWND hwnd, UINT msg, WPARAM wParam, LPAR
 
     if (msg == WM_TIMER && wParam == 12346)
     {
-        wm->render(hwnd);
+        request_frame(hwnd, FRAME_TIMER);
+
+        return 0;
+    }
+
+    if (msg == WM_TIMER && wParam == FRAME_FLUSH_TIMER_ID)
+    {
+        flush_frame(hwnd);
 
         return 0;
     }
@@ -892,7 +1357,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_wdb(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         const auto ret = o_WndProc_wdb(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (msg == WM_LBUTTONDOWN || msg == WM_LBUTTONDBLCLK || msg == WM_LBUTTONUP)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_INPUT);
 
         return ret;
     }
@@ -906,7 +1371,7 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_wdb(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         const auto ret = o_WndProc_wdb(hwnd, msg, wParam, MAKELPARAM(pt.x, pt.y), a5);
 
         if (wParam & MK_LBUTTON)
-            wm->render(hwnd);
+            request_frame(hwnd, FRAME_DRAG);
 
         return ret;
     }
@@ -915,6 +1380,9 @@ LRESULT WNDPROC_SUB_CALL hk_WndProc_wdb(HWND hwnd, UINT msg, WPARAM wParam, LPAR
     {
         const auto ret = o_WndProc_wdb(hwnd, msg, wParam, lParam, a5);
 
+        if (frames)
+            frames->forget(reinterpret_cast<uintptr_t>(hwnd));
+
         wm->destroy_window(hwnd);
 
         return ret;
@@ -1046,6 +1514,7 @@ static std::vector<std::pair<PVOID*, PVOID>> hooks_theme = {
     {&reinterpret_cast<PVOID&>(o_CreateFontIndirectA), hk_CreateFontIndirectA},
     {&reinterpret_cast<PVOID&>(o_CreatePen), hk_CreatePen},
     {&reinterpret_cast<PVOID&>(o_CreateBrushIndirect), hk_CreateBrushIndirect},
+    {&reinterpret_cast<PVOID&>(o_DeleteObject), hk_DeleteObject},
     {&reinterpret_cast<PVOID&>(o_SetTextColor), hk_SetTextColor},
     {&reinterpret_cast<PVOID&>(o_CreateDIBSection), hk_CreateDIBSection},
 };
@@ -1081,6 +1550,13 @@ bool apply_hooks()
                 return false;
             }
         }
+
+        // the bitmap mode is only known once colors.yaml is loaded, hk_SelectObject only acts on queued DIBs
+        if (DetourAttach(&reinterpret_cast<PVOID&>(o_SelectObject), hk_SelectObject) != NO_ERROR)
+        {
+            SPDLOG_ERROR("unable to hook functions");
+            return false;
+        }
     }
 
     if (DetourTransactionCommit() != NO_ERROR)
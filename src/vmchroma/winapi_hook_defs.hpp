@@ -23,6 +23,8 @@ extern HFONT (WINAPI *o_CreateFontIndirectA)(const LOGFONTA* lplf);
 extern BOOL (WINAPI *o_AppendMenuA)(HMENU hMenu, UINT uFlags, UINT_PTR uIDNewItem, LPCSTR lpNewItem);
 extern HPEN (WINAPI *o_CreatePen)(int iStyle, int cWidth, COLORREF color);
 extern HBRUSH (WINAPI *o_CreateBrushIndirect)(const LOGBRUSH* plbrush);
+extern BOOL (WINAPI *o_DeleteObject)(HGDIOBJ ho);
+extern HGDIOBJ (WINAPI *o_SelectObject)(HDC hdc, HGDIOBJ h);
 extern COLORREF (WINAPI *o_SetTextColor)(HDC hdc, COLORREF color);
 extern ATOM (WINAPI *o_RegisterClassA)(const WNDCLASSA* lpWndClass);
 extern BOOL (WINAPI *o_Rectangle)(HDC hdc, int left, int top, int right, int bottom);
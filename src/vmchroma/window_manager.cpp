@@ -16,6 +16,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "window_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
 #include "winapi_hook_defs.hpp"
 #include "spdlog/spdlog.h"
 
@@ -23,7 +29,23 @@ using namespace winrt::Windows;
 using namespace winrt::Windows::Graphics::Display;
 
 /**
- * Initializes the Direct2D context
+ * Maps a scaling filter to the Direct2D interpolation mode it is the CPU reference of
+ * @param filter Filter, auto resolved already
+ * @return Interpolation mode
+ */
+static D2D1_INTERPOLATION_MODE to_interpolation_mode(const frame_filter filter)
+{
+    switch (filter)
+    {
+    case FRAME_FILTER_NEAREST: return D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR;
+    case FRAME_FILTER_BILINEAR: return D2D1_INTERPOLATION_MODE_LINEAR;
+    case FRAME_FILTER_CUBIC: return D2D1_INTERPOLATION_MODE_CUBIC;
+    default: return D2D1_INTERPOLATION_MODE_HIGH_QUALITY_CUBIC;
+    }
+}
+
+/**
+ * Initializes the Direct2D context, falls back to software rendering if there is no usable Direct3D device
  */
 window_manager::window_manager()
 {
@@ -59,6 +81,8 @@ window_manager::window_manager()
     catch (const winrt::hresult_error& ex)
     {
         SPDLOG_ERROR("failed to init directx context: {}, {}", static_cast<uint32_t>(ex.code()), winrt::to_string(ex.message()));
+        SPDLOG_WARN("falling back to software rendering");
+        use_software_rendering();
     }
 }
 
@@ -79,6 +103,7 @@ window_ctx_t& window_manager::get_wctx(HWND hwnd)
 
 /**
  * Called in WM_CREATE, sets up the Direct2D rendering for that window
+ * If that fails this and all later windows are rendered in software
  * @param hwnd The hwnd of the window
  * @param type Main window or child window
  * @param cs CreateStruct pointer passed via WM_CREATE
@@ -94,17 +119,8 @@ bool window_manager::init_window(HWND hwnd, const WND_TYPE type, const CREATESTR
     wctx.hwnd = hwnd;
     wctx.type = type;
 
-    D3D11_TEXTURE2D_DESC tex_desc = {};
-    tex_desc.Width = cs->cx;
-    tex_desc.Height = cs->cy;
-    tex_desc.MipLevels = 1;
-    tex_desc.ArraySize = 1;
-    tex_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    tex_desc.SampleDesc.Count = 1;
-    tex_desc.Usage = D3D11_USAGE_DEFAULT;
-    tex_desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    tex_desc.MiscFlags = D3D11_RESOURCE_MISC_GDI_COMPATIBLE;
-    tex_desc.CPUAccessFlags = 0;
+    if (software)
+        return init_window_software(wctx);
 
     DXGI_SWAP_CHAIN_DESC1 swap_chain_desc = {};
     swap_chain_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
@@ -112,24 +128,23 @@ bool window_manager::init_window(HWND hwnd, const WND_TYPE type, const CREATESTR
     swap_chain_desc.Height = cs->cy;
     swap_chain_desc.SampleDesc.Count = 1;
     swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swap_chain_desc.BufferCount = 2;
-    swap_chain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swap_chain_desc.BufferCount = SWAP_CHAIN_BUFFERS;
+    // presenting only what changed needs the back buffers to keep their content
+    swap_chain_desc.SwapEffect = damage_tracking ? DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL : DXGI_SWAP_EFFECT_FLIP_DISCARD;
     swap_chain_desc.Scaling = DXGI_SCALING_STRETCH;
     swap_chain_desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
 
     try
     {
-        winrt::check_hresult(d3d_device->CreateTexture2D(&tex_desc, nullptr, wctx.source_texture.put()));
-        winrt::check_hresult(wctx.source_texture->QueryInterface(__uuidof(IDXGISurface1), wctx.source_surface.put_void()));
         winrt::check_hresult(d2d_device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, wctx.d2d_context.put()));
 
-        winrt::check_hresult(wctx.d2d_context->CreateBitmapFromDxgiSurface(
-            wctx.source_surface.get(),
-            &source_bitmap_props,
-            wctx.source_bitmap.put()
-        ));
+        wctx.source_device = std::make_shared<d3d_texture_device>(d3d_device, wctx.d2d_context, source_bitmap_props, texture_ring_size);
+        wctx.source_ring = std::make_shared<texture_ring>(*wctx.source_device, texture_ring_size);
+
+        if (!wctx.source_ring->create(cs->cx, cs->cy))
+            winrt::throw_hresult(E_FAIL);
 
-        winrt::check_hresult(wctx.source_surface->GetDC(FALSE, &wctx.mem_dc));
+        wctx.mem_dc = static_cast<HDC>(wctx.source_ring->get_dc());
 
         winrt::check_hresult(dxgi_factory->CreateSwapChainForHwnd(
             d3d_device.get(),
@@ -152,14 +167,35 @@ bool window_manager::init_window(HWND hwnd, const WND_TYPE type, const CREATESTR
         ));
 
         wctx.d2d_context->SetTarget(wctx.target_bitmap.get());
+
+        winrt::check_hresult(wctx.d2d_context->CreateEffect(CLSID_D2D1TableTransfer, wctx.grade_effect.put()));
+        set_grade_tables(wctx);
     }
     catch (const winrt::hresult_error& ex)
     {
         SPDLOG_ERROR("failed to initialize window: {}, {}", static_cast<uint32_t>(ex.code()), winrt::to_string(ex.message()));
-        return false;
+        SPDLOG_WARN("falling back to software rendering");
+
+        // drops what was created for this window, the ring first so it hands its DC back to the texture
+        wctx.source_ring = nullptr;
+        wctx.source_device = nullptr;
+        wctx.grade_effect = nullptr;
+        wctx.target_bitmap = nullptr;
+        wctx.swap_chain = nullptr;
+        wctx.d2d_context = nullptr;
+        wctx.mem_dc = nullptr;
+
+        // windows created before keep their own references to the device and stay on Direct3D
+        use_software_rendering();
+        return init_window_software(wctx);
     }
 
+    wctx.damage.resize(cs->cx, cs->cy);
+    wctx.damage_full = true;
+    wctx.full_frames_due = SWAP_CHAIN_BUFFERS;
+
     wctx_map[hwnd] = wctx;
+    index_dc(nullptr, wctx.mem_dc, type);
 
     return true;
 }
@@ -172,16 +208,43 @@ void window_manager::destroy_window(HWND hwnd)
 {
     const auto& wctx = wctx_map[hwnd];
 
-    try
+    if (wctx.source_ring)
     {
-        winrt::check_hresult((wctx.source_surface->ReleaseDC(nullptr)));
+        const auto stats = wctx.source_ring->get_stats();
+        SPDLOG_INFO("texture ring: {} frames, {} textures created, {} of them after the first frame, {} dc acquires, {} copies, {} fence waits",
+                    stats.frames, stats.textures_created, stats.frame_creations, stats.dc_acquires, stats.copies, stats.fence_waits);
+
+        // releases the DC, the surface owns it
+        wctx.source_ring->destroy();
     }
-    catch (const winrt::hresult_error& ex)
+
+    if (damage_tracking)
+    {
+        SPDLOG_INFO("damage tracking: {} frames skipped, {} presented partially, {} presented whole{}",
+                    wctx.frames_skipped, wctx.frames_partial, wctx.frames_full, wctx.capture_dc ? ", hashed from a copy" : "");
+    }
+
+    if (wctx.capture_dc)
+    {
+        DeleteDC(wctx.capture_dc);
+        o_DeleteObject(wctx.capture_bitmap);
+    }
+
+    if (wctx.soft_layers && wctx.soft_layers->has_background())
     {
-        SPDLOG_ERROR("failed to destroy window: {}, {}", static_cast<uint32_t>(ex.code()), winrt::to_string(ex.message()));
+        const auto stats = wctx.soft_layers->get_stats();
+        SPDLOG_INFO("layered compositing: {} frames, {} scaled whole, {} background scales, {:.1f}% of the output pixels scaled",
+                    stats.frames, stats.full_frames, stats.background_scales,
+                    stats.output_pixels ? 100.0 * stats.scaled_pixels / stats.output_pixels : 0.0);
     }
 
-    DeleteDC(wctx.mem_dc);
+    if (wctx.soft_bitmap)
+    {
+        DeleteDC(wctx.mem_dc);
+        o_DeleteObject(wctx.soft_bitmap);
+    }
+
+    index_dc(wctx.mem_dc, nullptr, wctx.type);
     wctx_map.erase(hwnd);
 }
 
@@ -193,48 +256,185 @@ void window_manager::render(HWND hwnd)
 {
     auto& wctx = wctx_map[hwnd];
 
+    if (wctx.soft_bitmap)
+    {
+        render_software(wctx);
+        return;
+    }
+
     try
     {
         GdiFlush();
 
-        winrt::check_hresult(wctx.source_surface->ReleaseDC(nullptr));
-
         RECT rc;
         o_GetClientRect(wctx.hwnd, &rc);
 
+        if (rc.right != wctx.present_cx || rc.bottom != wctx.present_cy)
+            wctx.full_frames_due = SWAP_CHAIN_BUFFERS;
+
+        // what changed since the last present, in window coordinates
+        std::vector<RECT> damage_rects;
+        bool damage_full = true;
+
+        if (damage_tracking && !find_damage(wctx, rc, damage_rects, damage_full) && wctx.full_frames_due == 0)
+        {
+            wctx.frames_skipped++;
+            return;
+        }
+
+        const bool present_full = damage_full || wctx.full_frames_due > 0;
+
+        // the back buffer still shows the frame before the last one, so what the last frame changed is drawn again too
+        const bool draw_full = present_full || wctx.damage_full;
+        std::vector<RECT> draw_rects = damage_rects;
+
+        if (!draw_full)
+            draw_rects.insert(draw_rects.end(), wctx.damage_rects.begin(), wctx.damage_rects.end());
+
+        if (!wctx.source_ring || !wctx.source_ring->begin_frame())
+            winrt::throw_hresult(E_FAIL);
+
+        ID2D1Bitmap1* source_bitmap = wctx.source_device->get_bitmap(wctx.source_ring->get_slot());
+
         const float scaleX = rc.right / static_cast<float>(wctx.default_cx);
         const float scaleY = rc.bottom / static_cast<float>(wctx.default_cy);
 
+        // a level at or above the window scale is drawn with a bilinear filter instead of scaling the full frame with the cubic one
+        const size_t level = mip_scaling ? mip_chain::pick_level(std::max(scaleX, scaleY)) : 0;
+        ID2D1Bitmap1* mip_bitmap = level > 0 ? get_mip_level(wctx, level) : nullptr;
+
+        // draws to the swap chain, once for the whole window or clipped to every damaged rectangle
+        const auto draw_target = [&](const D2D1_MATRIX_3X2_F& transform, const auto& draw)
+        {
+            if (draw_full)
+            {
+                wctx.d2d_context->SetTransform(transform);
+                draw();
+                return;
+            }
+
+            for (const auto& r : draw_rects)
+            {
+                wctx.d2d_context->SetTransform(D2D1::Matrix3x2F::Identity());
+                wctx.d2d_context->PushAxisAlignedClip(
+                    D2D1::RectF(static_cast<float>(r.left), static_cast<float>(r.top), static_cast<float>(r.right), static_cast<float>(r.bottom)),
+                    D2D1_ANTIALIAS_MODE_ALIASED
+                );
+                wctx.d2d_context->SetTransform(transform);
+                draw();
+                wctx.d2d_context->PopAxisAlignedClip();
+            }
+        };
+
         wctx.d2d_context->BeginDraw();
 
-        wctx.d2d_context->SetTransform(D2D1::Matrix3x2F::Scale(scaleX, scaleY));
+        // grading runs on the unscaled frame so the cubic filter blends already graded pixels
+        winrt::com_ptr<ID2D1Image> image;
+        image.copy_from(source_bitmap);
+
+        if (!grade.is_identity() && wctx.grade_effect)
+        {
+            wctx.grade_effect->SetInput(0, source_bitmap);
+            image = nullptr;
+            wctx.grade_effect->GetOutput(image.put());
+        }
 
-        wctx.d2d_context->DrawImage(
-            wctx.source_bitmap.get(),
-            D2D1::Point2F(0, 0),
-            D2D1::RectF(0, 0, static_cast<float>(wctx.default_cx), static_cast<float>(wctx.default_cy)),
-            D2D1_INTERPOLATION_MODE_HIGH_QUALITY_CUBIC,
-            D2D1_COMPOSITE_MODE_SOURCE_COPY
-        );
+        if (mip_bitmap)
+        {
+            // linear at exactly 50% averages 2x2 pixels like mip_chain's kernel, at 75% it's within a twelfth of a tap weight of it
+            const float level_scale = mip_chain::LEVEL_SCALES[level];
+
+            wctx.d2d_context->SetTarget(mip_bitmap);
+            wctx.d2d_context->SetTransform(D2D1::Matrix3x2F::Scale(level_scale, level_scale));
+
+            wctx.d2d_context->DrawImage(
+                image.get(),
+                D2D1::Point2F(0, 0),
+                D2D1::RectF(0, 0, static_cast<float>(wctx.default_cx), static_cast<float>(wctx.default_cy)),
+                D2D1_INTERPOLATION_MODE_LINEAR,
+                D2D1_COMPOSITE_MODE_SOURCE_COPY
+            );
+
+            wctx.d2d_context->SetTarget(wctx.target_bitmap.get());
+
+            draw_target(D2D1::Matrix3x2F::Scale(scaleX / level_scale, scaleY / level_scale), [&]
+            {
+                wctx.d2d_context->DrawImage(
+                    mip_bitmap,
+                    D2D1::Point2F(0, 0),
+                    D2D1::RectF(0, 0, wctx.default_cx * level_scale, wctx.default_cy * level_scale),
+                    D2D1_INTERPOLATION_MODE_LINEAR,
+                    D2D1_COMPOSITE_MODE_SOURCE_COPY
+                );
+            });
+        }
+        else
+        {
+            const auto filter = scaling_filter == FRAME_FILTER_AUTO ? frame_scaler::pick_filter(std::max(scaleX, scaleY)) : scaling_filter;
+
+            draw_target(D2D1::Matrix3x2F::Scale(scaleX, scaleY), [&]
+            {
+                wctx.d2d_context->DrawImage(
+                    image.get(),
+                    D2D1::Point2F(0, 0),
+                    D2D1::RectF(0, 0, static_cast<float>(wctx.default_cx), static_cast<float>(wctx.default_cy)),
+                    mip_scaling ? D2D1_INTERPOLATION_MODE_LINEAR : to_interpolation_mode(filter),
+                    D2D1_COMPOSITE_MODE_SOURCE_COPY
+                );
+            });
+        }
 
         winrt::check_hresult(wctx.d2d_context->EndDraw());
 
-        winrt::check_hresult(wctx.swap_chain->Present(1, 0));
+        if (present_full)
+        {
+            winrt::check_hresult(wctx.swap_chain->Present(1, 0));
+            wctx.frames_full++;
+        }
+        else
+        {
+            DXGI_PRESENT_PARAMETERS params = {};
+            params.DirtyRectsCount = static_cast<UINT>(damage_rects.size());
+            params.pDirtyRects = damage_rects.data();
+
+            winrt::check_hresult(wctx.swap_chain->Present1(1, 0, &params));
+            wctx.frames_partial++;
+        }
 
-        wctx.mem_dc = nullptr;
-        wctx.source_bitmap = nullptr;
+        wctx.damage_rects = std::move(damage_rects);
+        wctx.damage_full = present_full;
+        wctx.present_cx = rc.right;
+        wctx.present_cy = rc.bottom;
 
-        winrt::check_hresult(wctx.d2d_context->CreateBitmapFromDxgiSurface(
-            wctx.source_surface.get(),
-            &source_bitmap_props,
-            wctx.source_bitmap.put()
-        ));
+        if (wctx.full_frames_due > 0)
+            wctx.full_frames_due--;
+
+        // the textures live as long as the window, GDI continues in the next one of the ring
+        const HDC old_dc = wctx.mem_dc;
+        const bool has_dc = wctx.source_ring->end_frame();
+        wctx.mem_dc = static_cast<HDC>(wctx.source_ring->get_dc());
 
-        winrt::check_hresult(wctx.source_surface->GetDC(FALSE, &wctx.mem_dc));
+        if (!has_dc)
+            winrt::throw_hresult(E_FAIL);
+
+        if (wctx.mem_dc != old_dc)
+            index_dc(old_dc, wctx.mem_dc, wctx.type);
     }
     catch (const winrt::hresult_error& ex)
     {
         SPDLOG_ERROR("render error: {}, {}", static_cast<uint32_t>(ex.code()), winrt::to_string(ex.message()));
+
+        // the frame may be half drawn, the next one starts over
+        wctx.damage.invalidate();
+        wctx.full_frames_due = SWAP_CHAIN_BUFFERS;
+
+        // GDI needs a DC again even if the frame was lost
+        if (wctx.source_ring && !wctx.source_ring->get_dc() && wctx.source_ring->end_frame())
+        {
+            const HDC old_dc = wctx.mem_dc;
+            wctx.mem_dc = static_cast<HDC>(wctx.source_ring->get_dc());
+            index_dc(old_dc, wctx.mem_dc, wctx.type);
+        }
     }
 }
 
@@ -271,8 +471,16 @@ void window_manager::resize_d2d(HWND hwnd, const D2D1_SIZE_U& pixelSize)
 {
     auto& wctx = wctx_map[hwnd];
 
+    // the software renderer sizes its frame in render
+    if (wctx.soft_bitmap)
+    {
+        wctx.full_frames_due = 1;
+        return;
+    }
+
     wctx.d2d_context->SetTarget(nullptr);
     wctx.target_bitmap = nullptr;
+    wctx.full_frames_due = SWAP_CHAIN_BUFFERS;
 
     try
     {
@@ -359,3 +567,693 @@ void window_manager::resize_child_windows()
         resize_d2d(hwnd, D2D1::SizeU(cx, cy));
     }
 }
+
+/**
+ * Rebuilds the frame color grading tables and passes them to the effect of every window
+ * @param settings Grading settings from the config
+ */
+void window_manager::set_color_grade(const grade_settings_t& settings)
+{
+    grade.build(settings);
+
+    try
+    {
+        for (auto& [hwnd, wctx] : wctx_map)
+        {
+            set_grade_tables(wctx);
+            wctx.full_frames_due = SWAP_CHAIN_BUFFERS;
+        }
+    }
+    catch (const winrt::hresult_error& ex)
+    {
+        SPDLOG_ERROR("failed to set color grade: {}, {}", static_cast<uint32_t>(ex.code()), winrt::to_string(ex.message()));
+    }
+}
+
+/**
+ * Enables drawing shrunk windows from prefiltered levels of the frame
+ * @param enabled False draws the full frame with the scaling filter
+ */
+void window_manager::set_mip_scaling(const bool enabled)
+{
+    mip_scaling = enabled;
+}
+
+/**
+ * Sets the filter windows are scaled with, unless mip scaling is on
+ * @param filter Filter, auto picks one from the scale of each frame
+ */
+void window_manager::set_scaling_filter(const frame_filter filter)
+{
+    scaling_filter = filter;
+}
+
+/**
+ * Sets how many GDI textures each window rotates through, applies to windows created afterwards
+ * @param size 1 keeps a single texture, more let GDI draw while the GPU still reads the last frame
+ */
+void window_manager::set_texture_ring_size(const size_t size)
+{
+    texture_ring_size = std::clamp<size_t>(size, 1, 3);
+}
+
+/**
+ * Lets render skip frames in which nothing changed and present only the changed parts otherwise
+ * Applies to windows created afterwards
+ * @param enabled False presents every frame whole
+ */
+void window_manager::set_damage_tracking(const bool enabled)
+{
+    damage_tracking = enabled;
+}
+
+/**
+ * Renders without Direct3D, applies to windows created afterwards
+ * The constructor and init_window already switch to it if there is no usable device, e.g. in some VMs and RDP sessions
+ * @param enabled True renders on the CPU even if Direct3D works
+ */
+void window_manager::set_software_rendering(const bool enabled)
+{
+    if (enabled && !software)
+    {
+        SPDLOG_INFO("software rendering enabled in the config");
+        use_software_rendering();
+    }
+}
+
+bool window_manager::is_software_rendering() const
+{
+    return software;
+}
+
+/**
+ * Lets software rendering keep the background of a window scaled and scale only what is drawn over it
+ * @param enabled False scales every changed frame whole
+ */
+void window_manager::set_layered_compositing(const bool enabled)
+{
+    layered_compositing = enabled;
+}
+
+bool window_manager::is_layered_compositing() const
+{
+    return layered_compositing;
+}
+
+/**
+ * Sets the bitmap the frames of a window are drawn over, e.g. the theme bitmap, the layers of open windows pick it up
+ * @param type The window type
+ * @param width Width of the bitmap
+ * @param height Height of the bitmap, may be taller than the window
+ * @param pixels BGRX pixels, top-down without padding
+ */
+void window_manager::set_background(const WND_TYPE type, const uint32_t width, const uint32_t height, std::vector<uint8_t>&& pixels)
+{
+    if (pixels.size() != static_cast<size_t>(width) * height * 4)
+    {
+        SPDLOG_ERROR("background of {}x{} doesn't match its {} bytes", width, height, pixels.size());
+        return;
+    }
+
+    backgrounds[type] = {std::move(pixels), width, height, ++background_serial};
+}
+
+/**
+ * Checks whether a window type already has a background of a size, so it isn't decoded again
+ * @param type The window type
+ * @param width Width of the bitmap
+ * @param height Height of the bitmap
+ * @return True if set_background was called with that size
+ */
+bool window_manager::has_background(const WND_TYPE type, const uint32_t width, const uint32_t height) const
+{
+    const auto it = backgrounds.find(type);
+    return it != backgrounds.end() && it->second.width == width && it->second.height == height;
+}
+
+/**
+ * Drops the Direct3D and Direct2D objects, some of them may be left over from a failed init
+ */
+void window_manager::use_software_rendering()
+{
+    software = true;
+    d2d_device = nullptr;
+    dxgi_factory = nullptr;
+    adapter = nullptr;
+    dxgi_device = nullptr;
+    d3d_device = nullptr;
+    d2d_factory = nullptr;
+}
+
+/**
+ * Creates the memory DC of a window for software rendering, a top-down 32 bpp DIB at the default size of the window
+ * @param wctx The window context, added to the map if successful
+ * @return True if init was successful
+ */
+bool window_manager::init_window_software(window_ctx_t& wctx)
+{
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = wctx.default_cx;
+    bmi.bmiHeader.biHeight = -wctx.default_cy;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    wctx.soft_bitmap = o_CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    wctx.mem_dc = wctx.soft_bitmap ? CreateCompatibleDC(nullptr) : nullptr;
+
+    if (!wctx.mem_dc)
+    {
+        SPDLOG_ERROR("failed to create the {}x{} software frame bitmap", wctx.default_cx, wctx.default_cy);
+
+        if (wctx.soft_bitmap)
+            o_DeleteObject(wctx.soft_bitmap);
+
+        return false;
+    }
+
+    o_SelectObject(wctx.mem_dc, wctx.soft_bitmap);
+    wctx.soft_bits = static_cast<const uint8_t*>(bits);
+    wctx.soft_scaler = std::make_shared<frame_scaler>();
+    wctx.soft_layers = layered_compositing ? std::make_shared<frame_layers>() : nullptr;
+    wctx.soft_layers_serial = 0;
+
+    if (!soft_pool)
+        soft_pool = std::make_unique<thread_pool>(std::max(1u, std::thread::hardware_concurrency()));
+
+    wctx.damage.resize(wctx.default_cx, wctx.default_cy);
+    wctx.damage_full = true;
+    wctx.full_frames_due = 1;
+
+    wctx_map[wctx.hwnd] = wctx;
+    index_dc(nullptr, wctx.mem_dc, wctx.type);
+
+    return true;
+}
+
+/**
+ * Scales the memory DC to the window on the CPU, grades the scaled frame and blits it to the window DC
+ * Grading after scaling touches fewer pixels, unlike Direct2D the filter blends ungraded pixels
+ * With layered compositing only the parts drawn over the background that changed are scaled, see frame_layers
+ * @param wctx The window context
+ */
+void window_manager::render_software(window_ctx_t& wctx)
+{
+    GdiFlush();
+
+    RECT rc;
+    o_GetClientRect(wctx.hwnd, &rc);
+
+    if (rc.right <= 0 || rc.bottom <= 0)
+        return;
+
+    if (rc.right != wctx.present_cx || rc.bottom != wctx.present_cy)
+        wctx.full_frames_due = 1;
+
+    std::vector<RECT> damage_rects;
+    bool damage_full = true;
+
+    if (damage_tracking && !find_damage(wctx, rc, damage_rects, damage_full) && wctx.full_frames_due == 0)
+    {
+        wctx.frames_skipped++;
+        return;
+    }
+
+    const auto width = static_cast<uint32_t>(rc.right);
+    const auto height = static_cast<uint32_t>(rc.bottom);
+    wctx.soft_frame.resize(static_cast<size_t>(width) * height * 4);
+
+    image_view_t src = {const_cast<uint8_t*>(wctx.soft_bits), static_cast<uint32_t>(wctx.default_cx), static_cast<uint32_t>(wctx.default_cy),
+                        static_cast<uint32_t>(wctx.default_cx) * 4, 4};
+    const image_view_t dst = {wctx.soft_frame.data(), width, height, width * 4, 4};
+
+    // same as the Direct2D path, mip scaling draws the frame or its level with the bilinear filter
+    const auto filter = mip_scaling ? FRAME_FILTER_BILINEAR : scaling_filter;
+
+    const float scale = std::max(width / static_cast<float>(src.width), height / static_cast<float>(src.height));
+    const size_t level = mip_scaling ? mip_chain::pick_level(scale) : 0;
+
+    if (level != 0)
+    {
+        const uint32_t level_cx = mip_chain::level_extent(src.width, level);
+        const uint32_t level_cy = mip_chain::level_extent(src.height, level);
+        wctx.soft_level.resize(static_cast<size_t>(level_cx) * level_cy * 4);
+
+        const image_view_t level_view = {wctx.soft_level.data(), level_cx, level_cy, level_cx * 4, 4};
+
+        if (mip_chain::build_level(src, level_view, level, soft_pool.get()))
+            src = level_view;
+    }
+
+    std::vector<damage_rect_t> written;
+    bool written_full = true;
+    const bool layered = src.pixels == wctx.soft_bits && composite_layers(wctx, src, dst, filter, written, written_full);
+
+    if (!layered)
+    {
+        // soft_frame is graded in place below, the layers have to write all of it next time
+        if (wctx.soft_layers)
+            wctx.soft_layers->invalidate();
+
+        if (!wctx.soft_scaler->scale(src, dst, filter, soft_pool.get()))
+        {
+            SPDLOG_ERROR("failed to scale the frame from {}x{} to {}x{}", wctx.default_cx, wctx.default_cy, width, height);
+            return;
+        }
+    }
+
+    const uint8_t* frame = wctx.soft_frame.data();
+
+    if (layered && !grade.is_identity())
+    {
+        // the layers only write parts of soft_frame, so it stays ungraded and the written parts are graded into a copy
+        // copying before grading each rectangle keeps overlapping ones from being graded twice
+        wctx.soft_graded.resize(wctx.soft_frame.size());
+
+        if (written_full || wctx.full_frames_due != 0)
+            written.assign(1, {0, 0, width, height});
+
+        for (const auto& r : written)
+        {
+            const size_t offset = (static_cast<size_t>(r.top) * width + r.left) * 4;
+
+            for (uint32_t y = 0; y < r.bottom - r.top; y++)
+            {
+                memcpy(wctx.soft_graded.data() + offset + static_cast<size_t>(y) * width * 4, wctx.soft_frame.data() + offset + static_cast<size_t>(y) * width * 4,
+                       static_cast<size_t>(r.right - r.left) * 4);
+            }
+
+            grade.apply(wctx.soft_graded.data() + offset, r.right - r.left, r.bottom - r.top, width * 4);
+        }
+
+        frame = wctx.soft_graded.data();
+    }
+    else if (!grade.is_identity())
+        grade.apply(wctx.soft_frame.data(), width, height, width * 4);
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = rc.right;
+    bmi.bmiHeader.biHeight = -rc.bottom;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    // the hooked GetDC hands out the memory DC
+    const HDC dc = o_GetDC(wctx.hwnd);
+
+    if (!dc)
+    {
+        SPDLOG_ERROR("failed to get the window dc");
+        return;
+    }
+
+    // already at window size, so GDI copies the rows without stretching
+    const bool blitted = StretchDIBits(dc, 0, 0, rc.right, rc.bottom, 0, 0, rc.right, rc.bottom,
+                                       frame, &bmi, DIB_RGB_COLORS, SRCCOPY) != 0;
+    o_ReleaseDC(wctx.hwnd, dc);
+
+    if (!blitted)
+    {
+        SPDLOG_ERROR("failed to blit the frame to the window");
+        return;
+    }
+
+    wctx.present_cx = rc.right;
+    wctx.present_cy = rc.bottom;
+    wctx.full_frames_due = 0;
+
+    if (layered && !written_full)
+        wctx.frames_partial++;
+    else
+        wctx.frames_full++;
+}
+
+/**
+ * Scales the frame through the layers of the window, gives them the background of the window first if it changed
+ * @param wctx The window context
+ * @param src The memory DC's frame
+ * @param dst soft_frame, left ungraded
+ * @param filter Scaling filter
+ * @param written Receives the rectangles of soft_frame that were written
+ * @param full Receives true if all of soft_frame was written
+ * @return False if the frame has to be scaled whole, e.g. there is no background for the window or it is shown 1:1
+ */
+bool window_manager::composite_layers(window_ctx_t& wctx, const image_view_t& src, const image_view_t& dst, const frame_filter filter,
+                                      std::vector<damage_rect_t>& written, bool& full)
+{
+    // at 1:1 the scaler only copies rows, comparing the frame with the background costs more than that
+    if (!wctx.soft_layers || (src.width == dst.width && src.height == dst.height))
+        return false;
+
+    const auto it = backgrounds.find(wctx.type);
+
+    if (it == backgrounds.end())
+        return false;
+
+    const auto& background = it->second;
+
+    if (background.serial != wctx.soft_layers_serial)
+    {
+        wctx.soft_layers_serial = background.serial;
+        wctx.soft_layers->clear_background();
+
+        // the theme bitmap may continue below the window, e.g. with sprites
+        if (background.width == src.width && background.height >= src.height)
+            wctx.soft_layers->set_background({const_cast<uint8_t*>(background.pixels.data()), src.width, src.height, background.width * 4, 4});
+        else
+            SPDLOG_WARN("background of {}x{} doesn't fit the {}x{} window, scaling whole frames", background.width, background.height, src.width, src.height);
+    }
+
+    return wctx.soft_layers->composite(src, dst, filter, soft_pool.get(), written, full);
+}
+
+/**
+ * Gets the pixels GDI drew into the memory DC, directly from its DIB section or from a copy if GDI doesn't expose them
+ * @param wctx The window context
+ * @param stride Receives the bytes from one row to the next, negative for bottom-up bitmaps
+ * @return The top row of the frame or nullptr if it can't be read
+ */
+const uint8_t* window_manager::get_frame_bits(window_ctx_t& wctx, ptrdiff_t& stride) const
+{
+    DIBSECTION ds = {};
+    const auto bitmap = GetCurrentObject(wctx.mem_dc, OBJ_BITMAP);
+
+    if (bitmap && GetObjectW(bitmap, sizeof(ds), &ds) == sizeof(ds) && ds.dsBm.bmBits && ds.dsBm.bmBitsPixel == 32 &&
+        ds.dsBm.bmWidth >= wctx.default_cx && ds.dsBm.bmHeight >= wctx.default_cy)
+    {
+        const auto bits = static_cast<const uint8_t*>(ds.dsBm.bmBits);
+        stride = ds.dsBm.bmWidthBytes;
+
+        if (ds.dsBmih.biHeight < 0)
+            return bits;
+
+        stride = -stride;
+        return bits - static_cast<ptrdiff_t>(ds.dsBm.bmHeight - 1) * stride;
+    }
+
+    if (!wctx.capture_dc)
+    {
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+        bmi.bmiHeader.biWidth = wctx.default_cx;
+        bmi.bmiHeader.biHeight = -wctx.default_cy;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        wctx.capture_bitmap = o_CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+        wctx.capture_dc = wctx.capture_bitmap ? CreateCompatibleDC(nullptr) : nullptr;
+
+        if (!wctx.capture_dc)
+        {
+            SPDLOG_ERROR("failed to create the {}x{} damage capture bitmap", wctx.default_cx, wctx.default_cy);
+
+            if (wctx.capture_bitmap)
+                o_DeleteObject(wctx.capture_bitmap);
+
+            wctx.capture_bitmap = nullptr;
+            return nullptr;
+        }
+
+        o_SelectObject(wctx.capture_dc, wctx.capture_bitmap);
+        wctx.capture_bits = static_cast<const uint8_t*>(bits);
+    }
+
+    if (!BitBlt(wctx.capture_dc, 0, 0, wctx.default_cx, wctx.default_cy, wctx.mem_dc, 0, 0, SRCCOPY))
+        return nullptr;
+
+    GdiFlush();
+    stride = static_cast<ptrdiff_t>(wctx.default_cx) * 4;
+    return wctx.capture_bits;
+}
+
+/**
+ * Hashes the frame in tiles and maps the changed tiles to the window, widened by the reach of the scaling filter
+ * @param wctx The window context
+ * @param rc Client rectangle of the window
+ * @param rects Receives the changed rectangles in window coordinates
+ * @param full Receives true if the whole window has to be presented
+ * @return False if nothing changed since the last call
+ */
+bool window_manager::find_damage(window_ctx_t& wctx, const RECT& rc, std::vector<RECT>& rects, bool& full) const
+{
+    full = true;
+    ptrdiff_t stride = 0;
+    const uint8_t* bits = get_frame_bits(wctx, stride);
+
+    if (!bits)
+    {
+        wctx.damage.invalidate();
+        return true;
+    }
+
+    const size_t changed = wctx.damage.update(bits, stride);
+
+    if (changed == 0)
+        return false;
+
+    // past this the clips cost more than drawing everything
+    if (changed * 4 > wctx.damage.get_tile_count() * 3)
+        return true;
+
+    const float scale_x = rc.right / static_cast<float>(wctx.default_cx);
+    const float scale_y = rc.bottom / static_cast<float>(wctx.default_cy);
+    // the cubic filter reads two source pixels beyond a tile, plus one for rounding
+    const auto pad = static_cast<LONG>(std::ceil(2 * std::max(scale_x, scale_y))) + 1;
+
+    for (const auto& r : wctx.damage.rects(DAMAGE_MAX_RECTS))
+    {
+        rects.push_back({
+            std::max(0L, static_cast<LONG>(std::floor(r.left * scale_x)) - pad),
+            std::max(0L, static_cast<LONG>(std::floor(r.top * scale_y)) - pad),
+            std::min(rc.right, static_cast<LONG>(std::ceil(r.right * scale_x)) + pad),
+            std::min(rc.bottom, static_cast<LONG>(std::ceil(r.bottom * scale_y)) + pad)
+        });
+    }
+
+    full = false;
+    return true;
+}
+
+/**
+ * Gets the render target of a level, the levels don't depend on the window size and are kept until the window is destroyed
+ * @param wctx The window context
+ * @param level Index into mip_chain::LEVEL_SCALES, greater than 0
+ * @return The level bitmap or nullptr if it can't be created
+ */
+ID2D1Bitmap1* window_manager::get_mip_level(window_ctx_t& wctx, const size_t level) const
+{
+    auto& bitmap = wctx.mip_levels[level];
+
+    if (bitmap)
+        return bitmap.get();
+
+    const auto size = D2D1::SizeU(
+        mip_chain::level_extent(static_cast<uint32_t>(wctx.default_cx), level),
+        mip_chain::level_extent(static_cast<uint32_t>(wctx.default_cy), level)
+    );
+
+    if (FAILED(wctx.d2d_context->CreateBitmap(size, nullptr, 0, &mip_bitmap_props, bitmap.put())))
+    {
+        SPDLOG_ERROR("failed to create {}x{} mip level", size.width, size.height);
+        return nullptr;
+    }
+
+    return bitmap.get();
+}
+
+const color_grade& window_manager::get_color_grade() const
+{
+    return grade;
+}
+
+/**
+ * Converts the grading tables to the float tables of the Direct2D table transfer effect
+ * @param wctx The window context owning the effect
+ */
+void window_manager::set_grade_tables(const window_ctx_t& wctx) const
+{
+    if (!wctx.grade_effect)
+        return;
+
+    const std::pair<D2D1_TABLETRANSFER_PROP, const std::array<uint8_t, 256>*> tables[] = {
+        {D2D1_TABLETRANSFER_PROP_RED_TABLE, &grade.get_table_r()},
+        {D2D1_TABLETRANSFER_PROP_GREEN_TABLE, &grade.get_table_g()},
+        {D2D1_TABLETRANSFER_PROP_BLUE_TABLE, &grade.get_table_b()},
+    };
+
+    float values[256];
+
+    for (const auto& [prop, table] : tables)
+    {
+        for (size_t i = 0; i < table->size(); i++)
+            values[i] = (*table)[i] / 255.0f;
+
+        winrt::check_hresult(wctx.grade_effect->SetValue(prop, reinterpret_cast<const BYTE*>(values), sizeof(values)));
+    }
+
+    winrt::check_hresult(wctx.grade_effect->SetValue(D2D1_TABLETRANSFER_PROP_ALPHA_DISABLE, TRUE));
+}
+
+WND_TYPE window_manager::get_active_wnd_type() const
+{
+    return active_wnd_type;
+}
+
+/**
+ * Sets the window whose wndproc is currently running, colors of pens and brushes are resolved against it
+ * @param type The window type
+ * @return The previous window type, to be restored when the wndproc returns
+ */
+WND_TYPE window_manager::set_active_wnd_type(const WND_TYPE type)
+{
+    const auto prev = active_wnd_type;
+    active_wnd_type = type;
+    return prev;
+}
+
+/**
+ * Replaces a memory DC in the index, the surface hands out a new DC after every render
+ * @param old_dc The previous DC or nullptr to add a new entry
+ * @param new_dc The new DC or nullptr to remove the entry
+ * @param type The window type
+ */
+void window_manager::index_dc(HDC old_dc, HDC new_dc, const WND_TYPE type)
+{
+    if (!dcs.replace(old_dc, new_dc, type))
+        SPDLOG_WARN("dc index is full, window colors fall back to the active window");
+}
+
+/**
+ * @param d3d_device Device the textures are created on
+ * @param d2d_context Context of the window the bitmaps are drawn with
+ * @param bitmap_props Properties of the bitmaps over the textures
+ * @param slot_count Number of textures
+ */
+d3d_texture_device::d3d_texture_device(const winrt::com_ptr<ID3D11Device>& d3d_device, const winrt::com_ptr<ID2D1DeviceContext>& d2d_context,
+                                       const D2D1_BITMAP_PROPERTIES1& bitmap_props, const size_t slot_count)
+    : d3d_device(d3d_device), d2d_context(d2d_context), bitmap_props(bitmap_props), slots(slot_count)
+{
+    d3d_device->GetImmediateContext(d3d_context.put());
+}
+
+bool d3d_texture_device::create_slot(const size_t slot, const uint32_t width, const uint32_t height)
+{
+    auto& s = slots[slot];
+
+    D3D11_TEXTURE2D_DESC tex_desc = {};
+    tex_desc.Width = width;
+    tex_desc.Height = height;
+    tex_desc.MipLevels = 1;
+    tex_desc.ArraySize = 1;
+    tex_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    tex_desc.SampleDesc.Count = 1;
+    tex_desc.Usage = D3D11_USAGE_DEFAULT;
+    tex_desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    tex_desc.MiscFlags = D3D11_RESOURCE_MISC_GDI_COMPATIBLE;
+    tex_desc.CPUAccessFlags = 0;
+
+    if (FAILED(d3d_device->CreateTexture2D(&tex_desc, nullptr, s.texture.put())) ||
+        FAILED(s.texture->QueryInterface(__uuidof(IDXGISurface1), s.surface.put_void())) ||
+        FAILED(d2d_context->CreateBitmapFromDxgiSurface(s.surface.get(), &bitmap_props, s.bitmap.put())))
+    {
+        destroy_slot(slot);
+        return false;
+    }
+
+    return true;
+}
+
+void d3d_texture_device::destroy_slot(const size_t slot)
+{
+    slots[slot] = {};
+}
+
+void* d3d_texture_device::acquire_dc(const size_t slot)
+{
+    HDC dc = nullptr;
+
+    if (FAILED(slots[slot].surface->GetDC(FALSE, &dc)))
+    {
+        SPDLOG_ERROR("failed to get the dc of texture {}", slot);
+        return nullptr;
+    }
+
+    return dc;
+}
+
+bool d3d_texture_device::release_dc(const size_t slot)
+{
+    if (FAILED(slots[slot].surface->ReleaseDC(nullptr)))
+    {
+        SPDLOG_ERROR("failed to release the dc of texture {}", slot);
+        return false;
+    }
+
+    return true;
+}
+
+void d3d_texture_device::copy(const size_t dst_slot, const size_t src_slot)
+{
+    d3d_context->CopyResource(slots[dst_slot].texture.get(), slots[src_slot].texture.get());
+}
+
+/**
+ * Marks the work submitted so far, without a query the fence counts as complete right away
+ * @return Fence value
+ */
+uint64_t d3d_texture_device::signal()
+{
+    winrt::com_ptr<ID3D11Query> query;
+
+    if (!idle_queries.empty())
+    {
+        query = std::move(idle_queries.back());
+        idle_queries.pop_back();
+    }
+    else
+    {
+        const D3D11_QUERY_DESC desc = {D3D11_QUERY_EVENT, 0};
+
+        if (FAILED(d3d_device->CreateQuery(&desc, query.put())))
+        {
+            completed_fence = ++last_fence;
+            return last_fence;
+        }
+    }
+
+    d3d_context->End(query.get());
+    pending.emplace_back(++last_fence, std::move(query));
+
+    return last_fence;
+}
+
+bool d3d_texture_device::is_complete(const uint64_t fence)
+{
+    // event queries complete in submission order
+    while (!pending.empty() && d3d_context->GetData(pending.front().second.get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK)
+    {
+        completed_fence = pending.front().first;
+        idle_queries.push_back(std::move(pending.front().second));
+        pending.pop_front();
+    }
+
+    return fence <= completed_fence;
+}
+
+void d3d_texture_device::wait(const uint64_t fence)
+{
+    d3d_context->Flush();
+
+    while (!is_complete(fence))
+        std::this_thread::yield();
+}
+
+ID2D1Bitmap1* d3d_texture_device::get_bitmap(const size_t slot) const
+{
+    return slots[slot].bitmap.get();
+}
@@ -18,16 +18,68 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 
+#include <array>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <windows.h>
 #include <d2d1_1.h>
+#include <d2d1effects.h>
 #include <d3d11.h>
 #include <dxgi1_2.h>
 #include <winrt/Windows.Graphics.Display.h>
 
+#include "color_grade.hpp"
+#include "damage_tracker.hpp"
+#include "dc_index.hpp"
+#include "frame_layers.hpp"
+#include "frame_scaler.hpp"
+#include "mip_chain.hpp"
+#include "texture_ring.hpp"
+#include "thread_pool.hpp"
+#include "theme_types.hpp"
 
-const enum WND_TYPE { WND_TYPE_MAIN, WND_TYPE_COMP_DENOISE, WND_TYPE_WDB };
+
+/**
+ * GDI-compatible textures of one window, each with the Direct2D bitmap the frame is drawn from
+ * Fences are D3D11 event queries, recycled once they completed
+ */
+class d3d_texture_device : public texture_device
+{
+    typedef struct slot
+    {
+        winrt::com_ptr<ID3D11Texture2D> texture;
+        winrt::com_ptr<IDXGISurface1> surface;
+        winrt::com_ptr<ID2D1Bitmap1> bitmap;
+    } slot_t;
+
+    winrt::com_ptr<ID3D11Device> d3d_device;
+    winrt::com_ptr<ID3D11DeviceContext> d3d_context;
+    winrt::com_ptr<ID2D1DeviceContext> d2d_context;
+    D2D1_BITMAP_PROPERTIES1 bitmap_props;
+    std::vector<slot_t> slots;
+    std::deque<std::pair<uint64_t, winrt::com_ptr<ID3D11Query>>> pending;
+    std::vector<winrt::com_ptr<ID3D11Query>> idle_queries;
+    uint64_t last_fence = 0;
+    uint64_t completed_fence = 0;
+
+public:
+    d3d_texture_device(const winrt::com_ptr<ID3D11Device>& d3d_device, const winrt::com_ptr<ID2D1DeviceContext>& d2d_context,
+                       const D2D1_BITMAP_PROPERTIES1& bitmap_props, size_t slot_count);
+
+    bool create_slot(size_t slot, uint32_t width, uint32_t height) override;
+    void destroy_slot(size_t slot) override;
+    void* acquire_dc(size_t slot) override;
+    bool release_dc(size_t slot) override;
+    void copy(size_t dst_slot, size_t src_slot) override;
+    uint64_t signal() override;
+    bool is_complete(uint64_t fence) override;
+    void wait(uint64_t fence) override;
+    ID2D1Bitmap1* get_bitmap(size_t slot) const;
+};
 
 typedef struct window_ctx
 {
@@ -41,11 +93,42 @@ typedef struct window_ctx
     winrt::com_ptr<IDXGISwapChain1> swap_chain;
     winrt::com_ptr<ID2D1DeviceContext> d2d_context;
     winrt::com_ptr<ID2D1Bitmap1> target_bitmap;
-    winrt::com_ptr<ID2D1Bitmap1> source_bitmap;
-    winrt::com_ptr<ID3D11Texture2D> source_texture;
-    winrt::com_ptr<IDXGISurface1> source_surface;
+    std::shared_ptr<d3d_texture_device> source_device;
+    std::shared_ptr<texture_ring> source_ring; // declared after its device, so it is destroyed first
+    winrt::com_ptr<ID2D1Effect> grade_effect;
+    std::array<winrt::com_ptr<ID2D1Bitmap1>, mip_chain::LEVEL_SCALES.size()> mip_levels; // index 0 is unused, created on first use
+    damage_tracker damage;
+    std::vector<RECT> damage_rects; // window coordinates of what the last presented frame changed
+    bool damage_full; // the last presented frame may have changed everywhere
+    uint32_t full_frames_due; // frames to draw and present whole, one per swap chain buffer after it lost its content
+    LONG present_cx;
+    LONG present_cy;
+    // copy of the memory DC for hashing, only if GDI doesn't expose the bits of the surface
+    HDC capture_dc;
+    HBITMAP capture_bitmap;
+    const uint8_t* capture_bits;
+    uint64_t frames_skipped;
+    uint64_t frames_partial;
+    uint64_t frames_full;
+    // software rendering, the memory DC draws into this DIB and the frame is scaled on the CPU
+    HBITMAP soft_bitmap;
+    const uint8_t* soft_bits;
+    std::shared_ptr<frame_scaler> soft_scaler;
+    std::vector<uint8_t> soft_frame;
+    std::vector<uint8_t> soft_level; // mip level the frame is scaled from if mip scaling is on
+    std::shared_ptr<frame_layers> soft_layers; // keeps soft_frame ungraded, the graded copy is soft_graded
+    uint64_t soft_layers_serial; // serial of the background the layers were given, 0 if none
+    std::vector<uint8_t> soft_graded;
 } window_ctx_t;
 
+typedef struct window_background
+{
+    std::vector<uint8_t> pixels; // BGRX, top-down
+    uint32_t width;
+    uint32_t height;
+    uint64_t serial;
+} window_background_t;
+
 class window_manager
 {
 private:
@@ -62,12 +145,33 @@ private:
     winrt::com_ptr<IDXGIDevice> dxgi_device;
     winrt::com_ptr<IDXGIAdapter> adapter;
     winrt::com_ptr<IDXGIFactory2> dxgi_factory;
+    color_grade grade;
+    bool mip_scaling = false;
+    size_t texture_ring_size = 1;
+    bool damage_tracking = false;
+    bool software = false; // for windows created from now on, a window renders in software if it has soft_bitmap
+    frame_filter scaling_filter = FRAME_FILTER_HQ_CUBIC;
+    std::unique_ptr<thread_pool> soft_pool;
+    bool layered_compositing = true;
+    std::unordered_map<WND_TYPE, window_background_t> backgrounds;
+    uint64_t background_serial = 0;
+    // more rectangles than this cost more in Direct2D clips and DWM composition than they save
+    static constexpr size_t DAMAGE_MAX_RECTS = 8;
+    static constexpr uint32_t SWAP_CHAIN_BUFFERS = 2;
+    dc_index dcs;
+    WND_TYPE active_wnd_type = WND_TYPE_MAIN;
     D2D1_BITMAP_PROPERTIES1 target_bitmap_props = {
         {DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE},
         96.0f, 96.0f,
         D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
         nullptr
     };
+    D2D1_BITMAP_PROPERTIES1 mip_bitmap_props = {
+        {DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE},
+        96.0f, 96.0f,
+        D2D1_BITMAP_OPTIONS_TARGET,
+        nullptr
+    };
     D2D1_BITMAP_PROPERTIES1 source_bitmap_props = {
         {DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE},
         96.0f, 96.0f,
@@ -98,4 +202,41 @@ public:
     void scale_coords_inverse(HWND hwnd, POINT& pt);
     void scale_to_main_wnd(int& x, int& y, int& cx, int& cy);
     void resize_child_windows();
+    void set_color_grade(const grade_settings_t& settings);
+    void set_mip_scaling(bool enabled);
+    void set_texture_ring_size(size_t size);
+    void set_damage_tracking(bool enabled);
+    void set_software_rendering(bool enabled);
+    void set_scaling_filter(frame_filter filter);
+    void set_layered_compositing(bool enabled);
+    void set_background(WND_TYPE type, uint32_t width, uint32_t height, std::vector<uint8_t>&& pixels);
+    bool has_background(WND_TYPE type, uint32_t width, uint32_t height) const;
+    bool is_software_rendering() const;
+    bool is_layered_compositing() const;
+    WND_TYPE get_active_wnd_type() const;
+    WND_TYPE set_active_wnd_type(WND_TYPE type);
+
+    /**
+     * Finds the window a color is drawn in, by memory DC if there is one, otherwise by the running wndproc
+     * @param hdc The device context or nullptr for pens and brushes
+     * @return The window type
+     */
+    WND_TYPE resolve_wnd_type(HDC hdc) const
+    {
+        return dcs.resolve(hdc, active_wnd_type);
+    }
+
+    const color_grade& get_color_grade() const;
+
+private:
+    void set_grade_tables(const window_ctx_t& wctx) const;
+    ID2D1Bitmap1* get_mip_level(window_ctx_t& wctx, size_t level) const;
+    const uint8_t* get_frame_bits(window_ctx_t& wctx, ptrdiff_t& stride) const;
+    bool find_damage(window_ctx_t& wctx, const RECT& rc, std::vector<RECT>& rects, bool& full) const;
+    void index_dc(HDC old_dc, HDC new_dc, WND_TYPE type);
+    void use_software_rendering();
+    bool init_window_software(window_ctx_t& wctx);
+    void render_software(window_ctx_t& wctx);
+    bool composite_layers(window_ctx_t& wctx, const image_view_t& src, const image_view_t& dst, frame_filter filter,
+                          std::vector<damage_rect_t>& written, bool& full);
 };
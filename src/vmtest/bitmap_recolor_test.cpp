@@ -0,0 +1,238 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "bitmap_recolor.hpp"
+
+namespace
+{
+typedef struct dib
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    uint32_t stride;
+    std::vector<uint8_t> bits;
+
+    dib(const uint32_t w, const uint32_t h, const uint32_t b) : width(w), height(h), bpp(b), stride(bitmap_recolor::dib_stride(w, b)), bits(static_cast<size_t>(stride) * h, 0xA5)
+    {
+    }
+
+    // pixel value in memory order, BGR plus the fourth byte at 32 bpp
+    void set(const uint32_t x, const uint32_t y, const uint32_t px)
+    {
+        std::memcpy(bits.data() + static_cast<size_t>(y) * stride + x * (bpp / 8), &px, bpp / 8);
+    }
+
+    uint32_t get(const uint32_t x, const uint32_t y) const
+    {
+        uint32_t px = 0;
+        std::memcpy(&px, bits.data() + static_cast<size_t>(y) * stride + x * (bpp / 8), bpp / 8);
+        return px;
+    }
+} dib_t;
+
+// runs of a few colors with single stray pixels, like the flat panels of a background
+dib_t theme_like(const uint32_t width, const uint32_t height, const uint32_t bpp, uint32_t seed)
+{
+    static constexpr uint32_t PALETTE[] = {0xFF362E2A, 0x00807068, 0xFFFFFFFF, 0x00FFFFFF, 0x00101010, 0x80362E2A, 0x00000000};
+    dib_t d(width, height, bpp);
+    uint32_t color = 0;
+    uint32_t left = 0;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+
+            if (left == 0)
+            {
+                color = PALETTE[(seed >> 8) % std::size(PALETTE)];
+                left = (seed >> 16) % 70;
+            }
+
+            left--;
+            d.set(x, y, (seed >> 24) % 23 == 0 ? seed : color);
+        }
+    }
+
+    return d;
+}
+
+color_map_t table_map()
+{
+    color_map_t map;
+    map.table.insert(0x2A2E36, 0x503010);
+    map.table.insert(0xFFFFFF, 0x0000FF);
+    map.table.insert(0x101010, 0x202020);
+    map.table.insert(0x000000, 0x123456);
+    return map;
+}
+
+color_map_t lut_map()
+{
+    auto map = table_map();
+    color_rule_t rule = {};
+    rule.type = RULE_HUE_ROTATE;
+    rule.amount = 120.0f;
+    map.lut.bake({rule}, LUT_NEAREST);
+    return map;
+}
+
+void expect_matches_scalar(const dib_t& source, const color_map_t& map)
+{
+    auto fast = source;
+    auto reference = source;
+
+    bitmap_recolor::apply(fast.bits.data(), fast.width, fast.height, fast.stride, fast.bpp, map);
+    bitmap_recolor::apply_scalar(reference.bits.data(), reference.width, reference.height, reference.stride, reference.bpp, map);
+
+    ASSERT_EQ(fast.bits, reference.bits) << source.width << "x" << source.height << " " << source.bpp << " bpp";
+}
+}
+
+TEST(bitmap_recolor, stride_is_padded_to_four_bytes)
+{
+    EXPECT_EQ(bitmap_recolor::dib_stride(1, 24), 4u);
+    EXPECT_EQ(bitmap_recolor::dib_stride(5, 24), 16u);
+    EXPECT_EQ(bitmap_recolor::dib_stride(1645, 24), 4936u);
+    EXPECT_EQ(bitmap_recolor::dib_stride(1645, 32), 6580u);
+}
+
+TEST(bitmap_recolor, palette_size_follows_the_bit_depth)
+{
+    EXPECT_EQ(bitmap_recolor::palette_size(1, 0), 2u);
+    EXPECT_EQ(bitmap_recolor::palette_size(4, 0), 16u);
+    EXPECT_EQ(bitmap_recolor::palette_size(8, 0), 256u);
+    EXPECT_EQ(bitmap_recolor::palette_size(8, 20), 20u);
+    EXPECT_EQ(bitmap_recolor::palette_size(4, 300), 16u);
+
+    // JPEG/PNG compressed (0) and direct color bitmaps have no palette to recolor
+    for (const uint32_t bpp : {0u, 2u, 16u, 24u, 32u})
+        EXPECT_EQ(bitmap_recolor::palette_size(bpp, 0), 0u) << bpp;
+}
+
+TEST(bitmap_recolor, recolors_every_entry_of_a_full_8bpp_palette)
+{
+    const auto map = table_map();
+
+    // an 8 bpp header with biClrUsed 0 has all 256 entries, the RGBQUADs are recolored as one 32 bpp row
+    const uint32_t colors = bitmap_recolor::palette_size(8, 0);
+    dib_t palette(colors, 1, 32);
+
+    for (uint32_t i = 0; i < colors; i++)
+        palette.set(i, 0, i);
+
+    palette.set(1, 0, 0x00362E2A);
+    palette.set(colors - 1, 0, 0x00FFFFFF);
+
+    bitmap_recolor::apply(palette.bits.data(), colors, 1, colors * 4, 32, map);
+
+    EXPECT_EQ(palette.get(1, 0), 0x00103050u);
+    EXPECT_EQ(palette.get(colors - 1, 0), 0x00FF0000u);
+    EXPECT_EQ(palette.get(2, 0), 2u);
+}
+
+TEST(bitmap_recolor, maps_listed_colors_and_keeps_the_rest)
+{
+    const auto map = table_map();
+
+    for (const uint32_t bpp : {24u, 32u})
+    {
+        dib_t d(4, 1, bpp);
+        d.set(0, 0, 0xFF362E2A);
+        d.set(1, 0, 0x7FFFFFFF);
+        d.set(2, 0, 0x00ABCDEF);
+        d.set(3, 0, 0x00000000);
+
+        bitmap_recolor::apply(d.bits.data(), d.width, d.height, d.stride, d.bpp, map);
+
+        // the fourth byte is kept at 32 bpp and doesn't exist at 24 bpp
+        const uint32_t mask = bpp == 32 ? 0xFFFFFFFF : 0x00FFFFFF;
+        EXPECT_EQ(d.get(0, 0), 0xFF103050 & mask);
+        EXPECT_EQ(d.get(1, 0), 0x7FFF0000 & mask);
+        EXPECT_EQ(d.get(2, 0), 0x00ABCDEF);
+        EXPECT_EQ(d.get(3, 0), 0x00563412);
+
+        // row padding is left alone
+        for (uint32_t i = 4 * bpp / 8; i < d.stride; i++)
+            EXPECT_EQ(d.bits[i], 0xA5);
+    }
+}
+
+TEST(bitmap_recolor, vector_kernels_match_scalar_reference)
+{
+    const auto tables = table_map();
+    const auto luts = lut_map();
+
+    for (const uint32_t bpp : {24u, 32u})
+    {
+        // every tail length of the SSE2 and AVX2 loops
+        for (uint32_t width = 1; width <= 70; width++)
+        {
+            const auto d = theme_like(width, 3, bpp, width);
+            expect_matches_scalar(d, tables);
+            expect_matches_scalar(d, luts);
+        }
+
+        const auto background = theme_like(1645, 835, bpp, 7);
+        expect_matches_scalar(background, tables);
+        expect_matches_scalar(background, luts);
+    }
+}
+
+TEST(bitmap_recolor, runs_of_white_are_mapped)
+{
+    const auto map = table_map();
+
+    // the fast path compares whole vectors against the current run, white must not look like an empty run
+    for (const uint32_t bpp : {24u, 32u})
+    {
+        dib_t d(64, 2, bpp);
+
+        for (uint32_t y = 0; y < d.height; y++)
+        {
+            for (uint32_t x = 0; x < d.width; x++)
+                d.set(x, y, 0xFFFFFFFF);
+        }
+
+        expect_matches_scalar(d, map);
+
+        bitmap_recolor::apply(d.bits.data(), d.width, d.height, d.stride, d.bpp, map);
+        EXPECT_EQ(d.get(0, 0), (bpp == 32 ? 0xFFFF0000 : 0x00FF0000));
+        EXPECT_EQ(d.get(63, 1), (bpp == 32 ? 0xFFFF0000 : 0x00FF0000));
+    }
+}
+
+TEST(bitmap_recolor, unsupported_formats_are_untouched)
+{
+    const auto map = table_map();
+    dib_t d(16, 4, 16);
+    const auto before = d.bits;
+
+    EXPECT_FALSE(bitmap_recolor::is_supported(16));
+    bitmap_recolor::apply(d.bits.data(), d.width, d.height, d.stride, d.bpp, map);
+    bitmap_recolor::apply_scalar(d.bits.data(), d.width, d.height, d.stride, d.bpp, map);
+
+    EXPECT_EQ(d.bits, before);
+}
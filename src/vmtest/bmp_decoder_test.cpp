@@ -0,0 +1,248 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+
+namespace
+{
+void write32(std::vector<uint8_t>& file, const size_t pos, const uint32_t v)
+{
+    for (size_t i = 0; i < 4; i++)
+        file[pos + i] = static_cast<uint8_t>(v >> (i * 8));
+}
+
+uint32_t next(uint32_t& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+/**
+ * Builds a bitmap file with random pixels
+ * 16 bpp with masks is stored as BI_BITFIELDS RGB565, right after a plain info header
+ */
+std::vector<uint8_t> make_bmp(const uint32_t width, const uint32_t height, const uint32_t bpp, const bool top_down, const bool rgb565, uint32_t seed)
+{
+    auto file = bmp_decoder::create_bmp(width, height, bpp);
+
+    if (rgb565)
+    {
+        file.insert(file.begin() + 54, 12, 0);
+        write32(file, 2, static_cast<uint32_t>(file.size()));
+        write32(file, 10, 54 + 12);
+        write32(file, 30, BMP_COMPRESSION_BITFIELDS);
+        write32(file, 54, 0xF800);
+        write32(file, 58, 0x7E0);
+        write32(file, 62, 0x1F);
+    }
+
+    if (top_down)
+        write32(file, 22, static_cast<uint32_t>(-static_cast<int32_t>(height)));
+
+    for (size_t i = rgb565 ? 66 : 54; i < file.size(); i++)
+        file[i] = static_cast<uint8_t>(next(seed));
+
+    return file;
+}
+
+typedef struct quiet_log
+{
+    spdlog::level::level_enum prev = spdlog::get_level();
+
+    quiet_log()
+    {
+        spdlog::set_level(spdlog::level::off);
+    }
+
+    ~quiet_log()
+    {
+        spdlog::set_level(prev);
+    }
+} quiet_log_t;
+}
+
+TEST(bmp_decoder, parses_what_create_bmp_writes)
+{
+    const auto file = bmp_decoder::create_bmp(1645, 835, 24);
+    const auto info = bmp_decoder::parse(file.data(), file.size());
+
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->width, 1645u);
+    EXPECT_EQ(info->height, 835u);
+    EXPECT_FALSE(info->top_down);
+    EXPECT_EQ(info->bpp, 24u);
+    EXPECT_EQ(info->pixel_offset, 54u);
+    EXPECT_EQ(info->stride, 4936u);
+}
+
+TEST(bmp_decoder, flips_rows_and_expands_pixels)
+{
+    // 2x2 bottom-up 24 bpp: the first stored row is the bottom one
+    auto file = bmp_decoder::create_bmp(2, 2, 24);
+    const uint8_t rows[] = {1, 2, 3, 4, 5, 6, 0, 0, 7, 8, 9, 10, 11, 12, 0, 0};
+    std::memcpy(file.data() + 54, rows, sizeof(rows));
+
+    const auto info = bmp_decoder::parse(file.data(), file.size());
+    ASSERT_TRUE(info.has_value());
+
+    std::vector<uint8_t> dst(16, 0xEE);
+    ASSERT_TRUE(bmp_decoder::convert(file.data(), file.size(), *info, dst.data(), {2, 2, true, 32}));
+
+    const std::vector<uint8_t> expected = {7, 8, 9, 0, 10, 11, 12, 0, 1, 2, 3, 0, 4, 5, 6, 0};
+    EXPECT_EQ(dst, expected);
+}
+
+TEST(bmp_decoder, vector_kernels_match_scalar_reference)
+{
+    typedef struct source
+    {
+        uint32_t bpp;
+        bool rgb565;
+    } source_t;
+
+    uint32_t seed = 1;
+
+    for (const auto& [bpp, rgb565] : {source_t{16, false}, {16, true}, {24, false}, {32, false}})
+    {
+        for (uint32_t width = 1; width <= 40; width++)
+        {
+            for (const bool src_top_down : {false, true})
+            {
+                const auto file = make_bmp(width, 3, bpp, src_top_down, rgb565, seed++);
+                const auto info = bmp_decoder::parse(file.data(), file.size());
+                ASSERT_TRUE(info.has_value());
+
+                for (const uint32_t dst_bpp : {24u, 32u})
+                {
+                    for (const bool dst_top_down : {false, true})
+                    {
+                        const dib_layout_t layout = {width, 3, dst_top_down, dst_bpp};
+                        std::vector<uint8_t> fast(bmp_decoder::dib_size(layout), 0xEE);
+                        std::vector<uint8_t> reference(fast.size(), 0xEE);
+
+                        ASSERT_TRUE(bmp_decoder::convert(file.data(), file.size(), *info, fast.data(), layout));
+                        ASSERT_TRUE(bmp_decoder::convert_scalar(file.data(), file.size(), *info, reference.data(), layout));
+                        ASSERT_EQ(fast, reference) << bpp << (rgb565 ? " bpp 565 " : " bpp ") << width << " px to " << dst_bpp << " bpp";
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(bmp_decoder, rejects_layouts_of_another_size)
+{
+    const auto file = bmp_decoder::create_bmp(16, 8, 24);
+    const auto info = bmp_decoder::parse(file.data(), file.size());
+    ASSERT_TRUE(info.has_value());
+
+    quiet_log_t quiet;
+    std::vector<uint8_t> dst(bmp_decoder::dib_size({17, 8, false, 32}));
+
+    EXPECT_FALSE(bmp_decoder::convert(file.data(), file.size(), *info, dst.data(), {17, 8, false, 32}));
+    EXPECT_FALSE(bmp_decoder::convert(file.data(), file.size(), *info, dst.data(), {16, 7, false, 32}));
+    EXPECT_FALSE(bmp_decoder::convert(file.data(), file.size(), *info, dst.data(), {16, 8, false, 16}));
+}
+
+TEST(bmp_decoder, direct_mapping_needs_identical_layout_and_alignment)
+{
+    const auto file = bmp_decoder::create_bmp(16, 8, 24);
+    const auto info = bmp_decoder::parse(file.data(), file.size());
+    ASSERT_TRUE(info.has_value());
+
+    // 54 bytes of headers, the file has to start 2 bytes into the section for the pixels to be DWORD aligned
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, file.size(), {16, 8, false, 24}));
+    EXPECT_TRUE(bmp_decoder::is_direct_mappable(*info, file.size(), {16, 8, false, 24}, 2));
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, file.size(), {16, 8, true, 24}, 2));
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, file.size(), {16, 8, false, 32}, 2));
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, file.size() - 1, {16, 8, false, 24}, 2));
+}
+
+TEST(bmp_decoder, truncated_files_are_rejected)
+{
+    quiet_log_t quiet;
+
+    for (const uint32_t bpp : {16u, 24u, 32u})
+    {
+        const auto file = make_bmp(13, 7, bpp, false, bpp == 16, bpp);
+
+        for (size_t size = 0; size < file.size(); size++)
+            EXPECT_FALSE(bmp_decoder::parse(file.data(), size).has_value()) << bpp << " bpp, " << size << " bytes";
+    }
+}
+
+/**
+ * Corrupts header fields and random bytes of valid files
+ * Whatever parse accepts must convert without reading past the file, run under ASan to catch that
+ */
+TEST(bmp_decoder, fuzzed_headers_never_read_out_of_bounds)
+{
+    quiet_log_t quiet;
+    uint32_t seed = 42;
+    uint32_t accepted = 0;
+
+    // the fields the decoder reads, offsets into the file
+    static constexpr size_t FIELDS[] = {0, 1, 2, 10, 11, 14, 18, 19, 21, 22, 25, 26, 28, 30, 34, 54, 58, 62};
+
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        const uint32_t bpp = std::array<uint32_t, 3>{16, 24, 32}[next(seed) % 3];
+        auto file = make_bmp(1 + next(seed) % 33, 1 + next(seed) % 9, bpp, next(seed) % 2, bpp == 16 && next(seed) % 2, seed);
+
+        for (uint32_t m = 1 + next(seed) % 4; m > 0; m--)
+        {
+            // the mask fields lie past the end of the smallest files
+            const size_t pos = (next(seed) % 2 ? FIELDS[next(seed) % std::size(FIELDS)] : next(seed)) % file.size();
+            file[pos] = next(seed) % 4 == 0 ? static_cast<uint8_t>(file[pos] ^ (1 << next(seed) % 8)) : static_cast<uint8_t>(next(seed));
+        }
+
+        // an exact-size copy so ASan sees any read past the end
+        const size_t size = next(seed) % 8 == 0 ? next(seed) % file.size() : file.size();
+        const std::vector<uint8_t> data(file.begin(), file.begin() + static_cast<std::ptrdiff_t>(size));
+        const auto info = bmp_decoder::parse(data.data(), data.size());
+
+        if (!info)
+            continue;
+
+        accepted++;
+
+        if (static_cast<uint64_t>(info->width) * info->height > 1u << 20)
+            continue;
+
+        for (const uint32_t dst_bpp : {24u, 32u})
+        {
+            const dib_layout_t layout = {info->width, info->height, false, dst_bpp};
+            std::vector<uint8_t> fast(bmp_decoder::dib_size(layout));
+            std::vector<uint8_t> reference(fast.size());
+
+            const bool converted = bmp_decoder::convert(data.data(), data.size(), *info, fast.data(), layout);
+            EXPECT_EQ(converted, bmp_decoder::convert_scalar(data.data(), data.size(), *info, reference.data(), layout));
+            EXPECT_EQ(fast, reference);
+        }
+    }
+
+    // most mutations hit pixels or harmless fields, the interesting part is that some files still parse
+    EXPECT_GT(accepted, 1000u);
+}
@@ -0,0 +1,255 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "color_census.hpp"
+#include "yaml-cpp/yaml.h"
+
+namespace
+{
+/**
+ * Directory below the system temp directory that is removed with everything in it
+ */
+typedef struct temp_dir
+{
+    std::filesystem::path path;
+
+    temp_dir()
+    {
+        path = std::filesystem::temp_directory_path() / ("vmtest_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+
+    ~temp_dir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+} temp_dir_t;
+
+typedef struct quiet_log
+{
+    spdlog::level::level_enum prev = spdlog::get_level();
+
+    quiet_log()
+    {
+        spdlog::set_level(spdlog::level::off);
+    }
+
+    ~quiet_log()
+    {
+        spdlog::set_level(prev);
+    }
+} quiet_log_t;
+
+/**
+ * Finds colors that hash to the same home slot, mirrors the hash of color_census::find_slot
+ * @param count Number of colors
+ * @return The colors
+ */
+std::vector<uint32_t> colliding_colors(const size_t count)
+{
+    std::vector<uint32_t> colors;
+
+    for (uint32_t c = 0; colors.size() < count && c <= 0xFFFFFF; c++)
+    {
+        if ((c * 0x9E3779B1u) >> 20 == 0)
+            colors.push_back(c);
+    }
+
+    return colors;
+}
+}
+
+TEST(color_census, concurrent_records_claim_one_slot_per_color)
+{
+    color_census census({"shapes"});
+
+    constexpr uint32_t THREADS = 8;
+    constexpr uint32_t COLORS = 1000;
+    constexpr uint32_t ROUNDS = 50;
+
+    // every thread races for the same colors, in a different order
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&census, t]
+        {
+            for (uint32_t r = 0; r < ROUNDS; r++)
+            {
+                for (uint32_t i = 0; i < COLORS; i++)
+                {
+                    const uint32_t color = (i * 7919 + t * 131) % COLORS * 0x1021;
+                    census.record(color, 0, color & 1);
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    const auto entries = census.snapshot(0);
+    ASSERT_EQ(entries.size(), COLORS);
+
+    for (const auto& e : entries)
+    {
+        EXPECT_EQ(e.hits + e.misses, THREADS * ROUNDS) << std::hex << e.color;
+        EXPECT_EQ(e.color & 1 ? e.misses : e.hits, 0u) << std::hex << e.color;
+    }
+}
+
+TEST(color_census, ignores_the_upper_byte)
+{
+    color_census census({"text"});
+    census.record(0x01102030, 0, true);
+    census.record(0x00102030, 0, false);
+
+    const auto entries = census.snapshot(0);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].color, 0x102030u);
+    EXPECT_EQ(entries[0].hits, 1u);
+    EXPECT_EQ(entries[0].misses, 1u);
+}
+
+TEST(color_census, counts_dropped_colors_once_the_probes_run_out)
+{
+    const temp_dir_t dir;
+    color_census census({"shapes"});
+
+    // the first 32 colors take the home slot and the 31 after it, the rest find no room
+    const auto colors = colliding_colors(34);
+    ASSERT_EQ(colors.size(), 34u);
+
+    for (const auto c : colors)
+        census.record(c, 0, true);
+
+    census.record(colors[33], 0, false);
+
+    // a color that got a slot keeps counting
+    census.record(colors[0], 0, false);
+
+    const auto entries = census.snapshot(0);
+    EXPECT_EQ(entries.size(), 32u);
+
+    ASSERT_TRUE(census.write(dir.path / "census.yaml"));
+    const auto stats = YAML::LoadFile((dir.path / "census.yaml").string());
+    EXPECT_EQ(stats["shapes"]["dropped"].as<uint64_t>(), 3u);
+    EXPECT_EQ(stats["shapes"]["distinctColors"].as<uint64_t>(), 32u);
+    EXPECT_EQ(stats["shapes"]["calls"].as<uint64_t>(), 33u);
+}
+
+TEST(color_census, snapshot_is_sorted_by_calls_then_color)
+{
+    color_census census({"shapes", "text"});
+
+    const auto record = [&census](const uint32_t color, const uint32_t calls)
+    {
+        for (uint32_t i = 0; i < calls; i++)
+            census.record(color, 1, i % 2 == 0);
+    };
+
+    record(0x000005, 1);
+    record(0x000003, 4);
+    record(0x000009, 2);
+    record(0x000001, 2);
+    record(0x000007, 4);
+
+    const auto entries = census.snapshot(1);
+    ASSERT_EQ(entries.size(), 5u);
+
+    const uint32_t expected[] = {0x000003, 0x000007, 0x000001, 0x000009, 0x000005};
+
+    for (size_t i = 0; i < entries.size(); i++)
+        EXPECT_EQ(entries[i].color, expected[i]) << i;
+
+    EXPECT_EQ(entries[0].hits, 2u);
+    EXPECT_EQ(entries[0].misses, 2u);
+    EXPECT_TRUE(census.snapshot(0).empty());
+}
+
+TEST(color_census, write_replaces_the_stats_file_through_a_temporary_file)
+{
+    const temp_dir_t dir;
+    const auto path = dir.path / "census.yaml";
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+
+    {
+        std::ofstream old(path);
+        old << "stale: true\n";
+    }
+
+    color_census census({"shapes", "text"});
+    census.record(0x302010, 0, true);
+    census.record(0x302010, 0, false);
+    census.record(0x302010, 0, false);
+    census.record(0x0000FF, 1, true);
+
+    ASSERT_TRUE(census.write(path));
+    EXPECT_FALSE(std::filesystem::exists(tmp_path));
+
+    const auto stats = YAML::LoadFile(path.string());
+    EXPECT_FALSE(stats["stale"].IsDefined());
+    EXPECT_EQ(stats["shapes"]["calls"].as<uint64_t>(), 3u);
+    EXPECT_EQ(stats["shapes"]["hits"].as<uint64_t>(), 1u);
+    EXPECT_EQ(stats["shapes"]["misses"].as<uint64_t>(), 2u);
+    EXPECT_EQ(stats["shapes"]["dropped"].as<uint64_t>(), 0u);
+
+    // COLORREF is BGR, the file lists RGB hex like colors.yaml
+    ASSERT_EQ(stats["shapes"]["colors"].size(), 1u);
+    EXPECT_EQ(stats["shapes"]["colors"][0]["color"].as<std::string>(), "#102030");
+    EXPECT_EQ(stats["text"]["colors"][0]["color"].as<std::string>(), "#FF0000");
+}
+
+TEST(color_census, write_fails_without_touching_anything_if_the_directory_is_missing)
+{
+    const temp_dir_t dir;
+    const quiet_log_t quiet;
+    const auto path = dir.path / "missing" / "census.yaml";
+
+    color_census census({"shapes"});
+    census.record(0x302010, 0, true);
+
+    EXPECT_FALSE(census.write(path));
+    EXPECT_FALSE(std::filesystem::exists(dir.path / "missing"));
+}
+
+TEST(color_census, stopping_the_writer_writes_a_final_file)
+{
+    const temp_dir_t dir;
+    const auto path = dir.path / "census.yaml";
+
+    color_census census({"shapes"});
+    census.start_writer(path, std::chrono::seconds(3600));
+    census.record(0x302010, 0, true);
+    census.stop_writer();
+
+    ASSERT_TRUE(std::filesystem::exists(path));
+    EXPECT_EQ(YAML::LoadFile(path.string())["shapes"]["calls"].as<uint64_t>(), 1u);
+}
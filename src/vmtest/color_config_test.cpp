@@ -0,0 +1,117 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "color_config.hpp"
+
+namespace
+{
+// COLORREF is BGR, "#102030" is 0x302010
+constexpr uint32_t MAIN_ONLY = 0x302010;
+constexpr uint32_t BOTH = 0x605040;
+constexpr uint32_t WINDOW_ONLY = 0x908070;
+constexpr uint32_t UNLISTED = 0x123456;
+
+compiled_colors_t compile(const char* yaml)
+{
+    compiled_colors_t colors;
+    EXPECT_TRUE(color_config::compile(YAML::Load(yaml), colors));
+    return colors;
+}
+
+const char* WINDOW_RULES_YAML = R"(
+shapes:
+  "#102030": "#111111"
+  "#405060": "#222222"
+rules:
+  shapes:
+    - lightness: 0
+windows:
+  compDenoise:
+    shapes:
+      "#405060": "#333333"
+      "#708090": "#444444"
+    rules:
+      shapes:
+        - lightness: 2
+)";
+}
+
+TEST(color_config, window_mappings_take_precedence)
+{
+    const auto colors = compile(WINDOW_RULES_YAML);
+
+    EXPECT_EQ(colors.find(BOTH, CATEGORY_SHAPES, WND_TYPE_COMP_DENOISE), 0x333333u);
+    EXPECT_EQ(colors.find(WINDOW_ONLY, CATEGORY_SHAPES, WND_TYPE_COMP_DENOISE), 0x444444u);
+    EXPECT_EQ(colors.find(BOTH, CATEGORY_SHAPES, WND_TYPE_MAIN), 0x222222u);
+}
+
+TEST(color_config, main_mappings_win_over_window_rules)
+{
+    const auto colors = compile(WINDOW_RULES_YAML);
+
+    // the window's rules answer every color, the main window's explicit mapping must still apply
+    EXPECT_EQ(colors.find(MAIN_ONLY, CATEGORY_SHAPES, WND_TYPE_COMP_DENOISE), 0x111111u);
+    EXPECT_EQ(colors.find(UNLISTED, CATEGORY_SHAPES, WND_TYPE_COMP_DENOISE), 0xFFFFFFu);
+    EXPECT_EQ(colors.find(UNLISTED, CATEGORY_SHAPES, WND_TYPE_MAIN), 0x000000u);
+}
+
+TEST(color_config, main_rules_apply_last)
+{
+    const auto colors = compile(R"(
+rules:
+  text:
+    - lightness: 0
+windows:
+  wdb:
+    text:
+      "#FFFFFF": "#CDD6F4"
+)");
+
+    EXPECT_EQ(colors.find(0xFFFFFF, CATEGORY_TEXT, WND_TYPE_WDB), 0xF4D6CDu);
+    EXPECT_EQ(colors.find(UNLISTED, CATEGORY_TEXT, WND_TYPE_WDB), 0x000000u);
+    EXPECT_EQ(colors.find(0xFFFFFF, CATEGORY_TEXT, WND_TYPE_MAIN), 0x000000u);
+}
+
+TEST(color_config, windows_without_section_use_the_main_mapping)
+{
+    const auto colors = compile(WINDOW_RULES_YAML);
+
+    EXPECT_FALSE(colors.window_maps_enabled[WND_TYPE_WDB]);
+    EXPECT_EQ(colors.find(BOTH, CATEGORY_SHAPES, WND_TYPE_WDB), 0x222222u);
+    EXPECT_EQ(colors.find(UNLISTED, CATEGORY_SHAPES, WND_TYPE_WDB), 0x000000u);
+    EXPECT_EQ(colors.find(UNLISTED, CATEGORY_TEXT, WND_TYPE_WDB), std::nullopt);
+}
+
+TEST(color_config, window_sections_survive_save_and_load)
+{
+    const auto colors = compile(WINDOW_RULES_YAML);
+    std::vector<uint32_t> words;
+    color_config::save(colors, words);
+
+    compiled_colors_t loaded;
+    ASSERT_TRUE(color_config::load(words.data(), words.size(), loaded));
+
+    for (const auto color : {MAIN_ONLY, BOTH, WINDOW_ONLY, UNLISTED})
+    {
+        for (const auto wnd_type : {WND_TYPE_MAIN, WND_TYPE_COMP_DENOISE, WND_TYPE_WDB})
+            EXPECT_EQ(loaded.find(color, CATEGORY_SHAPES, wnd_type), colors.find(color, CATEGORY_SHAPES, wnd_type));
+    }
+}
@@ -0,0 +1,169 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "color_grade.hpp"
+
+namespace
+{
+std::vector<grade_settings_t> sample_settings()
+{
+    grade_settings_t gamma;
+    gamma.gamma = 1.4f;
+
+    grade_settings_t contrast;
+    contrast.contrast = 1.3f;
+
+    grade_settings_t tint;
+    tint.tint = 0x4080C0;
+    tint.tint_strength = 0.25f;
+
+    grade_settings_t night;
+    night.night_mode = 1.0f;
+
+    grade_settings_t all;
+    all.gamma = 0.8f;
+    all.contrast = 0.9f;
+    all.tint = 0x102030;
+    all.tint_strength = 0.1f;
+    all.night_mode = 0.5f;
+
+    return {gamma, contrast, tint, night, all};
+}
+
+// flat runs with stray pixels, every row starts with white
+std::vector<uint32_t> ui_like(const uint32_t width, const uint32_t height, uint32_t seed)
+{
+    std::vector<uint32_t> px(static_cast<size_t>(width) * height);
+    uint32_t color = 0xFFFFFFFF;
+    uint32_t left = 0;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+
+            if (x == 0)
+            {
+                color = 0xFFFFFFFF;
+                left = 20 + (seed >> 20) % 20;
+            }
+            else if (left == 0)
+            {
+                color = seed % 3 == 0 ? 0xFFFFFFFF : seed;
+                left = (seed >> 16) % 40;
+            }
+
+            left--;
+            px[static_cast<size_t>(y) * width + x] = (seed >> 24) % 17 == 0 ? seed : color;
+        }
+    }
+
+    return px;
+}
+
+void expect_matches_scalar(const color_grade& grade, const std::vector<uint32_t>& source, const uint32_t width, const uint32_t height)
+{
+    auto fast = source;
+    auto reference = source;
+
+    grade.apply(reinterpret_cast<uint8_t*>(fast.data()), width, height, width * 4);
+    grade.apply_scalar(reinterpret_cast<uint8_t*>(reference.data()), width, height, width * 4);
+
+    ASSERT_EQ(fast, reference) << width << "x" << height;
+}
+}
+
+TEST(color_grade, default_settings_are_identity)
+{
+    color_grade grade;
+    EXPECT_TRUE(grade.is_identity());
+
+    std::vector<uint32_t> px = {0x00123456, 0xFFFFFFFF};
+    const auto before = px;
+    grade.apply(reinterpret_cast<uint8_t*>(px.data()), 2, 1, 8);
+
+    EXPECT_EQ(px, before);
+}
+
+TEST(color_grade, night_mode_keeps_red_and_dims_blue_most)
+{
+    grade_settings_t s;
+    s.night_mode = 1.0f;
+    color_grade grade;
+    grade.build(s);
+
+    EXPECT_FALSE(grade.is_identity());
+    EXPECT_EQ(grade.get_table_r()[255], 255);
+    EXPECT_LT(grade.get_table_b()[255], grade.get_table_g()[255]);
+    EXPECT_LT(grade.get_table_g()[255], 255);
+}
+
+TEST(color_grade, vector_kernel_matches_scalar_reference)
+{
+    for (const auto& s : sample_settings())
+    {
+        color_grade grade;
+        grade.build(s);
+
+        for (uint32_t width = 1; width <= 40; width++)
+            expect_matches_scalar(grade, ui_like(width, 3, width), width, 3);
+
+        expect_matches_scalar(grade, ui_like(1645, 835, 9), 1645, 835);
+    }
+}
+
+TEST(color_grade, leading_white_vectors_are_graded)
+{
+    grade_settings_t s;
+    s.night_mode = 1.0f;
+    color_grade grade;
+    grade.build(s);
+
+    // 0xFFFFFFFF must not be mistaken for an already graded run at the start of a row
+    std::vector<uint32_t> px(64, 0xFFFFFFFF);
+    auto reference = px;
+    grade.apply(reinterpret_cast<uint8_t*>(px.data()), 32, 2, 128);
+    grade.apply_scalar(reinterpret_cast<uint8_t*>(reference.data()), 32, 2, 128);
+
+    EXPECT_EQ(px, reference);
+    EXPECT_NE(px[0], 0xFFFFFFFFu);
+    EXPECT_NE(px[0], 0u);
+}
+
+TEST(color_grade, fourth_byte_and_row_padding_are_kept)
+{
+    grade_settings_t s;
+    s.gamma = 2.0f;
+    color_grade grade;
+    grade.build(s);
+
+    // 10 pixels per row in a 12 pixel stride
+    std::vector<uint32_t> px(24, 0x7F404040);
+    px[10] = px[11] = px[22] = px[23] = 0xDEADBEEF;
+    grade.apply(reinterpret_cast<uint8_t*>(px.data()), 10, 2, 48);
+
+    EXPECT_EQ(px[0] >> 24, 0x7Fu);
+    EXPECT_NE(px[0] & 0xFFFFFF, 0x404040u);
+    EXPECT_EQ(px[11], 0xDEADBEEFu);
+    EXPECT_EQ(px[22], 0xDEADBEEFu);
+}
@@ -0,0 +1,234 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "color_config.hpp"
+#include "color_lut.hpp"
+
+namespace
+{
+uint32_t channel(const uint32_t color, const int c)
+{
+    return color >> (c * 8) & 0xFF;
+}
+
+// largest difference of any channel
+uint32_t distance(const uint32_t a, const uint32_t b)
+{
+    uint32_t d = 0;
+
+    for (int c = 0; c < 3; c++)
+        d = std::max(d, static_cast<uint32_t>(std::abs(static_cast<int32_t>(channel(a, c)) - static_cast<int32_t>(channel(b, c)))));
+
+    return d;
+}
+
+color_rule_t rule(const color_rule_type type, const float amount)
+{
+    color_rule_t r = {};
+    r.type = type;
+    r.amount = amount;
+    return r;
+}
+
+// colors spread over the whole cube, including the corners and grid nodes
+std::vector<uint32_t> sample_colors()
+{
+    std::vector<uint32_t> colors = {0x000000, 0xFFFFFF, 0x0000FF, 0x00FF00, 0xFF0000, 0x808080, 0x2A2E36};
+    uint32_t seed = 5;
+
+    for (int i = 0; i < 2000; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        colors.push_back(seed >> 8 & 0xFFFFFF);
+    }
+
+    return colors;
+}
+}
+
+TEST(color_lut, no_rules_leave_the_table_empty)
+{
+    color_lut lut;
+    lut.bake({}, LUT_TRILINEAR);
+
+    EXPECT_TRUE(lut.empty());
+}
+
+TEST(color_lut, neutral_rules_keep_colors)
+{
+    for (const auto mode : {LUT_NEAREST, LUT_TRILINEAR})
+    {
+        color_lut lut;
+        lut.bake({rule(RULE_HUE_ROTATE, 0.0f), rule(RULE_SATURATION, 1.0f), rule(RULE_LIGHTNESS, 1.0f)}, mode);
+
+        // nearest snaps to the closest of 32 nodes per axis, half a node is at most 5 levels
+        const uint32_t tolerance = mode == LUT_NEAREST ? 5 : 1;
+
+        for (const auto c : sample_colors())
+            EXPECT_LE(distance(lut.apply(c), c), tolerance) << std::hex << c;
+    }
+}
+
+TEST(color_lut, full_hue_rotation_keeps_colors)
+{
+    color_lut lut;
+    lut.bake({rule(RULE_HUE_ROTATE, 360.0f)}, LUT_TRILINEAR);
+
+    for (const auto c : sample_colors())
+        EXPECT_LE(distance(lut.apply(c), c), 2u) << std::hex << c;
+}
+
+TEST(color_lut, hue_rotation_moves_primaries)
+{
+    color_lut lut;
+    lut.bake({rule(RULE_HUE_ROTATE, 180.0f)}, LUT_TRILINEAR);
+
+    // red turns cyan-ish, gray stays gray
+    const auto red = lut.apply(0x0000FF);
+    EXPECT_LT(channel(red, 0), channel(red, 1));
+    EXPECT_LT(channel(red, 0), channel(red, 2));
+    EXPECT_LE(distance(lut.apply(0x808080), 0x808080), 1u);
+}
+
+TEST(color_lut, zero_saturation_gives_grays)
+{
+    color_lut lut;
+    lut.bake({rule(RULE_SATURATION, 0.0f)}, LUT_TRILINEAR);
+
+    for (const auto c : sample_colors())
+    {
+        const auto out = lut.apply(c);
+        EXPECT_LE(distance(out, (out & 0xFF) * 0x010101), 1u) << std::hex << c;
+    }
+}
+
+TEST(color_lut, lightness_blends_towards_black_and_white)
+{
+    color_lut black;
+    black.bake({rule(RULE_LIGHTNESS, 0.0f)}, LUT_TRILINEAR);
+    color_lut white;
+    white.bake({rule(RULE_LIGHTNESS, 2.0f)}, LUT_TRILINEAR);
+    color_lut half;
+    half.bake({rule(RULE_LIGHTNESS, 0.5f)}, LUT_TRILINEAR);
+
+    for (const auto c : sample_colors())
+    {
+        EXPECT_EQ(black.apply(c), 0x000000u);
+        EXPECT_EQ(white.apply(c), 0xFFFFFFu);
+
+        for (int ch = 0; ch < 3; ch++)
+            EXPECT_NEAR(static_cast<double>(channel(half.apply(c), ch)), channel(c, ch) / 2.0, 1.5) << std::hex << c;
+    }
+}
+
+TEST(color_lut, gray_ramp_maps_only_grays_in_range)
+{
+    color_rule_t ramp = {};
+    ramp.type = RULE_GRAY_RAMP;
+    ramp.range_min = 0x40;
+    ramp.range_max = 0xC0;
+    ramp.tolerance = 8;
+    ramp.ramp_from = 0x400000;
+    ramp.ramp_to = 0xFF8000;
+
+    color_lut lut;
+    lut.bake({ramp}, LUT_NEAREST);
+
+    // grid nodes are exact in nearest mode, node 16 of 31 is level 132
+    const uint32_t gray = 132 * 0x010101;
+    const float t = (132 - 0x40) / static_cast<float>(0xC0 - 0x40);
+    const auto out = lut.apply(gray);
+
+    EXPECT_NEAR(static_cast<double>(channel(out, 0)), 0.0, 1.0);
+    EXPECT_NEAR(static_cast<double>(channel(out, 1)), 0x80 * t, 1.0);
+    EXPECT_NEAR(static_cast<double>(channel(out, 2)), 0x40 + (0xFF - 0x40) * t, 1.0);
+
+    // saturated colors and grays outside the range are left alone
+    EXPECT_EQ(lut.apply(0x0000FF), 0x0000FFu);
+    EXPECT_EQ(lut.apply(0xFFFFFF), 0xFFFFFFu);
+    EXPECT_EQ(lut.apply(0x000000), 0x000000u);
+}
+
+TEST(color_lut, rules_apply_in_order)
+{
+    color_lut gray_then_dark;
+    gray_then_dark.bake({rule(RULE_SATURATION, 0.0f), rule(RULE_LIGHTNESS, 0.5f)}, LUT_TRILINEAR);
+
+    const auto out = gray_then_dark.apply(0xFFFFFF);
+    EXPECT_LE(distance(out, 0x808080), 1u);
+}
+
+TEST(color_lut, save_and_load_round_trip)
+{
+    color_lut lut;
+    lut.bake({rule(RULE_HUE_ROTATE, 42.0f), rule(RULE_SATURATION, 1.3f)}, LUT_NEAREST);
+
+    std::vector<uint32_t> words;
+    lut.save(words);
+
+    color_lut loaded;
+    ASSERT_EQ(loaded.load(words.data(), words.size()), words.size());
+
+    for (const auto c : sample_colors())
+        EXPECT_EQ(loaded.apply(c), lut.apply(c));
+
+    // truncated data is rejected
+    EXPECT_EQ(loaded.load(words.data(), words.size() - 1), 0u);
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST(color_lut, colors_yaml_rules_are_baked_per_category)
+{
+    const auto root = YAML::Load(R"(
+lutInterpolation: nearest
+shapes:
+  "#102030": "#FF0000"
+rules:
+  shapes:
+    - saturation: 0
+  text:
+    - lightness: 0
+)");
+
+    compiled_colors_t colors;
+    ASSERT_TRUE(color_config::compile(root, colors));
+
+    const auto& shapes = colors.maps[WND_TYPE_MAIN][CATEGORY_SHAPES];
+    const auto& text = colors.maps[WND_TYPE_MAIN][CATEGORY_TEXT];
+
+    // explicit mappings win over the rules, COLORREF is BGR
+    EXPECT_EQ(shapes.find(0x302010), 0x0000FFu);
+    EXPECT_EQ(text.find(0x123456), 0x000000u);
+
+    const auto gray = shapes.find(0x0000FF);
+    ASSERT_TRUE(gray.has_value());
+    EXPECT_LE(distance(*gray, (*gray & 0xFF) * 0x010101), 1u);
+}
+
+TEST(color_lut, invalid_rules_fail_to_compile)
+{
+    compiled_colors_t colors;
+
+    EXPECT_FALSE(color_config::compile(YAML::Load("rules: {shapes: [{lightness: 3}]}"), colors));
+    EXPECT_FALSE(color_config::compile(YAML::Load("rules: {shapes: [{blur: 1}]}"), colors));
+    EXPECT_FALSE(color_config::compile(YAML::Load("rules: {shapes: {saturation: 1}}"), colors));
+}
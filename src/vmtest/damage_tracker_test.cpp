@@ -0,0 +1,234 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "damage_tracker.hpp"
+
+namespace
+{
+// a top-down 32 bpp frame with rows padded like a DIB section of another bitmap's width
+typedef struct test_frame
+{
+    uint32_t width;
+    uint32_t height;
+    ptrdiff_t stride;
+    std::vector<uint8_t> bits;
+
+    test_frame(const uint32_t width, const uint32_t height, const uint32_t padding = 0)
+        : width(width), height(height), stride(static_cast<ptrdiff_t>(width + padding) * 4), bits(static_cast<size_t>(stride) * height)
+    {
+        uint32_t seed = 3;
+
+        for (auto& b : bits)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            b = static_cast<uint8_t>(seed >> 24);
+        }
+    }
+
+    void set(const uint32_t x, const uint32_t y, const uint32_t color)
+    {
+        memcpy(bits.data() + static_cast<ptrdiff_t>(y) * stride + x * 4, &color, 4);
+    }
+
+    void fill(const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1, const uint32_t color)
+    {
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            for (uint32_t x = x0; x < x1; x++)
+                set(x, y, color);
+        }
+    }
+} test_frame_t;
+
+constexpr uint32_t TILE = damage_tracker::TILE_SIZE;
+
+bool covers(const std::vector<damage_rect_t>& rects, const uint32_t x, const uint32_t y)
+{
+    for (const auto& r : rects)
+    {
+        if (x >= r.left && x < r.right && y >= r.top && y < r.bottom)
+            return true;
+    }
+
+    return false;
+}
+}
+
+TEST(damage_tracker, simd_hash_matches_scalar)
+{
+    // narrow widths only take the scalar tail, odd ones mix both
+    for (const uint32_t width : {1u, 7u, 8u, 9u, 31u, 32u, 33u, 64u, 100u})
+    {
+        const test_frame_t f(width, 19, 3);
+
+        EXPECT_EQ(tile_hash::hash(f.bits.data(), f.stride, width, f.height), tile_hash::hash_scalar(f.bits.data(), f.stride, width, f.height)) << width;
+
+        // bottom-up rows
+        const auto* last = f.bits.data() + (f.height - 1) * f.stride;
+        EXPECT_EQ(tile_hash::hash(last, -f.stride, width, f.height), tile_hash::hash_scalar(last, -f.stride, width, f.height)) << width;
+    }
+}
+
+TEST(damage_tracker, hash_sees_every_pixel_but_not_the_padding)
+{
+    test_frame_t f(40, 10, 4);
+    const auto base = tile_hash::hash(f.bits.data(), f.stride, f.width, f.height);
+
+    for (uint32_t y = 0; y < f.height; y++)
+    {
+        for (uint32_t x = 0; x < f.width; x++)
+        {
+            auto changed = f;
+            changed.bits[static_cast<ptrdiff_t>(y) * f.stride + x * 4 + 1] ^= 1;
+            EXPECT_NE(tile_hash::hash(changed.bits.data(), f.stride, f.width, f.height), base) << x << "," << y;
+        }
+
+        auto padded = f;
+        padded.bits[static_cast<ptrdiff_t>(y) * f.stride + f.width * 4] ^= 1;
+        EXPECT_EQ(tile_hash::hash(padded.bits.data(), f.stride, f.width, f.height), base) << y;
+    }
+}
+
+TEST(damage_tracker, first_update_reports_everything)
+{
+    const test_frame_t f(1645, 835);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+
+    // 26 x 14 tiles, the last column and row are partial
+    EXPECT_EQ(tracker.get_tile_count(), 26u * 14u);
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), 26u * 14u);
+
+    const auto rects = tracker.rects(8);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_EQ(rects[0].left, 0u);
+    EXPECT_EQ(rects[0].top, 0u);
+    EXPECT_EQ(rects[0].right, 1645u);
+    EXPECT_EQ(rects[0].bottom, 835u);
+}
+
+TEST(damage_tracker, unchanged_frame_reports_nothing)
+{
+    const test_frame_t f(300, 200);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+    tracker.update(f.bits.data(), f.stride);
+
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), 0u);
+    EXPECT_EQ(tracker.get_dirty_tiles(), 0u);
+    EXPECT_TRUE(tracker.rects(8).empty());
+}
+
+TEST(damage_tracker, single_pixel_marks_its_tile)
+{
+    test_frame_t f(300, 200);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+    tracker.update(f.bits.data(), f.stride);
+
+    // in the partial tile of the last column and row
+    f.set(299, 199, 0x12345678);
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), 1u);
+
+    const auto rects = tracker.rects(8);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_EQ(rects[0].left, 4 * TILE);
+    EXPECT_EQ(rects[0].top, 3 * TILE);
+    EXPECT_EQ(rects[0].right, 300u);
+    EXPECT_EQ(rects[0].bottom, 200u);
+}
+
+TEST(damage_tracker, runs_merge_into_rectangles)
+{
+    test_frame_t f(640, 640);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+    tracker.update(f.bits.data(), f.stride);
+
+    // a meter spanning two tile columns and three rows, and a separate knob
+    f.fill(70, 70, 190, 250, 0xFF00FF00);
+    f.fill(500, 500, 510, 510, 0xFFFF0000);
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), 2u * 3u + 1u);
+
+    const auto rects = tracker.rects(8);
+    ASSERT_EQ(rects.size(), 2u);
+    EXPECT_EQ(rects[0].left, TILE);
+    EXPECT_EQ(rects[0].top, TILE);
+    EXPECT_EQ(rects[0].right, 3 * TILE);
+    EXPECT_EQ(rects[0].bottom, 4 * TILE);
+    EXPECT_EQ(rects[1].left, 7 * TILE);
+    EXPECT_EQ(rects[1].top, 7 * TILE);
+}
+
+TEST(damage_tracker, rectangles_are_joined_down_to_the_limit)
+{
+    test_frame_t f(1645, 835);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+    tracker.update(f.bits.data(), f.stride);
+
+    // a changed pixel in every third tile of every other tile row, shifted from row to row
+    std::vector<std::pair<uint32_t, uint32_t>> changed;
+
+    for (uint32_t y = 0; y < f.height; y += 2 * TILE)
+    {
+        for (uint32_t x = (y / TILE % 4) * TILE; x < f.width; x += 3 * TILE)
+        {
+            f.set(x + 5, y + 5, 0xFFFFFFFF);
+            changed.push_back({x + 5, y + 5});
+        }
+    }
+
+    ASSERT_EQ(tracker.update(f.bits.data(), f.stride), changed.size());
+
+    for (const size_t max_rects : {1u, 3u, 8u})
+    {
+        const auto rects = tracker.rects(max_rects);
+        EXPECT_LE(rects.size(), max_rects);
+
+        for (const auto& [x, y] : changed)
+            EXPECT_TRUE(covers(rects, x, y)) << max_rects << " rectangles miss " << x << "," << y;
+
+        for (const auto& r : rects)
+        {
+            EXPECT_LE(r.right, f.width);
+            EXPECT_LE(r.bottom, f.height);
+        }
+    }
+}
+
+TEST(damage_tracker, invalidate_and_resize_report_everything_again)
+{
+    const test_frame_t f(300, 200);
+    damage_tracker tracker;
+    tracker.resize(f.width, f.height);
+    tracker.update(f.bits.data(), f.stride);
+
+    tracker.invalidate();
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), tracker.get_tile_count());
+    EXPECT_EQ(tracker.update(f.bits.data(), f.stride), 0u);
+
+    const test_frame_t larger(400, 200);
+    tracker.resize(larger.width, larger.height);
+    EXPECT_EQ(tracker.get_tile_count(), 7u * 4u);
+    EXPECT_EQ(tracker.update(larger.bits.data(), larger.stride), 7u * 4u);
+}
@@ -0,0 +1,83 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "dc_index.hpp"
+
+namespace
+{
+const void* dc(const uintptr_t n)
+{
+    return reinterpret_cast<const void*>(0x1000 + n * 0x10);
+}
+}
+
+TEST(dc_index, finds_indexed_dcs)
+{
+    dc_index dcs;
+    EXPECT_TRUE(dcs.replace(nullptr, dc(1), WND_TYPE_MAIN));
+    EXPECT_TRUE(dcs.replace(nullptr, dc(2), WND_TYPE_COMP_DENOISE));
+
+    EXPECT_EQ(dcs.find(dc(1)), WND_TYPE_MAIN);
+    EXPECT_EQ(dcs.find(dc(2)), WND_TYPE_COMP_DENOISE);
+    EXPECT_EQ(dcs.find(dc(3)), std::nullopt);
+    EXPECT_EQ(dcs.find(nullptr), std::nullopt);
+}
+
+TEST(dc_index, replaces_and_removes_dcs)
+{
+    dc_index dcs;
+    dcs.replace(nullptr, dc(1), WND_TYPE_WDB);
+
+    // the surface hands out a new DC after every render
+    EXPECT_TRUE(dcs.replace(dc(1), dc(2), WND_TYPE_WDB));
+    EXPECT_EQ(dcs.find(dc(1)), std::nullopt);
+    EXPECT_EQ(dcs.find(dc(2)), WND_TYPE_WDB);
+
+    EXPECT_TRUE(dcs.replace(dc(2), nullptr, WND_TYPE_WDB));
+    EXPECT_EQ(dcs.find(dc(2)), std::nullopt);
+
+    // removing a DC that isn't indexed is not an error
+    EXPECT_TRUE(dcs.replace(dc(3), nullptr, WND_TYPE_WDB));
+}
+
+TEST(dc_index, rejects_dcs_once_full)
+{
+    dc_index dcs;
+
+    for (uintptr_t i = 1; i <= dc_index::SIZE; i++)
+        EXPECT_TRUE(dcs.replace(nullptr, dc(i), WND_TYPE_MAIN));
+
+    EXPECT_FALSE(dcs.replace(nullptr, dc(dc_index::SIZE + 1), WND_TYPE_WDB));
+    EXPECT_EQ(dcs.find(dc(dc_index::SIZE + 1)), std::nullopt);
+
+    // a removed DC frees its slot
+    dcs.replace(dc(1), nullptr, WND_TYPE_MAIN);
+    EXPECT_TRUE(dcs.replace(nullptr, dc(dc_index::SIZE + 1), WND_TYPE_WDB));
+    EXPECT_EQ(dcs.find(dc(dc_index::SIZE + 1)), WND_TYPE_WDB);
+}
+
+TEST(dc_index, resolves_unknown_dcs_to_the_active_window)
+{
+    dc_index dcs;
+    dcs.replace(nullptr, dc(1), WND_TYPE_COMP_DENOISE);
+
+    EXPECT_EQ(dcs.resolve(dc(1), WND_TYPE_WDB), WND_TYPE_COMP_DENOISE);
+    EXPECT_EQ(dcs.resolve(dc(2), WND_TYPE_WDB), WND_TYPE_WDB);
+    EXPECT_EQ(dcs.resolve(nullptr, WND_TYPE_MAIN), WND_TYPE_MAIN);
+}
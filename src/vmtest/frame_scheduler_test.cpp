@@ -0,0 +1,204 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "frame_scheduler.hpp"
+
+namespace
+{
+// time only moves when a test advances it
+class manual_clock : public frame_clock
+{
+public:
+    uint64_t now = 1000000;
+
+    uint64_t now_us() override
+    {
+        return now;
+    }
+};
+
+constexpr uint64_t INTERVAL_US = 16000;
+constexpr uintptr_t WINDOW = 0x1234;
+}
+
+TEST(frame_scheduler, first_request_presents)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    EXPECT_TRUE(frames.is_due(WINDOW));
+    EXPECT_TRUE(frames.request(WINDOW, FRAME_PAINT));
+    EXPECT_FALSE(frames.is_dirty(WINDOW));
+}
+
+TEST(frame_scheduler, requests_within_a_frame_are_coalesced)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+
+    for (const auto reason : {FRAME_TIMER, FRAME_PAINT, FRAME_DRAG})
+    {
+        clock.now += 1000;
+        EXPECT_FALSE(frames.request(WINDOW, reason));
+    }
+
+    EXPECT_TRUE(frames.is_dirty(WINDOW));
+    EXPECT_FALSE(frames.is_due(WINDOW));
+}
+
+TEST(frame_scheduler, window_is_due_a_quarter_interval_early)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+
+    // a 64 Hz timer ticks every 15.625 ms, it has to present on every tick of a 16 ms interval
+    clock.now += INTERVAL_US * 3 / 4 - 1;
+    EXPECT_FALSE(frames.is_due(WINDOW));
+    EXPECT_FALSE(frames.request(WINDOW, FRAME_TIMER));
+
+    clock.now += 1;
+    EXPECT_TRUE(frames.is_due(WINDOW));
+    EXPECT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+    EXPECT_FALSE(frames.is_dirty(WINDOW));
+}
+
+TEST(frame_scheduler, input_presents_after_a_quarter_interval)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+
+    clock.now += INTERVAL_US / 4 - 1;
+    EXPECT_FALSE(frames.request(WINDOW, FRAME_INPUT));
+
+    clock.now += 1;
+    EXPECT_TRUE(frames.request(WINDOW, FRAME_INPUT));
+
+    // drags are paced like timer ticks
+    clock.now += INTERVAL_US / 2;
+    EXPECT_FALSE(frames.request(WINDOW, FRAME_DRAG));
+
+    const auto stats = frames.get_stats();
+    EXPECT_EQ(stats.requests, 4u);
+    EXPECT_EQ(stats.presented, 2u);
+    EXPECT_EQ(stats.coalesced, 2u);
+    EXPECT_EQ(stats.input_forced, 1u);
+}
+
+TEST(frame_scheduler, flush_is_armed_once_per_deferral)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_PAINT));
+    EXPECT_FALSE(frames.arm_flush(WINDOW).has_value());
+
+    clock.now += 5000;
+    ASSERT_FALSE(frames.request(WINDOW, FRAME_PAINT));
+
+    const auto delay = frames.arm_flush(WINDOW);
+    ASSERT_TRUE(delay.has_value());
+    EXPECT_EQ(*delay, INTERVAL_US * 3 / 4 - 5000);
+
+    // the rest of the burst doesn't push the flush back
+    clock.now += 1000;
+    ASSERT_FALSE(frames.request(WINDOW, FRAME_DRAG));
+    EXPECT_FALSE(frames.arm_flush(WINDOW).has_value());
+
+    // the flush timer fired early, the window isn't due yet so it arms again
+    frames.disarm_flush(WINDOW);
+    const auto rearmed = frames.arm_flush(WINDOW);
+    ASSERT_TRUE(rearmed.has_value());
+    EXPECT_EQ(*rearmed, INTERVAL_US * 3 / 4 - 6000);
+
+    clock.now += *rearmed;
+    EXPECT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+    EXPECT_FALSE(frames.is_dirty(WINDOW));
+    EXPECT_FALSE(frames.arm_flush(WINDOW).has_value());
+}
+
+TEST(frame_scheduler, overdue_flush_fires_right_away)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_PAINT));
+    clock.now += 1000;
+    ASSERT_FALSE(frames.request(WINDOW, FRAME_PAINT));
+
+    clock.now += INTERVAL_US;
+    const auto delay = frames.arm_flush(WINDOW);
+    ASSERT_TRUE(delay.has_value());
+    EXPECT_EQ(*delay, 0u);
+}
+
+TEST(frame_scheduler, windows_are_paced_independently)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+    constexpr uintptr_t other = 0x5678;
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+    EXPECT_TRUE(frames.request(other, FRAME_TIMER));
+
+    clock.now += 1000;
+    EXPECT_FALSE(frames.request(WINDOW, FRAME_TIMER));
+    EXPECT_TRUE(frames.is_dirty(WINDOW));
+    EXPECT_FALSE(frames.is_dirty(other));
+}
+
+TEST(frame_scheduler, forgotten_window_starts_over)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    ASSERT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+    clock.now += 1000;
+    ASSERT_FALSE(frames.request(WINDOW, FRAME_TIMER));
+
+    // a new window can get the handle of a destroyed one
+    frames.forget(WINDOW);
+    EXPECT_FALSE(frames.is_dirty(WINDOW));
+    EXPECT_TRUE(frames.is_due(WINDOW));
+    EXPECT_TRUE(frames.request(WINDOW, FRAME_TIMER));
+}
+
+TEST(frame_scheduler, drag_at_mouse_rate_presents_once_per_due_time)
+{
+    manual_clock clock;
+    frame_scheduler frames(clock, INTERVAL_US);
+
+    // a 1000 Hz mouse for one second, a present every 12 ms with the slack
+    for (int i = 0; i < 1000; i++)
+    {
+        frames.request(WINDOW, FRAME_DRAG);
+        clock.now += 1000;
+    }
+
+    const auto stats = frames.get_stats();
+    EXPECT_EQ(stats.requests, 1000u);
+    EXPECT_EQ(stats.presented, 84u);
+    EXPECT_EQ(stats.coalesced, 916u);
+    EXPECT_EQ(stats.input_forced, 0u);
+}
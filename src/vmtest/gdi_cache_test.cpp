@@ -0,0 +1,269 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gdi_cache.hpp"
+
+namespace
+{
+/**
+ * Hands out fake handles and remembers which of them are alive
+ * Pens with the null style get the same handle every time, like GDI's stock null pen
+ */
+class mock_gdi : public gdi_backend
+{
+public:
+    static constexpr uint32_t NULL_STYLE = 5;
+    static constexpr uint32_t FAILING_COLOR = 0xBAD;
+
+    std::set<void*> alive;
+    std::vector<void*> destroyed;
+    uintptr_t next = 0x1000;
+    uint32_t creates = 0;
+    uint32_t double_destroys = 0;
+
+    void* create(const gdi_object_key_t& key) override
+    {
+        creates++;
+
+        if (key.color == FAILING_COLOR)
+            return nullptr;
+
+        if (key.kind == GDI_OBJECT_PEN && key.style == NULL_STYLE)
+        {
+            const auto stock = reinterpret_cast<void*>(0x10);
+            alive.insert(stock);
+            return stock;
+        }
+
+        const auto handle = reinterpret_cast<void*>(next += 0x10);
+        alive.insert(handle);
+        return handle;
+    }
+
+    bool destroy(void* handle) override
+    {
+        if (alive.erase(handle) == 0)
+            double_destroys++;
+
+        destroyed.push_back(handle);
+        return true;
+    }
+};
+
+gdi_object_key_t pen(const uint32_t color, const uintptr_t width = 1, const uint32_t style = 0)
+{
+    return {GDI_OBJECT_PEN, style, width, color};
+}
+}
+
+TEST(gdi_cache, identical_requests_share_one_object)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 16);
+
+    void* a = cache.acquire(pen(0x123456));
+    void* b = cache.acquire(pen(0x123456));
+    void* c = cache.acquire(pen(0x123456, 2));
+    void* d = cache.acquire({GDI_OBJECT_BRUSH, 0, 1, 0x123456});
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_NE(a, d);
+    EXPECT_EQ(gdi.creates, 3u);
+
+    const auto stats = cache.get_stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.live_handles, 3u);
+    EXPECT_EQ(stats.referenced_handles, 3u);
+}
+
+TEST(gdi_cache, release_keeps_cached_objects_alive)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 16);
+
+    void* a = cache.acquire(pen(1));
+
+    EXPECT_TRUE(cache.release(a));
+    EXPECT_TRUE(cache.contains(a));
+    EXPECT_TRUE(gdi.destroyed.empty());
+    EXPECT_EQ(cache.get_stats().referenced_handles, 0u);
+
+    // unknown handles have to be deleted by the caller
+    int other;
+    EXPECT_FALSE(cache.release(&other));
+    EXPECT_FALSE(cache.contains(&other));
+}
+
+TEST(gdi_cache, evicts_least_recently_released_objects_over_capacity)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 2);
+
+    void* a = cache.acquire(pen(1));
+    void* b = cache.acquire(pen(2));
+    cache.release(b);
+    cache.release(a);
+
+    // a third object pushes the cache over capacity, b was released first
+    void* c = cache.acquire(pen(3));
+
+    ASSERT_EQ(gdi.destroyed.size(), 1u);
+    EXPECT_EQ(gdi.destroyed[0], b);
+    EXPECT_TRUE(cache.contains(a));
+    EXPECT_TRUE(cache.contains(c));
+    EXPECT_FALSE(cache.contains(b));
+    EXPECT_EQ(cache.get_stats().evictions, 1u);
+
+    // a is used again, so c becomes the oldest idle object
+    cache.release(c);
+    EXPECT_EQ(cache.acquire(pen(1)), a);
+    cache.release(a);
+    cache.acquire(pen(4));
+
+    ASSERT_EQ(gdi.destroyed.size(), 2u);
+    EXPECT_EQ(gdi.destroyed[1], c);
+}
+
+TEST(gdi_cache, never_evicts_referenced_objects)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 2);
+
+    std::vector<void*> held;
+
+    for (uint32_t i = 0; i < 8; i++)
+        held.push_back(cache.acquire(pen(i)));
+
+    EXPECT_TRUE(gdi.destroyed.empty());
+    EXPECT_EQ(cache.get_stats().live_handles, 8u);
+
+    // releasing shrinks the cache back to its capacity
+    for (void* h : held)
+        cache.release(h);
+
+    EXPECT_EQ(cache.get_stats().live_handles, 2u);
+    EXPECT_EQ(gdi.destroyed.size(), 6u);
+    EXPECT_EQ(gdi.double_destroys, 0u);
+}
+
+TEST(gdi_cache, shared_backend_handle_is_reference_counted_once)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 1);
+
+    // two keys the backend answers with the same stock handle
+    void* a = cache.acquire(pen(0x111111, 1, mock_gdi::NULL_STYLE));
+    void* b = cache.acquire(pen(0x222222, 1, mock_gdi::NULL_STYLE));
+    ASSERT_EQ(a, b);
+
+    // one caller lets go, the other one still has the object selected
+    EXPECT_TRUE(cache.release(a));
+    cache.release(cache.acquire(pen(7)));
+
+    EXPECT_TRUE(cache.contains(b));
+    EXPECT_EQ(gdi.alive.count(b), 1u);
+    EXPECT_EQ(cache.get_stats().referenced_handles, 1u);
+
+    EXPECT_TRUE(cache.release(b));
+    EXPECT_EQ(cache.get_stats().referenced_handles, 0u);
+    EXPECT_EQ(gdi.double_destroys, 0u);
+}
+
+TEST(gdi_cache, failed_creation_is_not_cached)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 4);
+
+    EXPECT_EQ(cache.acquire(pen(mock_gdi::FAILING_COLOR)), nullptr);
+    EXPECT_EQ(cache.acquire(pen(mock_gdi::FAILING_COLOR)), nullptr);
+    EXPECT_EQ(gdi.creates, 2u);
+    EXPECT_EQ(cache.get_stats().live_handles, 0u);
+}
+
+TEST(gdi_cache, extra_releases_keep_the_object)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 4);
+
+    void* a = cache.acquire(pen(1));
+    cache.release(a);
+
+    EXPECT_TRUE(cache.release(a));
+    EXPECT_TRUE(cache.contains(a));
+    EXPECT_EQ(cache.acquire(pen(1)), a);
+    EXPECT_EQ(cache.get_stats().referenced_handles, 1u);
+}
+
+TEST(gdi_cache, destructor_destroys_every_object_once)
+{
+    mock_gdi gdi;
+
+    {
+        gdi_cache cache(gdi, 2);
+
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            void* h = cache.acquire(pen(i));
+
+            if (i % 2)
+                cache.release(h);
+        }
+
+        cache.acquire(pen(0, 1, mock_gdi::NULL_STYLE));
+        cache.acquire(pen(1, 1, mock_gdi::NULL_STYLE));
+    }
+
+    EXPECT_TRUE(gdi.alive.empty());
+    EXPECT_EQ(gdi.double_destroys, 0u);
+}
+
+TEST(gdi_cache, concurrent_acquire_and_release)
+{
+    mock_gdi gdi;
+    gdi_cache cache(gdi, 8);
+    std::vector<std::thread> threads;
+
+    // the mock itself isn't thread safe, the cache calls it under its lock
+    for (uint32_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, t]
+        {
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                void* h = cache.acquire(pen((i + t) % 12));
+                cache.release(h);
+            }
+        });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    const auto stats = cache.get_stats();
+    EXPECT_EQ(stats.referenced_handles, 0u);
+    EXPECT_EQ(stats.live_handles, 8u);
+    EXPECT_EQ(stats.hits + stats.misses, 8000u);
+    EXPECT_EQ(gdi.double_destroys, 0u);
+}
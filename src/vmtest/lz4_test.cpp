@@ -0,0 +1,103 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "lz4.hpp"
+
+namespace
+{
+std::vector<uint8_t> round_trip(const std::vector<uint8_t>& src, size_t* compressed_size = nullptr)
+{
+    std::vector<uint8_t> packed(lz4::compress_bound(src.size()));
+    const auto packed_size = lz4::compress(src.data(), src.size(), packed.data(), packed.size());
+
+    if (compressed_size)
+        *compressed_size = packed_size;
+
+    std::vector<uint8_t> unpacked(src.size(), 0xEE);
+
+    if (packed_size == 0 && !src.empty())
+        return {};
+
+    if (!lz4::decompress(packed.data(), packed_size, unpacked.data(), unpacked.size()))
+        return {};
+
+    return unpacked;
+}
+}
+
+TEST(lz4, flat_colors_compress_well)
+{
+    // rows of a flat UI background with a few edges
+    std::vector<uint8_t> src(256 * 1024);
+
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = i % 4096 < 4000 ? 0x2A : static_cast<uint8_t>(i);
+
+    size_t packed_size = 0;
+    EXPECT_EQ(round_trip(src, &packed_size), src);
+    EXPECT_LT(packed_size, src.size() / 20);
+}
+
+TEST(lz4, noise_round_trips_within_the_bound)
+{
+    std::vector<uint8_t> src(70000);
+    uint32_t seed = 7;
+
+    for (auto& b : src)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(seed >> 24);
+    }
+
+    size_t packed_size = 0;
+    EXPECT_EQ(round_trip(src, &packed_size), src);
+    EXPECT_LE(packed_size, lz4::compress_bound(src.size()));
+}
+
+TEST(lz4, short_inputs_round_trip)
+{
+    for (size_t size = 1; size < 40; size++)
+    {
+        std::vector<uint8_t> src(size);
+
+        for (size_t i = 0; i < size; i++)
+            src[i] = static_cast<uint8_t>(i % 3);
+
+        EXPECT_EQ(round_trip(src), src) << size;
+    }
+}
+
+TEST(lz4, corrupt_blocks_are_rejected)
+{
+    std::vector<uint8_t> src(4096, 0x11);
+    std::vector<uint8_t> packed(lz4::compress_bound(src.size()));
+    const auto packed_size = lz4::compress(src.data(), src.size(), packed.data(), packed.size());
+    ASSERT_GT(packed_size, 0u);
+
+    std::vector<uint8_t> out(src.size());
+
+    // truncated input, wrong output size and an offset pointing before the start
+    EXPECT_FALSE(lz4::decompress(packed.data(), packed_size - 1, out.data(), out.size()));
+    EXPECT_FALSE(lz4::decompress(packed.data(), packed_size, out.data(), out.size() - 1));
+
+    const std::vector<uint8_t> bad_offset = {0x1F, 0x11, 0xFF, 0xFF, 0x00};
+    EXPECT_FALSE(lz4::decompress(bad_offset.data(), bad_offset.size(), out.data(), 20));
+}
@@ -0,0 +1,177 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+#include "mapped_file.hpp"
+#include "theme_pack.hpp"
+
+namespace
+{
+/**
+ * Directory below the system temp directory that is removed with everything in it
+ */
+typedef struct temp_dir
+{
+    std::filesystem::path path;
+
+    temp_dir()
+    {
+        path = std::filesystem::temp_directory_path() / ("vmtest_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+
+    ~temp_dir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    std::filesystem::path write(const std::string& name, const std::vector<uint8_t>& bytes) const
+    {
+        const auto file = path / name;
+        std::ofstream out(file, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return file;
+    }
+} temp_dir_t;
+
+std::vector<uint8_t> pattern(const size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+
+    for (size_t i = 0; i < size; i++)
+        bytes[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+
+    return bytes;
+}
+}
+
+TEST(mapped_file, maps_the_whole_file)
+{
+    temp_dir_t dir;
+    const auto bytes = pattern(100000);
+    mapped_file file;
+
+    ASSERT_TRUE(file.open(dir.write("a.bin", bytes)));
+    ASSERT_TRUE(file.is_open());
+    ASSERT_EQ(file.size(), bytes.size());
+    EXPECT_EQ(std::vector<uint8_t>(file.data(), file.data() + file.size()), bytes);
+
+    // views start on a page, offsets into the file keep their alignment in memory
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(file.data()) % 4096, 0u);
+}
+
+#ifndef _WIN32
+TEST(mapped_file, has_no_gdi_section)
+{
+    temp_dir_t dir;
+    mapped_file file;
+
+    ASSERT_TRUE(file.open(dir.write("a.bin", pattern(16))));
+    EXPECT_EQ(file.get_section(), nullptr);
+}
+#endif
+
+TEST(mapped_file, missing_and_empty_files_fail)
+{
+    temp_dir_t dir;
+    mapped_file file;
+
+    EXPECT_FALSE(file.open(dir.path / "missing.bin"));
+    EXPECT_FALSE(file.open(dir.write("empty.bin", {})));
+    EXPECT_FALSE(file.is_open());
+    EXPECT_EQ(file.data(), nullptr);
+    EXPECT_EQ(file.size(), 0u);
+}
+
+TEST(mapped_file, move_and_reopen_hand_over_the_mapping)
+{
+    temp_dir_t dir;
+    const auto a = pattern(5000);
+    const auto b = pattern(123);
+
+    mapped_file first;
+    ASSERT_TRUE(first.open(dir.write("a.bin", a)));
+    const uint8_t* view = first.data();
+
+    mapped_file second(std::move(first));
+    EXPECT_FALSE(first.is_open());
+    EXPECT_EQ(second.data(), view);
+    EXPECT_EQ(second.size(), a.size());
+
+    ASSERT_TRUE(second.open(dir.write("b.bin", b)));
+    EXPECT_EQ(std::vector<uint8_t>(second.data(), second.data() + second.size()), b);
+
+    second.close();
+    EXPECT_FALSE(second.is_open());
+}
+
+TEST(mapped_file, the_view_outlives_the_file_on_disk)
+{
+    temp_dir_t dir;
+    const auto bytes = pattern(8192);
+    const auto path = dir.write("a.bin", bytes);
+
+    mapped_file file;
+    ASSERT_TRUE(file.open(path));
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(std::vector<uint8_t>(file.data(), file.data() + file.size()), bytes);
+}
+
+/**
+ * The checks that decide whether a pack bitmap can back a DIB section, on the mapped pack as the DLL sees it
+ */
+TEST(mapped_file, pack_bitmaps_are_direct_mappable_from_the_mapping)
+{
+    temp_dir_t dir;
+    theme_pack::writer writer(0);
+    const auto colors = pattern(37);
+    ASSERT_TRUE(writer.add(theme_pack::SECTION_COLORS, theme_pack::COLORS_SECTION, colors.data(), colors.size()));
+
+    // 54 byte headers, the writer pads the section so the pixels land on an aligned offset
+    const dib_layout_t layout = {33, 5, false, 24};
+    const auto bmp = bmp_decoder::create_bmp(layout.width, layout.height, layout.bpp);
+    ASSERT_TRUE(writer.add(theme_pack::SECTION_BITMAP, "bg", bmp.data(), bmp.size(), 54));
+
+    mapped_file file;
+    ASSERT_TRUE(file.open(dir.write("Potato.vmtheme", writer.finish())));
+
+    theme_pack::reader reader;
+    ASSERT_TRUE(reader.open(file.data(), file.size()));
+
+    const auto section = reader.find(theme_pack::SECTION_BITMAP, "bg");
+    ASSERT_TRUE(section.has_value());
+
+    const auto info = bmp_decoder::parse(section->data, section->size);
+    ASSERT_TRUE(info.has_value());
+
+    EXPECT_TRUE(bmp_decoder::is_direct_mappable(*info, section->size, layout, section->offset));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(section->data + info->pixel_offset) % 4, 0u);
+
+    // any other layout or a misplaced file has to be copied
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, section->size, {33, 5, true, 24}, section->offset));
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, section->size, {33, 5, false, 32}, section->offset));
+    EXPECT_FALSE(bmp_decoder::is_direct_mappable(*info, section->size, layout, section->offset + 1));
+}
@@ -0,0 +1,139 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pixel_hash.hpp"
+#include "sprite_index.hpp"
+
+namespace
+{
+uint32_t hash_str(const std::string& s, const uint32_t seed = 0)
+{
+    return pixel_hash::xxh32(reinterpret_cast<const uint8_t*>(s.data()), s.size(), seed);
+}
+
+std::vector<uint8_t> noise(const size_t size, uint32_t seed)
+{
+    std::vector<uint8_t> bytes(size);
+
+    for (auto& b : bytes)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(seed >> 24);
+    }
+
+    return bytes;
+}
+}
+
+TEST(pixel_hash, matches_the_xxh32_reference)
+{
+    EXPECT_EQ(hash_str(""), 0x02CC5D05u);
+    EXPECT_EQ(hash_str("a"), 0x550D7456u);
+    EXPECT_EQ(hash_str("abc"), 0x32D153FFu);
+    EXPECT_EQ(hash_str("Nobody inspects the spammish repetition"), 0xE2293B2Fu);
+}
+
+TEST(pixel_hash, simd_matches_scalar_for_every_length)
+{
+    const auto bytes = noise(300, 3);
+
+    for (size_t len = 0; len <= bytes.size(); len++)
+    {
+        for (const uint32_t seed : {0u, 1u, 0x9E3779B1u})
+            ASSERT_EQ(pixel_hash::xxh32(bytes.data(), len, seed), pixel_hash::xxh32_scalar(bytes.data(), len, seed)) << len;
+    }
+}
+
+TEST(pixel_hash, dib_ignores_row_padding)
+{
+    for (const uint32_t bpp : {8u, 16u, 24u, 32u})
+    {
+        for (const uint32_t width : {1u, 3u, 5u, 17u, 61u})
+        {
+            const uint32_t height = 7;
+            const uint32_t row_bytes = (width * bpp + 7) / 8;
+            const uint32_t stride = (row_bytes + 3) & ~3u;
+            const auto rows = noise(static_cast<size_t>(row_bytes) * height, width * bpp);
+
+            // garbage in the padding must not change the fingerprint
+            auto padded = noise(static_cast<size_t>(stride) * height, 99);
+
+            for (uint32_t y = 0; y < height; y++)
+                memcpy(padded.data() + static_cast<size_t>(y) * stride, rows.data() + static_cast<size_t>(y) * row_bytes, row_bytes);
+
+            EXPECT_EQ(pixel_hash::dib(padded.data(), width, height, stride, bpp), pixel_hash::xxh32(rows.data(), rows.size())) << bpp << " bpp " << width;
+        }
+    }
+}
+
+TEST(pixel_hash, dib_sees_every_pixel)
+{
+    auto bits = noise(64 * 4 * 16, 5);
+    const auto before = pixel_hash::dib(bits.data(), 64, 16, 64 * 4, 32);
+
+    bits[bits.size() - 1] ^= 1;
+    EXPECT_NE(pixel_hash::dib(bits.data(), 64, 16, 64 * 4, 32), before);
+}
+
+TEST(sprite_index, finds_sprites_by_fingerprint)
+{
+    sprite_index index;
+    EXPECT_TRUE(index.empty());
+
+    index.insert({16, 16, 32, 0x1234}, 0);
+    index.insert({16, 16, 32, 0x5678}, 1);
+    index.insert({200, 50, 24, 0x1234}, 2);
+
+    EXPECT_EQ(index.size(), 3u);
+    EXPECT_EQ(index.find({16, 16, 32, 0x1234}), 0u);
+    EXPECT_EQ(index.find({16, 16, 32, 0x5678}), 1u);
+    EXPECT_EQ(index.find({200, 50, 24, 0x1234}), 2u);
+
+    // every part of the key counts
+    EXPECT_FALSE(index.find({16, 16, 24, 0x1234}).has_value());
+    EXPECT_FALSE(index.find({16, 17, 32, 0x1234}).has_value());
+    EXPECT_FALSE(index.find({16, 16, 32, 0x9999}).has_value());
+}
+
+TEST(sprite_index, later_sprites_replace_earlier_ones)
+{
+    sprite_index index;
+    index.insert({16, 16, 32, 0x1234}, 0);
+    index.insert({16, 16, 32, 0x1234}, 5);
+
+    EXPECT_EQ(index.size(), 1u);
+    EXPECT_EQ(index.find({16, 16, 32, 0x1234}), 5u);
+}
+
+TEST(sprite_index, dimensions_are_checked_without_a_hash)
+{
+    sprite_index index;
+    index.insert({16, 16, 32, 0x1234}, 0);
+    index.insert({1645, 835, 24, 0x1}, 1);
+
+    EXPECT_TRUE(index.has_dimensions(16, 16, 32));
+    EXPECT_TRUE(index.has_dimensions(1645, 835, 24));
+    EXPECT_FALSE(index.has_dimensions(16, 16, 24));
+    EXPECT_FALSE(index.has_dimensions(835, 1645, 24));
+    EXPECT_FALSE(index.has_dimensions(16, 1, 32));
+}
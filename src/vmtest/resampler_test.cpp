@@ -0,0 +1,197 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+#include "resampler.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+typedef struct image
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    std::vector<uint8_t> pixels;
+
+    image(const uint32_t width, const uint32_t height, const uint32_t channels)
+        : width(width), height(height), channels(channels), pixels(static_cast<size_t>(width) * height * channels)
+    {
+    }
+
+    image_view_t view()
+    {
+        return {pixels.data(), width, height, width * channels, channels};
+    }
+} image_t;
+
+/**
+ * Renders smooth art, gradients and soft waves without hard edges, with pixel centers at (x + 0.5) / scale
+ * Rendering it at two sizes gives a source and the ideal result of resampling between them
+ */
+image_t render(const uint32_t width, const uint32_t height, const uint32_t channels, const double scale)
+{
+    image_t img(width, height, channels);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const double u = (x + 0.5) / scale;
+            const double v = (y + 0.5) / scale;
+            uint8_t* px = img.pixels.data() + (static_cast<size_t>(y) * width + x) * channels;
+
+            px[0] = static_cast<uint8_t>(std::lround(128 + 100 * std::sin(u * 0.11) * std::cos(v * 0.07)));
+            px[1] = static_cast<uint8_t>(std::lround(40 + 170 * u / (width / scale)));
+            px[2] = static_cast<uint8_t>(std::lround(128 + 90 * std::sin((u + v) * 0.05)));
+
+            if (channels == 4)
+                px[3] = 255;
+        }
+    }
+
+    return img;
+}
+
+double psnr(const image_t& a, const image_t& b)
+{
+    double sq_sum = 0.0;
+
+    for (size_t i = 0; i < a.pixels.size(); i++)
+    {
+        const double d = static_cast<double>(a.pixels[i]) - b.pixels[i];
+        sq_sum += d * d;
+    }
+
+    return sq_sum == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / (sq_sum / a.pixels.size()));
+}
+
+int max_difference(const image_t& a, const image_t& b)
+{
+    int d = 0;
+
+    for (size_t i = 0; i < a.pixels.size(); i++)
+        d = std::max(d, std::abs(a.pixels[i] - b.pixels[i]));
+
+    return d;
+}
+}
+
+TEST(resampler, same_size_keeps_the_pixels)
+{
+    auto src = render(37, 21, 3, 1.0);
+
+    for (const auto filter : {RESAMPLE_LANCZOS3, RESAMPLE_MITCHELL})
+    {
+        image_t dst(37, 21, 3);
+        ASSERT_TRUE(resampler::resize(src.view(), dst.view(), filter));
+        EXPECT_LE(max_difference(src, dst), 1);
+    }
+}
+
+TEST(resampler, art_at_2x_shrinks_close_to_art_drawn_at_1x)
+{
+    for (const uint32_t channels : {3u, 4u})
+    {
+        auto art_2x = render(330, 168, channels, 2.0);
+        const auto art_1x = render(165, 84, channels, 1.0);
+
+        image_t dst(165, 84, channels);
+        ASSERT_TRUE(resampler::resize(art_2x.view(), dst.view(), RESAMPLE_LANCZOS3));
+        EXPECT_GT(psnr(dst, art_1x), 50.0) << channels;
+    }
+}
+
+TEST(resampler, art_at_1x_enlarges_close_to_art_drawn_at_2x)
+{
+    auto art_1x = render(165, 84, 3, 1.0);
+    const auto art_2x = render(330, 168, 3, 2.0);
+
+    image_t dst(330, 168, 3);
+    ASSERT_TRUE(resampler::resize(art_1x.view(), dst.view(), RESAMPLE_MITCHELL));
+    EXPECT_GT(psnr(dst, art_2x), 48.0);
+}
+
+TEST(resampler, simd_and_threads_match_scalar)
+{
+    thread_pool pool(4);
+
+    for (const uint32_t channels : {3u, 4u})
+    {
+        auto src = render(401, 203, channels, 1.3);
+
+        for (const auto filter : {RESAMPLE_LANCZOS3, RESAMPLE_MITCHELL})
+        {
+            for (const auto& [w, h] : {std::pair{250u, 130u}, {173u, 67u}, {613u, 301u}})
+            {
+                image_t scalar(w, h, channels);
+                image_t simd(w, h, channels);
+                image_t threaded(w, h, channels);
+
+                ASSERT_TRUE(resampler::resize_scalar(src.view(), scalar.view(), filter));
+                ASSERT_TRUE(resampler::resize(src.view(), simd.view(), filter));
+                ASSERT_TRUE(resampler::resize(src.view(), threaded.view(), filter, &pool));
+
+                // float sums in a different order may round a channel the other way
+                EXPECT_LE(max_difference(scalar, simd), 1) << w << "x" << h;
+                EXPECT_EQ(simd.pixels, threaded.pixels) << w << "x" << h;
+            }
+        }
+    }
+}
+
+TEST(resampler, invalid_images_are_rejected)
+{
+    auto src = render(8, 8, 3, 1.0);
+    image_t dst(4, 4, 3);
+    image_t dst_bgrx(4, 4, 4);
+
+    auto empty = dst.view();
+    empty.height = 0;
+
+    auto short_stride = dst.view();
+    short_stride.stride = 8;
+
+    EXPECT_FALSE(resampler::resize(src.view(), dst_bgrx.view(), RESAMPLE_LANCZOS3));
+    EXPECT_FALSE(resampler::resize(src.view(), empty, RESAMPLE_LANCZOS3));
+    EXPECT_FALSE(resampler::resize(src.view(), short_stride, RESAMPLE_LANCZOS3));
+}
+
+TEST(resampler, fit_bmp_keeps_the_aspect_ratio)
+{
+    auto art = bmp_decoder::create_bmp(320, 160, 32);
+    const auto fitted = resampler::fit_bmp(art.data(), art.size(), 100, 0);
+    ASSERT_TRUE(fitted.has_value());
+
+    const auto info = bmp_decoder::parse(fitted->data(), fitted->size());
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->width, 100u);
+    EXPECT_EQ(info->height, 50u);
+    EXPECT_EQ(info->bpp, 24u);
+
+    // art at the target size is only converted
+    const auto same = resampler::fit_bmp(art.data(), art.size(), 320, 160);
+    ASSERT_TRUE(same.has_value());
+    EXPECT_EQ(bmp_decoder::parse(same->data(), same->size())->width, 320u);
+
+    EXPECT_FALSE(resampler::fit_bmp(art.data(), 20, 100, 0).has_value());
+}
@@ -0,0 +1,304 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "texture_ring.hpp"
+
+namespace
+{
+typedef struct fake_slot
+{
+    bool exists;
+    bool dc_out;
+    uint64_t read_fence; // the frame that last read the slot on the GPU
+    int content;
+} fake_slot_t;
+
+/**
+ * Keeps a slot's content in memory and lets the GPU finish frames a fixed number of frames late
+ * GetDC of a texture the GPU still reads blocks until it is done, that is counted as a stall,
+ * every other use the real device would get wrong is counted as a violation
+ */
+class fake_device : public texture_device
+{
+public:
+    std::vector<fake_slot_t> slots;
+    uint32_t latency;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    size_t last_released = 0;
+    size_t fail_slot = SIZE_MAX;
+    bool fail_release = false;
+    uint32_t created = 0;
+    uint32_t destroyed = 0;
+    uint32_t waits = 0;
+    uint32_t stalls = 0;
+    uint32_t violations = 0;
+
+    fake_device(const size_t slot_count, const uint32_t latency) : slots(slot_count, fake_slot_t{}), latency(latency)
+    {
+    }
+
+    bool create_slot(const size_t slot, uint32_t, uint32_t) override
+    {
+        if (slot == fail_slot)
+            return false;
+
+        if (slots[slot].exists)
+            violations++;
+
+        slots[slot] = {true, false, 0, 0};
+        created++;
+        return true;
+    }
+
+    void destroy_slot(const size_t slot) override
+    {
+        if (slots[slot].dc_out || slots[slot].read_fence > completed)
+            violations++;
+
+        if (slots[slot].exists)
+            destroyed++;
+
+        slots[slot].exists = false;
+    }
+
+    void* acquire_dc(const size_t slot) override
+    {
+        if (!slots[slot].exists || slots[slot].dc_out)
+            violations++;
+
+        if (slots[slot].read_fence > completed)
+        {
+            stalls++;
+            completed = slots[slot].read_fence;
+        }
+
+        slots[slot].dc_out = true;
+        return &slots[slot];
+    }
+
+    bool release_dc(const size_t slot) override
+    {
+        if (!slots[slot].dc_out)
+            violations++;
+
+        if (fail_release)
+            return false;
+
+        slots[slot].dc_out = false;
+        last_released = slot;
+        return true;
+    }
+
+    void copy(const size_t dst_slot, const size_t src_slot) override
+    {
+        if (slots[dst_slot].dc_out || slots[src_slot].dc_out)
+            violations++;
+
+        slots[dst_slot].content = slots[src_slot].content;
+    }
+
+    uint64_t signal() override
+    {
+        submitted++;
+        slots[last_released].read_fence = submitted;
+        completed = std::max(completed, submitted > latency ? submitted - latency : 0);
+        return submitted;
+    }
+
+    bool is_complete(const uint64_t fence) override
+    {
+        return fence <= completed;
+    }
+
+    void wait(const uint64_t fence) override
+    {
+        waits++;
+        completed = std::max(completed, fence);
+    }
+};
+
+fake_slot_t& drawn(const texture_ring& ring)
+{
+    return *static_cast<fake_slot_t*>(ring.get_dc());
+}
+
+// GDI draws, the GPU reads the slot and GDI moves on to the next one
+void present(texture_ring& ring)
+{
+    ASSERT_TRUE(ring.begin_frame());
+    ASSERT_EQ(ring.get_dc(), nullptr);
+    ASSERT_TRUE(ring.end_frame());
+}
+}
+
+TEST(texture_ring, textures_are_created_once)
+{
+    for (size_t size = 1; size <= 3; size++)
+    {
+        fake_device device(size, 1);
+        texture_ring ring(device, size);
+        ASSERT_TRUE(ring.create(1645, 835));
+
+        for (int i = 0; i < 100; i++)
+            present(ring);
+
+        const auto stats = ring.get_stats();
+        EXPECT_EQ(device.created, size);
+        EXPECT_EQ(stats.textures_created, size);
+        EXPECT_EQ(stats.frame_creations, 0u);
+        EXPECT_EQ(stats.frames, 100u);
+        EXPECT_EQ(stats.dc_acquires, 101u);
+        EXPECT_EQ(device.violations, 0u);
+
+        // a single texture makes GDI wait for the GPU on every frame, a ring hands it one the GPU is done with
+        EXPECT_EQ(device.stalls, size == 1 ? 100u : 0u);
+    }
+}
+
+TEST(texture_ring, single_texture_is_never_copied)
+{
+    fake_device device(1, 1);
+    texture_ring ring(device, 1);
+    ASSERT_TRUE(ring.create(64, 64));
+
+    for (int i = 0; i < 10; i++)
+    {
+        present(ring);
+        EXPECT_EQ(ring.get_slot(), 0u);
+    }
+
+    EXPECT_EQ(ring.get_stats().copies, 0u);
+    EXPECT_EQ(ring.get_stats().fence_waits, 0u);
+}
+
+TEST(texture_ring, drawn_content_carries_over_to_the_next_texture)
+{
+    fake_device device(3, 1);
+    texture_ring ring(device, 3);
+    ASSERT_TRUE(ring.create(64, 64));
+
+    // Voicemeeter only redraws what changed, the rest has to be in the next texture already
+    for (int i = 1; i <= 10; i++)
+    {
+        const auto slot = ring.get_slot();
+        drawn(ring).content = i;
+        present(ring);
+
+        EXPECT_EQ(ring.get_slot(), (slot + 1) % 3);
+        EXPECT_EQ(drawn(ring).content, i);
+    }
+
+    EXPECT_EQ(ring.get_stats().copies, 10u);
+    EXPECT_EQ(device.violations, 0u);
+}
+
+TEST(texture_ring, waits_only_when_the_gpu_lags_behind_the_ring)
+{
+    typedef struct ring_case
+    {
+        size_t size;
+        uint32_t latency;
+        uint64_t waits;
+    } ring_case_t;
+
+    // the next texture was read size - 1 frames ago, the ring waits on every frame once the GPU lags that far
+    constexpr ring_case_t cases[] = {{2, 0, 0}, {2, 1, 0}, {2, 2, 99}, {3, 2, 0}, {3, 3, 98}};
+
+    for (const auto& [size, latency, waits] : cases)
+    {
+        fake_device device(size, latency);
+        texture_ring ring(device, size);
+        ASSERT_TRUE(ring.create(64, 64));
+
+        for (int i = 0; i < 100; i++)
+            present(ring);
+
+        EXPECT_EQ(ring.get_stats().fence_waits, waits) << size << " textures, " << latency << " frames latency";
+        EXPECT_EQ(device.stalls, 0u) << size << " textures, " << latency << " frames latency";
+        EXPECT_EQ(device.violations, 0u) << size << " textures, " << latency << " frames latency";
+    }
+}
+
+TEST(texture_ring, failed_creation_releases_the_created_textures)
+{
+    fake_device device(3, 1);
+    device.fail_slot = 2;
+    texture_ring ring(device, 3);
+
+    EXPECT_FALSE(ring.create(64, 64));
+    EXPECT_EQ(ring.get_dc(), nullptr);
+    EXPECT_FALSE(ring.begin_frame());
+    EXPECT_EQ(device.created, 2u);
+    EXPECT_EQ(device.destroyed, 2u);
+    EXPECT_EQ(device.violations, 0u);
+}
+
+TEST(texture_ring, failed_release_skips_the_frame)
+{
+    fake_device device(2, 1);
+    texture_ring ring(device, 2);
+    ASSERT_TRUE(ring.create(64, 64));
+
+    device.fail_release = true;
+    EXPECT_FALSE(ring.begin_frame());
+    EXPECT_NE(ring.get_dc(), nullptr);
+
+    device.fail_release = false;
+    present(ring);
+    EXPECT_EQ(ring.get_stats().frames, 1u);
+}
+
+TEST(texture_ring, destroy_waits_for_the_gpu)
+{
+    fake_device device(2, 2);
+
+    {
+        texture_ring ring(device, 2);
+        ASSERT_TRUE(ring.create(64, 64));
+        present(ring);
+        present(ring);
+    }
+
+    // the last two frames were still in flight
+    EXPECT_EQ(device.destroyed, 2u);
+    EXPECT_GE(device.waits, 1u);
+    EXPECT_EQ(device.completed, device.submitted);
+    EXPECT_EQ(device.violations, 0u);
+}
+
+TEST(texture_ring, resize_recreates_the_textures)
+{
+    fake_device device(2, 1);
+    texture_ring ring(device, 2);
+    ASSERT_TRUE(ring.create(64, 64));
+    present(ring);
+
+    ASSERT_TRUE(ring.create(128, 64));
+    EXPECT_EQ(ring.get_slot(), 0u);
+
+    const auto stats = ring.get_stats();
+    EXPECT_EQ(stats.textures_created, 4u);
+    EXPECT_EQ(stats.frame_creations, 2u);
+    EXPECT_EQ(device.destroyed, 2u);
+    EXPECT_EQ(device.violations, 0u);
+}
@@ -0,0 +1,216 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+#include "mapped_file.hpp"
+#include "theme_cache.hpp"
+#include "theme_compiler.hpp"
+#include "theme_loader.hpp"
+#include "theme_pack.hpp"
+
+namespace
+{
+/**
+ * themes folder below the system temp directory with one theme, removed with everything in it
+ */
+typedef struct temp_themes
+{
+    std::filesystem::path root;
+    std::filesystem::path theme_root;
+    std::filesystem::path cache_dir;
+    flavor_info_t flavor = {"potato", FLAVOR_POTATO, 8};
+
+    temp_themes()
+    {
+        root = std::filesystem::temp_directory_path() / ("vmtest_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        theme_root = root / "dark";
+        cache_dir = root / theme_cache::DIR_NAME;
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(theme_root / flavor.name);
+        std::filesystem::create_directories(theme_root / "sprites");
+
+        write("colors.yaml", "shapes:\n  \"#102030\": \"#FF0000\"\n");
+        write("sprites.yaml", "sprites:\n  - {width: 4, height: 2, bpp: 32, hash: \"1a2b3c4d\", file: knob}\n");
+        write(std::filesystem::path("sprites") / "knob.bmp", make_bmp(4, 2, 1));
+        write(std::filesystem::path(flavor.name) / "bg.bmp", make_bmp(8, 4, 2));
+    }
+
+    ~temp_themes()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+    }
+
+    void write(const std::filesystem::path& name, const std::vector<uint8_t>& bytes) const
+    {
+        std::ofstream out(theme_root / name, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void write(const std::filesystem::path& name, const std::string& text) const
+    {
+        write(name, std::vector<uint8_t>(text.begin(), text.end()));
+    }
+
+    static std::vector<uint8_t> make_bmp(const uint32_t width, const uint32_t height, const uint8_t seed)
+    {
+        auto file = bmp_decoder::create_bmp(width, height, 32);
+
+        for (size_t i = 54; i < file.size(); i++)
+            file[i] = static_cast<uint8_t>(i * seed);
+
+        return file;
+    }
+} temp_themes_t;
+
+/**
+ * Starts the theme like the DLL does on a cache miss: the loader reads the folder, the writer compiles from its results
+ * @return The pack that was stored
+ */
+std::vector<uint8_t> cold_start(const temp_themes_t& themes, const std::filesystem::path& entry)
+{
+    theme_loader loader;
+    loader.start(themes.theme_root, themes.flavor);
+    auto& loaded = loader.join();
+
+    EXPECT_TRUE(loaded.colors_ok && loaded.sprites_ok && loaded.bg_main_ok);
+
+    const std::vector<uint8_t> bg_main(loaded.bg_main.data(), loaded.bg_main.data() + loaded.bg_main.size());
+    const auto compiled = theme_compiler::compile(themes.theme_root, themes.flavor, loaded.colors, loaded.sprite_entries, bg_main);
+
+    if (!compiled)
+        return {};
+
+    EXPECT_TRUE(theme_cache::store(entry, *compiled));
+    theme_cache::prune(entry);
+    return *compiled;
+}
+}
+
+TEST(theme_cache, key_follows_size_and_write_time)
+{
+    const temp_themes_t themes;
+    const auto key = theme_cache::key(themes.theme_root, themes.flavor);
+    ASSERT_TRUE(key.has_value());
+    EXPECT_EQ(theme_cache::key(themes.theme_root, themes.flavor), key);
+
+    // same size, only the write time differs
+    const auto bg = themes.theme_root / themes.flavor.name / "bg.bmp";
+    std::filesystem::last_write_time(bg, std::filesystem::last_write_time(bg) + std::chrono::seconds(5));
+    const auto touched = theme_cache::key(themes.theme_root, themes.flavor);
+    EXPECT_NE(touched, key);
+
+    themes.write("colors.yaml", "shapes:\n  \"#102030\": \"#00FF00\"\n  \"#FFFFFF\": \"#000000\"\n");
+    EXPECT_NE(theme_cache::key(themes.theme_root, themes.flavor), touched);
+
+    const auto edited = theme_cache::key(themes.theme_root, themes.flavor);
+    themes.write(std::filesystem::path("sprites") / "fader.bmp", temp_themes_t::make_bmp(2, 2, 3));
+    EXPECT_NE(theme_cache::key(themes.theme_root, themes.flavor), edited);
+
+    // other flavors don't count
+    std::filesystem::create_directories(themes.theme_root / "banana");
+    const auto with_sprite = theme_cache::key(themes.theme_root, themes.flavor);
+    themes.write(std::filesystem::path("banana") / "bg.bmp", temp_themes_t::make_bmp(8, 4, 4));
+    EXPECT_EQ(theme_cache::key(themes.theme_root, themes.flavor), with_sprite);
+
+    std::filesystem::remove(themes.theme_root / "colors.yaml");
+    EXPECT_FALSE(theme_cache::key(themes.theme_root, themes.flavor).has_value());
+}
+
+TEST(theme_cache, compiling_from_the_loader_matches_compiling_the_folder)
+{
+    const temp_themes_t themes;
+
+    theme_loader loader;
+    loader.start(themes.theme_root, themes.flavor);
+    auto& loaded = loader.join();
+    ASSERT_TRUE(loaded.bg_main_ok);
+
+    const std::vector<uint8_t> bg_main(loaded.bg_main.data(), loaded.bg_main.data() + loaded.bg_main.size());
+    const auto from_loader = theme_compiler::compile(themes.theme_root, themes.flavor, loaded.colors, loaded.sprite_entries, bg_main);
+    const auto from_folder = theme_compiler::compile(themes.theme_root, themes.flavor);
+
+    ASSERT_TRUE(from_loader.has_value());
+    ASSERT_TRUE(from_folder.has_value());
+    EXPECT_EQ(*from_loader, *from_folder);
+}
+
+TEST(theme_cache, cold_start_stores_the_entry_the_warm_start_maps)
+{
+    const temp_themes_t themes;
+
+    // cold: nothing cached yet
+    const auto key = theme_cache::key(themes.theme_root, themes.flavor);
+    ASSERT_TRUE(key.has_value());
+    const auto entry = theme_cache::entry_path(themes.cache_dir, themes.theme_root, themes.flavor, *key);
+    ASSERT_FALSE(std::filesystem::exists(entry));
+
+    const auto compiled = cold_start(themes, entry);
+    ASSERT_FALSE(compiled.empty());
+
+    // warm: the same key finds the entry, which is mapped instead of loading the folder
+    const auto warm_key = theme_cache::key(themes.theme_root, themes.flavor);
+    ASSERT_EQ(warm_key, key);
+    ASSERT_EQ(theme_cache::entry_path(themes.cache_dir, themes.theme_root, themes.flavor, *warm_key), entry);
+
+    mapped_file file;
+    ASSERT_TRUE(file.open(entry));
+    ASSERT_EQ(std::vector<uint8_t>(file.data(), file.data() + file.size()), compiled);
+
+    theme_pack::reader reader;
+    ASSERT_TRUE(reader.open(file.data(), file.size()));
+    EXPECT_EQ(reader.get_flavor(), static_cast<uint32_t>(FLAVOR_POTATO));
+
+    const auto colors = reader.find(theme_pack::SECTION_COLORS, theme_pack::COLORS_SECTION);
+    ASSERT_TRUE(colors.has_value());
+
+    compiled_colors_t warm_colors;
+    ASSERT_TRUE(color_config::load(reinterpret_cast<const uint32_t*>(colors->data), static_cast<size_t>(colors->size / sizeof(uint32_t)), warm_colors));
+    EXPECT_EQ(warm_colors.find(0x302010, CATEGORY_SHAPES, WND_TYPE_MAIN), 0x0000FFu);
+
+    const auto bg = reader.find(theme_pack::SECTION_BITMAP, "bg");
+    ASSERT_TRUE(bg.has_value());
+    const auto bg_info = bmp_decoder::parse(bg->data, static_cast<size_t>(bg->size));
+    ASSERT_TRUE(bg_info.has_value());
+    EXPECT_EQ(bg_info->width, 8u);
+    EXPECT_TRUE(reader.find(theme_pack::SECTION_SPRITES, theme_pack::SPRITES_SECTION).has_value());
+}
+
+TEST(theme_cache, edited_theme_replaces_the_old_entry)
+{
+    const temp_themes_t themes;
+
+    const auto old_entry = theme_cache::entry_path(themes.cache_dir, themes.theme_root, themes.flavor, *theme_cache::key(themes.theme_root, themes.flavor));
+    ASSERT_FALSE(cold_start(themes, old_entry).empty());
+
+    themes.write(std::filesystem::path(themes.flavor.name) / "bg.bmp", temp_themes_t::make_bmp(16, 8, 5));
+
+    const auto new_entry = theme_cache::entry_path(themes.cache_dir, themes.theme_root, themes.flavor, *theme_cache::key(themes.theme_root, themes.flavor));
+    ASSERT_NE(new_entry, old_entry);
+    ASSERT_FALSE(cold_start(themes, new_entry).empty());
+
+    EXPECT_TRUE(std::filesystem::exists(new_entry));
+    EXPECT_FALSE(std::filesystem::exists(old_entry));
+}
@@ -0,0 +1,201 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bmp_decoder.hpp"
+#include "theme_loader.hpp"
+
+namespace
+{
+/**
+ * Theme folder below the system temp directory that is removed with everything in it
+ */
+typedef struct temp_theme
+{
+    std::filesystem::path root;
+    flavor_info_t flavor = {"potato", FLAVOR_POTATO, 8};
+
+    temp_theme()
+    {
+        root = std::filesystem::temp_directory_path() / ("vmtest_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / flavor.name);
+    }
+
+    ~temp_theme()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+    }
+
+    void write(const std::filesystem::path& name, const std::vector<uint8_t>& bytes) const
+    {
+        std::ofstream out(root / name, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void write(const std::filesystem::path& name, const std::string& text) const
+    {
+        write(name, std::vector<uint8_t>(text.begin(), text.end()));
+    }
+} temp_theme_t;
+
+std::vector<uint8_t> make_bmp(const uint32_t width, const uint32_t height)
+{
+    auto file = bmp_decoder::create_bmp(width, height, 32);
+
+    for (size_t i = 54; i < file.size(); i++)
+        file[i] = static_cast<uint8_t>(i * 7);
+
+    return file;
+}
+
+// every pixel as QOI_OP_RGBA
+std::vector<uint8_t> make_qoi(const uint32_t width, const uint32_t height)
+{
+    std::vector<uint8_t> file = {'q', 'o', 'i', 'f'};
+
+    for (const auto v : {width, height})
+        for (int shift = 24; shift >= 0; shift -= 8)
+            file.push_back(static_cast<uint8_t>(v >> shift));
+
+    file.push_back(4);
+    file.push_back(0);
+
+    for (uint32_t i = 0; i < width * height; i++)
+        file.insert(file.end(), {0xFF, static_cast<uint8_t>(i * 5), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i), 0xFF});
+
+    file.insert(file.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return file;
+}
+
+const char* colors_yaml = R"(
+shapes:
+  "#102030": "#FF0000"
+text:
+  "#FFFFFF": "#000000"
+)";
+
+const char* sprites_yaml = R"(
+sprites:
+  - {width: 16, height: 16, bpp: 32, hash: "1a2b3c4d", file: knob}
+)";
+}
+
+TEST(theme_loader, loads_the_same_theme_as_a_sequential_load)
+{
+    const temp_theme_t theme;
+    theme.write("colors.yaml", colors_yaml);
+    theme.write("sprites.yaml", sprites_yaml);
+    theme.write(std::filesystem::path("potato") / "bg.bmp", make_bmp(8, 4));
+
+    theme_loader loader;
+    loader.start(theme.root, theme.flavor);
+    const auto& loaded = loader.join();
+
+    ASSERT_TRUE(loaded.colors_ok);
+    ASSERT_TRUE(loaded.sprites_ok);
+    ASSERT_TRUE(loaded.bg_main_ok);
+
+    compiled_colors_t colors;
+    ASSERT_TRUE(color_config::load_file(theme.root / "colors.yaml", colors));
+
+    for (const uint32_t c : {0x302010u, 0xFFFFFFu, 0x123456u})
+    {
+        EXPECT_EQ(loaded.colors.find(c, CATEGORY_SHAPES, WND_TYPE_MAIN), colors.find(c, CATEGORY_SHAPES, WND_TYPE_MAIN));
+        EXPECT_EQ(loaded.colors.find(c, CATEGORY_TEXT, WND_TYPE_MAIN), colors.find(c, CATEGORY_TEXT, WND_TYPE_MAIN));
+    }
+
+    EXPECT_EQ(loaded.colors.find(0x302010, CATEGORY_SHAPES, WND_TYPE_MAIN), 0x0000FFu);
+
+    ASSERT_EQ(loaded.sprite_entries.size(), 1u);
+    EXPECT_EQ(loaded.sprite_entries[0].file, "knob");
+    EXPECT_EQ(loaded.sprite_entries[0].key.hash, 0x1a2b3c4du);
+
+    theme_asset bg;
+    ASSERT_TRUE(bg.load(theme.root / "potato", L"bg", theme.flavor.bitmap_width_main));
+    ASSERT_EQ(loaded.bg_main.size(), bg.size());
+    EXPECT_TRUE(std::equal(bg.data(), bg.data() + bg.size(), loaded.bg_main.data()));
+}
+
+TEST(theme_loader, background_at_another_width_is_fitted_to_the_flavor)
+{
+    const temp_theme_t theme;
+    theme.write("colors.yaml", colors_yaml);
+    theme.write(std::filesystem::path("potato") / "bg.qoi", make_qoi(16, 8));
+
+    theme_loader loader;
+    loader.start(theme.root, theme.flavor);
+    const auto& loaded = loader.join();
+
+    ASSERT_TRUE(loaded.bg_main_ok);
+
+    const auto info = bmp_decoder::parse(loaded.bg_main.data(), loaded.bg_main.size());
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->width, 8u);
+    EXPECT_EQ(info->height, 4u);
+}
+
+TEST(theme_loader, missing_sprites_yaml_is_no_error)
+{
+    const temp_theme_t theme;
+    theme.write("colors.yaml", colors_yaml);
+    theme.write(std::filesystem::path("potato") / "bg.bmp", make_bmp(8, 4));
+
+    theme_loader loader;
+    loader.start(theme.root, theme.flavor);
+    const auto& loaded = loader.join();
+
+    EXPECT_TRUE(loaded.sprites_ok);
+    EXPECT_TRUE(loaded.sprite_entries.empty());
+}
+
+TEST(theme_loader, failures_are_reported_per_part)
+{
+    const temp_theme_t theme;
+    theme.write("colors.yaml", "shapes: [");
+    theme.write("sprites.yaml", "sprites: [{width: 16}]");
+
+    theme_loader loader;
+    loader.start(theme.root, theme.flavor);
+    const auto& loaded = loader.join();
+
+    EXPECT_FALSE(loaded.colors_ok);
+    EXPECT_FALSE(loaded.sprites_ok);
+    EXPECT_FALSE(loaded.bg_main_ok);
+}
+
+TEST(theme_loader, missing_colors_yaml_keeps_the_background)
+{
+    const temp_theme_t theme;
+    theme.write(std::filesystem::path("potato") / "bg.bmp", make_bmp(8, 4));
+
+    theme_loader loader;
+    loader.start(theme.root, theme.flavor);
+    const auto& loaded = loader.join();
+
+    EXPECT_FALSE(loaded.colors_ok);
+    EXPECT_TRUE(loaded.sprites_ok);
+    EXPECT_TRUE(loaded.bg_main_ok);
+}
@@ -0,0 +1,202 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "shared_region.hpp"
+#include "theme_share.hpp"
+
+namespace
+{
+// unique per test and run, a region left behind by a crashed run must not make the next one fail
+std::string unique_name()
+{
+    return "vmtest." + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + "."
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+std::vector<uint8_t> make_pack(const size_t size)
+{
+    std::vector<uint8_t> pack(size);
+
+    for (size_t i = 0; i < size; i++)
+        pack[i] = static_cast<uint8_t>(i * 31 + 7);
+
+    return pack;
+}
+
+bool same_bytes(const mapped_view& view, const std::vector<uint8_t>& bytes)
+{
+    return view.size() == bytes.size() && std::memcmp(view.data(), bytes.data(), bytes.size()) == 0;
+}
+}
+
+TEST(theme_share, attached_instances_see_the_published_pack)
+{
+    const auto name = unique_name();
+    const auto pack = make_pack(200000);
+
+    const auto published = theme_share::publish(make_shared_region(), name, pack);
+    ASSERT_NE(published, nullptr);
+    EXPECT_TRUE(same_bytes(*published, pack));
+    EXPECT_EQ(published->get_section(), nullptr);
+
+    const auto attached = theme_share::attach(make_shared_region(), name);
+    ASSERT_NE(attached, nullptr);
+    EXPECT_TRUE(same_bytes(*attached, pack));
+
+    // separate mappings of the same pages
+    EXPECT_NE(attached->data(), published->data());
+}
+
+TEST(theme_share, nothing_published_attaches_nothing)
+{
+    EXPECT_EQ(theme_share::attach(make_shared_region(), unique_name()), nullptr);
+}
+
+TEST(theme_share, a_taken_name_is_not_published_twice)
+{
+    const auto name = unique_name();
+    const auto first = theme_share::publish(make_shared_region(), name, make_pack(1000));
+    ASSERT_NE(first, nullptr);
+
+    EXPECT_EQ(theme_share::publish(make_shared_region(), name, make_pack(2000)), nullptr);
+    EXPECT_EQ(theme_share::publish(make_shared_region(), unique_name(), {}), nullptr);
+}
+
+TEST(theme_share, the_last_instance_to_detach_removes_the_name)
+{
+    const auto name = unique_name();
+    const auto pack = make_pack(5000);
+
+    auto published = theme_share::publish(make_shared_region(), name, pack);
+    auto attached = theme_share::attach(make_shared_region(), name);
+    ASSERT_NE(attached, nullptr);
+
+    // the publisher exits first, the theme stays available to the others
+    published.reset();
+    auto late = theme_share::attach(make_shared_region(), name);
+    ASSERT_NE(late, nullptr);
+    EXPECT_TRUE(same_bytes(*late, pack));
+
+    attached.reset();
+    late.reset();
+    EXPECT_EQ(theme_share::attach(make_shared_region(), name), nullptr);
+
+    // the name can be published again
+    EXPECT_NE(theme_share::publish(make_shared_region(), name, pack), nullptr);
+}
+
+TEST(theme_share, incomplete_regions_are_not_attached)
+{
+    const auto name = unique_name();
+    auto region = make_shared_region();
+    ASSERT_TRUE(region->create(name, theme_share::HEADER_SIZE, 4096));
+
+    // a publisher still copying the pack
+    auto* hdr = new (region->header()) theme_share::header_t;
+    std::memcpy(hdr->magic, theme_share::MAGIC, sizeof(theme_share::MAGIC));
+    hdr->version = theme_share::VERSION;
+    hdr->state.store(theme_share::STATE_WRITING);
+    hdr->refs.store(1);
+    hdr->payload_size = 4096;
+    EXPECT_EQ(theme_share::attach(make_shared_region(), name), nullptr);
+
+    // a region whose last instance is detaching
+    hdr->state.store(theme_share::STATE_READY);
+    hdr->refs.store(0);
+    EXPECT_EQ(theme_share::attach(make_shared_region(), name), nullptr);
+
+    // a payload larger than the region
+    hdr->refs.store(1);
+    hdr->payload_size = 1 << 20;
+    EXPECT_EQ(theme_share::attach(make_shared_region(), name), nullptr);
+
+    hdr->payload_size = 4096;
+    EXPECT_NE(theme_share::attach(make_shared_region(), name), nullptr);
+
+    region->unlink();
+}
+
+TEST(theme_share, sealed_payload_is_read_only)
+{
+    const auto name = unique_name();
+    auto region = make_shared_region();
+    ASSERT_TRUE(region->create(name, theme_share::HEADER_SIZE, 4096));
+    ASSERT_NE(region->writable_payload(), nullptr);
+
+    region->writable_payload()[0] = 42;
+    ASSERT_TRUE(region->seal());
+    EXPECT_EQ(region->writable_payload(), nullptr);
+    EXPECT_EQ(region->data()[0], 42);
+
+    region->unlink();
+}
+
+TEST(theme_share, region_names_differ_per_flavor_and_key)
+{
+    const flavor_info_t banana = {"banana", FLAVOR_BANANA};
+    const flavor_info_t potato = {"potato", FLAVOR_POTATO};
+
+    EXPECT_EQ(theme_share::region_name(potato, 0x1234), theme_share::region_name(potato, 0x1234));
+    EXPECT_NE(theme_share::region_name(potato, 0x1234), theme_share::region_name(potato, 0x1235));
+    EXPECT_NE(theme_share::region_name(potato, 0x1234), theme_share::region_name(banana, 0x1234));
+}
+
+#ifndef _WIN32
+TEST(theme_share, another_process_attaches_to_the_published_pack)
+{
+    const auto name = unique_name();
+    const auto pack = make_pack(300000);
+    const auto published = theme_share::publish(make_shared_region(), name, pack);
+    ASSERT_NE(published, nullptr);
+
+    const pid_t child = fork();
+    ASSERT_NE(child, -1);
+
+    if (child == 0)
+    {
+        bool ok;
+
+        {
+            const auto attached = theme_share::attach(make_shared_region(), name);
+            ok = attached != nullptr && same_bytes(*attached, pack);
+        }
+
+        _exit(ok ? 0 : 1);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // the child's exit didn't remove the name while the publisher still holds it
+    EXPECT_NE(theme_share::attach(make_shared_region(), name), nullptr);
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+Copyright (C) 2025 Klaus Hahnenkamp
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "theme_compiler.hpp"
+#include "theme_pack.hpp"
+#include "theme_types.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * vmtheme compiles a theme folder into one <flavor>.vmtheme file per flavor, which the DLL maps instead of
+ * reading colors.yaml, sprites.yaml and the images at every start
+ *
+ * usage: vmtheme <theme folder> [default|banana|potato ...]
+ * Without flavors every flavor folder of the theme is compiled
+ */
+
+/**
+ * Compiles one flavor of a theme and writes <flavor>.vmtheme next to its folder
+ * @param theme_root The theme folder
+ * @param flavor The flavor to compile
+ * @param pool Worker threads for resampling
+ * @return True if the theme is valid and the pack was written
+ */
+static bool compile_flavor(const std::filesystem::path& theme_root, const flavor_info_t& flavor, thread_pool& pool)
+{
+    const auto pack = theme_compiler::compile(theme_root, flavor, &pool);
+
+    if (!pack)
+        return false;
+
+    const auto pack_path = theme_root / (flavor.name + theme_pack::FILE_EXTENSION);
+    std::ofstream out(pack_path, std::ios::binary | std::ios::trunc);
+
+    if (!out.is_open() || !out.write(reinterpret_cast<const char*>(pack->data()), static_cast<std::streamsize>(pack->size())))
+    {
+        SPDLOG_ERROR("can't write {}", pack_path.string());
+        return false;
+    }
+
+    SPDLOG_INFO("wrote {} ({} KB)", pack_path.string(), pack->size() / 1024);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    spdlog::set_pattern("%l: %v");
+
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: vmtheme <theme folder> [default|banana|potato ...]\n");
+        return 1;
+    }
+
+    const std::filesystem::path theme_root = argv[1];
+
+    if (!std::filesystem::is_directory(theme_root))
+    {
+        SPDLOG_ERROR("{} is not a folder", theme_root.string());
+        return 1;
+    }
+
+    std::vector<const flavor_info_t*> targets;
+
+    for (int i = 2; i < argc; i++)
+    {
+        const auto* flavor = flavors::find(std::string(argv[i]));
+
+        if (!flavor)
+        {
+            SPDLOG_ERROR("unknown flavor {}, must be default, banana or potato", argv[i]);
+            return 1;
+        }
+
+        targets.push_back(flavor);
+    }
+
+    if (targets.empty())
+    {
+        for (const auto id : {FLAVOR_DEFAULT, FLAVOR_BANANA, FLAVOR_POTATO})
+        {
+            const auto* flavor = flavors::find(id);
+
+            if (std::filesystem::is_directory(theme_root / flavor->name))
+                targets.push_back(flavor);
+        }
+    }
+
+    if (targets.empty())
+    {
+        SPDLOG_ERROR("{} has no default, banana or potato folder", theme_root.string());
+        return 1;
+    }
+
+    thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+    bool ok = true;
+
+    for (const auto* flavor : targets)
+    {
+        if (!compile_flavor(theme_root, *flavor, pool))
+        {
+            SPDLOG_ERROR("failed to compile {}", flavor->name);
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}